@@ -1,11 +1,17 @@
 #include "color.h"
 #include "logger.h"
+#include "math.h"
 #include "system.h"
+#include "thread.h"
 #include "windows.h"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <memory>
+#include <thread>
+#include <type_traits>
 
 #if defined(CONF_FAMILY_WINDOWS)
 #include <fcntl.h>
@@ -72,6 +78,21 @@ void log_set_scope_logger(ILogger *logger)
 	}
 }
 
+// Fills everything except the message itself.
+static void log_message_init(CLogMessage *msg, LEVEL level, bool have_color, LOG_COLOR color, const char *sys, const char *timestamp)
+{
+	msg->m_Level = level;
+	msg->m_HaveColor = have_color;
+	msg->m_Color = color;
+	str_copy(msg->m_aTimestamp, timestamp);
+	msg->m_TimestampLength = str_length(msg->m_aTimestamp);
+	str_copy(msg->m_aSystem, sys);
+	msg->m_SystemLength = str_length(msg->m_aSystem);
+
+	str_format(msg->m_aLine, sizeof(msg->m_aLine), "%s %c %s: ", msg->m_aTimestamp, "EWIDT"[level], msg->m_aSystem);
+	msg->m_LineMessageOffset = str_length(msg->m_aLine);
+}
+
 [[gnu::format(printf, 5, 0)]] static void log_log_impl(LEVEL level, bool have_color, LOG_COLOR color, const char *sys, const char *fmt, va_list args)
 {
 	// Make sure we're not logging recursively.
@@ -90,17 +111,16 @@ void log_set_scope_logger(ILogger *logger)
 		return;
 	}
 
-	CLogMessage Msg;
-	Msg.m_Level = level;
-	Msg.m_HaveColor = have_color;
-	Msg.m_Color = color;
-	str_timestamp_format(Msg.m_aTimestamp, sizeof(Msg.m_aTimestamp), FORMAT_SPACE);
-	Msg.m_TimestampLength = str_length(Msg.m_aTimestamp);
-	str_copy(Msg.m_aSystem, sys);
-	Msg.m_SystemLength = str_length(Msg.m_aSystem);
+	if(scope_logger->LogDeferred(level, have_color, color, sys, fmt, args))
+	{
+		in_logger = false;
+		return;
+	}
 
-	str_format(Msg.m_aLine, sizeof(Msg.m_aLine), "%s %c %s: ", Msg.m_aTimestamp, "EWIDT"[level], Msg.m_aSystem);
-	Msg.m_LineMessageOffset = str_length(Msg.m_aLine);
+	CLogMessage Msg;
+	char aTimestamp[sizeof(Msg.m_aTimestamp)];
+	str_timestamp_format(aTimestamp, sizeof(aTimestamp), FORMAT_SPACE);
+	log_message_init(&Msg, level, have_color, color, sys, aTimestamp);
 
 	char *pMessage = Msg.m_aLine + Msg.m_LineMessageOffset;
 	int MessageSize = sizeof(Msg.m_aLine) - Msg.m_LineMessageOffset;
@@ -493,6 +513,744 @@ std::unique_ptr<ILogger> log_logger_noop()
 	return std::make_unique<CLoggerNoOp>();
 }
 
+// Deferred formatting: the arguments of a message are copied as described by
+// its format string and formatted later with one `snprintf` per conversion.
+enum
+{
+	FORMAT_LENGTH_NONE,
+	FORMAT_LENGTH_HH,
+	FORMAT_LENGTH_H,
+	FORMAT_LENGTH_L,
+	FORMAT_LENGTH_LL,
+	FORMAT_LENGTH_J,
+	FORMAT_LENGTH_Z,
+	FORMAT_LENGTH_T,
+	FORMAT_LENGTH_LONG_DOUBLE,
+};
+
+class CFormatSpec
+{
+public:
+	const char *m_pFlags;
+	int m_FlagsLength;
+	const char *m_pWidth;
+	int m_WidthLength;
+	bool m_WidthArg;
+	bool m_HasPrecision;
+	int m_Precision;
+	bool m_PrecisionArg;
+	int m_Length;
+	char m_Conversion;
+};
+
+// Parses the conversion specification following a '%'. Returns the position
+// after it, or nullptr if it cannot be deferred.
+static const char *log_parse_format_spec(const char *p, CFormatSpec *spec)
+{
+	spec->m_pFlags = p;
+	while(*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'')
+		p++;
+	spec->m_FlagsLength = p - spec->m_pFlags;
+	if(spec->m_FlagsLength > 8)
+		return nullptr; // does not fit the reassembled specification
+
+	spec->m_pWidth = p;
+	spec->m_WidthArg = *p == '*';
+	if(spec->m_WidthArg)
+		p++;
+	else
+		while(*p >= '0' && *p <= '9')
+			p++;
+	spec->m_WidthLength = p - spec->m_pWidth;
+	if(*p == '$' || spec->m_WidthLength > 8)
+		return nullptr; // positional arguments or overly long width
+
+	spec->m_HasPrecision = *p == '.';
+	spec->m_Precision = -1;
+	spec->m_PrecisionArg = false;
+	if(spec->m_HasPrecision)
+	{
+		p++;
+		spec->m_PrecisionArg = *p == '*';
+		if(spec->m_PrecisionArg)
+		{
+			p++;
+		}
+		else
+		{
+			spec->m_Precision = 0;
+			while(*p >= '0' && *p <= '9')
+			{
+				if(spec->m_Precision > 100000)
+					return nullptr;
+				spec->m_Precision = spec->m_Precision * 10 + (*p - '0');
+				p++;
+			}
+		}
+	}
+
+	spec->m_Length = FORMAT_LENGTH_NONE;
+	if(p[0] == 'h' && p[1] == 'h')
+	{
+		spec->m_Length = FORMAT_LENGTH_HH;
+		p += 2;
+	}
+	else if(p[0] == 'l' && p[1] == 'l')
+	{
+		spec->m_Length = FORMAT_LENGTH_LL;
+		p += 2;
+	}
+	else if(p[0] == 'I' && p[1] == '6' && p[2] == '4')
+	{
+		spec->m_Length = FORMAT_LENGTH_LL;
+		p += 3;
+	}
+	else if(p[0] == 'I' && p[1] == '3' && p[2] == '2')
+	{
+		p += 3;
+	}
+	else
+	{
+		switch(*p)
+		{
+		case 'h': spec->m_Length = FORMAT_LENGTH_H; break;
+		case 'l': spec->m_Length = FORMAT_LENGTH_L; break;
+		case 'q': spec->m_Length = FORMAT_LENGTH_LL; break;
+		case 'j': spec->m_Length = FORMAT_LENGTH_J; break;
+		case 'z': spec->m_Length = FORMAT_LENGTH_Z; break;
+		case 'I': spec->m_Length = FORMAT_LENGTH_Z; break;
+		case 't': spec->m_Length = FORMAT_LENGTH_T; break;
+		case 'L': spec->m_Length = FORMAT_LENGTH_LONG_DOUBLE; break;
+		}
+		if(spec->m_Length != FORMAT_LENGTH_NONE)
+			p++;
+	}
+
+	spec->m_Conversion = *p;
+	switch(spec->m_Conversion)
+	{
+	case '%':
+		return p == spec->m_pFlags ? p + 1 : nullptr;
+	case 'd':
+	case 'i':
+	case 'u':
+	case 'o':
+	case 'x':
+	case 'X':
+	case 'f':
+	case 'F':
+	case 'e':
+	case 'E':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		return p + 1;
+	case 'c':
+	case 's':
+	case 'p':
+		// no wide characters
+		return spec->m_Length == FORMAT_LENGTH_NONE ? p + 1 : nullptr;
+	default:
+		// `%n`, `%m` or invalid
+		return nullptr;
+	}
+}
+
+class CLogArgsWriter
+{
+public:
+	unsigned char *m_pData;
+	int m_Size;
+	int m_Used = 0;
+
+	bool Write(const void *pData, int Size)
+	{
+		if(Size > m_Size - m_Used)
+			return false;
+		mem_copy(m_pData + m_Used, pData, Size);
+		m_Used += Size;
+		return true;
+	}
+	template<typename T>
+	bool Write(T Value)
+	{
+		return Write(&Value, sizeof(Value));
+	}
+};
+
+class CLogArgsReader
+{
+public:
+	const unsigned char *m_pData;
+
+	template<typename T>
+	T Read()
+	{
+		T Value;
+		mem_copy(&Value, m_pData, sizeof(Value));
+		m_pData += sizeof(Value);
+		return Value;
+	}
+};
+
+static constexpr uint32_t LOG_NULL_STRING = 0xffffffff;
+
+// Copies the format string and the arguments. Returns false if the format
+// string is not supported or the arguments do not fit, the arguments are not
+// consumed.
+static bool log_capture_args(const char *fmt, va_list args, CLogArgsWriter *writer)
+{
+	if(!writer->Write(fmt, str_length(fmt) + 1))
+		return false;
+
+	va_list ap;
+	va_copy(ap, args);
+	bool success = true;
+	const char *p = fmt;
+	while(success && *p)
+	{
+		if(*p != '%')
+		{
+			p++;
+			continue;
+		}
+		CFormatSpec spec;
+		p = log_parse_format_spec(p + 1, &spec);
+		if(!p)
+		{
+			success = false;
+			break;
+		}
+		if(spec.m_WidthArg)
+			success = success && writer->Write(va_arg(ap, int));
+		int precision = spec.m_Precision;
+		if(spec.m_PrecisionArg)
+		{
+			precision = va_arg(ap, int);
+			success = success && writer->Write(precision);
+		}
+		switch(spec.m_Conversion)
+		{
+		case '%':
+			break;
+		case 'd':
+		case 'i':
+		{
+			long long value;
+			switch(spec.m_Length)
+			{
+			case FORMAT_LENGTH_HH: value = (signed char)va_arg(ap, int); break;
+			case FORMAT_LENGTH_H: value = (short)va_arg(ap, int); break;
+			case FORMAT_LENGTH_L: value = va_arg(ap, long); break;
+			case FORMAT_LENGTH_LL: value = va_arg(ap, long long); break;
+			case FORMAT_LENGTH_J: value = va_arg(ap, intmax_t); break;
+			case FORMAT_LENGTH_Z: value = va_arg(ap, std::make_signed_t<size_t>); break;
+			case FORMAT_LENGTH_T: value = va_arg(ap, ptrdiff_t); break;
+			default: value = va_arg(ap, int); break;
+			}
+			success = success && writer->Write(value);
+			break;
+		}
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+		{
+			unsigned long long value;
+			switch(spec.m_Length)
+			{
+			case FORMAT_LENGTH_HH: value = (unsigned char)va_arg(ap, unsigned); break;
+			case FORMAT_LENGTH_H: value = (unsigned short)va_arg(ap, unsigned); break;
+			case FORMAT_LENGTH_L: value = va_arg(ap, unsigned long); break;
+			case FORMAT_LENGTH_LL: value = va_arg(ap, unsigned long long); break;
+			case FORMAT_LENGTH_J: value = va_arg(ap, uintmax_t); break;
+			case FORMAT_LENGTH_Z: value = va_arg(ap, size_t); break;
+			case FORMAT_LENGTH_T: value = va_arg(ap, std::make_unsigned_t<ptrdiff_t>); break;
+			default: value = va_arg(ap, unsigned); break;
+			}
+			success = success && writer->Write(value);
+			break;
+		}
+		case 'c':
+			success = success && writer->Write(va_arg(ap, int));
+			break;
+		case 's':
+		{
+			const char *str = va_arg(ap, const char *);
+			if(!str)
+			{
+				success = success && writer->Write(LOG_NULL_STRING);
+				break;
+			}
+			// the string may not be null-terminated if the precision is given
+			const uint32_t max_length = precision >= 0 ? minimum(precision, (int)sizeof(CLogMessage::m_aLine)) : sizeof(CLogMessage::m_aLine);
+			uint32_t length = 0;
+			while(length < max_length && str[length])
+				length++;
+			success = success && writer->Write(length) && writer->Write(str, length) && writer->Write('\0');
+			break;
+		}
+		case 'p':
+			success = success && writer->Write(va_arg(ap, void *));
+			break;
+		default:
+			if(spec.m_Length == FORMAT_LENGTH_LONG_DOUBLE)
+				success = success && writer->Write(va_arg(ap, long double));
+			else
+				success = success && writer->Write(va_arg(ap, double));
+			break;
+		}
+	}
+	va_end(ap);
+	return success;
+}
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#endif
+// Formats a message from the copied format string and arguments like
+// `str_format` does.
+static void log_format_args(const unsigned char *data, char *buffer, int buffer_size)
+{
+	const char *fmt = (const char *)data;
+	CLogArgsReader reader{data + str_length(fmt) + 1};
+
+	int length = 0;
+	const char *p = fmt;
+	while(*p && length < buffer_size - 1)
+	{
+		if(*p != '%')
+		{
+			buffer[length++] = *p++;
+			continue;
+		}
+		CFormatSpec spec;
+		p = log_parse_format_spec(p + 1, &spec);
+		if(spec.m_Conversion == '%')
+		{
+			buffer[length++] = '%';
+			continue;
+		}
+
+		char aSpec[64];
+		int spec_length = 0;
+		aSpec[spec_length++] = '%';
+		mem_copy(aSpec + spec_length, spec.m_pFlags, spec.m_FlagsLength);
+		spec_length += spec.m_FlagsLength;
+		if(spec.m_WidthArg)
+		{
+			spec_length += str_format(aSpec + spec_length, sizeof(aSpec) - spec_length, "%d", reader.Read<int>());
+		}
+		else
+		{
+			mem_copy(aSpec + spec_length, spec.m_pWidth, spec.m_WidthLength);
+			spec_length += spec.m_WidthLength;
+		}
+		const int precision = spec.m_PrecisionArg ? reader.Read<int>() : spec.m_Precision;
+		if(spec.m_HasPrecision && precision >= 0)
+			spec_length += str_format(aSpec + spec_length, sizeof(aSpec) - spec_length, ".%d", precision);
+
+		char *out = buffer + length;
+		const int out_size = buffer_size - length;
+		int written = 0;
+		switch(spec.m_Conversion)
+		{
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+			aSpec[spec_length++] = 'l';
+			aSpec[spec_length++] = 'l';
+			aSpec[spec_length++] = spec.m_Conversion;
+			aSpec[spec_length] = '\0';
+			written = snprintf(out, out_size, aSpec, reader.Read<long long>());
+			break;
+		case 'c':
+		case 'p':
+			aSpec[spec_length++] = spec.m_Conversion;
+			aSpec[spec_length] = '\0';
+			if(spec.m_Conversion == 'c')
+				written = snprintf(out, out_size, aSpec, reader.Read<int>());
+			else
+				written = snprintf(out, out_size, aSpec, reader.Read<void *>());
+			break;
+		case 's':
+		{
+			aSpec[spec_length++] = 's';
+			aSpec[spec_length] = '\0';
+			const uint32_t str_length = reader.Read<uint32_t>();
+			const char *str = nullptr;
+			if(str_length != LOG_NULL_STRING)
+			{
+				str = (const char *)reader.m_pData;
+				reader.m_pData += str_length + 1;
+			}
+			written = snprintf(out, out_size, aSpec, str);
+			break;
+		}
+		default:
+			if(spec.m_Length == FORMAT_LENGTH_LONG_DOUBLE)
+			{
+				aSpec[spec_length++] = 'L';
+				aSpec[spec_length++] = spec.m_Conversion;
+				aSpec[spec_length] = '\0';
+				written = snprintf(out, out_size, aSpec, reader.Read<long double>());
+			}
+			else
+			{
+				aSpec[spec_length++] = spec.m_Conversion;
+				aSpec[spec_length] = '\0';
+				written = snprintf(out, out_size, aSpec, reader.Read<double>());
+			}
+			break;
+		}
+		if(written < 0)
+			break;
+		length = minimum(length + written, buffer_size - 1);
+	}
+	buffer[length] = '\0';
+	str_utf8_fix_truncation(buffer);
+}
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+class CLogRecord
+{
+public:
+	enum
+	{
+		TYPE_PADDING,
+		TYPE_DEFERRED,
+		TYPE_FORMATTED,
+	};
+
+	// including the data following the record, multiple of 8
+	uint32_t m_Size;
+	uint8_t m_Type;
+	LEVEL m_Level;
+	bool m_HaveColor;
+	LOG_COLOR m_Color;
+	uint64_t m_Sequence;
+	int64_t m_Time;
+	char m_aSystem[32];
+	// followed by the format string and arguments, or by a `CLogMessage`
+};
+
+// Single producer, single consumer ring buffer of the messages of one thread.
+class CLogRing
+{
+public:
+	static constexpr int SIZE = 256 * 1024;
+	static constexpr int MAX_RECORD_SIZE = 8 * 1024;
+
+	alignas(64) std::atomic<uint64_t> m_WritePos{0};
+	alignas(64) std::atomic<uint64_t> m_ReadPos{0};
+	// set when the thread exits, the ring is removed after it is empty
+	std::atomic_bool m_Released{false};
+	// used by the producer to assemble a record
+	alignas(8) unsigned char m_aStaging[MAX_RECORD_SIZE];
+	alignas(8) unsigned char m_aData[SIZE];
+
+	const CLogRecord *Peek()
+	{
+		uint64_t ReadPos = m_ReadPos.load(std::memory_order_relaxed);
+		while(ReadPos != m_WritePos.load(std::memory_order_acquire))
+		{
+			const CLogRecord *pRecord = (const CLogRecord *)&m_aData[ReadPos % SIZE];
+			if(pRecord->m_Type != CLogRecord::TYPE_PADDING)
+				return pRecord;
+			ReadPos += pRecord->m_Size;
+			m_ReadPos.store(ReadPos, std::memory_order_release);
+		}
+		return nullptr;
+	}
+	void Pop(const CLogRecord *pRecord)
+	{
+		m_ReadPos.store(m_ReadPos.load(std::memory_order_relaxed) + pRecord->m_Size, std::memory_order_release);
+	}
+};
+
+static thread_local bool log_in_deferred_thread = false;
+static thread_local bool log_ring_handle_destroyed = false;
+
+class CLogRingHandle
+{
+public:
+	int m_LoggerId = -1;
+	std::shared_ptr<CLogRing> m_pRing;
+
+	~CLogRingHandle()
+	{
+		if(m_pRing)
+			m_pRing->m_Released.store(true, std::memory_order_release);
+		log_ring_handle_destroyed = true;
+	}
+};
+static thread_local CLogRingHandle log_ring_handle;
+
+class CLoggerDeferred : public ILogger
+{
+	static constexpr std::chrono::milliseconds BATCH_INTERVAL{1};
+
+	std::unique_ptr<ILogger> m_pLogger;
+	int m_Id;
+	std::atomic<uint64_t> m_NextSequence{0};
+
+	CLock m_RingsLock;
+	std::vector<std::shared_ptr<CLogRing>> m_vpRings GUARDED_BY(m_RingsLock);
+	std::atomic_bool m_RingsChanged{false};
+
+	SEMAPHORE m_Semaphore;
+	std::atomic_bool m_Waiting{false};
+	std::atomic_bool m_Stopping{false};
+	void *m_pThread;
+
+	// only used by the logger thread
+	std::vector<std::shared_ptr<CLogRing>> m_vpThreadRings;
+	int64_t m_LastTime = -1;
+	char m_aLastTimestamp[sizeof(CLogMessage::m_aTimestamp)];
+
+	CLogRing *ThreadRing() REQUIRES(!m_RingsLock)
+	{
+		if(log_in_deferred_thread || log_ring_handle_destroyed || m_Stopping.load(std::memory_order_relaxed))
+			return nullptr;
+		CLogRingHandle &Handle = log_ring_handle;
+		if(Handle.m_LoggerId != m_Id)
+		{
+			if(Handle.m_pRing)
+				Handle.m_pRing->m_Released.store(true, std::memory_order_release);
+			Handle.m_pRing = std::make_shared<CLogRing>();
+			Handle.m_LoggerId = m_Id;
+			const CLockScope LockScope(m_RingsLock);
+			m_vpRings.push_back(Handle.m_pRing);
+			m_RingsChanged.store(true, std::memory_order_release);
+		}
+		return Handle.m_pRing.get();
+	}
+
+	CLogRecord *InitRecord(CLogRing *pRing, uint8_t Type, LEVEL Level, bool HaveColor, LOG_COLOR Color, const char *pSystem)
+	{
+		CLogRecord *pRecord = (CLogRecord *)pRing->m_aStaging;
+		pRecord->m_Type = Type;
+		pRecord->m_Level = Level;
+		pRecord->m_HaveColor = HaveColor;
+		pRecord->m_Color = Color;
+		pRecord->m_Sequence = m_NextSequence.fetch_add(1, std::memory_order_relaxed);
+		pRecord->m_Time = time(nullptr);
+		str_copy(pRecord->m_aSystem, pSystem);
+		return pRecord;
+	}
+
+	bool Push(CLogRing *pRing, int Size)
+	{
+		Size = (Size + 7) & ~7;
+		((CLogRecord *)pRing->m_aStaging)->m_Size = Size;
+
+		uint64_t WritePos = pRing->m_WritePos.load(std::memory_order_relaxed);
+		const int Contiguous = CLogRing::SIZE - WritePos % CLogRing::SIZE;
+		const int Needed = Size <= Contiguous ? Size : Contiguous + Size;
+		while(CLogRing::SIZE - (WritePos - pRing->m_ReadPos.load(std::memory_order_acquire)) < (uint64_t)Needed)
+		{
+			// the logger thread is too slow, wait for it
+			if(m_Stopping.load(std::memory_order_relaxed))
+				return false;
+			Wake();
+			thread_yield();
+		}
+		if(Size > Contiguous)
+		{
+			CLogRecord *pPadding = (CLogRecord *)&pRing->m_aData[WritePos % CLogRing::SIZE];
+			pPadding->m_Size = Contiguous;
+			pPadding->m_Type = CLogRecord::TYPE_PADDING;
+			WritePos += Contiguous;
+		}
+		mem_copy(&pRing->m_aData[WritePos % CLogRing::SIZE], pRing->m_aStaging, Size);
+		pRing->m_WritePos.store(WritePos + Size, std::memory_order_seq_cst);
+		Wake();
+		return true;
+	}
+
+	void Wake()
+	{
+		if(m_Waiting.load(std::memory_order_seq_cst) && m_Waiting.exchange(false, std::memory_order_seq_cst))
+			sphore_signal(&m_Semaphore);
+	}
+
+	void OutputRecord(const CLogRecord *pRecord)
+	{
+		if(pRecord->m_Type == CLogRecord::TYPE_FORMATTED)
+		{
+			CLogMessage Msg;
+			mem_copy(&Msg, pRecord + 1, sizeof(Msg));
+			m_pLogger->Log(&Msg);
+			return;
+		}
+
+		if(pRecord->m_Time != m_LastTime)
+		{
+			str_timestamp_ex(pRecord->m_Time, m_aLastTimestamp, sizeof(m_aLastTimestamp), FORMAT_SPACE);
+			m_LastTime = pRecord->m_Time;
+		}
+		CLogMessage Msg;
+		log_message_init(&Msg, pRecord->m_Level, pRecord->m_HaveColor, pRecord->m_Color, pRecord->m_aSystem, m_aLastTimestamp);
+		log_format_args((const unsigned char *)(pRecord + 1), Msg.m_aLine + Msg.m_LineMessageOffset, sizeof(Msg.m_aLine) - Msg.m_LineMessageOffset);
+		Msg.m_LineLength = str_length(Msg.m_aLine);
+		m_pLogger->Log(&Msg);
+	}
+
+	// Outputs all queued messages in the order they were logged in. Returns
+	// whether there were any.
+	bool Drain() REQUIRES(!m_RingsLock)
+	{
+		if(m_RingsChanged.exchange(false, std::memory_order_acquire))
+		{
+			const CLockScope LockScope(m_RingsLock);
+			m_vpThreadRings = m_vpRings;
+		}
+
+		bool Output = false;
+		while(true)
+		{
+			CLogRing *pNextRing = nullptr;
+			const CLogRecord *pNext = nullptr;
+			for(const auto &pRing : m_vpThreadRings)
+			{
+				const CLogRecord *pRecord = pRing->Peek();
+				if(pRecord && (!pNext || pRecord->m_Sequence < pNext->m_Sequence))
+				{
+					pNextRing = pRing.get();
+					pNext = pRecord;
+				}
+			}
+			if(!pNext)
+				break;
+			OutputRecord(pNext);
+			pNextRing->Pop(pNext);
+			Output = true;
+		}
+
+		for(const auto &pRing : m_vpThreadRings)
+		{
+			if(pRing->m_Released.load(std::memory_order_acquire) && !pRing->Peek())
+			{
+				const CLockScope LockScope(m_RingsLock);
+				m_vpRings.erase(std::remove_if(m_vpRings.begin(), m_vpRings.end(), [](const std::shared_ptr<CLogRing> &pOther) {
+					return pOther->m_Released.load(std::memory_order_acquire) && !pOther->Peek();
+				}),
+					m_vpRings.end());
+				m_vpThreadRings = m_vpRings;
+				break;
+			}
+		}
+		return Output;
+	}
+
+	bool Empty()
+	{
+		for(const auto &pRing : m_vpThreadRings)
+			if(pRing->m_ReadPos.load(std::memory_order_relaxed) != pRing->m_WritePos.load(std::memory_order_seq_cst))
+				return false;
+		return !m_RingsChanged.load(std::memory_order_seq_cst);
+	}
+
+	static void ThreadFunc(void *pUser)
+	{
+		log_in_deferred_thread = true;
+		CLoggerDeferred *pThis = static_cast<CLoggerDeferred *>(pUser);
+		while(true)
+		{
+			const bool Stopping = pThis->m_Stopping.load(std::memory_order_acquire);
+			const bool Output = pThis->Drain();
+			if(Stopping)
+				break;
+			if(Output)
+			{
+				// collect messages for a moment instead of being woken up for each one
+				std::this_thread::sleep_for(BATCH_INTERVAL);
+				continue;
+			}
+			pThis->m_Waiting.store(true, std::memory_order_seq_cst);
+			if(pThis->Empty() && !pThis->m_Stopping.load(std::memory_order_acquire))
+				sphore_wait(&pThis->m_Semaphore);
+			pThis->m_Waiting.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	void Stop() REQUIRES(!m_RingsLock)
+	{
+		if(m_Stopping.exchange(true, std::memory_order_acq_rel))
+			return;
+		sphore_signal(&m_Semaphore);
+		thread_wait(m_pThread);
+		// messages of threads which were logging while stopping
+		Drain();
+	}
+
+public:
+	CLoggerDeferred(std::unique_ptr<ILogger> &&pLogger) :
+		m_pLogger(std::move(pLogger))
+	{
+		static std::atomic_int s_NextId{0};
+		m_Id = s_NextId.fetch_add(1, std::memory_order_relaxed);
+		m_Filter.m_MaxLevel.store(LEVEL_TRACE, std::memory_order_relaxed);
+		sphore_init(&m_Semaphore);
+		m_pThread = thread_init(ThreadFunc, this, "logger");
+	}
+	~CLoggerDeferred() override
+	{
+		Stop();
+		sphore_destroy(&m_Semaphore);
+	}
+
+	bool LogDeferred(LEVEL Level, bool HaveColor, LOG_COLOR Color, const char *pSystem, const char *pFormat, va_list Args) override
+	{
+		if(Level > m_Filter.m_MaxLevel.load(std::memory_order_relaxed))
+			return true;
+		CLogRing *pRing = ThreadRing();
+		if(!pRing)
+			return false;
+		CLogRecord *pRecord = InitRecord(pRing, CLogRecord::TYPE_DEFERRED, Level, HaveColor, Color, pSystem);
+		CLogArgsWriter Writer{pRing->m_aStaging + sizeof(CLogRecord), CLogRing::MAX_RECORD_SIZE - (int)sizeof(CLogRecord)};
+		if(!log_capture_args(pFormat, Args, &Writer))
+			return false;
+		return Push(pRing, sizeof(*pRecord) + Writer.m_Used);
+	}
+	void Log(const CLogMessage *pMessage) override
+	{
+		if(m_Filter.Filters(pMessage))
+			return;
+		// keep the order with the deferred messages of this thread
+		CLogRing *pRing = ThreadRing();
+		if(pRing)
+		{
+			static_assert(sizeof(CLogRecord) + sizeof(CLogMessage) <= CLogRing::MAX_RECORD_SIZE);
+			CLogRecord *pRecord = InitRecord(pRing, CLogRecord::TYPE_FORMATTED, pMessage->m_Level, pMessage->m_HaveColor, pMessage->m_Color, pMessage->m_aSystem);
+			mem_copy(pRecord + 1, pMessage, sizeof(*pMessage));
+			if(Push(pRing, sizeof(*pRecord) + sizeof(*pMessage)))
+				return;
+		}
+		m_pLogger->Log(pMessage);
+	}
+	void GlobalFinish() override
+	{
+		if(!log_in_deferred_thread)
+			Stop();
+		else
+			m_Stopping.store(true, std::memory_order_release);
+		m_pLogger->GlobalFinish();
+	}
+};
+
+std::unique_ptr<ILogger> log_logger_deferred(std::unique_ptr<ILogger> &&pLogger)
+{
+	return std::make_unique<CLoggerDeferred>(std::move(pLogger));
+}
+
 #ifdef __GNUC__
 // atomic_compare_exchange_strong_explicit is deprecated
 #pragma GCC diagnostic push
@@ -5,6 +5,7 @@
 #include "log.h"
 
 #include <atomic>
+#include <cstdarg>
 #include <memory>
 #include <string>
 #include <vector>
@@ -88,6 +89,16 @@ public:
 	 * @param pMessage Struct describing the log message.
 	 */
 	virtual void Log(const CLogMessage *pMessage) = 0;
+	/**
+	 * Takes a log message before it is formatted, so the logger can format
+	 * it later on another thread.
+	 *
+	 * The arguments must not be consumed, use `va_copy`.
+	 *
+	 * @return `false` if the message should be formatted and passed to
+	 * `Log` instead.
+	 */
+	virtual bool LogDeferred(LEVEL Level, bool HaveColor, LOG_COLOR Color, const char *pSystem, const char *pFormat, va_list Args) { return false; }
 	/**
 	 * Flushes output buffers and shuts down.
 	 * Global loggers cannot be destroyed because they might be accessed
@@ -218,6 +229,22 @@ std::unique_ptr<ILogger> log_logger_windows_debugger();
  */
 std::unique_ptr<ILogger> log_logger_noop();
 
+/**
+ * @ingroup Log
+ *
+ * Logger which moves formatting and output to a separate thread.
+ *
+ * Each logging thread copies the format string, the arguments and the
+ * metadata of its messages into its own lock-free ring buffer. The logger
+ * thread formats the messages in order and passes them to the given logger.
+ * Messages with format strings that cannot be copied this way, like
+ * positional arguments, are formatted on the calling thread.
+ *
+ * @param pLogger The logger receiving the formatted messages, it must be
+ * thread-safe.
+ */
+std::unique_ptr<ILogger> log_logger_deferred(std::unique_ptr<ILogger> &&pLogger);
+
 /**
  * @ingroup Log
  *
@@ -27,6 +27,7 @@
 #endif
 
 #if defined(CONF_FAMILY_UNIX)
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/utsname.h>
@@ -316,6 +317,51 @@ int io_flush(IOHANDLE io)
 	return fflush((FILE *)io);
 }
 
+bool io_map(IOHANDLE io, void **result, unsigned *result_len)
+{
+	*result = nullptr;
+	*result_len = 0;
+
+	constexpr int64_t MAX_FILE_SIZE = (int64_t)1024 * 1024 * 1024;
+	const int64_t len = io_length(io);
+	if(len <= 0 || len > MAX_FILE_SIZE)
+	{
+		return false;
+	}
+
+#if defined(CONF_FAMILY_WINDOWS)
+	HANDLE mapping = CreateFileMappingW((HANDLE)_get_osfhandle(_fileno((FILE *)io)), nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(mapping == nullptr)
+	{
+		return false;
+	}
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, len);
+	CloseHandle(mapping);
+	if(data == nullptr)
+	{
+		return false;
+	}
+#else
+	void *data = mmap(nullptr, len, PROT_READ, MAP_SHARED, fileno((FILE *)io), 0);
+	if(data == MAP_FAILED)
+	{
+		return false;
+	}
+#endif
+	*result = data;
+	*result_len = len;
+	return true;
+}
+
+void io_unmap(void *data, unsigned len)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#else
+	munmap(data, len);
+#endif
+}
+
 int io_sync(IOHANDLE io)
 {
 	if(io_flush(io))
@@ -633,6 +679,14 @@ int aio_error(ASYNCIO *aio)
 	return aio->error;
 }
 
+unsigned aio_queued(ASYNCIO *aio)
+{
+	CLockScope ls(aio->lock);
+	struct BUFFERS buffers;
+	buffer_ptrs(aio, &buffers);
+	return buffers.len1 + buffers.len2;
+}
+
 void aio_close(ASYNCIO *aio)
 {
 	{
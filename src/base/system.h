@@ -168,6 +168,35 @@ bool io_read_all(IOHANDLE io, void **result, unsigned *result_len);
  */
 char *io_read_all_str(IOHANDLE io);
 
+/**
+ * Maps a whole file read-only into memory.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file to map.
+ * @param result Receives the address of the mapped contents.
+ * @param result_len Receives the file's length.
+ *
+ * @return `true` on success, `false` on failure.
+ *
+ * @remark The pages are backed by the file and shared with every other
+ *         process that maps the same file.
+ * @remark The handle may be closed while the mapping is in use.
+ * @remark Empty files and files larger than 1 GiB cannot be mapped.
+ * @remark The result must be unmapped with @link io_unmap @endlink.
+ */
+bool io_map(IOHANDLE io, void **result, unsigned *result_len);
+
+/**
+ * Unmaps a file that was mapped with @link io_map @endlink.
+ *
+ * @ingroup File-IO
+ *
+ * @param data Address of the mapped contents.
+ * @param len Length of the mapped contents.
+ */
+void io_unmap(void *data, unsigned len);
+
 /**
  * Skips data in a file.
  *
@@ -420,6 +449,17 @@ void aio_write_newline_unlocked(ASYNCIO *aio);
  */
 int aio_error(ASYNCIO *aio);
 
+/**
+ * Returns the number of bytes that are queued but not written yet.
+ *
+ * @ingroup File-IO
+ *
+ * @param aio Handle to the file.
+ *
+ * @return Number of queued bytes.
+ */
+unsigned aio_queued(ASYNCIO *aio);
+
 /**
  * Queues file closing.
  *
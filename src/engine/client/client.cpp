@@ -944,6 +944,11 @@ void CClient::RenderDebug()
 	str_format(aBuffer, sizeof(aBuffer), "Frametime: %4d us", round_to_int(m_FrameTimeAverage * 1000000.0f));
 	Graphics()->QuadsText(20.0f * FontSize, 2 + FontSize, FontSize, aBuffer);
 
+	const STextLayoutCacheStats TextCacheStats = TextRender()->LayoutCacheStats();
+	const int TextCacheLookups = TextCacheStats.m_Hits + TextCacheStats.m_Misses;
+	str_format(aBuffer, sizeof(aBuffer), "Text cache: %4d entries %3d%% hits", TextCacheStats.m_Entries, TextCacheLookups == 0 ? 0 : TextCacheStats.m_Hits * 100 / TextCacheLookups);
+	Graphics()->QuadsText(2, 2 + 2 * FontSize, FontSize, aBuffer);
+
 	str_format(aBuffer, sizeof(aBuffer), "%16s: %" PRIu64 " KiB", "Texture memory", Graphics()->TextureMemoryUsage() / 1024);
 	Graphics()->QuadsText(32.0f * FontSize, 2, FontSize, aBuffer);
 
@@ -3125,6 +3130,7 @@ void CClient::Run()
 	// init text render
 	m_pTextRender = Kernel()->RequestInterface<IEngineTextRender>();
 	m_pTextRender->Init();
+	m_pTextRender->SetLayoutCacheEnabled(g_Config.m_GfxTextLayoutCache != 0);
 
 	// init the input
 	Input()->Init();
@@ -3328,6 +3334,7 @@ void CClient::Run()
 				m_LastRenderTime = Now;
 
 				Render();
+				m_pTextRender->UpdateLayoutCache();
 				m_pGraphics->Swap();
 			}
 			else if(!IsRenderActive)
@@ -4411,6 +4418,26 @@ void CClient::ConchainReplays(IConsole::IResult *pResult, void *pUserData, ICons
 	}
 }
 
+void CClient::ConchainStorageIndex(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	CClient *pSelf = (CClient *)pUserData;
+	pfnCallback(pResult, pCallbackUserData);
+	if(pResult->NumArguments())
+	{
+		pSelf->Storage()->SetIndexEnabled(g_Config.m_StorageIndex != 0);
+	}
+}
+
+void CClient::ConchainTextLayoutCache(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	CClient *pSelf = (CClient *)pUserData;
+	pfnCallback(pResult, pCallbackUserData);
+	if(pResult->NumArguments() && pSelf->m_pTextRender)
+	{
+		pSelf->m_pTextRender->SetLayoutCacheEnabled(g_Config.m_GfxTextLayoutCache != 0);
+	}
+}
+
 void CClient::ConchainInputFifo(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	CClient *pSelf = (CClient *)pUserData;
@@ -4496,6 +4523,8 @@ void CClient::RegisterCommands()
 
 	m_pConsole->Chain("cl_timeout_seed", ConchainTimeoutSeed, this);
 	m_pConsole->Chain("cl_replays", ConchainReplays, this);
+	m_pConsole->Chain("storage_index", ConchainStorageIndex, this);
+	m_pConsole->Chain("gfx_text_layout_cache", ConchainTextLayoutCache, this);
 	m_pConsole->Chain("cl_input_fifo", ConchainInputFifo, this);
 	m_pConsole->Chain("cl_port", ConchainNetReset, this);
 	m_pConsole->Chain("cl_dummy_port", ConchainNetReset, this);
@@ -17,6 +17,9 @@
 #include <chrono>
 #include <cstddef>
 #include <limits>
+#include <list>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -320,6 +323,8 @@ private:
 	uint8_t *m_apTextureData[NUM_FONT_TEXTURES];
 	CAtlas m_TextureAtlas;
 	std::unordered_map<std::tuple<FT_Face, int, int>, SGlyph, SGlyphKeyHash, SGlyphKeyEquals> m_Glyphs;
+	// Incremented whenever the atlas is cleared, which invalidates the UVs of all quads
+	int m_Generation = 0;
 
 	// Font faces
 	FT_Face m_DefaultFace = nullptr;
@@ -701,6 +706,12 @@ public:
 
 		m_TextureAtlas.Clear(m_TextureDimension);
 		m_Glyphs.clear();
+		m_Generation++;
+	}
+
+	int Generation() const
+	{
+		return m_Generation;
 	}
 
 	const SGlyph *GetGlyph(int Chr, int FontSize)
@@ -923,6 +934,72 @@ struct STextContainer
 	}
 };
 
+// everything that influences the layout of a TextEx call, compared bytewise
+struct SLayoutCacheParams
+{
+	int m_Flags;
+	int m_LineCount;
+	int m_GlyphCount;
+	int m_CharCount;
+	int m_MaxLines;
+	float m_StartX;
+	float m_StartY;
+	float m_LineWidth;
+	float m_X;
+	float m_Y;
+	float m_MaxCharacterHeight;
+	float m_LongestLineWidth;
+	float m_FontSize;
+	float m_LineSpacing;
+	unsigned m_RenderFlags;
+	int m_FontPreset;
+	float m_aScreen[4];
+	int m_ScreenWidth;
+	int m_ScreenHeight;
+	float m_aColor[4];
+};
+
+struct SLayoutCacheKey
+{
+	std::string m_Text;
+	SLayoutCacheParams m_Params;
+
+	bool operator==(const SLayoutCacheKey &Other) const
+	{
+		return m_Text == Other.m_Text && mem_comp(&m_Params, &Other.m_Params, sizeof(m_Params)) == 0;
+	}
+};
+
+struct SLayoutCacheKeyHash
+{
+	size_t operator()(const SLayoutCacheKey *pKey) const
+	{
+		const size_t TextHash = std::hash<std::string_view>{}(pKey->m_Text);
+		const size_t ParamsHash = std::hash<std::string_view>{}(std::string_view((const char *)&pKey->m_Params, sizeof(pKey->m_Params)));
+		return TextHash ^ (ParamsHash + 0x9e3779b9 + (TextHash << 6) + (TextHash >> 2));
+	}
+};
+
+struct SLayoutCacheKeyEquals
+{
+	bool operator()(const SLayoutCacheKey *pLhs, const SLayoutCacheKey *pRhs) const
+	{
+		return *pLhs == *pRhs;
+	}
+};
+
+struct SLayoutCacheEntry
+{
+	SLayoutCacheKey m_Key;
+	// cursor state after the layout
+	CTextCursor m_Result;
+	// only created once the text was requested a second time
+	STextContainerIndex m_TextContainer;
+	// the text has no quads, there is nothing to render
+	bool m_Empty = false;
+	int64_t m_LastUsedFrame;
+};
+
 float CTextCursor::Height() const
 {
 	return m_LineCount * (m_AlignedFontSize + m_AlignedLineSpacing);
@@ -977,6 +1054,18 @@ class CTextRender : public IEngineTextRender
 
 	std::chrono::nanoseconds m_CursorRenderTime;
 
+	// laid out text of TextEx calls, most recently used first
+	static constexpr size_t LAYOUT_CACHE_MAX_ENTRIES = 2048;
+	static constexpr int64_t LAYOUT_CACHE_MAX_AGE = 120; // frames
+	std::list<SLayoutCacheEntry> m_LayoutCache;
+	std::unordered_map<const SLayoutCacheKey *, std::list<SLayoutCacheEntry>::iterator, SLayoutCacheKeyHash, SLayoutCacheKeyEquals> m_LayoutCacheIndex;
+	bool m_LayoutCacheEnabled = true;
+	int m_LayoutCacheGeneration = 0;
+	int64_t m_LayoutCacheFrame = 0;
+	STextLayoutCacheStats m_LayoutCacheStats;
+	STextLayoutCacheStats m_LastFrameLayoutCacheStats;
+	EFontPreset m_FontPreset = EFontPreset::DEFAULT_FONT;
+
 	int GetFreeTextContainerIndex()
 	{
 		if(m_FirstFreeTextContainerIndex == -1)
@@ -1023,6 +1112,71 @@ class CTextRender : public IEngineTextRender
 		return *m_vpTextContainers[Index.m_Index];
 	}
 
+	void GetLayoutCacheKey(SLayoutCacheKey &Key, const CTextCursor *pCursor, const char *pText, int Length)
+	{
+		const int TextLength = Length < 0 ? str_length(pText) : minimum(Length, str_length(pText));
+		Key.m_Text.assign(pText, TextLength);
+
+		SLayoutCacheParams &Params = Key.m_Params;
+		mem_zero(&Params, sizeof(Params));
+		Params.m_Flags = pCursor->m_Flags;
+		Params.m_LineCount = pCursor->m_LineCount;
+		Params.m_GlyphCount = pCursor->m_GlyphCount;
+		Params.m_CharCount = pCursor->m_CharCount;
+		Params.m_MaxLines = pCursor->m_MaxLines;
+		Params.m_StartX = pCursor->m_StartX;
+		Params.m_StartY = pCursor->m_StartY;
+		Params.m_LineWidth = pCursor->m_LineWidth;
+		Params.m_X = pCursor->m_X;
+		Params.m_Y = pCursor->m_Y;
+		Params.m_MaxCharacterHeight = pCursor->m_MaxCharacterHeight;
+		Params.m_LongestLineWidth = pCursor->m_LongestLineWidth;
+		Params.m_FontSize = pCursor->m_FontSize;
+		Params.m_LineSpacing = pCursor->m_LineSpacing;
+		Params.m_RenderFlags = m_RenderFlags;
+		Params.m_FontPreset = (int)m_FontPreset;
+		Graphics()->GetScreen(&Params.m_aScreen[0], &Params.m_aScreen[1], &Params.m_aScreen[2], &Params.m_aScreen[3]);
+		Params.m_ScreenWidth = Graphics()->ScreenWidth();
+		Params.m_ScreenHeight = Graphics()->ScreenHeight();
+		Params.m_aColor[0] = m_Color.r;
+		Params.m_aColor[1] = m_Color.g;
+		Params.m_aColor[2] = m_Color.b;
+		Params.m_aColor[3] = m_Color.a;
+	}
+
+	void PopLayoutCacheEntry()
+	{
+		SLayoutCacheEntry &Entry = m_LayoutCache.back();
+		DeleteTextContainer(Entry.m_TextContainer);
+		m_LayoutCacheIndex.erase(&Entry.m_Key);
+		m_LayoutCache.pop_back();
+	}
+
+	void FlushLayoutCache()
+	{
+		while(!m_LayoutCache.empty())
+			PopLayoutCacheEntry();
+	}
+
+	void TextExUncached(CTextCursor *pCursor, const char *pText, int Length)
+	{
+		const unsigned OldRenderFlags = m_RenderFlags;
+		m_RenderFlags |= TEXT_RENDER_FLAG_ONE_TIME_USE;
+		STextContainerIndex TextCont;
+		CreateTextContainer(TextCont, pCursor, pText, Length);
+		m_RenderFlags = OldRenderFlags;
+		if(TextCont.Valid())
+		{
+			if((pCursor->m_Flags & TEXTFLAG_RENDER) != 0)
+			{
+				ColorRGBA TextColor = DefaultTextColor();
+				ColorRGBA TextColorOutline = DefaultTextOutlineColor();
+				RenderTextContainer(TextCont, TextColor, TextColorOutline);
+			}
+			DeleteTextContainer(TextCont);
+		}
+	}
+
 	int WordLength(const char *pText) const
 	{
 		const char *pCursor = pText;
@@ -1150,6 +1304,10 @@ public:
 
 	void Shutdown() override
 	{
+		// the text containers are deleted below
+		m_LayoutCacheIndex.clear();
+		m_LayoutCache.clear();
+
 		for(auto *pTextCont : m_vpTextContainers)
 			delete pTextCont;
 		m_vpTextContainers.clear();
@@ -1330,6 +1488,7 @@ public:
 
 	void SetFontPreset(EFontPreset FontPreset) override
 	{
+		m_FontPreset = FontPreset;
 		m_pGlyphMap->SetFontPreset(FontPreset);
 	}
 
@@ -1440,21 +1599,87 @@ public:
 
 	void TextEx(CTextCursor *pCursor, const char *pText, int Length = -1) override
 	{
-		const unsigned OldRenderFlags = m_RenderFlags;
-		m_RenderFlags |= TEXT_RENDER_FLAG_ONE_TIME_USE;
-		STextContainerIndex TextCont;
-		CreateTextContainer(TextCont, pCursor, pText, Length);
-		m_RenderFlags = OldRenderFlags;
-		if(TextCont.Valid())
+		// selections, cursors and color splits depend on more than the cursor values
+		if(!m_LayoutCacheEnabled ||
+			pCursor->m_CalculateSelectionMode != TEXT_CURSOR_SELECTION_MODE_NONE ||
+			pCursor->m_CursorMode != TEXT_CURSOR_CURSOR_MODE_NONE ||
+			!pCursor->m_vColorSplits.empty())
 		{
-			if((pCursor->m_Flags & TEXTFLAG_RENDER) != 0)
+			TextExUncached(pCursor, pText, Length);
+			return;
+		}
+
+		if(m_LayoutCacheGeneration != m_pGlyphMap->Generation())
+		{
+			FlushLayoutCache();
+			m_LayoutCacheGeneration = m_pGlyphMap->Generation();
+		}
+
+		SLayoutCacheKey Key;
+		GetLayoutCacheKey(Key, pCursor, pText, Length);
+		const auto Found = m_LayoutCacheIndex.find(&Key);
+		if(Found == m_LayoutCacheIndex.end())
+		{
+			m_LayoutCacheStats.m_Misses++;
+			TextExUncached(pCursor, pText, Length);
+
+			if(m_LayoutCache.size() >= LAYOUT_CACHE_MAX_ENTRIES)
+				PopLayoutCacheEntry();
+			SLayoutCacheEntry &Entry = m_LayoutCache.emplace_front();
+			Entry.m_Key = std::move(Key);
+			Entry.m_Result = *pCursor;
+			Entry.m_LastUsedFrame = m_LayoutCacheFrame;
+			m_LayoutCacheIndex.emplace(&Entry.m_Key, m_LayoutCache.begin());
+			return;
+		}
+
+		m_LayoutCache.splice(m_LayoutCache.begin(), m_LayoutCache, Found->second);
+		SLayoutCacheEntry &Entry = m_LayoutCache.front();
+		Entry.m_LastUsedFrame = m_LayoutCacheFrame;
+
+		if((pCursor->m_Flags & TEXTFLAG_RENDER) != 0)
+		{
+			// only keep the quads of text that is drawn repeatedly
+			if(!Entry.m_TextContainer.Valid() && !Entry.m_Empty)
 			{
-				ColorRGBA TextColor = DefaultTextColor();
-				ColorRGBA TextColorOutline = DefaultTextOutlineColor();
-				RenderTextContainer(TextCont, TextColor, TextColorOutline);
+				m_LayoutCacheStats.m_Misses++;
+				Entry.m_Empty = !CreateTextContainer(Entry.m_TextContainer, pCursor, pText, Length);
 			}
-			DeleteTextContainer(TextCont);
+			else
+			{
+				m_LayoutCacheStats.m_Hits++;
+			}
+			if(Entry.m_TextContainer.Valid())
+				RenderTextContainer(Entry.m_TextContainer, DefaultTextColor(), DefaultTextOutlineColor());
+		}
+		else
+		{
+			m_LayoutCacheStats.m_Hits++;
 		}
+		*pCursor = Entry.m_Result;
+	}
+
+	void SetLayoutCacheEnabled(bool Enabled) override
+	{
+		m_LayoutCacheEnabled = Enabled;
+		if(!Enabled)
+			FlushLayoutCache();
+	}
+
+	void UpdateLayoutCache() override
+	{
+		m_LayoutCacheFrame++;
+		while(!m_LayoutCache.empty() && m_LayoutCacheFrame - m_LayoutCache.back().m_LastUsedFrame > LAYOUT_CACHE_MAX_AGE)
+			PopLayoutCacheEntry();
+
+		m_LastFrameLayoutCacheStats = m_LayoutCacheStats;
+		m_LastFrameLayoutCacheStats.m_Entries = (int)m_LayoutCache.size();
+		m_LayoutCacheStats = {};
+	}
+
+	STextLayoutCacheStats LayoutCacheStats() const override
+	{
+		return m_LastFrameLayoutCacheStats;
 	}
 
 	bool CreateTextContainer(STextContainerIndex &TextContainerIndex, CTextCursor *pCursor, const char *pText, int Length = -1) override
@@ -2313,6 +2538,8 @@ public:
 
 	void OnPreWindowResize() override
 	{
+		FlushLayoutCache();
+
 		for(auto *pTextContainer : m_vpTextContainers)
 		{
 			if(pTextContainer->m_ContainerIndex.Valid() && pTextContainer->m_ContainerIndex.m_UseCount.use_count() <= 1)
@@ -13,6 +13,8 @@ enum
 	MAX_MAP_LENGTH = 128
 };
 
+class CDataFileReader;
+
 class IMap : public IInterface
 {
 	MACRO_INTERFACE("map")
@@ -37,6 +39,8 @@ class IEngineMap : public IMap
 	MACRO_INTERFACE("enginemap")
 public:
 	[[nodiscard]] virtual bool Load(const char *pMapName, int StorageType) = 0;
+	// replaces the loaded map with a datafile that was already opened and checked
+	virtual void Load(CDataFileReader &&DataFile) = 0;
 	virtual void Unload() = 0;
 	virtual bool IsLoaded() const = 0;
 	virtual IOHANDLE File() const = 0;
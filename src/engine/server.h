@@ -22,6 +22,8 @@
 #include <type_traits>
 
 struct CAntibotRoundData;
+class CMetrics;
+class CProfiler;
 
 // When recording a demo on the server, the ClientId -1 is used
 enum
@@ -246,6 +248,19 @@ public:
 
 	virtual void SnapSetStaticsize(int ItemType, int Size) = 0;
 
+	// Snapshots that are too large leave out the items with the lowest
+	// priorities first. Items are never left out unless a priority is set.
+	// The items added after one call are left out together, so an entity
+	// sets its priority once before it snaps all of its items.
+	enum
+	{
+		SNAP_PRIORITY_REQUIRED = 0x7fffffff,
+	};
+	virtual void SnapSetPriority(int Priority) = 0;
+	// The following items only have to be updated every this many ticks,
+	// the client keeps the data of their last update in between.
+	virtual void SnapSetUpdatePeriod(int Ticks) = 0;
+
 	enum
 	{
 		RCON_CID_SERV = -1,
@@ -262,6 +277,8 @@ public:
 	virtual void RedirectClient(int ClientId, int Port) = 0;
 	virtual void ChangeMap(const char *pMap) = 0;
 	virtual void ReloadMap() = 0;
+	// starts loading a map in the background that is likely to be changed to soon
+	virtual void PreloadMap(const char *pMapName) = 0;
 
 	virtual void DemoRecorder_HandleAutoStart() = 0;
 
@@ -295,6 +312,11 @@ public:
 	virtual const char *GetMapName() const = 0;
 
 	virtual bool IsSixup(int ClientId) const = 0;
+
+	// per-phase timings of the server frame, see `profile_dump`
+	virtual CProfiler *Profiler() = 0;
+	// counters, gauges and histograms served at `sv_metrics_port`
+	virtual CMetrics *Metrics() = 0;
 };
 
 class IGameServer : public IInterface
@@ -4,6 +4,7 @@
 
 #include <base/system.h>
 #include <base/thread.h>
+#include <base/time.h>
 
 #include <engine/console.h>
 #include <engine/shared/config.h>
@@ -121,25 +122,28 @@ CSqlExecData::CSqlExecData(IConsole *pConsole, CDbConnectionPool::Mode m) :
 	m_Ptr.m_Print.m_Mode = m;
 }
 
-void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
+void CDbConnectionPool::AddQuery(std::unique_ptr<CSqlExecData> pQuery)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pConsole, DatabaseMode);
+	m_pShared->m_aQueries[m_InsertIdx++] = std::move(pQuery);
 	m_InsertIdx %= std::size(m_pShared->m_aQueries);
+	if(m_pShared->m_pQueueLength)
+		m_pShared->m_pQueueLength->Add(1);
 	m_pShared->m_NumBackup.Signal();
 }
 
+void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
+{
+	AddQuery(std::make_unique<CSqlExecData>(pConsole, DatabaseMode));
+}
+
 void CDbConnectionPool::RegisterSqliteDatabase(Mode DatabaseMode, const char aFilename[64])
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, aFilename);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	AddQuery(std::make_unique<CSqlExecData>(DatabaseMode, aFilename));
 }
 
 void CDbConnectionPool::RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	AddQuery(std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig));
 }
 
 void CDbConnectionPool::Execute(
@@ -147,9 +151,7 @@ void CDbConnectionPool::Execute(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	AddQuery(std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
 }
 
 void CDbConnectionPool::ExecuteWrite(
@@ -157,9 +159,7 @@ void CDbConnectionPool::ExecuteWrite(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	AddQuery(std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
 }
 
 void CDbConnectionPool::OnShutdown()
@@ -302,6 +302,7 @@ void CWorker::ProcessQueries()
 			m_pShared->m_Shutdown.store(false);
 			return;
 		}
+		const std::chrono::nanoseconds StartTime = time_get_nanoseconds();
 		bool Success = false;
 		switch(pThreadData->m_Mode)
 		{
@@ -409,6 +410,16 @@ void CWorker::ProcessQueries()
 		}
 		if(!Success)
 			dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pThreadData->m_pName);
+		if(m_pShared->m_pQueueLength)
+		{
+			m_pShared->m_pQueueLength->Add(-1);
+			if(pThreadData->m_Mode == CSqlExecData::READ_ACCESS || pThreadData->m_Mode == CSqlExecData::WRITE_ACCESS)
+			{
+				m_pShared->m_pQueryDuration->Observe(std::chrono::duration<double>(time_get_nanoseconds() - StartTime).count());
+				if(!Success)
+					m_pShared->m_pFailedQueries->Add();
+			}
+		}
 		if(pThreadData->m_pThreadData != nullptr && pThreadData->m_pThreadData->m_pResult != nullptr)
 		{
 			pThreadData->m_pThreadData->m_pResult->m_Success = Success;
@@ -476,9 +487,15 @@ bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pD
 	return Success;
 }
 
-CDbConnectionPool::CDbConnectionPool()
+CDbConnectionPool::CDbConnectionPool(CMetrics *pMetrics)
 {
 	m_pShared = std::make_shared<CSharedData>();
+	if(pMetrics)
+	{
+		m_pShared->m_pQueueLength = pMetrics->Gauge("ddnet_sql_queue_length", "Database queries and commands waiting for or in execution");
+		m_pShared->m_pQueryDuration = pMetrics->Histogram("ddnet_sql_query_duration_seconds", "Time to execute a database query, including the connection", {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5});
+		m_pShared->m_pFailedQueries = pMetrics->Counter("ddnet_sql_failed_queries_total", "Database queries that failed on all databases");
+	}
 	m_pWorkerThread = thread_init(CWorker::Start, new CWorker(m_pShared, g_Config.m_DbgSql), "database worker thread");
 	m_pBackupThread = thread_init(CBackup::Start, new CBackup(m_pShared, g_Config.m_DbgSql), "database backup worker thread");
 }
@@ -3,6 +3,8 @@
 
 #include <base/tl/threading.h>
 
+#include <engine/shared/metrics.h>
+
 #include <atomic>
 #include <memory>
 #include <vector>
@@ -61,7 +63,9 @@ struct CMysqlConfig
 class CDbConnectionPool
 {
 public:
-	CDbConnectionPool();
+	// registers the queue length, duration and failures of the queries if
+	// `pMetrics` is set
+	CDbConnectionPool(CMetrics *pMetrics = nullptr);
 	~CDbConnectionPool();
 	CDbConnectionPool &operator=(const CDbConnectionPool &) = delete;
 
@@ -100,6 +104,7 @@ public:
 
 private:
 	static bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, Write w);
+	void AddQuery(std::unique_ptr<struct CSqlExecData> pQuery);
 
 	// Only the main thread accesses this variable. It points to the index,
 	// where the next query is added to the queue.
@@ -124,6 +129,11 @@ private:
 
 		// spsc queue with additional backup worker to look at queries first.
 		std::unique_ptr<struct CSqlExecData> m_aQueries[512];
+
+		// only set if metrics are enabled, before the threads are started
+		CMetrics::CGauge *m_pQueueLength = nullptr;
+		CMetrics::CHistogram *m_pQueryDuration = nullptr;
+		CMetrics::CCounter *m_pFailedQueries = nullptr;
 	};
 
 	std::shared_ptr<CSharedData> m_pShared;
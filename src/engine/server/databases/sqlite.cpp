@@ -1,4 +1,5 @@
 #include "connection.h"
+#include "statement_cache.h"
 
 #include <base/math.h>
 
@@ -7,6 +8,7 @@
 #include <sqlite3.h>
 
 #include <atomic>
+#include <memory>
 
 class CSqliteConnection : public IDbConnection
 {
@@ -58,12 +60,20 @@ public:
 	bool CreateFailsafeTables();
 
 private:
+	class CStmtDeleter
+	{
+	public:
+		void operator()(sqlite3_stmt *pStmt) const;
+	};
+
 	// copy of config vars
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	bool m_Setup;
 
 	sqlite3 *m_pDb;
+	// owned by m_StmtCache
 	sqlite3_stmt *m_pStmt;
+	CStatementCache<std::unique_ptr<sqlite3_stmt, CStmtDeleter>> m_StmtCache;
 	bool m_Done; // no more rows available for Step
 	// returns false, if the query succeeded
 	bool Execute(const char *pQuery, char *pError, int ErrorSize);
@@ -77,6 +87,11 @@ private:
 	std::atomic_bool m_InUse;
 };
 
+void CSqliteConnection::CStmtDeleter::operator()(sqlite3_stmt *pStmt) const
+{
+	sqlite3_finalize(pStmt);
+}
+
 CSqliteConnection::CSqliteConnection(const char *pFilename, bool Setup) :
 	IDbConnection("record"),
 	m_Setup(Setup),
@@ -90,8 +105,8 @@ CSqliteConnection::CSqliteConnection(const char *pFilename, bool Setup) :
 
 CSqliteConnection::~CSqliteConnection()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+	m_pStmt = nullptr;
+	m_StmtCache.Clear();
 	sqlite3_close(m_pDb);
 	m_pDb = nullptr;
 }
@@ -103,6 +118,7 @@ void CSqliteConnection::Print(IConsole *pConsole, const char *pMode)
 		"SQLite-%s: DB: '%s'",
 		pMode, m_aFilename);
 	pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	m_StmtCache.Print(pConsole);
 }
 
 void CSqliteConnection::ToUnixTimestamp(const char *pTimestamp, char *aBuf, unsigned int BufferSize)
@@ -183,8 +199,9 @@ bool CSqliteConnection::ConnectImpl(char *pError, int ErrorSize)
 
 void CSqliteConnection::Disconnect()
 {
+	// keep the statement cached, but release its locks
 	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+		sqlite3_reset(m_pStmt);
 	m_pStmt = nullptr;
 	m_InUse.store(false);
 }
@@ -192,18 +209,31 @@ void CSqliteConnection::Disconnect()
 bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
 {
 	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+		sqlite3_reset(m_pStmt);
 	m_pStmt = nullptr;
+
+	if(auto *pCached = m_StmtCache.Find(pStmt))
+	{
+		m_pStmt = pCached->get();
+		sqlite3_clear_bindings(m_pStmt);
+		m_Done = false;
+		return true;
+	}
+
+	sqlite3_stmt *pNewStmt = nullptr;
+	std::chrono::nanoseconds StartTime = time_get_nanoseconds();
 	int Result = sqlite3_prepare_v2(
 		m_pDb,
 		pStmt,
 		-1, // pStmt can be any length
-		&m_pStmt,
+		&pNewStmt,
 		nullptr);
 	if(FormatError(Result, pError, ErrorSize))
 	{
+		sqlite3_finalize(pNewStmt);
 		return false;
 	}
+	m_pStmt = m_StmtCache.Insert(pStmt, std::unique_ptr<sqlite3_stmt, CStmtDeleter>(pNewStmt), time_get_nanoseconds() - StartTime)->get();
 	m_Done = false;
 	return true;
 }
@@ -0,0 +1,109 @@
+#ifndef ENGINE_SERVER_DATABASES_STATEMENT_CACHE_H
+#define ENGINE_SERVER_DATABASES_STATEMENT_CACHE_H
+
+#include <base/system.h>
+
+#include <engine/console.h>
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+// LRU cache of prepared statements keyed by their SQL text, used by the
+// database connections to avoid preparing the same query over and over.
+//
+// `TStatement` owns the prepared statement, e.g. a `std::unique_ptr` with a
+// deleter that finalizes it. Not thread-safe, each connection is only used by
+// one worker thread at a time.
+template<typename TStatement>
+class CStatementCache
+{
+public:
+	enum
+	{
+		DEFAULT_CAPACITY = 64,
+	};
+
+	explicit CStatementCache(int Capacity = DEFAULT_CAPACITY) :
+		m_Capacity(Capacity)
+	{
+	}
+
+	// returns nullptr if the query isn't cached yet
+	TStatement *Find(const char *pQuery)
+	{
+		auto It = m_Index.find(pQuery);
+		if(It == m_Index.end())
+		{
+			m_Misses++;
+			return nullptr;
+		}
+		m_Hits++;
+		It->second->m_Hits++;
+		m_UsageList.splice(m_UsageList.begin(), m_UsageList, It->second);
+		return &It->second->m_Statement;
+	}
+
+	// takes ownership of the statement, evicting the least recently used one if necessary
+	TStatement *Insert(const char *pQuery, TStatement Statement, std::chrono::nanoseconds PrepareTime)
+	{
+		if((int)m_UsageList.size() >= m_Capacity)
+		{
+			m_Index.erase(m_UsageList.back().m_Query);
+			m_UsageList.pop_back();
+			m_Evictions++;
+		}
+		m_UsageList.emplace_front(pQuery, std::move(Statement), PrepareTime);
+		m_Index[m_UsageList.front().m_Query] = m_UsageList.begin();
+		return &m_UsageList.front().m_Statement;
+	}
+
+	// drops all statements, e.g. because the connection was reestablished
+	void Clear()
+	{
+		m_Index.clear();
+		m_UsageList.clear();
+		m_Resets++;
+	}
+
+	void Print(IConsole *pConsole) const
+	{
+		char aBuf[512];
+		str_format(aBuf, sizeof(aBuf), "  statement cache: %d/%d statements, %" PRId64 " hits, %" PRId64 " misses, %" PRId64 " evictions, %" PRId64 " resets",
+			(int)m_UsageList.size(), m_Capacity, m_Hits, m_Misses, m_Evictions, m_Resets);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+		for(const auto &Entry : m_UsageList)
+		{
+			str_format(aBuf, sizeof(aBuf), "    %" PRId64 " hits, prepared in %.3fms: %s",
+				Entry.m_Hits, Entry.m_PrepareTime.count() / 1000000.0, Entry.m_Query.c_str());
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+		}
+	}
+
+private:
+	struct CEntry
+	{
+		CEntry(const char *pQuery, TStatement Statement, std::chrono::nanoseconds PrepareTime) :
+			m_Query(pQuery), m_Statement(std::move(Statement)), m_PrepareTime(PrepareTime)
+		{
+		}
+
+		std::string m_Query;
+		TStatement m_Statement;
+		std::chrono::nanoseconds m_PrepareTime;
+		int64_t m_Hits = 0;
+	};
+
+	int m_Capacity;
+	std::list<CEntry> m_UsageList;
+	std::unordered_map<std::string, typename std::list<CEntry>::iterator> m_Index;
+
+	int64_t m_Hits = 0;
+	int64_t m_Misses = 0;
+	int64_t m_Evictions = 0;
+	int64_t m_Resets = 0;
+};
+
+#endif // ENGINE_SERVER_DATABASES_STATEMENT_CACHE_H
@@ -0,0 +1,91 @@
+#include "info_rate_limiter.h"
+
+#include <base/math.h>
+#include <base/secure.h>
+#include <base/system.h>
+#include <base/time.h>
+
+#include <algorithm>
+#include <limits>
+
+CInfoRateLimiter::CInfoRateLimiter()
+{
+	// keyed so that colliding address ranges can't be picked from outside
+	secure_random_fill(&m_Seed, sizeof(m_Seed));
+	Clear();
+}
+
+void CInfoRateLimiter::Clear()
+{
+	for(CBucket &Bucket : m_aBuckets)
+	{
+		Bucket.m_Used = false;
+	}
+}
+
+uint64_t CInfoRateLimiter::RangeKey(const NETADDR *pAddr)
+{
+	uint64_t Key = 0;
+	if(pAddr->type & (NETTYPE_IPV6 | NETTYPE_WEBSOCKET_IPV6))
+	{
+		for(int i = 0; i < 8; i++)
+			Key = (Key << 8) | pAddr->ip[i];
+	}
+	else
+	{
+		// IPv4-mapped IPv6 addresses are in ::ffff:0:0/96, so this doesn't
+		// collide with the /64 prefix of any assigned IPv6 range
+		Key = 0xffff000000000000ull | ((uint64_t)pAddr->ip[0] << 16) | ((uint64_t)pAddr->ip[1] << 8) | pAddr->ip[2];
+	}
+	return Key;
+}
+
+bool CInfoRateLimiter::Consume(const NETADDR *pAddr, int RatePerSecond, int64_t Now)
+{
+	const int64_t Freq = time_freq();
+	const int64_t Capacity = (int64_t)RatePerSecond * Freq;
+	const uint64_t Key = RangeKey(pAddr);
+	const uint64_t Hash = (Key ^ m_Seed) * 0x9e3779b97f4a7c15ull;
+	const int Start = (Hash >> 32) % NUM_SLOTS;
+
+	CBucket *pBucket = nullptr;
+	CBucket *pReplace = nullptr;
+	int64_t ReplaceLastUpdate = 0;
+	for(int i = 0; i < NUM_PROBES; i++)
+	{
+		CBucket *pSlot = &m_aBuckets[(Start + i) % NUM_SLOTS];
+		if(pSlot->m_Used && pSlot->m_Key == Key)
+		{
+			pBucket = pSlot;
+			break;
+		}
+		// buckets unused for a second are full again and hold no more state
+		// than a new one, so they are always older than the ones in use
+		const int64_t LastUpdate = pSlot->m_Used ? pSlot->m_LastUpdate : std::numeric_limits<int64_t>::min();
+		if(!pReplace || LastUpdate < ReplaceLastUpdate)
+		{
+			pReplace = pSlot;
+			ReplaceLastUpdate = LastUpdate;
+		}
+	}
+
+	if(!pBucket)
+	{
+		pBucket = pReplace;
+		pBucket->m_Used = true;
+		pBucket->m_Key = Key;
+		pBucket->m_LastUpdate = Now;
+		pBucket->m_Tokens = Capacity;
+	}
+	else
+	{
+		const int64_t Elapsed = std::clamp<int64_t>(Now - pBucket->m_LastUpdate, 0, Freq);
+		pBucket->m_Tokens = minimum(Capacity, pBucket->m_Tokens + Elapsed * RatePerSecond);
+		pBucket->m_LastUpdate = Now;
+	}
+
+	if(pBucket->m_Tokens < Freq)
+		return false;
+	pBucket->m_Tokens -= Freq;
+	return true;
+}
@@ -0,0 +1,49 @@
+#ifndef ENGINE_SERVER_INFO_RATE_LIMITER_H
+#define ENGINE_SERVER_INFO_RATE_LIMITER_H
+
+#include <base/types.h>
+
+#include <cstdint>
+
+// Token buckets for the server info requests of address ranges (/24 for
+// IPv4, /64 for IPv6), so that a single source can't use up the budget of
+// complete server info responses for everyone else.
+//
+// The buckets live in a fixed-size hash table. A bucket that wasn't used for
+// a second is full again and can be reused for another range. When all slots
+// a range can hash to are in use, the least recently used one is replaced.
+class CInfoRateLimiter
+{
+public:
+	enum
+	{
+		NUM_SLOTS = 4096,
+		NUM_PROBES = 8,
+	};
+
+	CInfoRateLimiter();
+
+	// Takes a token from the bucket of the address range of the given address.
+	// Returns false if the bucket is empty. The buckets hold up to
+	// `RatePerSecond` tokens and are refilled at that rate.
+	bool Consume(const NETADDR *pAddr, int RatePerSecond, int64_t Now);
+	void Clear();
+
+private:
+	class CBucket
+	{
+	public:
+		bool m_Used;
+		uint64_t m_Key;
+		int64_t m_LastUpdate;
+		// in 1/time_freq() tokens
+		int64_t m_Tokens;
+	};
+
+	static uint64_t RangeKey(const NETADDR *pAddr);
+
+	uint64_t m_Seed;
+	CBucket m_aBuckets[NUM_SLOTS];
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "input_buffer.h"
+
+#include <base/math.h>
+#include <base/system.h>
+
+#include <algorithm>
+#include <cmath>
+
+// weight of a new sample in the smoothed margin, like the interarrival jitter of RFC 3550
+static constexpr float MARGIN_SMOOTHING = 1.0f / 16.0f;
+
+CInputBuffer::CInputBuffer()
+{
+	Reset();
+}
+
+void CInputBuffer::Reset()
+{
+	for(auto &Slot : m_aSlots)
+		Slot.m_GameTick = -1;
+	mem_zero(&m_Stats, sizeof(m_Stats));
+}
+
+int CInputBuffer::Add(const int *pData, int NumInts, int IntendedTick, int CurrentTick, int Margin)
+{
+	if(m_Stats.m_NumInputs == 0)
+		m_Stats.m_MarginAvg = Margin;
+	const float Deviation = Margin - m_Stats.m_MarginAvg;
+	m_Stats.m_MarginAvg += Deviation * MARGIN_SMOOTHING;
+	m_Stats.m_MarginJitter += (std::fabs(Deviation) - m_Stats.m_MarginJitter) * MARGIN_SMOOTHING;
+	m_Stats.m_NumInputs++;
+
+	if(IntendedTick <= CurrentTick)
+	{
+		IntendedTick = CurrentTick + 1;
+		m_Stats.m_NumLate++;
+	}
+	else if(IntendedTick - CurrentTick >= NUM_SLOTS)
+	{
+		// would overwrite the slot of an upcoming tick
+		m_Stats.m_NumTooEarly++;
+		return IntendedTick;
+	}
+
+	CSlot &Slot = m_aSlots[IntendedTick % NUM_SLOTS];
+	if(Slot.m_GameTick == IntendedTick)
+	{
+		m_Stats.m_NumDuplicate++;
+		return IntendedTick;
+	}
+
+	NumInts = std::clamp(NumInts, 0, (int)MAX_INPUT_SIZE);
+	Slot.m_GameTick = IntendedTick;
+	mem_copy(Slot.m_aData, pData, NumInts * sizeof(int));
+	mem_zero(Slot.m_aData + NumInts, (MAX_INPUT_SIZE - NumInts) * sizeof(int));
+	return IntendedTick;
+}
+
+const int *CInputBuffer::Get(int GameTick) const
+{
+	if(GameTick < 0)
+		return nullptr;
+	const CSlot &Slot = m_aSlots[GameTick % NUM_SLOTS];
+	return Slot.m_GameTick == GameTick ? Slot.m_aData : nullptr;
+}
+
+const int *CInputBuffer::Consume(int GameTick)
+{
+	const int *pData = Get(GameTick);
+	if(!pData)
+		m_Stats.m_NumMissing++;
+	return pData;
+}
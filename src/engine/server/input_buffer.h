@@ -0,0 +1,68 @@
+#ifndef ENGINE_SERVER_INPUT_BUFFER_H
+#define ENGINE_SERVER_INPUT_BUFFER_H
+
+#include <engine/shared/protocol.h>
+
+// The inputs of a client for the upcoming ticks, indexed by game tick.
+//
+// Every tick has a fixed slot (`GameTick % NUM_SLOTS`), so the input of a
+// tick is found without searching. The first input for a tick wins, later
+// ones for the same tick are counted as duplicates. Inputs arriving after
+// their tick has started are moved to the next tick and counted as late.
+//
+// Also keeps statistics about how long before their tick the inputs arrive,
+// to spot bad connections.
+class CInputBuffer
+{
+public:
+	enum
+	{
+		NUM_SLOTS = 200,
+	};
+
+	class CStats
+	{
+	public:
+		int m_NumInputs;
+		int m_NumLate;
+		int m_NumDuplicate;
+		int m_NumTooEarly;
+		// ticks in which there was no input
+		int m_NumMissing;
+		// smoothed time in milliseconds between the arrival of an input and
+		// the start of its tick, negative for late inputs
+		float m_MarginAvg;
+		// smoothed deviation of the margin
+		float m_MarginJitter;
+
+		int LatePercent() const { return m_NumInputs > 0 ? m_NumLate * 100 / m_NumInputs : 0; }
+	};
+
+	CInputBuffer();
+
+	void Reset();
+
+	// Stores the input for the given tick. `NumInts` is the size of the input
+	// data and `Margin` the time in milliseconds until the intended tick
+	// starts. Returns the tick the input will be applied in.
+	int Add(const int *pData, int NumInts, int IntendedTick, int CurrentTick, int Margin);
+	// Returns the input for the given tick or nullptr.
+	const int *Get(int GameTick) const;
+	// Like `Get`, but counts the tick as missing if there is no input.
+	const int *Consume(int GameTick);
+
+	const CStats &Stats() const { return m_Stats; }
+
+private:
+	class CSlot
+	{
+	public:
+		int m_GameTick;
+		int m_aData[MAX_INPUT_SIZE];
+	};
+
+	CSlot m_aSlots[NUM_SLOTS];
+	CStats m_Stats;
+};
+
+#endif
@@ -89,7 +89,8 @@ int main(int argc, const char **argv)
 	vpLoggers.push_back(pFutureConsoleLogger);
 	std::shared_ptr<CFutureLogger> pFutureAssertionLogger = std::make_shared<CFutureLogger>();
 	vpLoggers.push_back(pFutureAssertionLogger);
-	log_set_global_logger(log_logger_collection(std::move(vpLoggers)).release());
+	// format and write log messages on a separate thread, rcon and econ lines are sent from the main thread
+	log_set_global_logger(log_logger_deferred(log_logger_collection(std::move(vpLoggers))).release());
 
 	if(MysqlInit() != 0)
 	{
@@ -0,0 +1,372 @@
+#include "map_cache.h"
+
+#include <base/log.h>
+#include <base/system.h>
+
+#include <engine/storage.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+
+CMapCache::CEntry::~CEntry()
+{
+	if(m_Mapped)
+		io_unmap(m_pData, m_Size);
+	else
+		free(m_pData);
+}
+
+void CMapCache::SetBudget(int64_t Bytes)
+{
+	const CLockScope LockScope(m_Lock);
+	m_Budget = Bytes;
+	while(m_NumBytes > m_Budget && !m_vpEntries.empty())
+	{
+		m_NumBytes -= m_vpEntries.front()->m_Size;
+		m_vpEntries.erase(m_vpEntries.begin());
+	}
+}
+
+void CMapCache::SetDirectory(const char *pDirectory)
+{
+	const CLockScope LockScope(m_Lock);
+	m_Directory = pDirectory;
+	if(!m_Directory.empty() && fs_makedir(m_Directory.c_str()) != 0)
+	{
+		log_error("map_cache", "failed to create cache directory '%s'", m_Directory.c_str());
+		m_Directory.clear();
+	}
+}
+
+int CMapCache::NumEntries() const
+{
+	const CLockScope LockScope(m_Lock);
+	return m_vpEntries.size();
+}
+
+int64_t CMapCache::NumBytes() const
+{
+	const CLockScope LockScope(m_Lock);
+	return m_NumBytes;
+}
+
+int64_t CMapCache::NumHits() const
+{
+	const CLockScope LockScope(m_Lock);
+	return m_NumHits;
+}
+
+int64_t CMapCache::NumMisses() const
+{
+	const CLockScope LockScope(m_Lock);
+	return m_NumMisses;
+}
+
+void CMapCache::IndexPath(const char *pDirectory, const char *pKey, char *pPath, int PathSize)
+{
+	char aKeyHash[SHA256_MAXSTRSIZE];
+	sha256_str(sha256(pKey, str_length(pKey)), aKeyHash, sizeof(aKeyHash));
+	str_format(pPath, PathSize, "%s/%s.idx", pDirectory, aKeyHash);
+}
+
+void CMapCache::DataPath(const char *pDirectory, const SHA256_DIGEST &Sha256, char *pPath, int PathSize)
+{
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(Sha256, aSha256, sizeof(aSha256));
+	str_format(pPath, PathSize, "%s/%s.map", pDirectory, aSha256);
+}
+
+// unique per process and call, for the temporary files
+static void TmpPath(const char *pPath, char *pTmpPath, int TmpPathSize)
+{
+	static std::atomic<int> s_Counter = 0;
+	str_format(pTmpPath, TmpPathSize, "%s.%d.%d.tmp", pPath, pid(), s_Counter.fetch_add(1));
+}
+
+std::shared_ptr<CMapCache::CEntry> CMapCache::FindLocked(const SHA256_DIGEST &Sha256)
+{
+	auto It = std::find_if(m_vpEntries.begin(), m_vpEntries.end(), [&](const std::shared_ptr<CEntry> &pEntry) {
+		return pEntry->m_Sha256 == Sha256;
+	});
+	if(It == m_vpEntries.end())
+		return nullptr;
+
+	// mark as most recently used
+	std::shared_ptr<CEntry> pEntry = *It;
+	m_vpEntries.erase(It);
+	m_vpEntries.push_back(pEntry);
+	return pEntry;
+}
+
+void CMapCache::InsertLocked(const std::shared_ptr<CEntry> &pEntry)
+{
+	m_vpEntries.push_back(pEntry);
+	m_NumBytes += pEntry->m_Size;
+	// entries that are still in use stay alive until their users release them
+	while(m_NumBytes > m_Budget && m_vpEntries.size() > 1)
+	{
+		m_NumBytes -= m_vpEntries.front()->m_Size;
+		m_vpEntries.erase(m_vpEntries.begin());
+	}
+}
+
+std::shared_ptr<CMapCache::CEntry> CMapCache::LoadFromDirectory(const char *pDirectory, const char *pKey, int64_t Size)
+{
+	char aPath[IO_MAX_PATH_LENGTH];
+	IndexPath(pDirectory, pKey, aPath, sizeof(aPath));
+	IOHANDLE File = io_open(aPath, IOFLAG_READ);
+	if(!File)
+		return nullptr;
+	char *pIndex = io_read_all_str(File);
+	io_close(File);
+	if(!pIndex)
+		return nullptr;
+
+	// "<sha256> <crc>"
+	auto pEntry = std::make_shared<CEntry>();
+	bool Valid = str_length(pIndex) > SHA256_MAXSTRSIZE && pIndex[SHA256_MAXSTRSIZE - 1] == ' ';
+	if(Valid)
+	{
+		char aSha256[SHA256_MAXSTRSIZE];
+		str_truncate(aSha256, sizeof(aSha256), pIndex, SHA256_MAXSTRSIZE - 1);
+		Valid = sha256_from_str(&pEntry->m_Sha256, aSha256) == 0;
+		pEntry->m_Crc = str_toulong_base(pIndex + SHA256_MAXSTRSIZE, 16);
+	}
+	free(pIndex);
+	if(!Valid)
+		return nullptr;
+
+	DataPath(pDirectory, pEntry->m_Sha256, aPath, sizeof(aPath));
+	File = io_open(aPath, IOFLAG_READ);
+	if(!File)
+		return nullptr;
+	void *pData;
+	const bool Mapped = io_length(File) == Size && io_map(File, &pData, &pEntry->m_Size);
+	io_close(File);
+	if(!Mapped)
+		return nullptr;
+	pEntry->m_pData = (unsigned char *)pData;
+	pEntry->m_Mapped = true;
+
+	// never send a damaged or foreign file under the hash of the map
+	if(sha256(pEntry->m_pData, pEntry->m_Size) != pEntry->m_Sha256 || crc32(0, pEntry->m_pData, pEntry->m_Size) != pEntry->m_Crc)
+	{
+		log_error("map_cache", "'%s' doesn't match its hash, removing it", aPath);
+		fs_remove(aPath);
+		return nullptr;
+	}
+	return pEntry;
+}
+
+void CMapCache::StoreInDirectory(const char *pDirectory, const char *pKey, CEntry *pEntry)
+{
+	// write to temporary files first so that other processes never see partial files,
+	// the data before the index that points to it
+	char aPath[IO_MAX_PATH_LENGTH];
+	char aTmpPath[IO_MAX_PATH_LENGTH];
+	DataPath(pDirectory, pEntry->m_Sha256, aPath, sizeof(aPath));
+	if(!fs_is_file(aPath))
+	{
+		TmpPath(aPath, aTmpPath, sizeof(aTmpPath));
+		IOHANDLE File = io_open(aTmpPath, IOFLAG_WRITE);
+		if(!File)
+		{
+			log_error("map_cache", "failed to open '%s' for writing", aTmpPath);
+			return;
+		}
+		const bool Written = io_write(File, pEntry->m_pData, pEntry->m_Size) == pEntry->m_Size;
+		if(io_close(File) != 0 || !Written || fs_rename(aTmpPath, aPath) != 0)
+		{
+			log_error("map_cache", "failed to write '%s'", aPath);
+			fs_remove(aTmpPath);
+			return;
+		}
+	}
+
+	char aIndex[SHA256_MAXSTRSIZE + 16];
+	sha256_str(pEntry->m_Sha256, aIndex, sizeof(aIndex));
+	str_format(aIndex + str_length(aIndex), sizeof(aIndex) - str_length(aIndex), " %08x", pEntry->m_Crc);
+	IndexPath(pDirectory, pKey, aPath, sizeof(aPath));
+	TmpPath(aPath, aTmpPath, sizeof(aTmpPath));
+	IOHANDLE File = io_open(aTmpPath, IOFLAG_WRITE);
+	if(!File)
+		return;
+	io_write(File, aIndex, str_length(aIndex));
+	if(io_close(File) != 0 || fs_rename(aTmpPath, aPath) != 0)
+		fs_remove(aTmpPath);
+
+	// use the shared pages instead of our own copy, if they have the same contents
+	DataPath(pDirectory, pEntry->m_Sha256, aPath, sizeof(aPath));
+	File = io_open(aPath, IOFLAG_READ);
+	if(!File)
+		return;
+	void *pData;
+	unsigned Size;
+	if(io_length(File) == pEntry->m_Size && io_map(File, &pData, &Size))
+	{
+		if(mem_comp(pData, pEntry->m_pData, Size) == 0)
+		{
+			free(pEntry->m_pData);
+			pEntry->m_pData = (unsigned char *)pData;
+			pEntry->m_Mapped = true;
+		}
+		else
+		{
+			io_unmap(pData, Size);
+		}
+	}
+	io_close(File);
+}
+
+void CMapCache::PruneDirectory(const char *pDirectory, int64_t Budget, const SHA256_DIGEST &Keep)
+{
+	class CFile
+	{
+	public:
+		std::string m_Name;
+		time_t m_Modified;
+		int64_t m_Size;
+	};
+	struct SListDir
+	{
+		const char *m_pDirectory;
+		std::vector<CFile> m_vFiles;
+	} ListDir = {pDirectory, {}};
+
+	fs_listdir_fileinfo(
+		pDirectory, [](const CFsFileInfo *pInfo, int IsDir, int DirType, void *pUser) {
+			SListDir *pListDir = static_cast<SListDir *>(pUser);
+			if(IsDir || !str_endswith(pInfo->m_pName, ".map"))
+				return 0;
+			char aPath[IO_MAX_PATH_LENGTH];
+			str_format(aPath, sizeof(aPath), "%s/%s", pListDir->m_pDirectory, pInfo->m_pName);
+			IOHANDLE File = io_open(aPath, IOFLAG_READ);
+			if(!File)
+				return 0;
+			pListDir->m_vFiles.push_back({pInfo->m_pName, pInfo->m_TimeModified, io_length(File)});
+			io_close(File);
+			return 0;
+		},
+		0, &ListDir);
+
+	int64_t Total = 0;
+	for(const CFile &File : ListDir.m_vFiles)
+		Total += File.m_Size;
+	if(Total <= Budget)
+		return;
+
+	// oldest first, maps still mapped by other processes stay valid after removal
+	std::sort(ListDir.m_vFiles.begin(), ListDir.m_vFiles.end(), [](const CFile &A, const CFile &B) {
+		return A.m_Modified < B.m_Modified;
+	});
+	char aKeep[SHA256_MAXSTRSIZE + 4];
+	sha256_str(Keep, aKeep, sizeof(aKeep));
+	str_append(aKeep, ".map");
+	for(const CFile &File : ListDir.m_vFiles)
+	{
+		if(Total <= Budget)
+			break;
+		if(File.m_Name == aKeep)
+			continue;
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "%s/%s", pDirectory, File.m_Name.c_str());
+		if(fs_remove(aPath) == 0)
+			Total -= File.m_Size;
+	}
+}
+
+std::shared_ptr<const CMapCache::CEntry> CMapCache::Load(IStorage *pStorage, const char *pFilename, int StorageType)
+{
+	char aFullPath[IO_MAX_PATH_LENGTH];
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aFullPath, sizeof(aFullPath));
+	if(!File)
+		return nullptr;
+
+	// the same relative path can be another file for another process
+	char aAbsolutePath[IO_MAX_PATH_LENGTH];
+	if(fs_is_relative_path(aFullPath) && fs_getcwd(aAbsolutePath, sizeof(aAbsolutePath)))
+	{
+		str_append(aAbsolutePath, "/");
+		str_append(aAbsolutePath, aFullPath);
+	}
+	else
+	{
+		str_copy(aAbsolutePath, aFullPath);
+	}
+
+	const int64_t Size = io_length(File);
+	time_t Created, Modified;
+	if(fs_file_time(aFullPath, &Created, &Modified) != 0)
+		Modified = 0;
+	char aKey[IO_MAX_PATH_LENGTH + 64];
+	str_format(aKey, sizeof(aKey), "%s:%" PRId64 ":%" PRId64, aAbsolutePath, Size, (int64_t)Modified);
+
+	std::string Directory;
+	int64_t Budget;
+	{
+		const CLockScope LockScope(m_Lock);
+		auto HashIt = m_FileHashes.find(aKey);
+		if(HashIt != m_FileHashes.end())
+		{
+			if(std::shared_ptr<CEntry> pEntry = FindLocked(HashIt->second))
+			{
+				io_close(File);
+				m_NumHits++;
+				return pEntry;
+			}
+		}
+		Directory = m_Directory;
+		Budget = m_Budget;
+	}
+
+	if(!Directory.empty())
+	{
+		if(std::shared_ptr<CEntry> pEntry = LoadFromDirectory(Directory.c_str(), aKey, Size))
+		{
+			io_close(File);
+			const CLockScope LockScope(m_Lock);
+			m_NumHits++;
+			m_FileHashes[aKey] = pEntry->m_Sha256;
+			if(std::shared_ptr<CEntry> pExisting = FindLocked(pEntry->m_Sha256))
+				return pExisting;
+			InsertLocked(pEntry);
+			return pEntry;
+		}
+	}
+
+	auto pEntry = std::make_shared<CEntry>();
+	void *pData;
+	const bool Read = io_read_all(File, &pData, &pEntry->m_Size);
+	io_close(File);
+	if(!Read)
+		return nullptr;
+	pEntry->m_pData = (unsigned char *)pData;
+	pEntry->m_Sha256 = sha256(pEntry->m_pData, pEntry->m_Size);
+	pEntry->m_Crc = crc32(0, pEntry->m_pData, pEntry->m_Size);
+
+	{
+		const CLockScope LockScope(m_Lock);
+		m_NumMisses++;
+		m_FileHashes[aKey] = pEntry->m_Sha256;
+		// the same contents under another name
+		if(std::shared_ptr<CEntry> pExisting = FindLocked(pEntry->m_Sha256))
+			return pExisting;
+	}
+
+	// the entry isn't shared yet, so it can still be changed to the mapped file
+	if(!Directory.empty())
+	{
+		StoreInDirectory(Directory.c_str(), aKey, pEntry.get());
+		PruneDirectory(Directory.c_str(), Budget, pEntry->m_Sha256);
+	}
+
+	const CLockScope LockScope(m_Lock);
+	// another thread might have loaded it in the meantime
+	if(std::shared_ptr<CEntry> pExisting = FindLocked(pEntry->m_Sha256))
+		return pExisting;
+	InsertLocked(pEntry);
+	return pEntry;
+}
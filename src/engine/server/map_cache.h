@@ -0,0 +1,82 @@
+#ifndef ENGINE_SERVER_MAP_CACHE_H
+#define ENGINE_SERVER_MAP_CACHE_H
+
+#include <base/hash.h>
+#include <base/lock.h>
+#include <base/types.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class IStorage;
+
+// Content-addressed cache of the map files that the server sends to clients.
+//
+// Entries are keyed by SHA-256 and kept in memory up to a byte budget, the
+// least recently used ones are dropped first. Files are recognized by their
+// absolute path, size and modification time, so loading a map that is still
+// cached neither reads nor hashes it again.
+//
+// With a cache directory, the files are additionally stored there under their
+// hash and mapped into memory. Server processes on the same host that share
+// the directory then share the pages of the maps instead of each holding a
+// copy. Files from the directory are checked against their hash before they
+// are used. The directory is bounded by the same budget.
+class CMapCache
+{
+public:
+	class CEntry
+	{
+	public:
+		CEntry() = default;
+		CEntry(const CEntry &Other) = delete;
+		CEntry &operator=(const CEntry &Other) = delete;
+		~CEntry();
+
+		SHA256_DIGEST m_Sha256 = {};
+		unsigned m_Crc = 0;
+		unsigned char *m_pData = nullptr;
+		unsigned m_Size = 0;
+		// mapped from the cache directory instead of allocated
+		bool m_Mapped = false;
+	};
+
+	void SetBudget(int64_t Bytes);
+	// absolute path, empty to only cache in memory
+	void SetDirectory(const char *pDirectory);
+
+	// thread-safe, returns nullptr if the file cannot be read
+	std::shared_ptr<const CEntry> Load(IStorage *pStorage, const char *pFilename, int StorageType);
+
+	int NumEntries() const;
+	int64_t NumBytes() const;
+	int64_t NumHits() const;
+	int64_t NumMisses() const;
+
+private:
+	std::shared_ptr<CEntry> FindLocked(const SHA256_DIGEST &Sha256) REQUIRES(m_Lock);
+	void InsertLocked(const std::shared_ptr<CEntry> &pEntry) REQUIRES(m_Lock);
+
+	// the directory is accessed without holding the lock
+	static std::shared_ptr<CEntry> LoadFromDirectory(const char *pDirectory, const char *pKey, int64_t Size);
+	static void StoreInDirectory(const char *pDirectory, const char *pKey, CEntry *pEntry);
+	static void PruneDirectory(const char *pDirectory, int64_t Budget, const SHA256_DIGEST &Keep);
+	static void IndexPath(const char *pDirectory, const char *pKey, char *pPath, int PathSize);
+	static void DataPath(const char *pDirectory, const SHA256_DIGEST &Sha256, char *pPath, int PathSize);
+
+	mutable CLock m_Lock;
+	int64_t m_Budget GUARDED_BY(m_Lock) = 64 * 1024 * 1024;
+	std::string m_Directory GUARDED_BY(m_Lock);
+	// least recently used first
+	std::vector<std::shared_ptr<CEntry>> m_vpEntries GUARDED_BY(m_Lock);
+	int64_t m_NumBytes GUARDED_BY(m_Lock) = 0;
+	// "absolute path:size:modified" to the hash of the file's contents
+	std::map<std::string, SHA256_DIGEST> m_FileHashes GUARDED_BY(m_Lock);
+	int64_t m_NumHits GUARDED_BY(m_Lock) = 0;
+	int64_t m_NumMisses GUARDED_BY(m_Lock) = 0;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "map_preload.h"
+
+#include <base/system.h>
+
+#include <engine/shared/map.h>
+#include <engine/storage.h>
+
+CMapPreload::CMapPreload(IStorage *pStorage, CMapCache *pMapCache, const char *pMapName, const char *pPath, bool Sixup) :
+	m_pStorage(pStorage),
+	m_pMapCache(pMapCache),
+	m_Sixup(Sixup),
+	m_StartTime(time_get())
+{
+	str_copy(m_aMapName, pMapName);
+	str_copy(m_aPath, pPath);
+	str_format(m_aSixupPath, sizeof(m_aSixupPath), "maps7/%s.map", pMapName);
+}
+
+void CMapPreload::Run()
+{
+	Prepare();
+}
+
+void CMapPreload::Prepare()
+{
+	// complete map in memory for download, its hashes are also the ones of
+	// the datafile so that the file is only hashed once
+	m_pMapFile = m_pMapCache->Load(m_pStorage, m_aPath, IStorage::TYPE_ALL);
+	if(!m_pMapFile)
+		return;
+	const CDataFileReader::CKnownHashes KnownHashes = {m_pMapFile->m_Sha256, m_pMapFile->m_Crc, m_pMapFile->m_Size};
+	if(!CMap::Prepare(m_pStorage, m_aPath, IStorage::TYPE_ALL, m_DataFile, &KnownHashes))
+	{
+		m_pMapFile = nullptr;
+		return;
+	}
+
+	// sixup version of the map, the server disables sixup if it is missing
+	if(m_Sixup)
+		m_pSixupMapFile = m_pMapCache->Load(m_pStorage, m_aSixupPath, IStorage::TYPE_ALL);
+
+	m_Success = true;
+}
@@ -0,0 +1,47 @@
+#ifndef ENGINE_SERVER_MAP_PRELOAD_H
+#define ENGINE_SERVER_MAP_PRELOAD_H
+
+#include <base/hash.h>
+#include <base/types.h>
+
+#include "map_cache.h"
+
+#include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
+
+#include <memory>
+
+class IStorage;
+
+// Does everything for a map change that doesn't need the game: opens and
+// checks the datafile, decompresses the entity layers and loads the map files
+// that are sent to the clients from the map cache. Runs as a job so that the server keeps ticking
+// while the next map loads, the result is then swapped in by CServer::LoadMap.
+class CMapPreload : public IJob
+{
+	IStorage *m_pStorage;
+	CMapCache *m_pMapCache;
+
+	void Run() override;
+
+public:
+	CMapPreload(IStorage *pStorage, CMapCache *pMapCache, const char *pMapName, const char *pPath, bool Sixup);
+
+	// loads the map in the calling thread, used when no job was started in time
+	void Prepare();
+
+	char m_aMapName[IO_MAX_PATH_LENGTH];
+	char m_aPath[IO_MAX_PATH_LENGTH];
+	char m_aSixupPath[IO_MAX_PATH_LENGTH];
+	bool m_Sixup;
+	int64_t m_StartTime;
+
+	// results, only valid once the job is done
+	bool m_Success = false;
+	CDataFileReader m_DataFile;
+	std::shared_ptr<const CMapCache::CEntry> m_pMapFile;
+	// null if the sixup version of the map is missing
+	std::shared_ptr<const CMapCache::CEntry> m_pSixupMapFile;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "metrics_server.h"
+
+#include <base/system.h>
+#include <base/thread.h>
+#include <base/time.h>
+
+#include <engine/shared/metrics.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+enum
+{
+	MAX_REQUEST_SIZE = 4096,
+};
+
+// for receiving the request and sending the response each
+static constexpr std::chrono::nanoseconds CONNECTION_TIMEOUT = 5s;
+
+CMetricsServer::~CMetricsServer()
+{
+	Close();
+}
+
+bool CMetricsServer::Open(NETADDR BindAddr, const CMetrics *pMetrics)
+{
+	dbg_assert(!IsOpen(), "metrics server already open");
+
+	m_Socket = net_tcp_create(BindAddr);
+	if(!m_Socket)
+		return false;
+	if(net_tcp_listen(m_Socket, 8) != 0 || net_set_non_blocking(m_Socket) != 0)
+	{
+		net_tcp_close(m_Socket);
+		m_Socket = nullptr;
+		return false;
+	}
+
+	m_pMetrics = pMetrics;
+	m_Stop.store(false);
+	m_pThread = thread_init(ThreadFunc, this, "metrics server");
+	return true;
+}
+
+void CMetricsServer::Close()
+{
+	if(!IsOpen())
+		return;
+
+	m_Stop.store(true);
+	thread_wait(m_pThread);
+	m_pThread = nullptr;
+	net_tcp_close(m_Socket);
+	m_Socket = nullptr;
+}
+
+void CMetricsServer::ThreadFunc(void *pUser)
+{
+	static_cast<CMetricsServer *>(pUser)->Run();
+}
+
+void CMetricsServer::Run()
+{
+	while(!m_Stop.load())
+	{
+		if(!net_socket_read_wait(m_Socket, 100ms))
+			continue;
+
+		NETSOCKET Socket;
+		NETADDR Addr;
+		if(net_tcp_accept(m_Socket, &Socket, &Addr) < 0)
+			continue;
+		HandleConnection(Socket);
+		net_tcp_close(Socket);
+	}
+}
+
+void CMetricsServer::HandleConnection(NETSOCKET Socket)
+{
+	if(net_set_non_blocking(Socket) != 0)
+		return;
+
+	char aRequest[MAX_REQUEST_SIZE];
+	int Size = 0;
+	std::chrono::nanoseconds Deadline = time_get_nanoseconds() + CONNECTION_TIMEOUT;
+	while(true)
+	{
+		aRequest[Size] = '\0';
+		// the request doesn't have a body, only the headers are needed
+		if(str_find(aRequest, "\r\n\r\n") || str_find(aRequest, "\n\n") || Size == (int)sizeof(aRequest) - 1)
+			break;
+
+		const std::chrono::nanoseconds Now = time_get_nanoseconds();
+		if(Now >= Deadline || m_Stop.load())
+			return;
+		if(!net_socket_read_wait(Socket, std::min<std::chrono::nanoseconds>(Deadline - Now, 100ms)))
+			continue;
+		const int Received = net_tcp_recv(Socket, aRequest + Size, sizeof(aRequest) - 1 - Size);
+		if(Received <= 0)
+			return;
+		Size += Received;
+	}
+
+	std::string Response;
+	Respond(m_pMetrics, aRequest, Response);
+
+	size_t Sent = 0;
+	Deadline = time_get_nanoseconds() + CONNECTION_TIMEOUT;
+	while(Sent < Response.size())
+	{
+		const int Result = net_tcp_send(Socket, Response.data() + Sent, std::min<size_t>(Response.size() - Sent, 64 * 1024));
+		if(Result > 0)
+		{
+			Sent += Result;
+			continue;
+		}
+		if(!net_would_block() || time_get_nanoseconds() >= Deadline || m_Stop.load())
+			return;
+		std::this_thread::sleep_for(1ms);
+	}
+}
+
+static void HttpResponse(std::string &Response, const char *pStatus, const char *pContentType, const std::string &Body)
+{
+	char aHeaders[256];
+	str_format(aHeaders, sizeof(aHeaders), "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %" PRIzu "\r\nConnection: close\r\n\r\n", pStatus, pContentType, Body.size());
+	Response = aHeaders;
+	Response += Body;
+}
+
+void CMetricsServer::Respond(const CMetrics *pMetrics, const char *pRequest, std::string &Response)
+{
+	// request line, e.g. `GET /metrics HTTP/1.1`
+	const char *pMethodEnd = str_find(pRequest, " ");
+	if(!pMethodEnd)
+	{
+		HttpResponse(Response, "400 Bad Request", "text/plain", "bad request\n");
+		return;
+	}
+	const char *pPath = pMethodEnd + 1;
+	int PathLength = 0;
+	while(pPath[PathLength] && pPath[PathLength] != ' ' && pPath[PathLength] != '?' && pPath[PathLength] != '\r' && pPath[PathLength] != '\n')
+		PathLength++;
+
+	if(str_comp_num(pRequest, "GET ", 4) != 0)
+	{
+		HttpResponse(Response, "405 Method Not Allowed", "text/plain", "only GET is supported\n");
+		return;
+	}
+	if(PathLength != 8 || str_comp_num(pPath, "/metrics", 8) != 0)
+	{
+		HttpResponse(Response, "404 Not Found", "text/plain", "metrics are served at /metrics\n");
+		return;
+	}
+
+	std::string Body;
+	pMetrics->Format(Body);
+	HttpResponse(Response, "200 OK", "text/plain; version=0.0.4; charset=utf-8", Body);
+}
@@ -0,0 +1,39 @@
+#ifndef ENGINE_SERVER_METRICS_SERVER_H
+#define ENGINE_SERVER_METRICS_SERVER_H
+
+#include <base/types.h>
+
+#include <atomic>
+#include <string>
+
+class CMetrics;
+
+// Serves the metrics over HTTP for Prometheus to scrape `/metrics`.
+//
+// Requests are handled one after another on a separate thread, which only
+// reads the atomic values of the metrics. Connections that don't send a
+// request or don't read the response in time are closed.
+class CMetricsServer
+{
+public:
+	~CMetricsServer();
+
+	bool Open(NETADDR BindAddr, const CMetrics *pMetrics);
+	void Close();
+	bool IsOpen() const { return m_pThread != nullptr; }
+
+	// builds the HTTP response to the request line and headers
+	static void Respond(const CMetrics *pMetrics, const char *pRequest, std::string &Response);
+
+private:
+	static void ThreadFunc(void *pUser);
+	void Run();
+	void HandleConnection(NETSOCKET Socket);
+
+	NETSOCKET m_Socket = nullptr;
+	const CMetrics *m_pMetrics = nullptr;
+	void *m_pThread = nullptr;
+	std::atomic_bool m_Stop{false};
+};
+
+#endif // ENGINE_SERVER_METRICS_SERVER_H
@@ -1,10 +1,13 @@
 #include "name_ban.h"
 
 #include <base/log.h>
+#include <base/math.h>
 #include <base/system.h>
 
 #include <engine/shared/config.h>
 
+#include <algorithm>
+
 CNameBan::CNameBan(const char *pName, const char *pReason, int Distance, bool IsSubstring) :
 	m_Distance(Distance), m_IsSubstring(IsSubstring)
 {
@@ -13,6 +16,157 @@ CNameBan::CNameBan(const char *pName, const char *pReason, int Distance, bool Is
 	m_SkeletonLength = str_utf8_to_skeleton(m_aName, m_aSkeleton, std::size(m_aSkeleton));
 }
 
+void CNameBans::CSkeletonTree::Clear()
+{
+	m_vNodes.clear();
+}
+
+void CNameBans::CSkeletonTree::Insert(const std::vector<CNameBan> &vBans, int Ban)
+{
+	const CNameBan &NewBan = vBans[Ban];
+	if(m_vNodes.empty())
+	{
+		m_vNodes.push_back({Ban, NewBan.m_Distance, Ban, {}});
+		return;
+	}
+
+	int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
+	int Node = 0;
+	while(true)
+	{
+		CNode &Current = m_vNodes[Node];
+		Current.m_MaxDistance = maximum(Current.m_MaxDistance, NewBan.m_Distance);
+		Current.m_MaxBan = maximum(Current.m_MaxBan, Ban);
+
+		const CNameBan &NodeBan = vBans[Current.m_Ban];
+		const int Distance = str_utf32_dist_buffer(NewBan.m_aSkeleton, NewBan.m_SkeletonLength, NodeBan.m_aSkeleton, NodeBan.m_SkeletonLength, aBuffer, std::size(aBuffer));
+		auto It = std::find_if(Current.m_vChildren.begin(), Current.m_vChildren.end(), [Distance](const std::pair<int, int> &Child) { return Child.first == Distance; });
+		if(It == Current.m_vChildren.end())
+		{
+			Current.m_vChildren.emplace_back(Distance, (int)m_vNodes.size());
+			m_vNodes.push_back({Ban, NewBan.m_Distance, Ban, {}});
+			return;
+		}
+		Node = It->second;
+	}
+}
+
+int CNameBans::CSkeletonTree::FindLast(const std::vector<CNameBan> &vBans, const int *pSkeleton, int SkeletonLength) const
+{
+	if(m_vNodes.empty())
+		return -1;
+
+	int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
+	int Last = -1;
+	std::vector<int> vStack = {0};
+	while(!vStack.empty())
+	{
+		const CNode &Current = m_vNodes[vStack.back()];
+		vStack.pop_back();
+		if(Current.m_MaxBan <= Last)
+			continue;
+
+		const CNameBan &Ban = vBans[Current.m_Ban];
+		const int Distance = str_utf32_dist_buffer(pSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer));
+		if(Distance <= Ban.m_Distance)
+			Last = maximum(Last, Current.m_Ban);
+
+		// by the triangle inequality, every ban below an edge is at least
+		// |Distance - Edge| away from the name
+		for(const auto &[Edge, Child] : Current.m_vChildren)
+		{
+			const CNode &ChildNode = m_vNodes[Child];
+			if(ChildNode.m_MaxBan > Last && absolute(Distance - Edge) <= ChildNode.m_MaxDistance)
+				vStack.push_back(Child);
+		}
+	}
+	return Last;
+}
+
+void CNameBans::CSubstringMatcher::Build(const std::vector<CNameBan> &vBans)
+{
+	m_vStates.clear();
+	m_vStates.emplace_back();
+	m_EmptyBan = -1;
+
+	for(int Ban = 0; Ban < (int)vBans.size(); Ban++)
+	{
+		if(!vBans[Ban].m_IsSubstring)
+			continue;
+		const char *pName = vBans[Ban].m_aName;
+		if(pName[0] == '\0')
+		{
+			m_EmptyBan = Ban;
+			continue;
+		}
+		int State = 0;
+		while(*pName)
+		{
+			const int Code = str_utf8_tolower_codepoint(str_utf8_decode(&pName));
+			auto It = m_vStates[State].m_Next.find(Code);
+			if(It == m_vStates[State].m_Next.end())
+			{
+				const int NewState = m_vStates.size();
+				m_vStates[State].m_Next[Code] = NewState;
+				m_vStates.emplace_back();
+				State = NewState;
+			}
+			else
+			{
+				State = It->second;
+			}
+		}
+		m_vStates[State].m_Ban = Ban;
+	}
+
+	// link every state to the longest proper suffix that is also in the trie,
+	// breadth-first so that the links of shorter states are known already
+	std::vector<int> vQueue;
+	for(const auto &[Code, Next] : m_vStates[0].m_Next)
+		vQueue.push_back(Next);
+	for(size_t i = 0; i < vQueue.size(); i++)
+	{
+		const CState &Current = m_vStates[vQueue[i]];
+		for(const auto &[Code, Next] : Current.m_Next)
+		{
+			int Fail = Current.m_Fail;
+			while(Fail != 0 && !m_vStates[Fail].m_Next.count(Code))
+				Fail = m_vStates[Fail].m_Fail;
+			auto It = m_vStates[Fail].m_Next.find(Code);
+			m_vStates[Next].m_Fail = It == m_vStates[Fail].m_Next.end() ? 0 : It->second;
+			m_vStates[Next].m_Ban = maximum(m_vStates[Next].m_Ban, m_vStates[m_vStates[Next].m_Fail].m_Ban);
+			vQueue.push_back(Next);
+		}
+	}
+}
+
+int CNameBans::CSubstringMatcher::FindLast(const char *pName) const
+{
+	int Last = pName[0] != '\0' ? m_EmptyBan : -1;
+	if(m_vStates.size() <= 1)
+		return Last;
+
+	int State = 0;
+	while(*pName)
+	{
+		const int Code = str_utf8_tolower_codepoint(str_utf8_decode(&pName));
+		while(true)
+		{
+			auto It = m_vStates[State].m_Next.find(Code);
+			if(It != m_vStates[State].m_Next.end())
+			{
+				State = It->second;
+				break;
+			}
+			if(State == 0)
+				break;
+			State = m_vStates[State].m_Fail;
+		}
+		Last = maximum(Last, m_vStates[State].m_Ban);
+	}
+	return Last;
+}
+
 void CNameBans::InitConsole(IConsole *pConsole)
 {
 	m_pConsole = pConsole;
@@ -37,11 +191,17 @@ void CNameBans::Ban(const char *pName, const char *pReason, const int Distance,
 			str_copy(Ban.m_aReason, pReason);
 			Ban.m_Distance = Distance;
 			Ban.m_IsSubstring = IsSubstring;
+			m_SkeletonTreeDirty = true;
+			m_SubstringMatcherDirty = true;
 			return;
 		}
 	}
 
 	m_vNameBans.emplace_back(pName, pReason, Distance, IsSubstring);
+	if(!m_SkeletonTreeDirty)
+		m_SkeletonTree.Insert(m_vNameBans, (int)m_vNameBans.size() - 1);
+	if(IsSubstring)
+		m_SubstringMatcherDirty = true;
 	if(m_pConsole)
 	{
 		char aBuf[256];
@@ -71,6 +231,8 @@ void CNameBans::Unban(const char *pName)
 			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
 		}
 		m_vNameBans.erase(ToRemove, m_vNameBans.end());
+		m_SkeletonTreeDirty = true;
+		m_SubstringMatcherDirty = true;
 	}
 }
 
@@ -89,22 +251,29 @@ void CNameBans::Dump() const
 
 const CNameBan *CNameBans::IsBanned(const char *pName) const
 {
+	if(m_SkeletonTreeDirty)
+	{
+		m_SkeletonTree.Clear();
+		for(int Ban = 0; Ban < (int)m_vNameBans.size(); Ban++)
+			m_SkeletonTree.Insert(m_vNameBans, Ban);
+		m_SkeletonTreeDirty = false;
+	}
+	if(m_SubstringMatcherDirty)
+	{
+		m_SubstringMatcher.Build(m_vNameBans);
+		m_SubstringMatcherDirty = false;
+	}
+
 	char aTrimmed[MAX_NAME_LENGTH];
 	str_copy(aTrimmed, str_utf8_skip_whitespaces(pName));
 	str_utf8_trim_right(aTrimmed);
 
 	int aSkeleton[MAX_NAME_SKELETON_LENGTH];
 	int SkeletonLength = str_utf8_to_skeleton(aTrimmed, aSkeleton, std::size(aSkeleton));
-	int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
 
-	const CNameBan *pResult = nullptr;
-	for(const CNameBan &Ban : m_vNameBans)
-	{
-		int Distance = str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer));
-		if(Distance <= Ban.m_Distance || (Ban.m_IsSubstring && str_utf8_find_nocase(pName, Ban.m_aName)))
-			pResult = &Ban;
-	}
-	return pResult;
+	// the last matching ban in the list wins
+	const int Last = maximum(m_SkeletonTree.FindLast(m_vNameBans, aSkeleton, SkeletonLength), m_SubstringMatcher.FindLast(pName));
+	return Last < 0 ? nullptr : &m_vNameBans[Last];
 }
 
 void CNameBans::ConNameBan(IConsole::IResult *pResult, void *pUser)
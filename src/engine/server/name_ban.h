@@ -4,6 +4,8 @@
 #include <engine/console.h>
 #include <engine/shared/protocol.h>
 
+#include <map>
+#include <utility>
 #include <vector>
 
 enum
@@ -27,9 +29,57 @@ public:
 
 class CNameBans
 {
+	// BK-tree over the ban skeletons. Every node also stores the largest
+	// allowed distance and the largest ban index in its subtree, which bound
+	// the subtrees that can still contain a later matching ban.
+	class CSkeletonTree
+	{
+		class CNode
+		{
+		public:
+			int m_Ban;
+			int m_MaxDistance;
+			int m_MaxBan;
+			std::vector<std::pair<int, int>> m_vChildren; // (edge distance, node)
+		};
+
+		std::vector<CNode> m_vNodes;
+
+	public:
+		void Clear();
+		void Insert(const std::vector<CNameBan> &vBans, int Ban);
+		int FindLast(const std::vector<CNameBan> &vBans, const int *pSkeleton, int SkeletonLength) const;
+	};
+
+	// Aho-Corasick automaton over the lowercased names of the substring bans.
+	class CSubstringMatcher
+	{
+		class CState
+		{
+		public:
+			std::map<int, int> m_Next;
+			int m_Fail = 0;
+			int m_Ban = -1;
+		};
+
+		std::vector<CState> m_vStates;
+		int m_EmptyBan = -1;
+
+	public:
+		void Build(const std::vector<CNameBan> &vBans);
+		int FindLast(const char *pName) const;
+	};
+
 	IConsole *m_pConsole = nullptr;
 	std::vector<CNameBan> m_vNameBans;
 
+	// The indices are rebuilt on the next lookup after bans were changed or
+	// removed. New bans are added to the skeleton tree directly.
+	mutable CSkeletonTree m_SkeletonTree;
+	mutable CSubstringMatcher m_SubstringMatcher;
+	mutable bool m_SkeletonTreeDirty = false;
+	mutable bool m_SubstringMatcherDirty = false;
+
 	static void ConNameBan(IConsole::IResult *pResult, void *pUser);
 	static void ConNameUnban(IConsole::IResult *pResult, void *pUser);
 	static void ConNameBans(IConsole::IResult *pResult, void *pUser);
@@ -5,7 +5,9 @@
 
 #include "databases/connection.h"
 #include "databases/connection_pool.h"
+#include "map_preload.h"
 #include "register.h"
+#include "server_logger.h"
 
 #include <base/logger.h>
 #include <base/math.h>
@@ -211,13 +213,12 @@ void CRconClientLogger::Log(const CLogMessage *pMessage)
 void CServer::CClient::Reset()
 {
 	// reset input
-	for(auto &Input : m_aInputs)
-		Input.m_GameTick = -1;
-	m_CurrentInput = 0;
+	m_Inputs.Reset();
 	mem_zero(&m_LastPreInput, sizeof(m_LastPreInput));
 	mem_zero(&m_LatestInput, sizeof(m_LatestInput));
 
 	m_Snapshots.PurgeAll();
+	m_SnapshotStarvation.Clear();
 	m_LastAckedSnapshot = -1;
 	m_LastInputTick = -1;
 	m_SnapRate = CClient::SNAPRATE_INIT;
@@ -261,11 +262,35 @@ CServer::CServer()
 	m_ServerInfoFirstRequest = 0;
 	m_ServerInfoNumRequests = 0;
 
+	m_ProfileFrame = m_Profiler.AddSection("frame");
+	m_ProfilePumpNetwork = m_Profiler.AddSection("pump_network");
+	m_ProfileTeehistorian = m_Profiler.AddSection("teehistorian");
+	m_ProfileEarlyInput = m_Profiler.AddSection("early_input");
+	m_ProfileInput = m_Profiler.AddSection("predicted_input");
+	m_ProfileGameTick = m_Profiler.AddSection("game_tick");
+	m_ProfileSnapshot = m_Profiler.AddSection("snapshot");
+	m_ProfileRegister = m_Profiler.AddSection("register");
+	m_LastProfileEconTime = 0;
+
+	m_pMetricClients = m_Metrics.Gauge("ddnet_clients", "Connected clients, including the ones still connecting");
+	m_pMetricPlayers = m_Metrics.Gauge("ddnet_players", "Clients in game");
+	m_pMetricTickDuration = m_Metrics.Histogram("ddnet_tick_duration_seconds", "Time to run a game tick", {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.02, 0.04, 0.1});
+	m_pMetricTickOverruns = m_Metrics.Counter("ddnet_tick_overruns_total", "Game ticks that ran late because the server fell behind");
+	m_pMetricSnapshotSize = m_Metrics.Histogram("ddnet_snapshot_size_bytes", "Compressed size of the snapshot deltas sent to clients", {64, 128, 256, 512, 1024, 2048, 4096, 8192});
+	m_pMetricSnapshotBudgetHits = m_Metrics.Counter("ddnet_snapshot_budget_hits_total", "Snapshots that items were left out of to fit the size limit");
+	m_pMetricSnapshotCutItems = m_Metrics.Counter("ddnet_snapshot_cut_items_total", "Items left out of snapshots to fit the size limit");
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		char aLabels[32];
+		str_format(aLabels, sizeof(aLabels), "client=\"%d\"", i);
+		m_aClients[i].m_pMetricSnapshotStaleBytes = m_Metrics.Counter("ddnet_client_snapshot_stale_bytes_total", "Uncompressed bytes of changed snapshot items at the edge of the view that were not updated for the client slot, not the bytes saved on the wire", aLabels);
+	}
+
 #ifdef CONF_FAMILY_UNIX
 	m_ConnLoggingSocketCreated = false;
 #endif
 
-	m_pConnectionPool = new CDbConnectionPool();
+	m_pConnectionPool = new CDbConnectionPool(&m_Metrics);
 	m_pRegister = nullptr;
 
 	m_aErrorShutdownReason[0] = 0;
@@ -275,11 +300,6 @@ CServer::CServer()
 
 CServer::~CServer()
 {
-	for(auto &pCurrentMapData : m_apCurrentMapData)
-	{
-		free(pCurrentMapData);
-	}
-
 	if(m_RunServer != UNINITIALIZED)
 	{
 		for(auto &Client : m_aClients)
@@ -1010,6 +1030,11 @@ void CServer::DoSnapshot()
 		m_SnapshotBuilder.Init();
 		GameServer()->OnSnap(-1, IsGlobalSnap, true);
 		int SnapshotSize = m_SnapshotBuilder.Finish(aData);
+		if(m_SnapshotBuilder.NumCutItems())
+		{
+			m_pMetricSnapshotBudgetHits->Add();
+			m_pMetricSnapshotCutItems->Add(m_SnapshotBuilder.NumCutItems());
+		}
 
 		// write snapshot
 		if(m_aDemoRecorder[RECORDER_MANUAL].IsRecording())
@@ -1043,10 +1068,23 @@ void CServer::DoSnapshot()
 			// only snap events on global ticks
 			GameServer()->OnSnap(i, IsGlobalSnap, m_aDemoRecorder[i].IsRecording());
 
+			// keep the previous data of the items that don't need an update yet
+			if(m_aClients[i].m_Snapshots.m_pLast)
+			{
+				const CSnapshotStorage::CHolder *pLast = m_aClients[i].m_Snapshots.m_pLast;
+				m_aClients[i].m_pMetricSnapshotStaleBytes->Add(m_SnapshotBuilder.ReuseItems(pLast->m_pSnap, pLast->m_Tick, m_CurrentGameTick));
+			}
+
 			// finish snapshot
 			char aData[CSnapshot::MAX_SIZE];
 			CSnapshot *pData = (CSnapshot *)aData; // Fix compiler warning for strict-aliasing
-			int SnapshotSize = m_SnapshotBuilder.Finish(pData);
+			const int MaxSnapshotSize = Config()->m_SvSnapBudget ? Config()->m_SvSnapBudget : CSnapshot::MAX_SIZE;
+			int SnapshotSize = m_SnapshotBuilder.Finish(pData, MaxSnapshotSize, &m_aClients[i].m_SnapshotStarvation);
+			if(m_SnapshotBuilder.NumCutItems())
+			{
+				m_pMetricSnapshotBudgetHits->Add();
+				m_pMetricSnapshotCutItems->Add(m_SnapshotBuilder.NumCutItems());
+			}
 
 			if(m_aDemoRecorder[i].IsRecording())
 			{
@@ -1091,6 +1129,7 @@ void CServer::DoSnapshot()
 
 				char aCompData[CSnapshot::MAX_SIZE];
 				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
+				m_pMetricSnapshotSize->Observe(SnapshotSize);
 				int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
 
 				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
@@ -1858,12 +1897,12 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 			if(m_aClients[ClientId].m_Snapshots.Get(m_aClients[ClientId].m_LastAckedSnapshot, &TagTime, nullptr, nullptr) >= 0)
 				m_aClients[ClientId].m_Latency = (int)(((time_get() - TagTime) * 1000) / time_freq());
 
+			const int TimeLeft = (TickStartTime(IntendedTick) - time_get()) / (time_freq() / 1000);
+
 			// add message to report the input timing
 			// skip packets that are old
 			if(IntendedTick > m_aClients[ClientId].m_LastInputTick)
 			{
-				const int TimeLeft = (TickStartTime(IntendedTick) - time_get()) / (time_freq() / 1000);
-
 				CMsgPacker Msgp(NETMSG_INPUTTIMING, true);
 				Msgp.AddInt(IntendedTick);
 				Msgp.AddInt(TimeLeft);
@@ -1872,21 +1911,20 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 
 			m_aClients[ClientId].m_LastInputTick = IntendedTick;
 
-			CClient::CInput *pInput = &m_aClients[ClientId].m_aInputs[m_aClients[ClientId].m_CurrentInput];
-
-			if(IntendedTick <= Tick())
-				IntendedTick = Tick() + 1;
-
-			pInput->m_GameTick = IntendedTick;
-
-			for(int i = 0; i < Size / 4; i++)
+			CClient::CInput Input;
+			const int NumInts = maximum(Size / 4, 0);
+			for(int i = 0; i < NumInts; i++)
 			{
-				pInput->m_aData[i] = Unpacker.GetInt();
+				Input.m_aData[i] = Unpacker.GetInt();
 			}
 			if(Unpacker.Error())
 			{
 				return;
 			}
+			mem_zero(Input.m_aData + NumInts, (MAX_INPUT_SIZE - NumInts) * sizeof(int));
+			GameServer()->OnClientPrepareInput(ClientId, Input.m_aData);
+
+			IntendedTick = m_aClients[ClientId].m_Inputs.Add(Input.m_aData, NumInts, IntendedTick, Tick(), TimeLeft);
 
 			if(g_Config.m_SvPreInput)
 			{
@@ -1896,7 +1934,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 
 				CNetMsg_Sv_PreInput PreInput = {};
 				mem_zero(&PreInput, sizeof(PreInput));
-				CNetObj_PlayerInput *pInputData = (CNetObj_PlayerInput *)&pInput->m_aData;
+				CNetObj_PlayerInput *pInputData = (CNetObj_PlayerInput *)Input.m_aData;
 
 				PreInput.m_Direction = pInputData->m_Direction;
 				PreInput.m_Jump = pInputData->m_Jump;
@@ -1927,11 +1965,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				}
 			}
 
-			GameServer()->OnClientPrepareInput(ClientId, pInput->m_aData);
-			mem_copy(m_aClients[ClientId].m_LatestInput.m_aData, pInput->m_aData, MAX_INPUT_SIZE * sizeof(int));
-
-			m_aClients[ClientId].m_CurrentInput++;
-			m_aClients[ClientId].m_CurrentInput %= 200;
+			mem_copy(m_aClients[ClientId].m_LatestInput.m_aData, Input.m_aData, MAX_INPUT_SIZE * sizeof(int));
 
 			// call the mod with the fresh input data
 			if(m_aClients[ClientId].m_State == CClient::STATE_INGAME)
@@ -2120,8 +2154,12 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 	}
 }
 
-bool CServer::RateLimitServerInfoConnless()
+bool CServer::RateLimitServerInfoConnless(const NETADDR *pAddr)
 {
+	// sources over their own limit don't count towards the global one
+	if(Config()->m_SvServerInfoPerSource && !m_ServerInfoRateLimiter.Consume(pAddr, Config()->m_SvServerInfoPerSource, time_get()))
+		return false;
+
 	bool SendClients = true;
 	if(Config()->m_SvServerInfoPerSecond)
 	{
@@ -2144,7 +2182,7 @@ bool CServer::RateLimitServerInfoConnless()
 
 void CServer::SendServerInfoConnless(const NETADDR *pAddr, int Token, int Type)
 {
-	SendServerInfo(pAddr, Token, Type, RateLimitServerInfoConnless());
+	SendServerInfo(pAddr, Token, Type, RateLimitServerInfoConnless(pAddr));
 }
 
 static inline int GetCacheIndex(int Type, bool SendClient)
@@ -2167,14 +2205,22 @@ CServer::CCache::~CCache()
 	Clear();
 }
 
-CServer::CCache::CCacheChunk::CCacheChunk(const void *pData, int Size)
+CServer::CCache::CCacheChunk::CCacheChunk(const void *pHeader, int HeaderSize, const void *pData, int Size) :
+	m_HeaderSize(HeaderSize)
 {
-	m_vData.assign((const uint8_t *)pData, (const uint8_t *)pData + Size);
+	m_vData.reserve(HeaderSize + Size);
+	m_vData.assign((const uint8_t *)pHeader, (const uint8_t *)pHeader + HeaderSize);
+	m_vData.insert(m_vData.end(), (const uint8_t *)pData, (const uint8_t *)pData + Size);
 }
 
 void CServer::CCache::AddChunk(const void *pData, int Size)
 {
-	m_vCache.emplace_back(pData, Size);
+	m_vCache.emplace_back(nullptr, 0, pData, Size);
+}
+
+void CServer::CCache::AddChunk(const void *pHeader, int HeaderSize, const void *pData, int Size)
+{
+	m_vCache.emplace_back(pHeader, HeaderSize, pData, Size);
 }
 
 void CServer::CCache::Clear()
@@ -2278,10 +2324,30 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 	int ChunksStored = 0;
 	int PlayersStored = 0;
 
+	// the replies are stored with their header so that sending them only
+	// needs the token of the request to be filled in
+	const unsigned char *pHeader;
+	const unsigned char *pMoreHeader;
+	if(Type == SERVERINFO_EXTENDED)
+	{
+		pHeader = SERVERBROWSE_INFO_EXTENDED;
+		pMoreHeader = SERVERBROWSE_INFO_EXTENDED_MORE;
+	}
+	else if(Type == SERVERINFO_64_LEGACY)
+	{
+		pHeader = SERVERBROWSE_INFO_64_LEGACY;
+		pMoreHeader = SERVERBROWSE_INFO_64_LEGACY;
+	}
+	else
+	{
+		pHeader = SERVERBROWSE_INFO;
+		pMoreHeader = SERVERBROWSE_INFO;
+	}
+
 #define SAVE(size) \
 	do \
 	{ \
-		pCache->AddChunk(q.Data(), size); \
+		pCache->AddChunk(ChunksStored == 0 ? pHeader : pMoreHeader, SERVERBROWSE_SIZE, q.Data(), size); \
 		ChunksStored++; \
 	} while(0)
 
@@ -2490,54 +2556,27 @@ void CServer::CacheServerInfoSixup(CCache *pCache, bool SendClients, int MaxCons
 
 void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
 {
-	CPacker p;
-	char aBuf[128];
-	p.Reset();
-
-	CCache *pCache = &m_aServerInfoCache[GetCacheIndex(Type, SendClients)];
+	dbg_assert(Type == SERVERINFO_VANILLA || Type == SERVERINFO_64_LEGACY || Type == SERVERINFO_EXTENDED || Type == SERVERINFO_INGAME, "Invalid serverinfo Type: %d", Type);
+	const CCache *pCache = &m_aServerInfoCache[GetCacheIndex(Type, SendClients)];
 
-#define ADD_RAW(p, x) (p).AddRaw(x, sizeof(x))
-#define ADD_INT(p, x) \
-	do \
-	{ \
-		str_format(aBuf, sizeof(aBuf), "%d", x); \
-		(p).AddString(aBuf, 0); \
-	} while(0)
+	char aToken[16];
+	const int TokenSize = str_format(aToken, sizeof(aToken), "%d", Token) + 1;
 
 	CNetChunk Packet;
 	Packet.m_ClientId = -1;
 	Packet.m_Address = *pAddr;
 	Packet.m_Flags = NETSENDFLAG_CONNLESS;
 
+	unsigned char aData[NET_MAX_PAYLOAD];
 	for(const auto &Chunk : pCache->m_vCache)
 	{
-		p.Reset();
-		if(Type == SERVERINFO_EXTENDED)
-		{
-			if(&Chunk == &pCache->m_vCache.front())
-				p.AddRaw(SERVERBROWSE_INFO_EXTENDED, sizeof(SERVERBROWSE_INFO_EXTENDED));
-			else
-				p.AddRaw(SERVERBROWSE_INFO_EXTENDED_MORE, sizeof(SERVERBROWSE_INFO_EXTENDED_MORE));
-			ADD_INT(p, Token);
-		}
-		else if(Type == SERVERINFO_64_LEGACY)
-		{
-			ADD_RAW(p, SERVERBROWSE_INFO_64_LEGACY);
-			ADD_INT(p, Token);
-		}
-		else if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
-		{
-			ADD_RAW(p, SERVERBROWSE_INFO);
-			ADD_INT(p, Token);
-		}
-		else
-		{
-			dbg_assert_failed("Invalid serverinfo Type: %d", Type);
-		}
-
-		p.AddRaw(Chunk.m_vData.data(), Chunk.m_vData.size());
-		Packet.m_pData = p.Data();
-		Packet.m_DataSize = p.Size();
+		const int DataSize = Chunk.m_vData.size() - Chunk.m_HeaderSize;
+		dbg_assert(Chunk.m_HeaderSize + TokenSize + DataSize <= (int)sizeof(aData), "Server info chunk too large: %d", (int)Chunk.m_vData.size());
+		mem_copy(aData, Chunk.m_vData.data(), Chunk.m_HeaderSize);
+		mem_copy(aData + Chunk.m_HeaderSize, aToken, TokenSize);
+		mem_copy(aData + Chunk.m_HeaderSize + TokenSize, Chunk.m_vData.data() + Chunk.m_HeaderSize, DataSize);
+		Packet.m_pData = aData;
+		Packet.m_DataSize = Chunk.m_HeaderSize + TokenSize + DataSize;
 		m_NetServer.Send(&Packet);
 	}
 }
@@ -2808,7 +2847,7 @@ void CServer::PumpNetwork(bool PacketWaiting)
 						Packer.Reset();
 						Packer.AddRaw(SERVERBROWSE_INFO, sizeof(SERVERBROWSE_INFO));
 						Packer.AddInt(SrvBrwsToken);
-						GetServerInfoSixup(&Packer, RateLimitServerInfoConnless());
+						GetServerInfoSixup(&Packer, RateLimitServerInfoConnless(&Packet.m_Address));
 						CNetBase::SendPacketConnlessWithToken7(m_NetServer.Socket(), &Packet.m_Address, Packer.Data(), Packer.Size(), ResponseToken, m_NetServer.GetToken(Packet.m_Address));
 					}
 					else if(Type != -1)
@@ -2856,6 +2895,9 @@ void CServer::PumpNetwork(bool PacketWaiting)
 
 	m_ServerBan.Update();
 	m_Econ.Update();
+
+	if(m_pServerLogger)
+		m_pServerLogger->SendPending();
 }
 
 const char *CServer::GetMapName() const
@@ -2867,11 +2909,52 @@ void CServer::ChangeMap(const char *pMap)
 {
 	str_copy(Config()->m_SvMap, pMap);
 	m_MapReload = str_comp(Config()->m_SvMap, m_aCurrentMap) != 0;
+	if(m_MapReload)
+		PreloadMap(Config()->m_SvMap);
 }
 
 void CServer::ReloadMap()
 {
 	m_SameMapReload = true;
+	// the map file might have changed, don't use an older preload
+	StartMapPreload(m_aCurrentMap);
+}
+
+void CServer::PreloadMap(const char *pMapName)
+{
+	// a map that was prepared for a recent vote can be used for the map change
+	if(m_pMapPreload && str_comp(m_pMapPreload->m_aMapName, pMapName) == 0 &&
+		m_pMapPreload->m_Sixup == (Config()->m_SvSixup != 0) &&
+		time_get() < m_pMapPreload->m_StartTime + time_freq() * MAP_PRELOAD_REUSE_SECONDS)
+	{
+		return;
+	}
+	StartMapPreload(pMapName);
+}
+
+void CServer::StartMapPreload(const char *pMapName)
+{
+	m_pMapPreload = nullptr;
+
+	char aPath[IO_MAX_PATH_LENGTH];
+	str_format(aPath, sizeof(aPath), "maps/%s.map", pMapName);
+	if(!str_valid_filename(fs_filename(aPath)))
+		return;
+
+	// maps with a map-specific config are rewritten by the game when they
+	// are loaded, these are still loaded synchronously
+	char aConfig[IO_MAX_PATH_LENGTH];
+	str_format(aConfig, sizeof(aConfig), "maps/%s.cfg", pMapName);
+	if(Storage()->FileExists(aConfig, IStorage::TYPE_ALL))
+		return;
+
+	m_pMapPreload = std::make_shared<CMapPreload>(Storage(), &m_MapCache, pMapName, aPath, Config()->m_SvSixup);
+	Engine()->AddJob(m_pMapPreload);
+}
+
+bool CServer::MapPreloadPending() const
+{
+	return m_pMapPreload && !m_pMapPreload->Done();
 }
 
 int CServer::LoadMap(const char *pMapName)
@@ -2890,17 +2973,30 @@ int CServer::LoadMap(const char *pMapName)
 	{
 		return 0;
 	}
-	if(!m_pMap->Load(aBuf, IStorage::TYPE_ALL))
+
+	// use the map prepared in the background if it matches, otherwise load it now
+	std::shared_ptr<CMapPreload> pPreload = std::move(m_pMapPreload);
+	if(pPreload && pPreload->Done() && str_comp(pPreload->m_aPath, aBuf) == 0 && pPreload->m_Sixup == (Config()->m_SvSixup != 0))
+	{
+		log_debug("server", "using map '%s' prepared in the background", aBuf);
+	}
+	else
+	{
+		pPreload = std::make_shared<CMapPreload>(Storage(), &m_MapCache, pMapName, aBuf, Config()->m_SvSixup);
+		pPreload->Prepare();
+	}
+	if(!pPreload->m_Success)
 	{
 		return 0;
 	}
+	m_pMap->Load(std::move(pPreload->m_DataFile));
 
 	// reinit snapshot ids
 	m_IdPool.TimeoutIds();
 
-	// get the crc of the map
-	m_aCurrentMapSha256[MAP_TYPE_SIX] = m_pMap->Sha256();
-	m_aCurrentMapCrc[MAP_TYPE_SIX] = m_pMap->Crc();
+	// the hashes of the map file that is sent to the clients
+	m_aCurrentMapSha256[MAP_TYPE_SIX] = pPreload->m_pMapFile->m_Sha256;
+	m_aCurrentMapCrc[MAP_TYPE_SIX] = pPreload->m_pMapFile->m_Crc;
 	char aBufMsg[256];
 	char aSha256[SHA256_MAXSTRSIZE];
 	sha256_str(m_aCurrentMapSha256[MAP_TYPE_SIX], aSha256, sizeof(aSha256));
@@ -2910,13 +3006,10 @@ int CServer::LoadMap(const char *pMapName)
 	str_copy(m_aCurrentMap, pMapName);
 	m_pCurrentMapName = fs_filename(m_aCurrentMap);
 
-	// load complete map into memory for download
-	{
-		free(m_apCurrentMapData[MAP_TYPE_SIX]);
-		void *pData;
-		Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIX]);
-		m_apCurrentMapData[MAP_TYPE_SIX] = (unsigned char *)pData;
-	}
+	// complete map in memory for download
+	m_apCurrentMapFile[MAP_TYPE_SIX] = pPreload->m_pMapFile;
+	m_apCurrentMapData[MAP_TYPE_SIX] = m_apCurrentMapFile[MAP_TYPE_SIX]->m_pData;
+	m_aCurrentMapSize[MAP_TYPE_SIX] = m_apCurrentMapFile[MAP_TYPE_SIX]->m_Size;
 
 	if(Config()->m_SvMapsBaseUrl[0])
 	{
@@ -2930,36 +3023,34 @@ int CServer::LoadMap(const char *pMapName)
 		m_aMapDownloadUrl[0] = '\0';
 	}
 
-	// load sixup version of the map
+	// sixup version of the map
 	if(Config()->m_SvSixup)
 	{
-		str_format(aBuf, sizeof(aBuf), "maps7/%s.map", pMapName);
-		void *pData;
-		if(!Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIXUP]))
+		if(!pPreload->m_pSixupMapFile)
 		{
 			Config()->m_SvSixup = 0;
 			if(m_pRegister)
 			{
 				m_pRegister->OnConfigChange();
 			}
-			log_error("sixup", "couldn't load map %s", aBuf);
+			log_error("sixup", "couldn't load map %s", pPreload->m_aSixupPath);
 			log_info("sixup", "disabling 0.7 compatibility");
 		}
 		else
 		{
-			free(m_apCurrentMapData[MAP_TYPE_SIXUP]);
-			m_apCurrentMapData[MAP_TYPE_SIXUP] = (unsigned char *)pData;
-
-			m_aCurrentMapSha256[MAP_TYPE_SIXUP] = sha256(m_apCurrentMapData[MAP_TYPE_SIXUP], m_aCurrentMapSize[MAP_TYPE_SIXUP]);
-			m_aCurrentMapCrc[MAP_TYPE_SIXUP] = crc32(0, m_apCurrentMapData[MAP_TYPE_SIXUP], m_aCurrentMapSize[MAP_TYPE_SIXUP]);
+			m_apCurrentMapFile[MAP_TYPE_SIXUP] = pPreload->m_pSixupMapFile;
+			m_apCurrentMapData[MAP_TYPE_SIXUP] = m_apCurrentMapFile[MAP_TYPE_SIXUP]->m_pData;
+			m_aCurrentMapSize[MAP_TYPE_SIXUP] = m_apCurrentMapFile[MAP_TYPE_SIXUP]->m_Size;
+			m_aCurrentMapSha256[MAP_TYPE_SIXUP] = m_apCurrentMapFile[MAP_TYPE_SIXUP]->m_Sha256;
+			m_aCurrentMapCrc[MAP_TYPE_SIXUP] = m_apCurrentMapFile[MAP_TYPE_SIXUP]->m_Crc;
 			sha256_str(m_aCurrentMapSha256[MAP_TYPE_SIXUP], aSha256, sizeof(aSha256));
-			str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", aBuf, aSha256);
+			str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", pPreload->m_aSixupPath, aSha256);
 			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "sixup", aBufMsg);
 		}
 	}
 	if(!Config()->m_SvSixup)
 	{
-		free(m_apCurrentMapData[MAP_TYPE_SIXUP]);
+		m_apCurrentMapFile[MAP_TYPE_SIXUP] = nullptr;
 		m_apCurrentMapData[MAP_TYPE_SIXUP] = nullptr;
 	}
 
@@ -3018,16 +3109,54 @@ void CServer::UpdateDebugDummies(bool ForceDisconnect)
 		{
 			CNetObj_PlayerInput Input = {0};
 			Input.m_Direction = (ClientId & 1) ? -1 : 1;
-			Client.m_aInputs[0].m_GameTick = Tick() + 1;
-			mem_copy(Client.m_aInputs[0].m_aData, &Input, minimum(sizeof(Input), sizeof(Client.m_aInputs[0].m_aData)));
-			Client.m_LatestInput = Client.m_aInputs[0];
-			Client.m_CurrentInput = 0;
+			static_assert(sizeof(Input) <= sizeof(Client.m_LatestInput.m_aData));
+			mem_zero(&Client.m_LatestInput, sizeof(Client.m_LatestInput));
+			mem_copy(Client.m_LatestInput.m_aData, &Input, sizeof(Input));
+			const int TimeLeft = (TickStartTime(Tick() + 1) - time_get()) / (time_freq() / 1000);
+			Client.m_LatestInput.m_GameTick = Client.m_Inputs.Add(Client.m_LatestInput.m_aData, MAX_INPUT_SIZE, Tick() + 1, Tick(), TimeLeft);
 		}
 	}
 
 	m_PreviousDebugDummies = ForceDisconnect ? 0 : g_Config.m_DbgDummies;
 }
 
+void CServer::RunGameTick()
+{
+	{
+		CProfiler::CScope Scope(&m_Profiler, m_ProfileTeehistorian);
+		GameServer()->OnPreTickTeehistorian();
+	}
+	UpdateDebugDummies(false);
+
+	{
+		CProfiler::CScope Scope(&m_Profiler, m_ProfileEarlyInput);
+		for(int c = 0; c < MAX_CLIENTS; c++)
+		{
+			if(m_aClients[c].m_State != CClient::STATE_INGAME)
+				continue;
+			GameServer()->OnClientPredictedEarlyInput(c, m_aClients[c].m_Inputs.Get(Tick() + 1));
+		}
+	}
+
+	m_CurrentGameTick++;
+
+	// apply new input
+	{
+		CProfiler::CScope Scope(&m_Profiler, m_ProfileInput);
+		for(int c = 0; c < MAX_CLIENTS; c++)
+		{
+			if(m_aClients[c].m_State != CClient::STATE_INGAME)
+				continue;
+			GameServer()->OnClientPredictedInput(c, m_aClients[c].m_Inputs.Consume(Tick()));
+		}
+	}
+
+	{
+		CProfiler::CScope Scope(&m_Profiler, m_ProfileGameTick);
+		GameServer()->OnTick();
+	}
+}
+
 int CServer::Run()
 {
 	if(m_RunServer == UNINITIALIZED)
@@ -3110,12 +3239,32 @@ int CServer::Run()
 	}
 
 	m_pEngine = Kernel()->RequestInterface<IEngine>();
+	for(auto &Recorder : m_aDemoRecorder)
+		Recorder.RecordAsync(m_pEngine);
 	m_pRegister = CreateRegister(&g_Config, m_pConsole, m_pEngine, &m_Http, g_Config.m_SvRegisterPort > 0 ? g_Config.m_SvRegisterPort : this->Port(), m_NetServer.GetGlobalToken());
 
 	m_NetServer.SetCallbacks(NewClientCallback, NewClientNoAuthCallback, ClientRejoinCallback, DelClientCallback, this);
 
 	m_Econ.Init(Config(), Console(), &m_ServerBan);
 
+	m_NetServer.SetMetrics(&m_Metrics);
+	if(Config()->m_SvMetricsPort)
+	{
+		NETADDR MetricsAddr;
+		if(net_host_lookup(Config()->m_SvMetricsBindaddr, &MetricsAddr, NETTYPE_ALL) != 0)
+		{
+			log_error("metrics", "the configured bindaddr '%s' cannot be resolved", Config()->m_SvMetricsBindaddr);
+		}
+		else
+		{
+			MetricsAddr.port = Config()->m_SvMetricsPort;
+			if(m_MetricsServer.Open(MetricsAddr, &m_Metrics))
+				log_info("metrics", "serving metrics at http://%s:%d/metrics", Config()->m_SvMetricsBindaddr, Config()->m_SvMetricsPort);
+			else
+				log_error("metrics", "couldn't open socket. port %d might already be in use", Config()->m_SvMetricsPort);
+		}
+	}
+
 	m_Fifo.Init(Console(), Config()->m_SvInputFifo, CFGFLAG_SERVER);
 
 	char aBuf[256];
@@ -3159,16 +3308,22 @@ int CServer::Run()
 		UpdateServerInfo(false);
 		while(m_RunServer < STOPPING)
 		{
+			m_Profiler.SetEnabled(Config()->m_SvProfile);
+			const std::chrono::nanoseconds FrameStart = m_Profiler.Enabled() ? time_get_nanoseconds() : 0ns;
+
 			if(NonActive)
+			{
+				CProfiler::CScope Scope(&m_Profiler, m_ProfilePumpNetwork);
 				PumpNetwork(PacketWaiting);
+			}
 
 			set_new_tick();
 
 			int64_t LastTime = time_get();
 			int NewTicks = 0;
 
-			// load new map
-			if(m_MapReload || m_SameMapReload || m_CurrentGameTick >= MAX_TICK) // force reload to make sure the ticks stay within a valid range
+			// load new map, keep ticking the current one while the next one is prepared
+			if((m_MapReload || m_SameMapReload || m_CurrentGameTick >= MAX_TICK) && !MapPreloadPending()) // force reload to make sure the ticks stay within a valid range
 			{
 				const bool SameMapReload = m_SameMapReload;
 				// load map
@@ -3246,50 +3401,10 @@ int CServer::Run()
 
 			while(LastTime > TickStartTime(m_CurrentGameTick + 1))
 			{
-				GameServer()->OnPreTickTeehistorian();
-				UpdateDebugDummies(false);
-
-				for(int c = 0; c < MAX_CLIENTS; c++)
-				{
-					if(m_aClients[c].m_State != CClient::STATE_INGAME)
-						continue;
-					bool ClientHadInput = false;
-					for(auto &Input : m_aClients[c].m_aInputs)
-					{
-						if(Input.m_GameTick == Tick() + 1)
-						{
-							GameServer()->OnClientPredictedEarlyInput(c, Input.m_aData);
-							ClientHadInput = true;
-							break;
-						}
-					}
-					if(!ClientHadInput)
-						GameServer()->OnClientPredictedEarlyInput(c, nullptr);
-				}
-
-				m_CurrentGameTick++;
+				const std::chrono::nanoseconds TickStart = time_get_nanoseconds();
+				RunGameTick();
+				m_pMetricTickDuration->Observe(std::chrono::duration<double>(time_get_nanoseconds() - TickStart).count());
 				NewTicks++;
-
-				// apply new input
-				for(int c = 0; c < MAX_CLIENTS; c++)
-				{
-					if(m_aClients[c].m_State != CClient::STATE_INGAME)
-						continue;
-					bool ClientHadInput = false;
-					for(auto &Input : m_aClients[c].m_aInputs)
-					{
-						if(Input.m_GameTick == Tick())
-						{
-							GameServer()->OnClientPredictedInput(c, Input.m_aData);
-							ClientHadInput = true;
-							break;
-						}
-					}
-					if(!ClientHadInput)
-						GameServer()->OnClientPredictedInput(c, nullptr);
-				}
-
-				GameServer()->OnTick();
 				if(ErrorShutdown())
 				{
 					break;
@@ -3299,7 +3414,10 @@ int CServer::Run()
 			// snap game
 			if(NewTicks)
 			{
-				DoSnapshot();
+				{
+					CProfiler::CScope Scope(&m_Profiler, m_ProfileSnapshot);
+					DoSnapshot();
+				}
 
 				const int CommandSendingClientId = Tick() % MAX_CLIENTS;
 				UpdateClientRconCommands(CommandSendingClientId);
@@ -3316,7 +3434,10 @@ int CServer::Run()
 #endif
 
 				// master server stuff
-				m_pRegister->Update();
+				{
+					CProfiler::CScope Scope(&m_Profiler, m_ProfileRegister);
+					m_pRegister->Update();
+				}
 
 				if(m_ServerInfoNeedsUpdate)
 				{
@@ -3378,7 +3499,17 @@ int CServer::Run()
 			}
 
 			if(!NonActive)
+			{
+				CProfiler::CScope Scope(&m_Profiler, m_ProfilePumpNetwork);
 				PumpNetwork(PacketWaiting);
+			}
+
+			if(NewTicks)
+			{
+				UpdateProfiler(FrameStart);
+				// an empty server sleeps for up to a second and catches up afterwards
+				UpdateMetrics(NonActive ? 0 : NewTicks - 1);
+			}
 
 			NonActive = true;
 			for(const auto &Client : m_aClients)
@@ -3451,6 +3582,7 @@ int CServer::Run()
 
 	m_pRegister->OnShutdown();
 	m_Econ.Shutdown();
+	m_MetricsServer.Close();
 	m_Fifo.Shutdown();
 	Engine()->ShutdownJobs();
 
@@ -3529,9 +3661,14 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 			{
 				pClientPrefix = "0.7:";
 			}
-			str_format(aBuf, sizeof(aBuf), "id=%d addr=<{%s}> name='%s' client=%s%d secure=%s flags=%d%s%s",
+			const CInputBuffer::CStats &InputStats = pThis->m_aClients[i].m_Inputs.Stats();
+			char aInputStr[128];
+			str_format(aInputStr, sizeof(aInputStr), " input_margin=%dms input_jitter=%dms input_late=%d%% input_missing=%d",
+				round_to_int(InputStats.m_MarginAvg), round_to_int(InputStats.m_MarginJitter), InputStats.LatePercent(), InputStats.m_NumMissing);
+
+			str_format(aBuf, sizeof(aBuf), "id=%d addr=<{%s}> name='%s' client=%s%d secure=%s flags=%d%s%s%s",
 				i, pThis->ClientAddrString(i, true), pThis->m_aClients[i].m_aName, pClientPrefix, pThis->m_aClients[i].m_DDNetVersion,
-				pThis->m_NetServer.HasSecurityToken(i) ? "yes" : "no", pThis->m_aClients[i].m_Flags, aDnsblStr, aAuthStr);
+				pThis->m_NetServer.HasSecurityToken(i) ? "yes" : "no", pThis->m_aClients[i].m_Flags, aDnsblStr, aAuthStr, aInputStr);
 		}
 		else
 		{
@@ -4076,6 +4213,22 @@ void CServer::ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData)
 	}
 }
 
+void CServer::ConProfileDump(IConsole::IResult *pResult, void *pUserData)
+{
+	CServer *pThis = static_cast<CServer *>(pUserData);
+	if(!pThis->Config()->m_SvProfile)
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", "profiling is disabled, enable it with sv_profile 1");
+	pThis->m_Profiler.Print([pThis](const char *pLine) {
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", pLine);
+	});
+}
+
+void CServer::ConProfileReset(IConsole::IResult *pResult, void *pUserData)
+{
+	CServer *pThis = static_cast<CServer *>(pUserData);
+	pThis->m_Profiler.Reset();
+}
+
 void CServer::ConReloadAnnouncement(IConsole::IResult *pResult, void *pUserData)
 {
 	CServer *pThis = static_cast<CServer *>(pUserData);
@@ -4249,6 +4402,29 @@ void CServer::ConchainMapUpdate(IConsole::IResult *pResult, void *pUserData, ICo
 	{
 		CServer *pThis = static_cast<CServer *>(pUserData);
 		pThis->m_MapReload = str_comp(pThis->Config()->m_SvMap, pThis->m_aCurrentMap) != 0;
+		if(pThis->m_MapReload && pThis->m_aCurrentMap[0] != '\0')
+			pThis->PreloadMap(pThis->Config()->m_SvMap);
+	}
+}
+
+void CServer::ConchainMapCacheUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	if(pResult->NumArguments() >= 1)
+	{
+		CServer *pThis = static_cast<CServer *>(pUserData);
+		pThis->m_MapCache.SetBudget((int64_t)pThis->Config()->m_SvMapCacheSize * 1024 * 1024);
+		pThis->m_MapCache.SetDirectory(pThis->Config()->m_SvMapCacheDir);
+	}
+}
+
+void CServer::ConchainStorageIndex(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	if(pResult->NumArguments() >= 1)
+	{
+		CServer *pThis = static_cast<CServer *>(pUserData);
+		pThis->Storage()->SetIndexEnabled(pThis->Config()->m_StorageIndex != 0);
 	}
 }
 
@@ -4374,6 +4550,9 @@ void CServer::RegisterCommands()
 	Console()->Register("add_sqlserver", "s['r'|'w'] s[Database] s[Prefix] s[User] s[Password] s[IP] i[Port] ?i[SetUpDatabase ?]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAddSqlServer, this, "add a sqlserver");
 	Console()->Register("dump_sqlservers", "s['r'|'w']", CFGFLAG_SERVER, ConDumpSqlServers, this, "dumps all sqlservers readservers = r, writeservers = w");
 
+	Console()->Register("profile_dump", "", CFGFLAG_SERVER, ConProfileDump, this, "Print percentiles of the time spent in each phase of the server tick");
+	Console()->Register("profile_reset", "", CFGFLAG_SERVER, ConProfileReset, this, "Clear the recorded tick profile");
+
 	Console()->Register("auth_add", "s[ident] s[level] r[pw]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAdd, this, "Add a rcon key");
 	Console()->Register("auth_add_p", "s[ident] s[level] s[hash] s[salt]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAddHashed, this, "Add a prehashed rcon key");
 	Console()->Register("auth_change", "s[ident] s[level] r[pw]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthUpdate, this, "Update a rcon key");
@@ -4399,6 +4578,9 @@ void CServer::RegisterCommands()
 	Console()->Chain("sv_rcon_helper_password", ConchainRconHelperPasswordChange, this);
 	Console()->Chain("sv_map", ConchainMapUpdate, this);
 	Console()->Chain("sv_sixup", ConchainSixupUpdate, this);
+	Console()->Chain("sv_map_cache_size", ConchainMapCacheUpdate, this);
+	Console()->Chain("sv_map_cache_dir", ConchainMapCacheUpdate, this);
+	Console()->Chain("storage_index", ConchainStorageIndex, this);
 	Console()->Chain("sv_register_community_token", ConchainRegisterCommunityTokenRedact, nullptr);
 
 	Console()->Chain("loglevel", ConchainLoglevel, this);
@@ -4440,6 +4622,17 @@ void CServer::SnapSetStaticsize(int ItemType, int Size)
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
 }
 
+void CServer::SnapSetPriority(int Priority)
+{
+	static_assert((int)SNAP_PRIORITY_REQUIRED == (int)CSnapshotBuilder::PRIORITY_REQUIRED);
+	m_SnapshotBuilder.SetPriority(Priority);
+}
+
+void CServer::SnapSetUpdatePeriod(int Ticks)
+{
+	m_SnapshotBuilder.SetUpdatePeriod(Ticks);
+}
+
 CServer *CreateServer() { return new CServer(); }
 
 // DDRace
@@ -4600,6 +4793,41 @@ void CServer::SetErrorShutdown(const char *pReason)
 	str_copy(m_aErrorShutdownReason, pReason);
 }
 
+void CServer::UpdateProfiler(std::chrono::nanoseconds FrameStart)
+{
+	if(!m_Profiler.Enabled())
+		return;
+
+	m_Profiler.Add(m_ProfileFrame, time_get_nanoseconds() - FrameStart);
+	m_Profiler.EndFrame();
+
+	const int64_t Now = time_get();
+	if(Config()->m_SvProfileEconInterval > 0 && Now > m_LastProfileEconTime + Config()->m_SvProfileEconInterval * time_freq())
+	{
+		m_LastProfileEconTime = Now;
+		m_Profiler.Print([this](const char *pLine) {
+			char aBuf[256];
+			str_format(aBuf, sizeof(aBuf), "[profile]: %s", pLine);
+			m_Econ.Send(-1, aBuf);
+		});
+	}
+}
+
+void CServer::UpdateMetrics(int LateTicks)
+{
+	m_pMetricTickOverruns->Add(LateTicks);
+
+	int NumClients = 0;
+	int NumPlayers = 0;
+	for(const CClient &Client : m_aClients)
+	{
+		NumClients += Client.m_State > CClient::STATE_EMPTY;
+		NumPlayers += Client.m_State == CClient::STATE_INGAME;
+	}
+	m_pMetricClients->Set(NumClients);
+	m_pMetricPlayers->Set(NumPlayers);
+}
+
 void CServer::SetLoggers(std::shared_ptr<ILogger> &&pFileLogger, std::shared_ptr<ILogger> &&pStdoutLogger)
 {
 	m_pFileLogger = pFileLogger;
@@ -5,6 +5,10 @@
 
 #include "antibot.h"
 #include "authmanager.h"
+#include "info_rate_limiter.h"
+#include "input_buffer.h"
+#include "map_cache.h"
+#include "metrics_server.h"
 #include "name_ban.h"
 #include "snap_id_pool.h"
 
@@ -16,8 +20,10 @@
 #include <engine/shared/econ.h>
 #include <engine/shared/fifo.h>
 #include <engine/shared/http.h>
+#include <engine/shared/metrics.h>
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/snapshot.h>
 #include <engine/shared/uuid_manager.h>
@@ -63,6 +69,7 @@ class CServer : public IServer
 {
 	friend class CServerLogger;
 
+	class CServerLogger *m_pServerLogger = nullptr;
 	class IGameServer *m_pGameServer;
 	class CConfig *m_pConfig;
 	class IConsole *m_pConsole;
@@ -150,11 +157,12 @@ public:
 		int m_LastAckedSnapshot;
 		int m_LastInputTick;
 		CSnapshotStorage m_Snapshots;
+		CSnapshotStarvation m_SnapshotStarvation;
+		CMetrics::CCounter *m_pMetricSnapshotStaleBytes;
 
 		CNetMsg_Sv_PreInput m_LastPreInput = {};
 		CInput m_LatestInput;
-		CInput m_aInputs[200]; // TODO: handle input better
-		int m_CurrentInput;
+		CInputBuffer m_Inputs;
 
 		char m_aName[MAX_NAME_LENGTH];
 		char m_aClan[MAX_CLAN_LENGTH];
@@ -221,6 +229,28 @@ public:
 	CServerBan m_ServerBan;
 	CHttp m_Http;
 
+	CProfiler m_Profiler;
+	int m_ProfileFrame;
+	int m_ProfilePumpNetwork;
+	int m_ProfileTeehistorian;
+	int m_ProfileEarlyInput;
+	int m_ProfileInput;
+	int m_ProfileGameTick;
+	int m_ProfileSnapshot;
+	int m_ProfileRegister;
+	int64_t m_LastProfileEconTime;
+
+	CMetrics m_Metrics;
+	// declared after the metrics, stops reading them first
+	CMetricsServer m_MetricsServer;
+	CMetrics::CGauge *m_pMetricClients;
+	CMetrics::CGauge *m_pMetricPlayers;
+	CMetrics::CHistogram *m_pMetricTickDuration;
+	CMetrics::CCounter *m_pMetricTickOverruns;
+	CMetrics::CHistogram *m_pMetricSnapshotSize;
+	CMetrics::CCounter *m_pMetricSnapshotBudgetHits;
+	CMetrics::CCounter *m_pMetricSnapshotCutItems;
+
 	IEngineMap *m_pMap;
 
 	int64_t m_GameStartTime;
@@ -262,14 +292,23 @@ public:
 	SHA256_DIGEST m_aCurrentMapSha256[NUM_MAP_TYPES];
 	unsigned m_aCurrentMapCrc[NUM_MAP_TYPES];
 	unsigned char *m_apCurrentMapData[NUM_MAP_TYPES];
+	std::shared_ptr<const CMapCache::CEntry> m_apCurrentMapFile[NUM_MAP_TYPES];
 	unsigned int m_aCurrentMapSize[NUM_MAP_TYPES];
 	char m_aMapDownloadUrl[256];
 
+	enum
+	{
+		MAP_PRELOAD_REUSE_SECONDS = 60,
+	};
+	std::shared_ptr<class CMapPreload> m_pMapPreload;
+	CMapCache m_MapCache;
+
 	CDemoRecorder m_aDemoRecorder[NUM_RECORDERS];
 	CAuthManager m_AuthManager;
 
 	int64_t m_ServerInfoFirstRequest;
 	int m_ServerInfoNumRequests;
+	CInfoRateLimiter m_ServerInfoRateLimiter;
 
 	char m_aErrorShutdownReason[128];
 
@@ -334,6 +373,8 @@ public:
 	int SendMsg(CMsgPacker *pMsg, int Flags, int ClientId) override;
 
 	void DoSnapshot();
+	// advances the game by one tick, applying the inputs stored for it
+	void RunGameTick();
 
 	static int NewClientCallback(int ClientId, void *pUser, bool Sixup);
 	static int NewClientNoAuthCallback(int ClientId, void *pUser);
@@ -381,11 +422,14 @@ public:
 		class CCacheChunk
 		{
 		public:
-			CCacheChunk(const void *pData, int Size);
+			CCacheChunk(const void *pHeader, int HeaderSize, const void *pData, int Size);
 			CCacheChunk(const CCacheChunk &) = delete;
 			CCacheChunk(CCacheChunk &&) = default;
 
+			// the reply header, followed by the data; the token of the
+			// request goes between them
 			std::vector<uint8_t> m_vData;
+			int m_HeaderSize;
 		};
 
 		std::vector<CCacheChunk> m_vCache;
@@ -394,6 +438,7 @@ public:
 		~CCache();
 
 		void AddChunk(const void *pData, int Size);
+		void AddChunk(const void *pHeader, int HeaderSize, const void *pData, int Size);
 		void Clear();
 	};
 	CCache m_aServerInfoCache[3 * 2];
@@ -409,7 +454,7 @@ public:
 	void CacheServerInfoSixup(CCache *pCache, bool SendClients, int MaxConsideredClients);
 	void SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients);
 	void GetServerInfoSixup(CPacker *pPacker, bool SendClients);
-	bool RateLimitServerInfoConnless();
+	bool RateLimitServerInfoConnless(const NETADDR *pAddr);
 	void SendServerInfoConnless(const NETADDR *pAddr, int Token, int Type);
 	void UpdateRegisterServerInfo();
 	void UpdateServerInfo(bool Resend);
@@ -419,6 +464,9 @@ public:
 	void ChangeMap(const char *pMap) override;
 	const char *GetMapName() const override;
 	void ReloadMap() override;
+	void PreloadMap(const char *pMapName) override;
+	void StartMapPreload(const char *pMapName);
+	bool MapPreloadPending() const;
 	int LoadMap(const char *pMapName);
 
 	void SaveDemo(int ClientId, float Time) override;
@@ -451,6 +499,9 @@ public:
 	static void ConAddSqlServer(IConsole::IResult *pResult, void *pUserData);
 	static void ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData);
 
+	static void ConProfileDump(IConsole::IResult *pResult, void *pUserData);
+	static void ConProfileReset(IConsole::IResult *pResult, void *pUserData);
+
 	static void ConReloadAnnouncement(IConsole::IResult *pResult, void *pUserData);
 	static void ConReloadMaplist(IConsole::IResult *pResult, void *pUserData);
 
@@ -466,6 +517,8 @@ public:
 	static void ConchainRconModPasswordChange(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainRconHelperPasswordChange(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMapUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainMapCacheUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainStorageIndex(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainSixupUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainRegisterCommunityTokenRedact(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainLoglevel(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -483,6 +536,8 @@ public:
 	void SnapFreeId(int Id) override;
 	void *SnapNewItem(int Type, int Id, int Size) override;
 	void SnapSetStaticsize(int ItemType, int Size) override;
+	void SnapSetPriority(int Priority) override;
+	void SnapSetUpdatePeriod(int Ticks) override;
 
 	// DDRace
 
@@ -526,6 +581,13 @@ public:
 
 	bool IsSixup(int ClientId) const override { return ClientId != SERVER_DEMO_CLIENT && m_aClients[ClientId].m_Sixup; }
 
+	CProfiler *Profiler() override { return &m_Profiler; }
+	void UpdateProfiler(std::chrono::nanoseconds FrameStart);
+
+	CMetrics *Metrics() override { return &m_Metrics; }
+	// `LateTicks` are the ticks of the frame that ran late, after the first one
+	void UpdateMetrics(int LateTicks);
+
 	void SetLoggers(std::shared_ptr<ILogger> &&pFileLogger, std::shared_ptr<ILogger> &&pStdoutLogger);
 
 #ifdef CONF_FAMILY_UNIX
@@ -7,6 +7,7 @@ CServerLogger::CServerLogger(CServer *pServer) :
 	m_MainThread(std::this_thread::get_id())
 {
 	dbg_assert(pServer != nullptr, "server pointer must not be null");
+	m_pServer->m_pServerLogger = this;
 }
 
 void CServerLogger::Log(const CLogMessage *pMessage)
@@ -40,8 +41,28 @@ void CServerLogger::Log(const CLogMessage *pMessage)
 	}
 }
 
+void CServerLogger::SendPending()
+{
+	dbg_assert(m_MainThread == std::this_thread::get_id(), "CServerLogger::SendPending not called from the main thread");
+	std::vector<CLogMessage> vPending;
+	{
+		const CLockScope LockScope(m_PendingLock);
+		if(m_vPending.empty())
+			return;
+		std::swap(vPending, m_vPending);
+	}
+	if(m_pServer)
+	{
+		for(const auto &Message : vPending)
+		{
+			m_pServer->SendLogLine(&Message);
+		}
+	}
+}
+
 void CServerLogger::OnServerDeletion()
 {
 	dbg_assert(m_MainThread == std::this_thread::get_id(), "CServerLogger::OnServerDeletion not called from the main thread");
+	m_pServer->m_pServerLogger = nullptr;
 	m_pServer = nullptr;
 }
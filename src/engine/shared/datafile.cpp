@@ -9,18 +9,24 @@
 #include <base/log.h>
 #include <base/math.h>
 #include <base/system.h>
+#include <base/thread.h>
 
 #include <engine/storage.h>
 
 #include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <limits>
+#include <numeric>
+#include <thread>
 #include <unordered_set>
 
 static constexpr int MAX_ITEM_TYPE = 0xFFFF;
 static constexpr int MAX_ITEM_ID = 0xFFFF;
 static constexpr int OFFSET_UUID_TYPE = 0x8000;
+static constexpr int64_t PARALLEL_COMPRESSION_MIN_SIZE = 256 * 1024;
 
 static inline void SwapEndianInPlace(void *pObj, size_t Size)
 {
@@ -442,7 +448,7 @@ CDataFileReader &CDataFileReader::operator=(CDataFileReader &&Other)
 	return *this;
 }
 
-bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType)
+bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType, const CKnownHashes *pKnownHashes)
 {
 	dbg_assert(m_pDataFile == nullptr, "File already open");
 
@@ -459,6 +465,13 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	int64_t FileSize = 0;
 	unsigned Crc = 0;
 	SHA256_DIGEST Sha256;
+	if(pKnownHashes && io_length(File) == pKnownHashes->m_Size)
+	{
+		FileSize = pKnownHashes->m_Size;
+		Crc = pKnownHashes->m_Crc;
+		Sha256 = pKnownHashes->m_Sha256;
+	}
+	else
 	{
 		SHA256_CTX Sha256Ctxt;
 		sha256_init(&Sha256Ctxt);
@@ -753,6 +766,17 @@ void CDataFileReader::UnloadData(int Index)
 	m_pDataFile->m_pDataSizes[Index] = 0;
 }
 
+void *CDataFileReader::ReleaseData(int Index)
+{
+	void *pData = GetData(Index);
+	if(pData != nullptr)
+	{
+		m_pDataFile->m_ppDataPtrs[Index] = nullptr;
+		m_pDataFile->m_pDataSizes[Index] = 0;
+	}
+	return pData;
+}
+
 int CDataFileReader::NumData() const
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
@@ -918,6 +942,7 @@ int CDataFileReader::Size() const
 CDataFileWriter::CDataFileWriter()
 {
 	m_File = nullptr;
+	m_CompressionThreads = 0;
 }
 
 CDataFileWriter::~CDataFileWriter()
@@ -1061,6 +1086,23 @@ int CDataFileWriter::AddData(size_t Size, const void *pData, ECompressionLevel C
 	return m_vDatas.size() - 1;
 }
 
+int CDataFileWriter::AddDataOwned(size_t Size, void *pData, ECompressionLevel CompressionLevel)
+{
+	dbg_assert(Size > 0 && pData != nullptr, "Data missing");
+	dbg_assert(Size <= (size_t)std::numeric_limits<int>::max(), "Data too large");
+	dbg_assert(m_vDatas.size() < (size_t)std::numeric_limits<int>::max(), "Too many data");
+
+	CDataInfo Info;
+	Info.m_pUncompressedData = pData;
+	Info.m_UncompressedSize = Size;
+	Info.m_pCompressedData = nullptr;
+	Info.m_CompressedSize = 0;
+	Info.m_CompressionLevel = CompressionLevel;
+	m_vDatas.emplace_back(Info);
+
+	return m_vDatas.size() - 1;
+}
+
 int CDataFileWriter::AddDataSwapped(size_t Size, const void *pData)
 {
 	dbg_assert(Size > 0 && pData != nullptr, "Data missing");
@@ -1104,14 +1146,22 @@ static int CompressionLevelToZlib(CDataFileWriter::ECompressionLevel Compression
 	}
 }
 
-void CDataFileWriter::Finish()
+// The data blocks which are not compressed yet, shared by the compression threads.
+class CDataFileWriter::CCompressionQueue
 {
-	dbg_assert((bool)m_File, "File not open");
+public:
+	std::vector<CDataInfo> *m_pvDatas;
+	// largest first, so the threads finish at about the same time
+	std::vector<int> m_vOrder;
+	std::atomic<size_t> m_Next = 0;
+};
 
-	// Compress data. This takes the majority of the time when saving a datafile,
-	// so it's delayed until the end so it can be off-loaded to another thread.
-	for(CDataInfo &DataInfo : m_vDatas)
+void CDataFileWriter::CompressThread(void *pUser)
+{
+	CCompressionQueue *pQueue = static_cast<CCompressionQueue *>(pUser);
+	for(size_t Next = pQueue->m_Next++; Next < pQueue->m_vOrder.size(); Next = pQueue->m_Next++)
 	{
+		CDataInfo &DataInfo = (*pQueue->m_pvDatas)[pQueue->m_vOrder[Next]];
 		unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
 		DataInfo.m_pCompressedData = malloc(CompressedSize);
 		const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
@@ -1120,6 +1170,43 @@ void CDataFileWriter::Finish()
 		DataInfo.m_pUncompressedData = nullptr;
 		dbg_assert(Result == Z_OK, "datafile zlib compression failed with error %d", Result);
 	}
+}
+
+void CDataFileWriter::CompressDatas()
+{
+	CCompressionQueue Queue;
+	Queue.m_pvDatas = &m_vDatas;
+	Queue.m_vOrder.resize(m_vDatas.size());
+	std::iota(Queue.m_vOrder.begin(), Queue.m_vOrder.end(), 0);
+	std::stable_sort(Queue.m_vOrder.begin(), Queue.m_vOrder.end(), [&](int Left, int Right) {
+		return m_vDatas[Left].m_UncompressedSize > m_vDatas[Right].m_UncompressedSize;
+	});
+
+	// starting threads is not worth it for small files
+	int64_t TotalSize = 0;
+	for(const CDataInfo &DataInfo : m_vDatas)
+		TotalSize += DataInfo.m_UncompressedSize;
+	int NumThreads = m_CompressionThreads > 0 ? m_CompressionThreads : (int)std::thread::hardware_concurrency();
+	if(TotalSize < PARALLEL_COMPRESSION_MIN_SIZE)
+		NumThreads = 1;
+	NumThreads = std::clamp<int>(NumThreads, 1, maximum<int>(m_vDatas.size(), 1));
+
+	// the calling thread compresses as well
+	std::vector<void *> vpThreads;
+	for(int i = 1; i < NumThreads; i++)
+		vpThreads.push_back(thread_init(CompressThread, &Queue, "datafile compression"));
+	CompressThread(&Queue);
+	for(void *pThread : vpThreads)
+		thread_wait(pThread);
+}
+
+void CDataFileWriter::Finish()
+{
+	dbg_assert((bool)m_File, "File not open");
+
+	// Compress data. This takes the majority of the time when saving a datafile,
+	// so it's delayed until the end so it can be off-loaded to other threads.
+	CompressDatas();
 
 	// Calculate total size of items
 	int64_t ItemSize = 0;
@@ -28,10 +28,20 @@ class CDataFileReader
 	int GetInternalItemType(int ExternalType);
 
 public:
+	// hashes of a file that were already calculated, the file is only hashed
+	// again if its size differs
+	class CKnownHashes
+	{
+	public:
+		SHA256_DIGEST m_Sha256;
+		unsigned m_Crc;
+		int64_t m_Size;
+	};
+
 	~CDataFileReader();
 	CDataFileReader &operator=(CDataFileReader &&Other);
 
-	[[nodiscard]] bool Open(class IStorage *pStorage, const char *pFilename, int StorageType);
+	[[nodiscard]] bool Open(class IStorage *pStorage, const char *pFilename, int StorageType, const CKnownHashes *pKnownHashes = nullptr);
 	void Close();
 	bool IsOpen() const;
 	IOHANDLE File() const;
@@ -42,6 +52,7 @@ public:
 	const char *GetDataString(int Index);
 	void ReplaceData(int Index, char *pData, size_t Size); // memory for data must have been allocated with malloc
 	void UnloadData(int Index);
+	void *ReleaseData(int Index); // like GetData, but the caller takes ownership of the data and has to free it
 	int NumData() const;
 
 	int GetItemSize(int Index) const;
@@ -103,7 +114,10 @@ private:
 		CUuid m_Uuid;
 	};
 
+	class CCompressionQueue;
+
 	IOHANDLE m_File;
+	int m_CompressionThreads;
 	std::map<uint16_t, CItemTypeInfo, std::less<>> m_ItemTypes; // item types must be sorted in ascending order
 	std::vector<CItemInfo> m_vItems;
 	std::vector<CDataInfo> m_vDatas;
@@ -111,6 +125,8 @@ private:
 
 	int GetTypeFromIndex(int Index) const;
 	int GetExtendedItemTypeIndex(int Type, const CUuid *pUuid);
+	void CompressDatas();
+	static void CompressThread(void *pUser);
 
 public:
 	CDataFileWriter();
@@ -118,6 +134,7 @@ public:
 	{
 		m_File = Other.m_File;
 		Other.m_File = nullptr;
+		m_CompressionThreads = Other.m_CompressionThreads;
 		m_ItemTypes = std::move(Other.m_ItemTypes);
 		m_vItems = std::move(Other.m_vItems);
 		m_vDatas = std::move(Other.m_vDatas);
@@ -128,8 +145,20 @@ public:
 	[[nodiscard]] bool Open(class IStorage *pStorage, const char *pFilename, int StorageType = IStorage::TYPE_SAVE);
 	int AddItem(int Type, int Id, size_t Size, const void *pData, const CUuid *pUuid = nullptr);
 	int AddData(size_t Size, const void *pData, ECompressionLevel CompressionLevel = COMPRESSION_DEFAULT);
+	/**
+	 * Like @link AddData @endlink, but takes ownership of the data instead of
+	 * copying it.
+	 *
+	 * @param pData Data allocated with `malloc`, freed by the writer.
+	 */
+	int AddDataOwned(size_t Size, void *pData, ECompressionLevel CompressionLevel = COMPRESSION_DEFAULT);
 	int AddDataSwapped(size_t Size, const void *pData);
 	int AddDataString(const char *pStr);
+	/**
+	 * Sets the number of threads compressing the data in @link Finish @endlink,
+	 * `0` to use all hardware threads. The file is the same for any number.
+	 */
+	void SetCompressionThreads(int NumThreads) { m_CompressionThreads = NumThreads; }
 	void Finish();
 };
 
@@ -1,11 +1,15 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/lock.h>
 #include <base/log.h>
 #include <base/math.h>
 #include <base/system.h>
+#include <base/time.h>
 
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/shared/config.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
 #if defined(CONF_VIDEORECORDER)
@@ -48,6 +52,9 @@ CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapDat
 	m_pUser = nullptr;
 	m_LastTickMarker = -1;
 	m_pSnapshotDelta = pSnapshotDelta;
+	m_Writer.m_File = nullptr;
+	m_Writer.m_pSnapshotDelta = pSnapshotDelta;
+	m_Writer.m_LastTickMarker = -1;
 	m_NoMapData = NoMapData;
 }
 
@@ -90,7 +97,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	char aSha256[SHA256_MAXSTRSIZE];
 	sha256_str(Sha256, aSha256, sizeof(aSha256));
 
-	if(!pMapData && !MapFile)
+	if(!m_NoMapData && !pMapData && !MapFile)
 	{
 		// open mapfile
 		char aMapFilename[IO_MAX_PATH_LENGTH];
@@ -216,6 +223,17 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_File = DemoFile;
 	str_copy(m_aCurrentFilename, pFilename);
 
+	mem_zero(&m_AsyncStats, sizeof(m_AsyncStats));
+	if(m_pEngine)
+	{
+		m_pAsyncWriter = std::make_shared<CAsyncWriter>(m_pEngine, DemoFile, m_pSnapshotDelta);
+	}
+	else
+	{
+		m_Writer.m_File = DemoFile;
+		m_Writer.m_LastTickMarker = -1;
+	}
+
 	return 0;
 }
 
@@ -247,7 +265,7 @@ enum
 	CHUNKTYPE_DELTA = 3,
 };
 
-void CDemoRecorder::WriteTickMarker(int Tick, bool Keyframe)
+void CDemoRecorder::CChunkWriter::WriteTickMarker(int Tick, bool Keyframe)
 {
 	if(m_LastTickMarker == -1 || Tick - m_LastTickMarker > CHUNKMASK_TICK || Keyframe)
 	{
@@ -268,11 +286,9 @@ void CDemoRecorder::WriteTickMarker(int Tick, bool Keyframe)
 	}
 
 	m_LastTickMarker = Tick;
-	if(m_FirstTick < 0)
-		m_FirstTick = Tick;
 }
 
-void CDemoRecorder::Write(int Type, const void *pData, int Size)
+void CDemoRecorder::CChunkWriter::Write(int Type, const void *pData, int Size)
 {
 	if(!m_File)
 		return;
@@ -295,6 +311,11 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 	if(Size < 0)
 		return;
 
+	WriteCompressed(Type, aBuffer2, Size);
+}
+
+void CDemoRecorder::CChunkWriter::WriteCompressed(int Type, const void *pData, int Size)
+{
 	unsigned char aChunk[3];
 	aChunk[0] = ((Type & 0x3) << 5);
 	if(Size < 30)
@@ -319,12 +340,12 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 		}
 	}
 
-	io_write(m_File, aBuffer2, Size);
+	io_write(m_File, pData, Size);
 }
 
-void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
+void CDemoRecorder::CChunkWriter::WriteSnapshot(int Tick, bool Keyframe, const void *pData, int Size)
 {
-	if(m_LastKeyFrame == -1 || (Tick - m_LastKeyFrame) > SERVER_TICK_SPEED * 5)
+	if(Keyframe)
 	{
 		// write full tickmarker
 		WriteTickMarker(Tick, true);
@@ -332,7 +353,6 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 		// write snapshot
 		Write(CHUNKTYPE_SNAPSHOT, pData, Size);
 
-		m_LastKeyFrame = Tick;
 		mem_copy(m_aLastSnapshotData, pData, Size);
 	}
 	else
@@ -354,6 +374,225 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 	}
 }
 
+// Queue of the chunks of an asynchronous recording. At most one drain job is
+// queued or running at a time, so the chunks are written in order.
+class CDemoRecorder::CAsyncWriter : public std::enable_shared_from_this<CDemoRecorder::CAsyncWriter>
+{
+	static constexpr size_t MAX_QUEUED_BYTES = 1024 * 1024;
+
+	class CQueuedChunk
+	{
+	public:
+		int m_Type;
+		int m_Tick;
+		bool m_Keyframe;
+		std::vector<unsigned char> m_vData;
+	};
+
+	IEngine *m_pEngine;
+	CSnapshotDelta m_SnapshotDelta;
+	CChunkWriter m_Writer;
+
+	CLock m_Lock;
+	std::deque<CQueuedChunk> m_Queue GUARDED_BY(m_Lock);
+	size_t m_QueuedBytes GUARDED_BY(m_Lock) = 0;
+	std::shared_ptr<CDrainJob> m_pDrainJob GUARDED_BY(m_Lock);
+	bool m_Waiting GUARDED_BY(m_Lock) = false;
+	SEMAPHORE m_Progress;
+
+	void Wake() REQUIRES(m_Lock);
+	void WaitForProgress() REQUIRES(m_Lock);
+	bool HelpDrain() REQUIRES(!m_Lock);
+
+public:
+	CAsyncWriter(IEngine *pEngine, IOHANDLE File, CSnapshotDelta *pSnapshotDelta);
+	~CAsyncWriter();
+
+	void Push(int Type, int Tick, bool Keyframe, const void *pData, int Size, CAsyncStats *pStats) REQUIRES(!m_Lock);
+	void Drain() REQUIRES(!m_Lock);
+	void Flush() REQUIRES(!m_Lock);
+};
+
+class CDemoRecorder::CDrainJob : public IJob
+{
+	std::shared_ptr<CAsyncWriter> m_pWriter;
+	std::atomic<bool> m_Claimed = false;
+
+protected:
+	void Run() override
+	{
+		if(Claim())
+			m_pWriter->Drain();
+	}
+
+public:
+	explicit CDrainJob(std::shared_ptr<CAsyncWriter> pWriter) :
+		m_pWriter(std::move(pWriter))
+	{
+	}
+
+	// Returns true for the first caller, the job pool or a thread that
+	// drains the queue itself because the job did not start yet.
+	bool Claim()
+	{
+		return !m_Claimed.exchange(true);
+	}
+};
+
+CDemoRecorder::CAsyncWriter::CAsyncWriter(IEngine *pEngine, IOHANDLE File, CSnapshotDelta *pSnapshotDelta) :
+	m_pEngine(pEngine),
+	// the delta of the recorder is shared with the thread recording, use a copy
+	m_SnapshotDelta(*pSnapshotDelta)
+{
+	m_Writer.m_File = File;
+	m_Writer.m_pSnapshotDelta = &m_SnapshotDelta;
+	m_Writer.m_LastTickMarker = -1;
+	sphore_init(&m_Progress);
+}
+
+CDemoRecorder::CAsyncWriter::~CAsyncWriter()
+{
+	sphore_destroy(&m_Progress);
+}
+
+void CDemoRecorder::CAsyncWriter::Wake()
+{
+	if(m_Waiting)
+	{
+		m_Waiting = false;
+		sphore_signal(&m_Progress);
+	}
+}
+
+void CDemoRecorder::CAsyncWriter::WaitForProgress()
+{
+	m_Waiting = true;
+	m_Lock.unlock();
+	sphore_wait(&m_Progress);
+	m_Lock.lock();
+}
+
+bool CDemoRecorder::CAsyncWriter::HelpDrain()
+{
+	std::shared_ptr<CDrainJob> pDrainJob;
+	{
+		const CLockScope LockScope(m_Lock);
+		pDrainJob = m_pDrainJob;
+	}
+	if(!pDrainJob || !pDrainJob->Claim())
+		return false;
+	Drain();
+	return true;
+}
+
+void CDemoRecorder::CAsyncWriter::Push(int Type, int Tick, bool Keyframe, const void *pData, int Size, CAsyncStats *pStats)
+{
+	bool Stalled = false;
+	int64_t StallStart = 0;
+	{
+		const CLockScope LockScope(m_Lock);
+		Stalled = m_pDrainJob && m_QueuedBytes + Size > MAX_QUEUED_BYTES;
+	}
+	if(Stalled)
+	{
+		pStats->m_NumStalls++;
+		StallStart = time_get();
+		// do the work of the job if it did not start yet, otherwise wait for it
+		if(!HelpDrain())
+		{
+			m_Lock.lock();
+			while(m_pDrainJob && m_QueuedBytes + Size > MAX_QUEUED_BYTES)
+				WaitForProgress();
+			m_Lock.unlock();
+		}
+		pStats->m_StallTime += time_get() - StallStart;
+	}
+
+	std::shared_ptr<CDrainJob> pNewJob;
+	{
+		const CLockScope LockScope(m_Lock);
+		CQueuedChunk &Chunk = m_Queue.emplace_back();
+		Chunk.m_Type = Type;
+		Chunk.m_Tick = Tick;
+		Chunk.m_Keyframe = Keyframe;
+		Chunk.m_vData.assign((const unsigned char *)pData, (const unsigned char *)pData + Size);
+		m_QueuedBytes += Size;
+		pStats->m_MaxQueuedBytes = maximum(pStats->m_MaxQueuedBytes, (int)m_QueuedBytes);
+		if(!m_pDrainJob)
+		{
+			m_pDrainJob = std::make_shared<CDrainJob>(shared_from_this());
+			pNewJob = m_pDrainJob;
+		}
+	}
+	if(pNewJob)
+		m_pEngine->AddJob(pNewJob);
+}
+
+void CDemoRecorder::CAsyncWriter::Drain()
+{
+	while(true)
+	{
+		CQueuedChunk Chunk;
+		{
+			const CLockScope LockScope(m_Lock);
+			if(m_Queue.empty())
+			{
+				m_pDrainJob = nullptr;
+				Wake();
+				return;
+			}
+			Chunk = std::move(m_Queue.front());
+			m_Queue.pop_front();
+		}
+
+		if(Chunk.m_Type == CHUNKTYPE_SNAPSHOT)
+			m_Writer.WriteSnapshot(Chunk.m_Tick, Chunk.m_Keyframe, Chunk.m_vData.data(), Chunk.m_vData.size());
+		else
+			m_Writer.Write(Chunk.m_Type, Chunk.m_vData.data(), Chunk.m_vData.size());
+
+		{
+			const CLockScope LockScope(m_Lock);
+			m_QueuedBytes -= Chunk.m_vData.size();
+			Wake();
+		}
+	}
+}
+
+void CDemoRecorder::CAsyncWriter::Flush()
+{
+	if(HelpDrain())
+		return;
+	m_Lock.lock();
+	while(m_pDrainJob)
+		WaitForProgress();
+	m_Lock.unlock();
+}
+
+void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
+{
+	const bool Keyframe = m_LastKeyFrame == -1 || (Tick - m_LastKeyFrame) > SERVER_TICK_SPEED * 5;
+	if(Keyframe)
+		m_LastKeyFrame = Tick;
+	m_LastTickMarker = Tick;
+	if(m_FirstTick < 0)
+		m_FirstTick = Tick;
+
+	if(m_pAsyncWriter)
+	{
+		if(!Keyframe)
+		{
+			// same effect on the shared delta as recording synchronously
+			m_pSnapshotDelta->SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, true);
+			m_pSnapshotDelta->SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, true);
+		}
+		m_pAsyncWriter->Push(CHUNKTYPE_SNAPSHOT, Tick, Keyframe, pData, Size, &m_AsyncStats);
+	}
+	else
+	{
+		m_Writer.WriteSnapshot(Tick, Keyframe, pData, Size);
+	}
+}
+
 void CDemoRecorder::RecordMessage(const void *pData, int Size)
 {
 	if(m_pfnFilter)
@@ -363,7 +602,28 @@ void CDemoRecorder::RecordMessage(const void *pData, int Size)
 			return;
 		}
 	}
-	Write(CHUNKTYPE_MESSAGE, pData, Size);
+	if(m_pAsyncWriter)
+		m_pAsyncWriter->Push(CHUNKTYPE_MESSAGE, -1, false, pData, Size, &m_AsyncStats);
+	else
+		m_Writer.Write(CHUNKTYPE_MESSAGE, pData, Size);
+}
+
+void CDemoRecorder::RecordTickMarker(int Tick, bool Keyframe)
+{
+	dbg_assert(!m_pAsyncWriter, "Copying chunks is not supported when recording asynchronously");
+	if(Keyframe)
+		m_LastKeyFrame = Tick;
+	m_LastTickMarker = Tick;
+	if(m_FirstTick < 0)
+		m_FirstTick = Tick;
+	m_Writer.WriteTickMarker(Tick, Keyframe);
+}
+
+void CDemoRecorder::RecordCompressedChunk(int Type, const void *pData, int Size)
+{
+	dbg_assert(!m_pAsyncWriter, "Copying chunks is not supported when recording asynchronously");
+	if(m_Writer.m_File)
+		m_Writer.WriteCompressed(Type, pData, Size);
 }
 
 int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilename)
@@ -371,6 +631,18 @@ int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilena
 	if(!m_File)
 		return -1;
 
+	if(m_pAsyncWriter)
+	{
+		m_pAsyncWriter->Flush();
+		m_pAsyncWriter = nullptr;
+		if(m_AsyncStats.m_NumStalls > 0)
+		{
+			log_info_color(DEMO_PRINT_COLOR, "demo_recorder", "Writing '%s' could not keep up %d times, waited %.2fms in total",
+				m_aCurrentFilename, m_AsyncStats.m_NumStalls, m_AsyncStats.m_StallTime * 1000.0 / time_freq());
+		}
+	}
+	m_Writer.m_File = nullptr;
+
 	if(Mode == IDemoRecorder::EStopMode::KEEP_FILE)
 	{
 		// add the demo length to the header
@@ -497,6 +769,7 @@ void CDemoPlayer::Construct(class CSnapshotDelta *pSnapshotDelta, bool UseVideo)
 
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_LastSnapshotDataSize = -1;
+	m_SnapshotSkipped = false;
 	m_pListener = nullptr;
 	m_UseVideo = UseVideo;
 
@@ -651,7 +924,30 @@ CDemoPlayer::EScanFileResult CDemoPlayer::ScanFile()
 	return ResetToStartPosition(m_vKeyFrames.empty() ? EScanFileResult::ERROR_UNRECOVERABLE : EScanFileResult::SUCCESS);
 }
 
-void CDemoPlayer::DoTick()
+void CDemoPlayer::DeliverSkippedMessages()
+{
+	m_SnapshotSkipped = false;
+	if(m_pListener)
+	{
+		size_t Offset = 0;
+		for(int Size : m_vSkippedMessageSizes)
+		{
+			m_pListener->OnDemoPlayerMessage(m_vSkippedMessageData.data() + Offset, Size);
+			Offset += Size;
+		}
+	}
+	m_vSkippedMessageData.clear();
+	m_vSkippedMessageSizes.clear();
+}
+
+void CDemoPlayer::FinishFastForward()
+{
+	if(m_SnapshotSkipped && m_pListener && m_LastSnapshotDataSize != -1)
+		m_pListener->OnDemoPlayerSnapshot(m_aLastSnapshotData, m_LastSnapshotDataSize);
+	DeliverSkippedMessages();
+}
+
+void CDemoPlayer::DoTick(bool Skip)
 {
 	// update ticks
 	m_Info.m_PreviousTick = m_Info.m_Info.m_CurrentTick;
@@ -667,6 +963,7 @@ void CDemoPlayer::DoTick()
 		const EReadChunkHeaderResult Result = ReadChunkHeader(&ChunkType, &ChunkSize, &ChunkTick);
 		if(Result == CHUNKHEADER_EOF)
 		{
+			FinishFastForward();
 			if(m_Info.m_PreviousTick == -1)
 			{
 				Stop("Empty demo");
@@ -739,12 +1036,16 @@ void CDemoPlayer::DoTick()
 			}
 			else
 			{
-				if(m_pListener)
+				if(Skip)
+					m_SnapshotSkipped = true;
+				else if(m_pListener)
 					m_pListener->OnDemoPlayerSnapshot(m_aSnapshot, DataSize);
 
 				m_LastSnapshotDataSize = DataSize;
 				mem_copy(m_aLastSnapshotData, m_aSnapshot, DataSize);
 				GotSnapshot = true;
+				if(!Skip)
+					DeliverSkippedMessages();
 			}
 		}
 		else if(ChunkType == CHUNKTYPE_SNAPSHOT)
@@ -766,17 +1067,26 @@ void CDemoPlayer::DoTick()
 
 				m_LastSnapshotDataSize = DataSize;
 				mem_copy(m_aLastSnapshotData, m_aChunkData, DataSize);
-				if(m_pListener)
-					m_pListener->OnDemoPlayerSnapshot(m_aChunkData, DataSize);
+				if(Skip)
+				{
+					m_SnapshotSkipped = true;
+				}
+				else
+				{
+					if(m_pListener)
+						m_pListener->OnDemoPlayerSnapshot(m_aChunkData, DataSize);
+					DeliverSkippedMessages();
+				}
 			}
 		}
 		else
 		{
 			// if there were no snapshots in this tick, replay the last one
-			if(!GotSnapshot && m_pListener && m_LastSnapshotDataSize != -1)
+			if(!GotSnapshot && m_pListener && m_LastSnapshotDataSize != -1 && !Skip)
 			{
 				GotSnapshot = true;
 				m_pListener->OnDemoPlayerSnapshot(m_aLastSnapshotData, m_LastSnapshotDataSize);
+				DeliverSkippedMessages();
 			}
 
 			// check the remaining types
@@ -787,8 +1097,17 @@ void CDemoPlayer::DoTick()
 			}
 			else if(ChunkType == CHUNKTYPE_MESSAGE)
 			{
-				if(m_pListener)
-					m_pListener->OnDemoPlayerMessage(m_aChunkData, DataSize);
+				if(Skip)
+				{
+					m_vSkippedMessageData.insert(m_vSkippedMessageData.end(), m_aChunkData, m_aChunkData + DataSize);
+					m_vSkippedMessageSizes.push_back(DataSize);
+				}
+				else
+				{
+					DeliverSkippedMessages();
+					if(m_pListener)
+						m_pListener->OnDemoPlayerMessage(m_aChunkData, DataSize);
+				}
 			}
 		}
 	}
@@ -1083,21 +1402,49 @@ bool CDemoPlayer::SetPos(int WantedTick)
 		m_Info.m_PreviousTick = -1;
 	}
 
-	// playback everything until we hit our tick
+	// playback everything until we hit our tick, only the last ticks are passed to the listener
 	while(m_Info.m_NextTick < WantedTick)
 	{
-		DoTick();
+		DoTick(m_Info.m_NextTick < WantedTick - FAST_FORWARD_FULL_TICKS);
 		if(!IsPlaying())
 		{
 			return false;
 		}
 	}
+	FinishFastForward();
 
 	Play();
 
 	return true;
 }
 
+int CDemoPlayer::SeekKeyFrame(int Tick)
+{
+	if(!m_File || m_vKeyFrames.empty())
+		return -1;
+
+	size_t KeyFrame = 0;
+	while(KeyFrame < m_vKeyFrames.size() - 1 && m_vKeyFrames[KeyFrame + 1].m_Tick <= Tick)
+		KeyFrame++;
+	if(io_seek(m_File, m_vKeyFrames[KeyFrame].m_Filepos, IOSEEK_START) != 0)
+	{
+		Stop("Error seeking keyframe position");
+		return -1;
+	}
+	return m_vKeyFrames[KeyFrame].m_Tick;
+}
+
+CDemoPlayer::EReadChunkHeaderResult CDemoPlayer::ReadCompressedChunk(int *pType, int *pTick, const unsigned char **ppData, int *pSize)
+{
+	const EReadChunkHeaderResult Result = ReadChunkHeader(pType, pSize, pTick);
+	if(Result != CHUNKHEADER_SUCCESS)
+		return Result;
+	if(*pSize && io_read(m_File, m_aCompressedSnapshotData, *pSize) != (unsigned)*pSize)
+		return CHUNKHEADER_ERROR;
+	*ppData = m_aCompressedSnapshotData;
+	return CHUNKHEADER_SUCCESS;
+}
+
 void CDemoPlayer::SetSpeed(float Speed)
 {
 	m_Info.m_Info.m_Speed = std::clamp(Speed, 0.f, 256.f);
@@ -1211,7 +1558,9 @@ void CDemoPlayer::Update(bool RealTime)
 
 		m_Info.m_CurrentTime += (int64_t)(DeltaTime * (double)m_Info.m_Info.m_Speed);
 
-		// Do more ticks until we reach the current time.
+		// Do more ticks until we reach the current time. When playing fast,
+		// only the last ticks are passed to the listener.
+		const int TargetTick = m_Info.m_CurrentTime * SERVER_TICK_SPEED / Freq;
 		while(!m_Info.m_Info.m_Paused)
 		{
 			const int64_t CurrentTickStart = m_Info.m_Info.m_CurrentTick * Freq / SERVER_TICK_SPEED;
@@ -1219,12 +1568,13 @@ void CDemoPlayer::Update(bool RealTime)
 			{
 				break;
 			}
-			DoTick();
+			DoTick(RealTime && m_Info.m_NextTick < TargetTick - FAST_FORWARD_FULL_TICKS);
 			if(!IsPlaying())
 			{
 				return;
 			}
 		}
+		FinishFastForward();
 	}
 
 	UpdateTimes();
@@ -1270,6 +1620,9 @@ void CDemoPlayer::Stop(const char *pErrorMessage)
 	io_close(m_File);
 	m_File = nullptr;
 	m_vKeyFrames.clear();
+	m_SnapshotSkipped = false;
+	m_vSkippedMessageData.clear();
+	m_vSkippedMessageSizes.clear();
 	str_copy(m_aFilename, "");
 	str_copy(m_aErrorMessage, pErrorMessage);
 }
@@ -1376,35 +1729,15 @@ bool CDemoPlayer::GetDemoInfo(IStorage *pStorage, IConsole *pConsole, const char
 	return true;
 }
 
-class CDemoRecordingListener : public CDemoPlayer::IListener
+// Reverses the compression of `CDemoRecorder::CChunkWriter::Write`.
+static int DecompressChunk(const unsigned char *pData, int Size, unsigned char *pOut, int OutSize)
 {
-public:
-	CDemoRecorder *m_pDemoRecorder;
-	CDemoPlayer *m_pDemoPlayer;
-	bool m_Stop;
-	int m_StartTick;
-	int m_EndTick;
-
-	void OnDemoPlayerSnapshot(void *pData, int Size) override
-	{
-		const CDemoPlayer::CPlaybackInfo *pInfo = m_pDemoPlayer->Info();
-
-		if(m_EndTick != -1 && pInfo->m_Info.m_CurrentTick > m_EndTick)
-			m_Stop = true;
-		else if(m_StartTick == -1 || pInfo->m_Info.m_CurrentTick >= m_StartTick)
-			m_pDemoRecorder->RecordSnapshot(pInfo->m_Info.m_CurrentTick, pData, Size);
-	}
-
-	void OnDemoPlayerMessage(void *pData, int Size) override
-	{
-		const CDemoPlayer::CPlaybackInfo *pInfo = m_pDemoPlayer->Info();
-
-		if(m_EndTick != -1 && pInfo->m_Info.m_CurrentTick > m_EndTick)
-			m_Stop = true;
-		else if(m_StartTick == -1 || pInfo->m_Info.m_CurrentTick >= m_StartTick)
-			m_pDemoRecorder->RecordMessage(pData, Size);
-	}
-};
+	unsigned char aDecompressed[CSnapshot::MAX_SIZE];
+	const int DecompressedSize = CNetBase::Decompress(pData, Size, aDecompressed, sizeof(aDecompressed));
+	if(DecompressedSize < 0)
+		return -1;
+	return CVariableInt::Decompress(aDecompressed, DecompressedSize, pOut, OutSize);
+}
 
 void CDemoEditor::Init(class CSnapshotDelta *pSnapshotDelta, class IConsole *pConsole, class IStorage *pStorage)
 {
@@ -1433,10 +1766,12 @@ bool CDemoEditor::Slice(const char *pDemo, const char *pDst, int StartTick, int
 	if(!Sha256.has_value())
 	{
 		log_error_color(DEMO_PRINT_COLOR, "demo/slice", "Failed to start demo slicing because map SHA256 could not be determined.");
+		DemoPlayer.Stop();
 		return false;
 	}
 
-	CDemoRecorder DemoRecorder(m_pSnapshotDelta);
+	// demos recorded without the map are sliced without it
+	CDemoRecorder DemoRecorder(m_pSnapshotDelta, pMapInfo->m_Size == 0);
 	unsigned char *pMapData = DemoPlayer.GetMapData(m_pStorage);
 	const int Result = DemoRecorder.Start(m_pStorage, m_pConsole, pDst, pInfo->m_Header.m_aNetversion, pMapInfo->m_aName, Sha256.value(), pMapInfo->m_Crc, pInfo->m_Header.m_aType, pMapInfo->m_Size, pMapData, nullptr, pfnFilter, pUser) == -1;
 	free(pMapData);
@@ -1446,22 +1781,119 @@ bool CDemoEditor::Slice(const char *pDemo, const char *pDst, int StartTick, int
 		return false;
 	}
 
-	CDemoRecordingListener Listener;
-	Listener.m_pDemoRecorder = &DemoRecorder;
-	Listener.m_pDemoPlayer = &DemoPlayer;
-	Listener.m_Stop = false;
-	Listener.m_StartTick = StartTick;
-	Listener.m_EndTick = EndTick;
-	DemoPlayer.SetListener(&Listener);
+	// Only the chunks from the keyframe before the start tick to the first
+	// snapshot of the slice are decoded, that snapshot is recorded as keyframe.
+	// The following chunks are copied without decoding them, their deltas
+	// stay valid because the keyframe is identical to the snapshot they were
+	// created from.
+	const auto &&InSlice = [&](int Tick) {
+		return Tick >= 0 && (StartTick == -1 || Tick >= StartTick);
+	};
+	std::vector<unsigned char> vChunkData(CSnapshot::MAX_SIZE);
+	std::vector<unsigned char> vSnapshot(CSnapshot::MAX_SIZE);
+	std::vector<unsigned char> vLastSnapshot(CSnapshot::MAX_SIZE);
+	int LastSnapshotSize = -1;
+	int Tick = -1;
+	int ChunkTick = -1;
+	bool GotSnapshot = false;
+	bool RecordedKeyFrame = false;
+	bool Copying = false;
 
-	DemoPlayer.Play();
+	// like the demo player, replay the last snapshot in ticks without one
+	const auto &&RecordLastSnapshot = [&]() {
+		if(!GotSnapshot && LastSnapshotSize >= 0)
+		{
+			DemoRecorder.RecordSnapshot(Tick, vLastSnapshot.data(), LastSnapshotSize);
+			GotSnapshot = true;
+			RecordedKeyFrame = true;
+		}
+	};
 
-	while(DemoPlayer.IsPlaying() && !Listener.m_Stop)
+	if(DemoPlayer.SeekKeyFrame(StartTick) < 0)
 	{
-		DemoPlayer.Update(false);
-
-		if(pInfo->m_Info.m_Paused)
+		DemoRecorder.Stop(IDemoRecorder::EStopMode::REMOVE_FILE);
+		return false;
+	}
+	while(true)
+	{
+		int ChunkType, ChunkSize;
+		const unsigned char *pChunkData;
+		const CDemoPlayer::EReadChunkHeaderResult ReadResult = DemoPlayer.ReadCompressedChunk(&ChunkType, &ChunkTick, &pChunkData, &ChunkSize);
+		if(ReadResult == CDemoPlayer::CHUNKHEADER_EOF)
+		{
 			break;
+		}
+		else if(ReadResult == CDemoPlayer::CHUNKHEADER_ERROR)
+		{
+			log_error_color(DEMO_PRINT_COLOR, "demo/slice", "Error reading chunk, slice ends at tick %d", Tick);
+			break;
+		}
+
+		if(ChunkType & CHUNKTYPEFLAG_TICKMARKER)
+		{
+			if(!Copying && InSlice(Tick))
+				RecordLastSnapshot();
+			if(EndTick != -1 && ChunkTick > EndTick)
+				break;
+			Copying = RecordedKeyFrame;
+			if(Copying)
+				DemoRecorder.RecordTickMarker(ChunkTick, ChunkType & CHUNKTICKFLAG_KEYFRAME);
+			Tick = ChunkTick;
+			GotSnapshot = false;
+			continue;
+		}
+
+		if(Copying)
+		{
+			if(ChunkType == CHUNKTYPE_MESSAGE && pfnFilter)
+			{
+				const int DataSize = DecompressChunk(pChunkData, ChunkSize, vChunkData.data(), vChunkData.size());
+				if(DataSize < 0 || pfnFilter(vChunkData.data(), DataSize, pUser))
+					continue;
+			}
+			DemoRecorder.RecordCompressedChunk(ChunkType, pChunkData, ChunkSize);
+			continue;
+		}
+
+		int DataSize = 0;
+		if(ChunkSize)
+		{
+			DataSize = DecompressChunk(pChunkData, ChunkSize, vChunkData.data(), vChunkData.size());
+			if(DataSize < 0)
+				continue;
+		}
+
+		if(ChunkType == CHUNKTYPE_DELTA || ChunkType == CHUNKTYPE_SNAPSHOT)
+		{
+			int SnapshotSize;
+			if(ChunkType == CHUNKTYPE_DELTA)
+			{
+				if(LastSnapshotSize < 0)
+					continue;
+				SnapshotSize = m_pSnapshotDelta->UnpackDelta((CSnapshot *)vLastSnapshot.data(), (CSnapshot *)vSnapshot.data(), vChunkData.data(), DataSize, DemoPlayer.IsSixup());
+			}
+			else
+			{
+				SnapshotSize = DataSize;
+				mem_copy(vSnapshot.data(), vChunkData.data(), DataSize);
+			}
+			if(SnapshotSize < 0 || !((CSnapshot *)vSnapshot.data())->IsValid(SnapshotSize))
+				continue;
+
+			std::swap(vSnapshot, vLastSnapshot);
+			LastSnapshotSize = SnapshotSize;
+			GotSnapshot = true;
+			if(InSlice(Tick))
+			{
+				DemoRecorder.RecordSnapshot(Tick, vLastSnapshot.data(), LastSnapshotSize);
+				RecordedKeyFrame = true;
+			}
+		}
+		else if(ChunkType == CHUNKTYPE_MESSAGE && InSlice(Tick))
+		{
+			RecordLastSnapshot();
+			DemoRecorder.RecordMessage(vChunkData.data(), DataSize);
+		}
 	}
 
 	// Copy timeline markers to sliced demo
@@ -11,14 +11,45 @@
 #include <engine/shared/protocol.h>
 
 #include <functional>
+#include <memory>
 #include <vector>
 
 typedef std::function<void()> TUpdateIntraTimesFunc;
 
 class CDemoRecorder : public IDemoRecorder
 {
+public:
+	class CAsyncStats
+	{
+	public:
+		// number of times recording had to wait for the writer
+		int m_NumStalls;
+		int64_t m_StallTime;
+		int m_MaxQueuedBytes;
+	};
+
+private:
+	// Encodes and writes the chunks after the header. Runs on the recording
+	// thread or, when recording asynchronously, in the job pool.
+	class CChunkWriter
+	{
+	public:
+		IOHANDLE m_File;
+		class CSnapshotDelta *m_pSnapshotDelta;
+		int m_LastTickMarker;
+		unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
+
+		void WriteTickMarker(int Tick, bool Keyframe);
+		void Write(int Type, const void *pData, int Size);
+		void WriteCompressed(int Type, const void *pData, int Size);
+		void WriteSnapshot(int Tick, bool Keyframe, const void *pData, int Size);
+	};
+	class CAsyncWriter;
+	class CDrainJob;
+
 	class IConsole *m_pConsole;
 	class IStorage *m_pStorage;
+	class IEngine *m_pEngine = nullptr;
 
 	IOHANDLE m_File;
 	char m_aCurrentFilename[IO_MAX_PATH_LENGTH];
@@ -26,8 +57,10 @@ class CDemoRecorder : public IDemoRecorder
 	int m_LastKeyFrame;
 	int m_FirstTick;
 
-	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
 	class CSnapshotDelta *m_pSnapshotDelta;
+	CChunkWriter m_Writer;
+	std::shared_ptr<CAsyncWriter> m_pAsyncWriter;
+	CAsyncStats m_AsyncStats;
 
 	int m_NumTimelineMarkers;
 	int m_aTimelineMarkers[MAX_TIMELINE_MARKERS];
@@ -37,14 +70,21 @@ class CDemoRecorder : public IDemoRecorder
 	DEMOFUNC_FILTER m_pfnFilter;
 	void *m_pUser;
 
-	void WriteTickMarker(int Tick, bool Keyframe);
-	void Write(int Type, const void *pData, int Size);
-
 public:
 	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false);
 	CDemoRecorder() = default;
 	~CDemoRecorder() override;
 
+	/**
+	 * Makes the following recordings hand snapshots and messages to a bounded
+	 * queue, which is delta encoded, compressed and written in the job pool.
+	 * The demo is identical to one recorded synchronously.
+	 *
+	 * @param pEngine The engine whose job pool is used, `nullptr` to record
+	 * on the calling thread.
+	 */
+	void RecordAsync(class IEngine *pEngine) { m_pEngine = pEngine; }
+
 	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, const SHA256_DIGEST &Sha256, unsigned MapCrc, const char *pType, unsigned MapSize, unsigned char *pMapData, IOHANDLE MapFile, DEMOFUNC_FILTER pfnFilter, void *pUser);
 	int Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilename = "") override;
 
@@ -54,15 +94,34 @@ public:
 	void RecordSnapshot(int Tick, const void *pData, int Size);
 	void RecordMessage(const void *pData, int Size);
 
+	/**
+	 * Copy a tick marker and already compressed chunks from another demo, see
+	 * @link CDemoEditor::Slice @endlink. Snapshot deltas must be relative to the
+	 * last recorded snapshot, so @link RecordSnapshot @endlink cannot be used
+	 * afterwards. Not supported when recording asynchronously.
+	 */
+	void RecordTickMarker(int Tick, bool Keyframe);
+	void RecordCompressedChunk(int Type, const void *pData, int Size);
+
 	bool IsRecording() const override { return m_File != nullptr; }
 	const char *CurrentFilename() const override { return m_aCurrentFilename; }
 
 	int Length() const override { return (m_LastTickMarker - m_FirstTick) / SERVER_TICK_SPEED; }
+
+	// statistics of the current or last asynchronous recording
+	const CAsyncStats &AsyncStats() const { return m_AsyncStats; }
 };
 
 class CDemoPlayer : public IDemoPlayer
 {
 public:
+	enum EReadChunkHeaderResult
+	{
+		CHUNKHEADER_SUCCESS,
+		CHUNKHEADER_ERROR,
+		CHUNKHEADER_EOF,
+	};
+
 	class IListener
 	{
 	public:
@@ -136,19 +195,23 @@ private:
 	int m_LastSnapshotDataSize;
 	class CSnapshotDelta *m_pSnapshotDelta;
 
+	// When seeking or playing fast, the snapshots of ticks before the last
+	// few are only unpacked and not passed to the listener. Their messages
+	// are collected and passed after the next snapshot.
+	static constexpr int FAST_FORWARD_FULL_TICKS = 3;
+	bool m_SnapshotSkipped;
+	std::vector<unsigned char> m_vSkippedMessageData;
+	std::vector<int> m_vSkippedMessageSizes;
+
 	bool m_UseVideo;
 #if defined(CONF_VIDEORECORDER)
 	bool m_WasRecording = false;
 #endif
 
-	enum EReadChunkHeaderResult
-	{
-		CHUNKHEADER_SUCCESS,
-		CHUNKHEADER_ERROR,
-		CHUNKHEADER_EOF,
-	};
 	EReadChunkHeaderResult ReadChunkHeader(int *pType, int *pSize, int *pTick);
-	void DoTick();
+	void DoTick(bool Skip = false);
+	void DeliverSkippedMessages();
+	void FinishFastForward();
 	enum class EScanFileResult
 	{
 		SUCCESS,
@@ -184,6 +247,24 @@ public:
 	bool SeekTime(float Seconds) override;
 	bool SeekTick(ETickOffset TickOffset) override;
 	bool SetPos(int WantedTick) override;
+
+	/**
+	 * Moves the file position to the last keyframe at or before the tick, or
+	 * to the first keyframe, for reading chunks with @link ReadCompressedChunk @endlink.
+	 *
+	 * @return The tick of the keyframe, `-1` on error.
+	 */
+	int SeekKeyFrame(int Tick);
+	/**
+	 * Reads the next chunk without decompressing it. Playback must not be
+	 * continued afterwards.
+	 *
+	 * @param pType Set to the type of the chunk, or to the tick marker flags.
+	 * @param pTick The tick of the previous tick marker, updated by tick markers.
+	 * @param ppData Set to the compressed data, valid until the next call.
+	 * @param pSize Set to the size of the compressed data.
+	 */
+	EReadChunkHeaderResult ReadCompressedChunk(int *pType, int *pTick, const unsigned char **ppData, int *pSize);
 	const CInfo *BaseInfo() const override { return &m_Info.m_Info; }
 	void GetDemoName(char *pBuffer, size_t BufferSize) const override;
 	bool GetDemoInfo(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, int StorageType, CDemoHeader *pDemoHeader, CTimelineMarkers *pTimelineMarkers, CMapInfo *pMapInfo, IOHANDLE *pFile = nullptr, char *pErrorMessage = nullptr, size_t ErrorMessageSize = 0) const override;
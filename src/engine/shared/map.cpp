@@ -8,6 +8,8 @@
 
 #include <game/mapitems.h>
 
+#include <iterator>
+
 CMap::CMap() = default;
 
 int CMap::GetDataSize(int Index) const
@@ -79,28 +81,44 @@ bool CMap::Load(const char *pMapName, int StorageType)
 	// Ensure current datafile is not left in an inconsistent state if loading fails,
 	// by loading the new datafile separately first.
 	CDataFileReader NewDataFile;
-	if(!NewDataFile.Open(pStorage, pMapName, StorageType))
+	if(!Prepare(pStorage, pMapName, StorageType, NewDataFile))
+		return false;
+
+	Load(std::move(NewDataFile));
+	return true;
+}
+
+void CMap::Load(CDataFileReader &&DataFile)
+{
+	// Replace existing datafile with new datafile
+	m_DataFile.Close();
+	m_DataFile = std::move(DataFile);
+}
+
+bool CMap::Prepare(IStorage *pStorage, const char *pMapName, int StorageType, CDataFileReader &DataFile, const CDataFileReader::CKnownHashes *pKnownHashes)
+{
+	if(!DataFile.Open(pStorage, pMapName, StorageType, pKnownHashes))
 		return false;
 
 	// Check version
-	const CMapItemVersion *pItem = (CMapItemVersion *)NewDataFile.FindItem(MAPITEMTYPE_VERSION, 0);
+	const CMapItemVersion *pItem = (CMapItemVersion *)DataFile.FindItem(MAPITEMTYPE_VERSION, 0);
 	if(pItem == nullptr || pItem->m_Version != 1)
 	{
 		log_error("map/load", "Error: map version not supported.");
-		NewDataFile.Close();
+		DataFile.Close();
 		return false;
 	}
 
 	// Replace compressed tile layers with uncompressed ones
 	int GroupsStart, GroupsNum, LayersStart, LayersNum;
-	NewDataFile.GetType(MAPITEMTYPE_GROUP, &GroupsStart, &GroupsNum);
-	NewDataFile.GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
+	DataFile.GetType(MAPITEMTYPE_GROUP, &GroupsStart, &GroupsNum);
+	DataFile.GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
 	for(int g = 0; g < GroupsNum; g++)
 	{
-		const CMapItemGroup *pGroup = static_cast<CMapItemGroup *>(NewDataFile.GetItem(GroupsStart + g));
+		const CMapItemGroup *pGroup = static_cast<CMapItemGroup *>(DataFile.GetItem(GroupsStart + g));
 		for(int l = 0; l < pGroup->m_NumLayers; l++)
 		{
-			CMapItemLayer *pLayer = static_cast<CMapItemLayer *>(NewDataFile.GetItem(LayersStart + pGroup->m_StartLayer + l));
+			CMapItemLayer *pLayer = static_cast<CMapItemLayer *>(DataFile.GetItem(LayersStart + pGroup->m_StartLayer + l));
 			if(pLayer->m_Type == LAYERTYPE_TILES)
 			{
 				CMapItemLayerTilemap *pTilemap = reinterpret_cast<CMapItemLayerTilemap *>(pLayer);
@@ -112,21 +130,36 @@ bool CMap::Load(const char *pMapName, int StorageType)
 					if(((int)TilemapCount / pTilemap->m_Width != pTilemap->m_Height) || (TilemapSize / sizeof(CTile) != TilemapCount))
 					{
 						log_error("map/load", "map layer too big (%d * %d * %d causes an integer overflow)", pTilemap->m_Width, pTilemap->m_Height, (int)sizeof(CTile));
+						DataFile.Close();
 						return false;
 					}
 					CTile *pTiles = static_cast<CTile *>(malloc(TilemapSize));
 					if(!pTiles)
+					{
+						DataFile.Close();
 						return false;
-					ExtractTiles(pTiles, (size_t)pTilemap->m_Width * pTilemap->m_Height, static_cast<CTile *>(NewDataFile.GetData(pTilemap->m_Data)), NewDataFile.GetDataSize(pTilemap->m_Data) / sizeof(CTile));
-					NewDataFile.ReplaceData(pTilemap->m_Data, reinterpret_cast<char *>(pTiles), TilemapSize);
+					}
+					ExtractTiles(pTiles, (size_t)pTilemap->m_Width * pTilemap->m_Height, static_cast<CTile *>(DataFile.GetData(pTilemap->m_Data)), DataFile.GetDataSize(pTilemap->m_Data) / sizeof(CTile));
+					DataFile.ReplaceData(pTilemap->m_Data, reinterpret_cast<char *>(pTiles), TilemapSize);
+				}
+				else
+				{
+					// decompress the entity layers now instead of when the collision is built
+					if(pTilemap->m_Flags & TILESLAYERFLAG_GAME)
+						DataFile.GetData(pTilemap->m_Data);
+					static const int s_aEntityFlags[] = {TILESLAYERFLAG_TELE, TILESLAYERFLAG_SPEEDUP, TILESLAYERFLAG_FRONT, TILESLAYERFLAG_SWITCH, TILESLAYERFLAG_TUNE};
+					for(int i = 0; i < (int)std::size(s_aEntityFlags); i++)
+					{
+						if(!(pTilemap->m_Flags & s_aEntityFlags[i]))
+							continue;
+						// same layout as in CLayers, older versions store the data index at a fixed offset
+						const int Data = pTilemap->m_Version <= 2 ? *((int *)(pTilemap) + 15 + i) : (&pTilemap->m_Tele)[i];
+						DataFile.GetData(Data);
+					}
 				}
 			}
 		}
 	}
-
-	// Replace existing datafile with new datafile
-	m_DataFile.Close();
-	m_DataFile = std::move(NewDataFile);
 	return true;
 }
 
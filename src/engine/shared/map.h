@@ -33,6 +33,7 @@ public:
 	int NumItems() const override;
 
 	[[nodiscard]] bool Load(const char *pMapName, int StorageType) override;
+	void Load(CDataFileReader &&DataFile) override;
 	void Unload() override;
 	bool IsLoaded() const override;
 	IOHANDLE File() const override;
@@ -41,6 +42,12 @@ public:
 	unsigned Crc() const override;
 	int Size() const override;
 
+	/**
+	 * Opens the map into a separate datafile reader without touching the
+	 * loaded map, so that it can be done in a job and the result passed to
+	 * @link Load @endlink later.
+	 */
+	[[nodiscard]] static bool Prepare(class IStorage *pStorage, const char *pMapName, int StorageType, CDataFileReader &DataFile, const CDataFileReader::CKnownHashes *pKnownHashes = nullptr);
 	static void ExtractTiles(class CTile *pDest, size_t DestSize, const class CTile *pSrc, size_t SrcSize);
 };
 
@@ -0,0 +1,161 @@
+#include "metrics.h"
+
+#include <base/system.h>
+
+#include <algorithm>
+
+static bool IsValidMetricName(const char *pName)
+{
+	if(!pName[0] || (pName[0] >= '0' && pName[0] <= '9'))
+		return false;
+	for(const char *p = pName; *p; p++)
+	{
+		if(!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '_' || *p == ':'))
+			return false;
+	}
+	return true;
+}
+
+CMetrics::CHistogram::CHistogram(const std::vector<double> &vBounds) :
+	m_vBounds(vBounds),
+	m_pCounts(std::make_unique<std::atomic<uint64_t>[]>(vBounds.size() + 1))
+{
+	dbg_assert(std::is_sorted(m_vBounds.begin(), m_vBounds.end()), "histogram bounds must be ascending");
+	for(size_t i = 0; i <= m_vBounds.size(); i++)
+		m_pCounts[i].store(0, std::memory_order_relaxed);
+}
+
+void CMetrics::CHistogram::Observe(double Value)
+{
+	const size_t Bucket = std::lower_bound(m_vBounds.begin(), m_vBounds.end(), Value) - m_vBounds.begin();
+	m_pCounts[Bucket].fetch_add(1, std::memory_order_relaxed);
+	m_Sum.fetch_add(Value, std::memory_order_relaxed);
+}
+
+CMetrics::CSeries &CMetrics::FindSeries(const char *pName, const char *pHelp, EType Type, const char *pLabels, bool &Inserted)
+{
+	dbg_assert(IsValidMetricName(pName), "invalid metric name '%s'", pName);
+
+	auto FamilyIt = std::find_if(m_vFamilies.begin(), m_vFamilies.end(), [pName](const CFamily &Family) {
+		return Family.m_Name == pName;
+	});
+	if(FamilyIt == m_vFamilies.end())
+	{
+		CFamily &Family = m_vFamilies.emplace_back();
+		Family.m_Name = pName;
+		Family.m_Help = pHelp;
+		Family.m_Type = Type;
+		FamilyIt = m_vFamilies.end() - 1;
+	}
+	dbg_assert(FamilyIt->m_Type == Type, "metric '%s' registered with different types", pName);
+
+	for(CSeries &Series : FamilyIt->m_vSeries)
+	{
+		if(Series.m_Labels == pLabels)
+		{
+			Inserted = false;
+			return Series;
+		}
+	}
+	Inserted = true;
+	CSeries &Series = FamilyIt->m_vSeries.emplace_back();
+	Series.m_Labels = pLabels;
+	return Series;
+}
+
+CMetrics::CCounter *CMetrics::Counter(const char *pName, const char *pHelp, const char *pLabels)
+{
+	const CLockScope LockScope(m_Lock);
+	bool Inserted;
+	CSeries &Series = FindSeries(pName, pHelp, EType::COUNTER, pLabels, Inserted);
+	if(Inserted)
+		Series.m_pCounter = std::make_unique<CCounter>();
+	return Series.m_pCounter.get();
+}
+
+CMetrics::CGauge *CMetrics::Gauge(const char *pName, const char *pHelp, const char *pLabels)
+{
+	const CLockScope LockScope(m_Lock);
+	bool Inserted;
+	CSeries &Series = FindSeries(pName, pHelp, EType::GAUGE, pLabels, Inserted);
+	if(Inserted)
+		Series.m_pGauge = std::make_unique<CGauge>();
+	return Series.m_pGauge.get();
+}
+
+CMetrics::CHistogram *CMetrics::Histogram(const char *pName, const char *pHelp, const std::vector<double> &vBounds, const char *pLabels)
+{
+	const CLockScope LockScope(m_Lock);
+	bool Inserted;
+	CSeries &Series = FindSeries(pName, pHelp, EType::HISTOGRAM, pLabels, Inserted);
+	if(Inserted)
+		Series.m_pHistogram = std::make_unique<CHistogram>(vBounds);
+	dbg_assert(Series.m_pHistogram->Bounds() == vBounds, "histogram '%s' registered with different bounds", pName);
+	return Series.m_pHistogram.get();
+}
+
+static void AppendLine(std::string &Output, const char *pName, const char *pSuffix, const std::string &Labels, const char *pExtraLabel, const char *pValue)
+{
+	Output += pName;
+	Output += pSuffix;
+	if(!Labels.empty() || pExtraLabel[0])
+	{
+		Output += '{';
+		Output += Labels;
+		if(!Labels.empty() && pExtraLabel[0])
+			Output += ',';
+		Output += pExtraLabel;
+		Output += '}';
+	}
+	Output += ' ';
+	Output += pValue;
+	Output += '\n';
+}
+
+void CMetrics::Format(std::string &Output) const
+{
+	static const char *const s_apTypeNames[] = {"counter", "gauge", "histogram"};
+
+	const CLockScope LockScope(m_Lock);
+	char aValue[64];
+	char aBound[64];
+	for(const CFamily &Family : m_vFamilies)
+	{
+		Output += "# HELP " + Family.m_Name + " " + Family.m_Help + "\n";
+		Output += "# TYPE " + Family.m_Name + " " + s_apTypeNames[(int)Family.m_Type] + "\n";
+		for(const CSeries &Series : Family.m_vSeries)
+		{
+			switch(Family.m_Type)
+			{
+			case EType::COUNTER:
+				str_format(aValue, sizeof(aValue), "%" PRIu64, Series.m_pCounter->Value());
+				AppendLine(Output, Family.m_Name.c_str(), "", Series.m_Labels, "", aValue);
+				break;
+			case EType::GAUGE:
+				str_format(aValue, sizeof(aValue), "%" PRId64, Series.m_pGauge->Value());
+				AppendLine(Output, Family.m_Name.c_str(), "", Series.m_Labels, "", aValue);
+				break;
+			case EType::HISTOGRAM:
+			{
+				const CHistogram &Histogram = *Series.m_pHistogram;
+				uint64_t Cumulative = 0;
+				for(size_t Bucket = 0; Bucket <= Histogram.Bounds().size(); Bucket++)
+				{
+					Cumulative += Histogram.Count(Bucket);
+					if(Bucket < Histogram.Bounds().size())
+						str_format(aBound, sizeof(aBound), "le=\"%g\"", Histogram.Bounds()[Bucket]);
+					else
+						str_copy(aBound, "le=\"+Inf\"");
+					str_format(aValue, sizeof(aValue), "%" PRIu64, Cumulative);
+					AppendLine(Output, Family.m_Name.c_str(), "_bucket", Series.m_Labels, aBound, aValue);
+				}
+				str_format(aValue, sizeof(aValue), "%.17g", Histogram.Sum());
+				AppendLine(Output, Family.m_Name.c_str(), "_sum", Series.m_Labels, "", aValue);
+				str_format(aValue, sizeof(aValue), "%" PRIu64, Cumulative);
+				AppendLine(Output, Family.m_Name.c_str(), "_count", Series.m_Labels, "", aValue);
+				break;
+			}
+			}
+		}
+	}
+}
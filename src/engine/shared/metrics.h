@@ -0,0 +1,106 @@
+#ifndef ENGINE_SHARED_METRICS_H
+#define ENGINE_SHARED_METRICS_H
+
+#include <base/lock.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Counters, gauges and histograms that are updated by the server threads and
+// read by another thread, in the Prometheus text format.
+//
+// Metrics are registered by name and labels. Registering a metric again
+// returns the existing one, so metrics can be registered again on every map
+// load. Metrics are never removed, the returned pointers stay valid as long as
+// the registry exists. Updating a metric only uses relaxed atomics and never
+// takes the lock, so reading the metrics never blocks the game thread.
+class CMetrics
+{
+public:
+	class CCounter
+	{
+	public:
+		void Add(uint64_t Value = 1) { m_Value.fetch_add(Value, std::memory_order_relaxed); }
+		uint64_t Value() const { return m_Value.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<uint64_t> m_Value{0};
+	};
+
+	class CGauge
+	{
+	public:
+		void Set(int64_t Value) { m_Value.store(Value, std::memory_order_relaxed); }
+		void Add(int64_t Value) { m_Value.fetch_add(Value, std::memory_order_relaxed); }
+		int64_t Value() const { return m_Value.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<int64_t> m_Value{0};
+	};
+
+	// counts observations in buckets with the given ascending upper bounds and
+	// one more bucket for larger values
+	class CHistogram
+	{
+	public:
+		explicit CHistogram(const std::vector<double> &vBounds);
+
+		void Observe(double Value);
+
+		const std::vector<double> &Bounds() const { return m_vBounds; }
+		// not cumulative, bucket `Bounds().size()` holds the values above all bounds
+		uint64_t Count(int Bucket) const { return m_pCounts[Bucket].load(std::memory_order_relaxed); }
+		double Sum() const { return m_Sum.load(std::memory_order_relaxed); }
+
+	private:
+		std::vector<double> m_vBounds;
+		std::unique_ptr<std::atomic<uint64_t>[]> m_pCounts;
+		std::atomic<double> m_Sum{0.0};
+	};
+
+	// `pLabels` are the label pairs without braces, e.g. `client="3"`
+	CCounter *Counter(const char *pName, const char *pHelp, const char *pLabels = "") EXCLUDES(m_Lock);
+	CGauge *Gauge(const char *pName, const char *pHelp, const char *pLabels = "") EXCLUDES(m_Lock);
+	CHistogram *Histogram(const char *pName, const char *pHelp, const std::vector<double> &vBounds, const char *pLabels = "") EXCLUDES(m_Lock);
+
+	// appends all metrics in the Prometheus text exposition format
+	void Format(std::string &Output) const EXCLUDES(m_Lock);
+
+private:
+	enum class EType
+	{
+		COUNTER,
+		GAUGE,
+		HISTOGRAM,
+	};
+
+	class CSeries
+	{
+	public:
+		std::string m_Labels;
+		// only the one of the type of the family
+		std::unique_ptr<CCounter> m_pCounter;
+		std::unique_ptr<CGauge> m_pGauge;
+		std::unique_ptr<CHistogram> m_pHistogram;
+	};
+
+	class CFamily
+	{
+	public:
+		std::string m_Name;
+		std::string m_Help;
+		EType m_Type;
+		std::vector<CSeries> m_vSeries;
+	};
+
+	// returns the series, `Inserted` tells whether it has to be initialized
+	CSeries &FindSeries(const char *pName, const char *pHelp, EType Type, const char *pLabels, bool &Inserted) REQUIRES(m_Lock);
+
+	mutable CLock m_Lock;
+	std::vector<CFamily> m_vFamilies GUARDED_BY(m_Lock);
+};
+
+#endif // ENGINE_SHARED_METRICS_H
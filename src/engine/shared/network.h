@@ -3,6 +3,7 @@
 #ifndef ENGINE_SHARED_NETWORK_H
 #define ENGINE_SHARED_NETWORK_H
 
+#include "metrics.h"
 #include "ringbuffer.h"
 #include "stun.h"
 
@@ -322,6 +323,8 @@ public:
 	// Needed for GotProblems in NetClient
 	int64_t LastRecvTime() const { return m_LastRecvTime; }
 	int64_t ConnectTime() const { return m_LastUpdateTime; }
+	// only counts the sent packets, since `Init` over all peers of the connection
+	const NETSTATS &Stats() const { return m_Stats; }
 
 	int AckSequence() const { return m_Ack; }
 	int SeqSequence() const { return m_Sequence; }
@@ -405,6 +408,11 @@ class CNetServer
 	{
 	public:
 		CNetConnection m_Connection;
+
+		// only set if metrics are enabled
+		CMetrics::CCounter *m_pReceivedBytes = nullptr;
+		CMetrics::CCounter *m_pSentBytes = nullptr;
+		uint64_t m_ReportedSentBytes = 0;
 	};
 
 	struct CSpamConn
@@ -438,6 +446,8 @@ class CNetServer
 	CPacketChunkUnpacker m_PacketChunkUnpacker;
 	CNetPacketConstruct m_RecvBuffer;
 
+	CMetrics::CCounter *m_pBanHits = nullptr;
+
 	void OnTokenCtrlMsg(NETADDR &Addr, int ControlMsg, const CNetPacketConstruct &Packet);
 	int OnSixupCtrlMsg(NETADDR &Addr, CNetChunk *pChunk, int ControlMsg, const CNetPacketConstruct &Packet, SECURITY_TOKEN &ResponseToken, SECURITY_TOKEN Token);
 	void OnPreConnMsg(NETADDR &Addr, CNetPacketConstruct &Packet);
@@ -458,6 +468,8 @@ public:
 	//
 	bool Open(NETADDR BindAddr, CNetBan *pNetBan, int MaxClients, int MaxClientsPerIp);
 	void Close();
+	// registers the traffic per client slot and the ban hits, call after `Open`
+	void SetMetrics(CMetrics *pMetrics);
 
 	//
 	int Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken);
@@ -629,7 +641,8 @@ public:
 	static void SendControlMsgWithToken7(NETSOCKET Socket, NETADDR *pAddr, TOKEN Token, int Ack, int ControlMsg, TOKEN MyToken, bool Extended);
 	static void SendPacketConnless(NETSOCKET Socket, NETADDR *pAddr, const void *pData, int DataSize, bool Extended, unsigned char aExtra[NET_CONNLESS_EXTRA_SIZE]);
 	static void SendPacketConnlessWithToken7(NETSOCKET Socket, NETADDR *pAddr, const void *pData, int DataSize, SECURITY_TOKEN Token, SECURITY_TOKEN ResponseToken);
-	static void SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct *pPacket, SECURITY_TOKEN SecurityToken, bool Sixup = false);
+	// returns the number of bytes sent
+	static int SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct *pPacket, SECURITY_TOKEN SecurityToken, bool Sixup = false);
 
 	static std::optional<int> UnpackPacketFlags(unsigned char *pBuffer, int Size);
 	static int UnpackPacket(unsigned char *pBuffer, int Size, CNetPacketConstruct *pPacket, bool &Sixup, SECURITY_TOKEN *pSecurityToken = nullptr, SECURITY_TOKEN *pResponseToken = nullptr);
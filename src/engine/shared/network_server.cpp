@@ -66,6 +66,19 @@ bool CNetServer::Open(NETADDR BindAddr, CNetBan *pNetBan, int MaxClients, int Ma
 	return true;
 }
 
+void CNetServer::SetMetrics(CMetrics *pMetrics)
+{
+	for(int i = 0; i < MaxClients(); i++)
+	{
+		char aLabels[32];
+		str_format(aLabels, sizeof(aLabels), "client=\"%d\"", i);
+		m_aSlots[i].m_pReceivedBytes = pMetrics->Counter("ddnet_client_received_bytes_total", "Bytes received from the client slot, including packet headers", aLabels);
+		m_aSlots[i].m_pSentBytes = pMetrics->Counter("ddnet_client_sent_bytes_total", "Bytes sent to the client slot, including packet headers", aLabels);
+		m_aSlots[i].m_ReportedSentBytes = m_aSlots[i].m_Connection.Stats().sent_bytes;
+	}
+	m_pBanHits = pMetrics->Counter("ddnet_ban_hits_total", "Packets dropped because their address is banned");
+}
+
 int CNetServer::SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_DELCLIENT pfnDelClient, void *pUser)
 {
 	m_pfnNewClient = pfnNewClient;
@@ -109,6 +122,12 @@ void CNetServer::Update()
 	for(int i = 0; i < MaxClients(); i++)
 	{
 		m_aSlots[i].m_Connection.Update();
+		if(m_aSlots[i].m_pSentBytes)
+		{
+			const uint64_t SentBytes = m_aSlots[i].m_Connection.Stats().sent_bytes;
+			m_aSlots[i].m_pSentBytes->Add(SentBytes - m_aSlots[i].m_ReportedSentBytes);
+			m_aSlots[i].m_ReportedSentBytes = SentBytes;
+		}
 		if(m_aSlots[i].m_Connection.State() == CNetConnection::EState::ERROR &&
 			(!m_aSlots[i].m_Connection.m_TimeoutProtected ||
 				!m_aSlots[i].m_Connection.m_TimeoutSituation))
@@ -604,6 +623,8 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 		char aBuf[128];
 		if(NetBan() && NetBan()->IsBanned(&Addr, aBuf, sizeof(aBuf)))
 		{
+			if(m_pBanHits)
+				m_pBanHits->Add();
 			// banned, reply with a message
 			CNetBase::SendControlMsg(m_Socket, &Addr, 0, NET_CTRLMSG_CLOSE, aBuf, str_length(aBuf) + 1, NET_SECURITY_TOKEN_UNSUPPORTED);
 			continue;
@@ -645,6 +666,8 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 			{
 				if(Slot != -1) // connection found
 				{
+					if(m_aSlots[Slot].m_pReceivedBytes)
+						m_aSlots[Slot].m_pReceivedBytes->Add(Bytes);
 					const bool Control = (m_RecvBuffer.m_Flags & NET_PACKETFLAG_CONTROL) != 0;
 					if(Control)
 					{
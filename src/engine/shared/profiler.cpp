@@ -0,0 +1,93 @@
+#include "profiler.h"
+
+#include <algorithm>
+
+int CProfiler::AddSection(const char *pName)
+{
+	for(int i = 0; i < (int)m_vSections.size(); i++)
+	{
+		if(m_vSections[i].m_Name == pName)
+			return i;
+	}
+	m_vSections.emplace_back();
+	m_vSections.back().m_Name = pName;
+	return m_vSections.size() - 1;
+}
+
+void CProfiler::Add(int Section, std::chrono::nanoseconds Duration)
+{
+	CSection &Current = m_vSections[Section];
+	if(!Current.m_Touched)
+	{
+		Current.m_Touched = true;
+		m_vTouched.push_back(Section);
+	}
+	Current.m_Current += Duration.count();
+}
+
+void CProfiler::EndFrame()
+{
+	if(m_vTouched.empty())
+		return;
+
+	for(int Section : m_vTouched)
+	{
+		CSection &Current = m_vSections[Section];
+		Current.m_aWindow[Current.m_WindowNext] = Current.m_Current;
+		Current.m_WindowNext = (Current.m_WindowNext + 1) % WINDOW_SIZE;
+		Current.m_WindowCount = std::min(Current.m_WindowCount + 1, (int)WINDOW_SIZE);
+		Current.m_Frames++;
+		Current.m_Total += Current.m_Current;
+		Current.m_Max = std::max(Current.m_Max, Current.m_Current);
+		Current.m_Current = 0;
+		Current.m_Touched = false;
+	}
+	m_vTouched.clear();
+	m_Frames++;
+}
+
+void CProfiler::Reset()
+{
+	for(auto &Section : m_vSections)
+	{
+		Section.m_WindowCount = 0;
+		Section.m_WindowNext = 0;
+		Section.m_Current = 0;
+		Section.m_Touched = false;
+		Section.m_Frames = 0;
+		Section.m_Total = 0;
+		Section.m_Max = 0;
+	}
+	m_vTouched.clear();
+	m_Frames = 0;
+}
+
+void CProfiler::Print(const FPrintLine &PrintLine) const
+{
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%" PRId64 " frames, last %d per section (ms):", m_Frames, (int)WINDOW_SIZE);
+	PrintLine(aBuf);
+
+	std::vector<int64_t> vSamples;
+	vSamples.reserve(WINDOW_SIZE);
+	for(const auto &Section : m_vSections)
+	{
+		if(Section.m_WindowCount == 0)
+			continue;
+
+		vSamples.assign(Section.m_aWindow, Section.m_aWindow + Section.m_WindowCount);
+		const auto Percentile = [&](int Percent) {
+			auto It = vSamples.begin() + std::min<size_t>(vSamples.size() - 1, vSamples.size() * Percent / 100);
+			std::nth_element(vSamples.begin(), It, vSamples.end());
+			return *It / 1000000.0;
+		};
+		const double P50 = Percentile(50);
+		const double P99 = Percentile(99);
+		const double WindowMax = *std::max_element(vSamples.begin(), vSamples.end()) / 1000000.0;
+
+		str_format(aBuf, sizeof(aBuf), "  %-28s p50 %8.3f  p99 %8.3f  max %8.3f  avg %8.3f  all-time max %8.3f (%" PRId64 " frames)",
+			Section.m_Name.c_str(), P50, P99, WindowMax, Section.m_Total / (double)Section.m_Frames / 1000000.0,
+			Section.m_Max / 1000000.0, Section.m_Frames);
+		PrintLine(aBuf);
+	}
+}
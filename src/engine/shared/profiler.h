@@ -0,0 +1,86 @@
+#ifndef ENGINE_SHARED_PROFILER_H
+#define ENGINE_SHARED_PROFILER_H
+
+#include <base/system.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Records how long each phase of a server frame takes.
+//
+// Phases are named sections, the time spent in a section is summed up over a
+// frame and the sums of the last `WINDOW_SIZE` frames in which the section ran
+// are kept to report percentiles. Sections may be nested, e.g. the world tick
+// inside the game tick. Nothing is measured while disabled, scopes then only
+// check a flag.
+class CProfiler
+{
+public:
+	enum
+	{
+		WINDOW_SIZE = 512,
+	};
+
+	typedef std::function<void(const char *pLine)> FPrintLine;
+
+	// measures the lifetime of the scope and adds it to the section
+	class CScope
+	{
+		CProfiler *m_pProfiler;
+		int m_Section;
+		std::chrono::nanoseconds m_Start;
+
+	public:
+		CScope(CProfiler *pProfiler, int Section) :
+			m_pProfiler(pProfiler->Enabled() ? pProfiler : nullptr),
+			m_Section(Section)
+		{
+			if(m_pProfiler)
+				m_Start = time_get_nanoseconds();
+		}
+		~CScope()
+		{
+			if(m_pProfiler)
+				m_pProfiler->Add(m_Section, time_get_nanoseconds() - m_Start);
+		}
+	};
+
+	// returns the existing section if one with the same name was already added
+	int AddSection(const char *pName);
+
+	bool Enabled() const { return m_Enabled; }
+	void SetEnabled(bool Enabled) { m_Enabled = Enabled; }
+
+	void Add(int Section, std::chrono::nanoseconds Duration);
+	// pushes the sums of the current frame into the histograms
+	void EndFrame();
+	void Reset();
+
+	// one line per section that ran at least once, times in milliseconds
+	void Print(const FPrintLine &PrintLine) const;
+
+private:
+	class CSection
+	{
+	public:
+		std::string m_Name;
+		int64_t m_aWindow[WINDOW_SIZE];
+		int m_WindowCount = 0;
+		int m_WindowNext = 0;
+		int64_t m_Current = 0;
+		bool m_Touched = false;
+		int64_t m_Frames = 0;
+		int64_t m_Total = 0;
+		int64_t m_Max = 0;
+	};
+
+	bool m_Enabled = false;
+	int64_t m_Frames = 0;
+	std::vector<CSection> m_vSections;
+	std::vector<int> m_vTouched;
+};
+
+#endif // ENGINE_SHARED_PROFILER_H
@@ -12,4 +12,15 @@ void CSnapshotBuilder::Init7(const CSnapshot *pSnapshot)
 	m_NumItems = pSnapshot->m_NumItems;
 	mem_copy(m_aOffsets, pSnapshot->Offsets(), sizeof(int) * m_NumItems);
 	mem_copy(m_aData, pSnapshot->DataStart(), m_DataSize);
+	m_Priority = PRIORITY_REQUIRED;
+	m_NewGroup = true;
+	m_UpdatePeriod = 1;
+	for(int i = 0; i < m_NumItems; i++)
+	{
+		m_aGroups[i] = -1;
+		m_aUpdatePeriods[i] = 1;
+	}
+	m_RequiredSize = pSnapshot->OffsetSize() + m_DataSize;
+	m_NumRequiredItems = m_NumItems;
+	m_NumGroups = 0;
 }
@@ -11,6 +11,7 @@
 #include <generated/protocol7.h>
 #include <generated/protocolglue.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <limits>
 
@@ -716,16 +717,30 @@ int CSnapshotStorage::Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData,
 	return -1;
 }
 
+int CSnapshotStarvation::CutSnapshots(int Key) const
+{
+	const auto It = m_CutSnapshots.find(Key);
+	return It == m_CutSnapshots.end() ? 0 : It->second;
+}
+
 // CSnapshotBuilder
 CSnapshotBuilder::CSnapshotBuilder()
 {
 	m_NumExtendedItemTypes = 0;
+	m_NumCutItems = 0;
+	m_CutSize = 0;
 }
 
 void CSnapshotBuilder::Init(bool Sixup)
 {
 	m_DataSize = 0;
 	m_NumItems = 0;
+	m_Priority = PRIORITY_REQUIRED;
+	m_NewGroup = true;
+	m_UpdatePeriod = 1;
+	m_RequiredSize = 0;
+	m_NumRequiredItems = 0;
+	m_NumGroups = 0;
 	m_Sixup = Sixup;
 
 	for(int i = 0; i < m_NumExtendedItemTypes; i++)
@@ -739,6 +754,12 @@ CSnapshotItem *CSnapshotBuilder::GetItem(int Index)
 	return (CSnapshotItem *)&(m_aData[m_aOffsets[Index]]);
 }
 
+int CSnapshotBuilder::GetItemSize(int Index) const
+{
+	const int End = Index + 1 < m_NumItems ? m_aOffsets[Index + 1] : m_DataSize;
+	return End - m_aOffsets[Index];
+}
+
 int *CSnapshotBuilder::GetItemData(int Key)
 {
 	for(int i = 0; i < m_NumItems; i++)
@@ -752,18 +773,132 @@ int *CSnapshotBuilder::GetItemData(int Key)
 	return nullptr;
 }
 
-int CSnapshotBuilder::Finish(void *pSnapData)
+int CSnapshotBuilder::ReuseItems(const CSnapshot *pPrevious, int PreviousTick, int Tick)
+{
+	bool Reduced = false;
+	for(int i = 0; i < m_NumItems && !Reduced; i++)
+		Reduced = m_aUpdatePeriods[i] > 1;
+	if(!Reduced)
+		return 0;
+
+	CItemList aHashlist[HASHLIST_SIZE];
+	GenerateHash(aHashlist, pPrevious);
+
+	int StaleSize = 0;
+	for(int i = 0; i < m_NumItems; i++)
+	{
+		const int Period = m_aUpdatePeriods[i];
+		if(Period <= 1)
+			continue;
+
+		// items with the same id are updated together, like the character
+		// items of a player, other items are spread over the period. Entities
+		// that snap several objects with their own ids, like draggers and
+		// laser doors, therefore update them out of phase.
+		CSnapshotItem *pItem = GetItem(i);
+		const int Phase = pItem->Id() % Period;
+		if((Tick + Phase) / Period != (PreviousTick + Phase) / Period)
+			continue;
+
+		const int PreviousIndex = GetItemIndexHashed(pItem->Key(), aHashlist);
+		const int DataSize = GetItemSize(i) - sizeof(CSnapshotItem);
+		if(PreviousIndex == -1 || pPrevious->GetItemSize(PreviousIndex) != DataSize)
+			continue;
+
+		const int *pPreviousData = pPrevious->GetItem(PreviousIndex)->Data();
+		if(mem_comp(pItem->Data(), pPreviousData, DataSize) != 0)
+		{
+			mem_copy(pItem->Data(), pPreviousData, DataSize);
+			StaleSize += DataSize;
+		}
+	}
+	return StaleSize;
+}
+
+int CSnapshotBuilder::Finish(void *pSnapData, int MaxSize, CSnapshotStarvation *pStarvation)
 {
-	// flatten and make the snapshot
-	dbg_assert(m_NumItems <= CSnapshot::MAX_ITEMS, "Too many snap items");
+	dbg_assert(MaxSize <= CSnapshot::MAX_SIZE, "Snapshot size limit too large");
 	CSnapshot *pSnap = (CSnapshot *)pSnapData;
-	pSnap->m_DataSize = m_DataSize;
-	pSnap->m_NumItems = m_NumItems;
-	const size_t TotalSize = pSnap->TotalSize();
-	dbg_assert(TotalSize <= (size_t)CSnapshot::MAX_SIZE, "Snapshot too large");
-	mem_copy(pSnap->Offsets(), m_aOffsets, pSnap->OffsetSize());
-	mem_copy(pSnap->DataStart(), m_aData, m_DataSize);
-	return TotalSize;
+	m_NumCutItems = 0;
+	m_CutSize = 0;
+
+	if(m_NumItems <= CSnapshot::MAX_ITEMS && sizeof(CSnapshot) + m_NumItems * sizeof(int) + m_DataSize <= (size_t)MaxSize)
+	{
+		// flatten and make the snapshot
+		if(pStarvation)
+			pStarvation->Clear();
+		pSnap->m_DataSize = m_DataSize;
+		pSnap->m_NumItems = m_NumItems;
+		mem_copy(pSnap->Offsets(), m_aOffsets, pSnap->OffsetSize());
+		mem_copy(pSnap->DataStart(), m_aData, m_DataSize);
+		return pSnap->TotalSize();
+	}
+
+	// the groups that were cut before get more important every snapshot
+	for(int i = 0; i < m_NumGroups; i++)
+	{
+		m_aOrder[i] = i;
+		if(pStarvation)
+		{
+			const int64_t Priority = m_aGroupPriorities[i] + (int64_t)STARVATION_BOOST * pStarvation->CutSnapshots(m_aGroupKeys[i]);
+			m_aGroupPriorities[i] = minimum<int64_t>(Priority, PRIORITY_REQUIRED - 1);
+		}
+	}
+	std::sort(m_aOrder, m_aOrder + m_NumGroups, [this](int Left, int Right) {
+		if(m_aGroupPriorities[Left] != m_aGroupPriorities[Right])
+			return m_aGroupPriorities[Left] > m_aGroupPriorities[Right];
+		return Left < Right;
+	});
+
+	// keep the required items, which always fit into the protocol limits,
+	// and the most important groups that fit into the size limit as a whole
+	size_t Size = sizeof(CSnapshot) + m_RequiredSize;
+	int NumKept = m_NumRequiredItems;
+	dbg_assert(NumKept <= CSnapshot::MAX_ITEMS && Size <= (size_t)CSnapshot::MAX_SIZE, "Required snap items exceed the limits");
+	for(int i = 0; i < m_NumGroups; i++)
+	{
+		const int Group = m_aOrder[i];
+		const int GroupSize = m_aGroupSizes[Group];
+		const int GroupNumItems = m_aGroupNumItems[Group];
+		m_aKeep[Group] = NumKept + GroupNumItems <= CSnapshot::MAX_ITEMS && Size + GroupSize <= (size_t)MaxSize;
+		if(m_aKeep[Group])
+		{
+			Size += GroupSize;
+			NumKept += GroupNumItems;
+		}
+		else
+		{
+			m_NumCutItems += GroupNumItems;
+			m_CutSize += GroupSize;
+		}
+	}
+
+	// flatten the kept items in their original order
+	pSnap->m_NumItems = NumKept;
+	int *pOffsets = pSnap->Offsets();
+	char *pData = (char *)pSnap->DataStart();
+	int DataSize = 0;
+	for(int i = 0; i < m_NumItems; i++)
+	{
+		if(m_aGroups[i] != -1 && !m_aKeep[m_aGroups[i]])
+			continue;
+		const int ItemSize = GetItemSize(i);
+		*pOffsets++ = DataSize;
+		mem_copy(pData + DataSize, GetItem(i), ItemSize);
+		DataSize += ItemSize;
+	}
+	pSnap->m_DataSize = DataSize;
+	if(pStarvation)
+	{
+		std::unordered_map<int, int> CutSnapshots;
+		for(int i = 0; i < m_NumGroups; i++)
+		{
+			if(!m_aKeep[i])
+				CutSnapshots[m_aGroupKeys[i]] = pStarvation->CutSnapshots(m_aGroupKeys[i]) + 1;
+		}
+		pStarvation->m_CutSnapshots = std::move(CutSnapshots);
+	}
+	return pSnap->TotalSize();
 }
 
 int CSnapshotBuilder::GetTypeFromIndex(int Index) const
@@ -774,7 +909,14 @@ int CSnapshotBuilder::GetTypeFromIndex(int Index) const
 bool CSnapshotBuilder::AddExtendedItemType(int Index)
 {
 	dbg_assert(0 <= Index && Index < m_NumExtendedItemTypes, "index out of range");
+	// the items of the extended type can't be read without it
+	const int Priority = m_Priority;
+	const int UpdatePeriod = m_UpdatePeriod;
+	m_Priority = PRIORITY_REQUIRED;
+	m_UpdatePeriod = 1;
 	int *pUuidItem = static_cast<int *>(NewItem(0, GetTypeFromIndex(Index), sizeof(CUuid))); // NETOBJTYPE_EX
+	m_Priority = Priority;
+	m_UpdatePeriod = UpdatePeriod;
 	if(pUuidItem == nullptr)
 	{
 		return false;
@@ -817,27 +959,34 @@ void *CSnapshotBuilder::NewItem(int Type, int Id, int Size)
 		return nullptr;
 	}
 
-	if(m_NumItems >= CSnapshot::MAX_ITEMS)
+	// the item of the extended type is added first, so that the limits
+	// below also account for it
+	const bool Extended = Type >= OFFSET_UUID;
+	if(Extended)
+	{
+		const int ExtendedItemTypeIndex = GetExtendedItemTypeIndex(Type);
+		if(ExtendedItemTypeIndex == -1)
+		{
+			return nullptr;
+		}
+		Type = GetTypeFromIndex(ExtendedItemTypeIndex);
+	}
+
+	if(m_NumItems >= MAX_BUILD_ITEMS)
 	{
 		return nullptr;
 	}
 
-	const size_t OffsetSize = (m_NumItems + 1) * sizeof(int);
 	const size_t ItemSize = sizeof(CSnapshotItem) + Size;
-	if(sizeof(CSnapshot) + OffsetSize + m_DataSize + ItemSize > CSnapshot::MAX_SIZE)
+	if(m_DataSize + ItemSize > MAX_BUILD_SIZE)
 	{
 		return nullptr;
 	}
 
-	const bool Extended = Type >= OFFSET_UUID;
-	if(Extended)
+	const bool Required = m_Priority == PRIORITY_REQUIRED;
+	if(Required && (m_NumRequiredItems >= CSnapshot::MAX_ITEMS || sizeof(CSnapshot) + m_RequiredSize + sizeof(int) + ItemSize > CSnapshot::MAX_SIZE))
 	{
-		const int ExtendedItemTypeIndex = GetExtendedItemTypeIndex(Type);
-		if(ExtendedItemTypeIndex == -1)
-		{
-			return nullptr;
-		}
-		Type = GetTypeFromIndex(ExtendedItemTypeIndex);
+		return nullptr;
 	}
 
 	CSnapshotItem *pObj = (CSnapshotItem *)(m_aData + m_DataSize);
@@ -857,6 +1006,29 @@ void *CSnapshotBuilder::NewItem(int Type, int Id, int Size)
 
 	pObj->m_TypeAndId = (Type << 16) | Id;
 	m_aOffsets[m_NumItems] = m_DataSize;
+	m_aUpdatePeriods[m_NumItems] = m_UpdatePeriod;
+	if(Required)
+	{
+		m_aGroups[m_NumItems] = -1;
+		m_RequiredSize += sizeof(int) + ItemSize;
+		m_NumRequiredItems++;
+	}
+	else
+	{
+		if(m_NewGroup)
+		{
+			m_aGroupPriorities[m_NumGroups] = m_Priority;
+			m_aGroupKeys[m_NumGroups] = pObj->Key();
+			m_aGroupSizes[m_NumGroups] = 0;
+			m_aGroupNumItems[m_NumGroups] = 0;
+			m_NumGroups++;
+			m_NewGroup = false;
+		}
+		const int Group = m_NumGroups - 1;
+		m_aGroups[m_NumItems] = Group;
+		m_aGroupSizes[Group] += sizeof(int) + ItemSize;
+		m_aGroupNumItems[Group]++;
+	}
 	m_DataSize += ItemSize;
 	m_NumItems++;
 
@@ -8,6 +8,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <unordered_map>
 
 // CSnapshot
 
@@ -146,25 +147,78 @@ public:
 	int Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData) const;
 };
 
+// The item groups that were cut from the last snapshots of a client, by the
+// key of their first item, with the number of snapshots in a row they were cut
+// from, so that they can be preferred in the next snapshots.
+class CSnapshotStarvation
+{
+	friend class CSnapshotBuilder;
+
+	std::unordered_map<int, int> m_CutSnapshots;
+
+public:
+	void Clear() { m_CutSnapshots.clear(); }
+	int CutSnapshots(int Key) const;
+};
+
 class CSnapshotBuilder
 {
+public:
+	enum
+	{
+		// items with this priority are never cut for other items
+		PRIORITY_REQUIRED = 0x7fffffff,
+		// added to the priority of an item for each snapshot in a row it was cut from
+		STARVATION_BOOST = 128,
+	};
+
+private:
 	enum
 	{
 		MAX_EXTENDED_ITEM_TYPES = 64,
+		// items with a priority can be added beyond the snapshot limits,
+		// `Finish` keeps the ones that fit
+		MAX_BUILD_SIZE = 2 * CSnapshot::MAX_SIZE,
+		MAX_BUILD_ITEMS = 2 * CSnapshot::MAX_ITEMS,
 	};
 
-	char m_aData[CSnapshot::MAX_SIZE];
+	char m_aData[MAX_BUILD_SIZE];
 	int m_DataSize;
 
-	int m_aOffsets[CSnapshot::MAX_ITEMS];
+	int m_aOffsets[MAX_BUILD_ITEMS];
+	// group of each item, -1 for required items
+	int m_aGroups[MAX_BUILD_ITEMS];
+	int m_aUpdatePeriods[MAX_BUILD_ITEMS];
 	int m_NumItems;
 
+	int m_Priority;
+	bool m_NewGroup;
+	int m_UpdatePeriod;
+	// size in the finished snapshot and number of the required items, which
+	// always have to fit into the snapshot limits
+	int m_RequiredSize;
+	int m_NumRequiredItems;
+
+	// the items with a priority that are added after one `SetPriority` call
+	// form a group, which is kept or cut as a whole
+	int m_aGroupPriorities[MAX_BUILD_ITEMS];
+	int m_aGroupKeys[MAX_BUILD_ITEMS];
+	int m_aGroupSizes[MAX_BUILD_ITEMS];
+	int m_aGroupNumItems[MAX_BUILD_ITEMS];
+	int m_NumGroups;
+
+	int m_NumCutItems;
+	int m_CutSize;
+	int m_aOrder[MAX_BUILD_ITEMS];
+	bool m_aKeep[MAX_BUILD_ITEMS];
+
 	int m_aExtendedItemTypes[MAX_EXTENDED_ITEM_TYPES];
 	int m_NumExtendedItemTypes;
 
 	bool AddExtendedItemType(int Index);
 	int GetExtendedItemTypeIndex(int TypeId);
 	int GetTypeFromIndex(int Index) const;
+	int GetItemSize(int Index) const;
 
 	bool m_Sixup = false;
 
@@ -174,12 +228,34 @@ public:
 	void Init(bool Sixup = false);
 	void Init7(const CSnapshot *pSnapshot);
 
+	// priority of the following items, items with lower priorities are cut
+	// first if the snapshot doesn't fit. The items added until the next call
+	// belong together and are only kept if all of them fit.
+	void SetPriority(int Priority)
+	{
+		m_Priority = Priority;
+		m_NewGroup = true;
+	}
+	// the following items only have to be updated every this many ticks,
+	// see `ReuseItems`
+	void SetUpdatePeriod(int Ticks) { m_UpdatePeriod = Ticks; }
 	void *NewItem(int Type, int Id, int Size);
 
+	// keeps the data of the previous snapshot for the items that don't have
+	// to be updated yet, so that the delta doesn't contain them, returns the
+	// size of the changed data that was not updated
+	int ReuseItems(const CSnapshot *pPrevious, int PreviousTick, int Tick);
+
 	CSnapshotItem *GetItem(int Index);
 	int *GetItemData(int Key);
 
-	int Finish(void *pSnapdata);
+	// cuts the item groups with the lowest priorities if the snapshot is larger
+	// than `MaxSize`, preferring the groups in `pStarvation` and updating it,
+	// required items are always kept even if they alone exceed `MaxSize`
+	int Finish(void *pSnapdata, int MaxSize = CSnapshot::MAX_SIZE, CSnapshotStarvation *pStarvation = nullptr);
+	// items cut by the last `Finish` and their size
+	int NumCutItems() const { return m_NumCutItems; }
+	int CutSize() const { return m_CutSize; }
 };
 
 #endif // ENGINE_SNAPSHOT_H
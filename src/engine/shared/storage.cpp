@@ -1,22 +1,276 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/hash_ctxt.h>
+#include <base/lock.h>
 #include <base/log.h>
 #include <base/math.h>
 #include <base/system.h>
+#include <base/time.h>
 
 #include <engine/client/updater.h>
 #include <engine/shared/linereader.h>
 #include <engine/storage.h>
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #ifdef CONF_PLATFORM_HAIKU
 #include <cstdlib>
 #endif
 
+#if defined(CONF_PLATFORM_LINUX)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 #include <zlib.h>
 
+// Keeps directory listings in memory so that repeated listings and recursive
+// file searches don't read the same directories again. On Linux the indexed
+// directories are watched with inotify. Elsewhere, or when a watch can't be
+// added, a listing is reused only while the modification time of its
+// directory is unchanged, which doesn't cover the times of the files inside.
+class CDirectoryIndex
+{
+public:
+	class CEntry
+	{
+	public:
+		std::string m_Name;
+		bool m_IsDir;
+		time_t m_TimeCreated;
+		time_t m_TimeModified;
+	};
+
+	class CListing
+	{
+	public:
+		std::vector<CEntry> m_vEntries;
+		time_t m_DirModified = -1;
+		bool m_Watched = false;
+		// The directory was modified in the same second as it was listed,
+		// so its modification time can't tell whether the listing is current.
+		bool m_Recent = true;
+	};
+
+	enum
+	{
+		MAX_DIRECTORIES = 4096,
+	};
+
+	CDirectoryIndex()
+	{
+#if defined(CONF_PLATFORM_LINUX)
+		m_InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	}
+
+	~CDirectoryIndex()
+	{
+#if defined(CONF_PLATFORM_LINUX)
+		if(m_InotifyFd >= 0)
+			close(m_InotifyFd);
+#endif
+	}
+
+	void SetEnabled(bool Enabled)
+	{
+		const CLockScope LockScope(m_Lock);
+		m_Enabled = Enabled;
+		ClearLocked();
+	}
+
+	// Returns the entries of the directory at the given path. Times are only
+	// served from the index for watched directories, otherwise requesting
+	// them lists the directory again.
+	std::shared_ptr<const CListing> List(const char *pPath, bool NeedTimes)
+	{
+		const std::string Key = NormalizedKey(pPath);
+		uint64_t Generation;
+		{
+			const CLockScope LockScope(m_Lock);
+			if(!m_Enabled)
+				return Scan(pPath, NeedTimes);
+
+			PollLocked();
+			auto It = m_Listings.find(Key);
+			if(It != m_Listings.end())
+			{
+				const std::shared_ptr<const CListing> &pListing = It->second;
+				if(pListing->m_Watched)
+					return pListing;
+				if(!NeedTimes && !pListing->m_Recent)
+				{
+					time_t Created, Modified;
+					if(fs_file_time(pPath, &Created, &Modified) == 0 && Modified == pListing->m_DirModified)
+						return pListing;
+				}
+				m_Listings.erase(It);
+			}
+			if(m_Listings.size() >= MAX_DIRECTORIES)
+				ClearLocked();
+			Generation = m_Generation;
+		}
+
+		// the watch is added before listing so that no change goes unnoticed
+		const bool Watched = Watch(Key);
+		const int64_t ScanTime = time_timestamp();
+		time_t Created, Modified;
+		const bool HasTime = fs_file_time(pPath, &Created, &Modified) == 0;
+		std::shared_ptr<CListing> pListing = Scan(pPath, true);
+		if(!HasTime)
+			return pListing;
+		pListing->m_DirModified = Modified;
+		pListing->m_Watched = Watched;
+		pListing->m_Recent = Modified >= ScanTime - 1;
+
+		const CLockScope LockScope(m_Lock);
+		if(m_Enabled && m_Generation == Generation)
+			m_Listings[Key] = pListing;
+		return pListing;
+	}
+
+	// Drops the listing of the directory at the given path.
+	void Invalidate(const char *pPath)
+	{
+		const std::string Key = NormalizedKey(pPath);
+		const CLockScope LockScope(m_Lock);
+		m_Listings.erase(Key);
+		m_Generation++;
+	}
+
+	// Drops the listing of the directory containing the given path.
+	void InvalidateParent(const char *pPath)
+	{
+		std::string Key = NormalizedKey(pPath);
+		const size_t Slash = Key.rfind('/');
+		Key.resize(Slash == std::string::npos ? 0 : Slash);
+		const CLockScope LockScope(m_Lock);
+		m_Listings.erase(Key);
+		m_Generation++;
+	}
+
+	size_t NumDirectories()
+	{
+		const CLockScope LockScope(m_Lock);
+		return m_Listings.size();
+	}
+
+private:
+	static std::string NormalizedKey(const char *pPath)
+	{
+		std::string Key;
+		Key.reserve(str_length(pPath));
+		for(const char *pChar = pPath; *pChar; pChar++)
+		{
+			const char Char = *pChar == '\\' ? '/' : *pChar;
+			if(Char == '/' && !Key.empty() && Key.back() == '/')
+				continue;
+			Key.push_back(Char);
+		}
+		if(Key.size() > 1 && Key.back() == '/')
+			Key.pop_back();
+		return Key;
+	}
+
+	static int ScanCallback(const char *pName, int IsDir, int Type, void *pUser)
+	{
+		CListing *pListing = static_cast<CListing *>(pUser);
+		pListing->m_vEntries.push_back({pName, IsDir != 0, -1, -1});
+		return 0;
+	}
+
+	static int ScanInfoCallback(const CFsFileInfo *pInfo, int IsDir, int Type, void *pUser)
+	{
+		CListing *pListing = static_cast<CListing *>(pUser);
+		pListing->m_vEntries.push_back({pInfo->m_pName, IsDir != 0, pInfo->m_TimeCreated, pInfo->m_TimeModified});
+		return 0;
+	}
+
+	static std::shared_ptr<CListing> Scan(const char *pPath, bool WithTimes)
+	{
+		std::shared_ptr<CListing> pListing = std::make_shared<CListing>();
+		if(WithTimes)
+			fs_listdir_fileinfo(pPath, ScanInfoCallback, 0, pListing.get());
+		else
+			fs_listdir(pPath, ScanCallback, 0, pListing.get());
+		return pListing;
+	}
+
+	void ClearLocked() REQUIRES(m_Lock)
+	{
+		m_Listings.clear();
+		m_Generation++;
+#if defined(CONF_PLATFORM_LINUX)
+		for(const auto &[Wd, _] : m_WatchPaths)
+			inotify_rm_watch(m_InotifyFd, Wd);
+		m_WatchPaths.clear();
+#endif
+	}
+
+	bool Watch(const std::string &Key)
+	{
+#if defined(CONF_PLATFORM_LINUX)
+		const CLockScope LockScope(m_Lock);
+		if(m_InotifyFd < 0)
+			return false;
+		const int Wd = inotify_add_watch(m_InotifyFd, Key.c_str(), IN_ONLYDIR | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF);
+		if(Wd < 0)
+			return false;
+		m_WatchPaths[Wd] = Key;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void PollLocked() REQUIRES(m_Lock)
+	{
+#if defined(CONF_PLATFORM_LINUX)
+		if(m_InotifyFd < 0)
+			return;
+		alignas(struct inotify_event) char aBuffer[4096];
+		while(true)
+		{
+			const ssize_t Length = read(m_InotifyFd, aBuffer, sizeof(aBuffer));
+			if(Length <= 0)
+				break;
+			m_Generation++;
+			for(ssize_t Offset = 0; Offset < Length;)
+			{
+				const struct inotify_event *pEvent = reinterpret_cast<const struct inotify_event *>(aBuffer + Offset);
+				Offset += sizeof(struct inotify_event) + pEvent->len;
+				if(pEvent->mask & IN_Q_OVERFLOW)
+				{
+					m_Listings.clear();
+					continue;
+				}
+				auto It = m_WatchPaths.find(pEvent->wd);
+				if(It == m_WatchPaths.end())
+					continue;
+				m_Listings.erase(It->second);
+				if(pEvent->mask & IN_IGNORED)
+					m_WatchPaths.erase(It);
+			}
+		}
+#endif
+	}
+
+	CLock m_Lock;
+	bool m_Enabled GUARDED_BY(m_Lock) = true;
+	// incremented whenever listings are dropped, so that a listing read
+	// concurrently with a change isn't added afterwards
+	uint64_t m_Generation GUARDED_BY(m_Lock) = 0;
+	std::unordered_map<std::string, std::shared_ptr<const CListing>> m_Listings GUARDED_BY(m_Lock);
+#if defined(CONF_PLATFORM_LINUX)
+	int m_InotifyFd = -1;
+	std::unordered_map<int, std::string> m_WatchPaths GUARDED_BY(m_Lock);
+#endif
+};
+
 class CStorage : public IStorage
 {
 	char m_aaStoragePaths[MAX_PATHS][IO_MAX_PATH_LENGTH];
@@ -25,6 +279,7 @@ class CStorage : public IStorage
 	char m_aDatadir[IO_MAX_PATH_LENGTH] = "";
 	char m_aCurrentdir[IO_MAX_PATH_LENGTH] = "";
 	char m_aBinarydir[IO_MAX_PATH_LENGTH] = "";
+	CDirectoryIndex m_Index;
 
 public:
 	bool Init(EInitializationType InitializationType, int NumArgs, const char **ppArguments)
@@ -402,38 +657,42 @@ public:
 		return m_NumPaths;
 	}
 
-	struct SListDirectoryInfoUniqueCallbackData
-	{
-		FS_LISTDIR_CALLBACK_FILEINFO m_pfnDelegate;
-		void *m_pDelegateUser;
-		std::unordered_set<std::string> m_Seen;
-	};
-
-	static int ListDirectoryInfoUniqueCallback(const CFsFileInfo *pInfo, int IsDir, int Type, void *pUser)
+	void SetIndexEnabled(bool Enabled) override
 	{
-		SListDirectoryInfoUniqueCallbackData *pData = static_cast<SListDirectoryInfoUniqueCallbackData *>(pUser);
-		auto [_, InsertionTookPlace] = pData->m_Seen.emplace(pInfo->m_pName);
-		if(InsertionTookPlace)
-			return pData->m_pfnDelegate(pInfo, IsDir, Type, pData->m_pDelegateUser);
-		return 0;
+		m_Index.SetEnabled(Enabled);
 	}
 
-	void ListDirectoryInfo(int Type, const char *pPath, FS_LISTDIR_CALLBACK_FILEINFO pfnCallback, void *pUser) override
+	// Calls the given function with the entries of the directory, until it
+	// returns true. With TYPE_ALL, entries of the same name in multiple storage
+	// paths are only visited for the first path, and stopping only skips the
+	// rest of the current path.
+	template<typename F>
+	void ForEachEntry(int Type, const char *pPath, bool NeedTimes, F &&Visit)
 	{
 		char aBuffer[IO_MAX_PATH_LENGTH];
 		if(Type == TYPE_ALL)
 		{
-			SListDirectoryInfoUniqueCallbackData Data;
-			Data.m_pfnDelegate = pfnCallback;
-			Data.m_pDelegateUser = pUser;
+			std::unordered_set<std::string> Seen;
 			// list all available directories
 			for(int i = TYPE_SAVE; i < m_NumPaths; ++i)
-				fs_listdir_fileinfo(GetPath(i, pPath, aBuffer, sizeof(aBuffer)), ListDirectoryInfoUniqueCallback, i, &Data);
+			{
+				const std::shared_ptr<const CDirectoryIndex::CListing> pListing = m_Index.List(GetPath(i, pPath, aBuffer, sizeof(aBuffer)), NeedTimes);
+				for(const CDirectoryIndex::CEntry &Entry : pListing->m_vEntries)
+				{
+					if(Seen.emplace(Entry.m_Name).second && Visit(Entry, i))
+						break;
+				}
+			}
 		}
 		else if(Type >= TYPE_SAVE && Type < m_NumPaths)
 		{
 			// list wanted directory
-			fs_listdir_fileinfo(GetPath(Type, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, Type, pUser);
+			const std::shared_ptr<const CDirectoryIndex::CListing> pListing = m_Index.List(GetPath(Type, pPath, aBuffer, sizeof(aBuffer)), NeedTimes);
+			for(const CDirectoryIndex::CEntry &Entry : pListing->m_vEntries)
+			{
+				if(Visit(Entry, Type))
+					break;
+			}
 		}
 		else
 		{
@@ -441,43 +700,22 @@ public:
 		}
 	}
 
-	struct SListDirectoryUniqueCallbackData
-	{
-		FS_LISTDIR_CALLBACK m_pfnDelegate;
-		void *m_pDelegateUser;
-		std::unordered_set<std::string> m_Seen;
-	};
-
-	static int ListDirectoryUniqueCallback(const char *pName, int IsDir, int Type, void *pUser)
+	void ListDirectoryInfo(int Type, const char *pPath, FS_LISTDIR_CALLBACK_FILEINFO pfnCallback, void *pUser) override
 	{
-		SListDirectoryUniqueCallbackData *pData = static_cast<SListDirectoryUniqueCallbackData *>(pUser);
-		auto [_, InsertionTookPlace] = pData->m_Seen.emplace(pName);
-		if(InsertionTookPlace)
-			return pData->m_pfnDelegate(pName, IsDir, Type, pData->m_pDelegateUser);
-		return 0;
+		ForEachEntry(Type, pPath, true, [&](const CDirectoryIndex::CEntry &Entry, int EntryType) {
+			CFsFileInfo Info;
+			Info.m_pName = Entry.m_Name.c_str();
+			Info.m_TimeCreated = Entry.m_TimeCreated;
+			Info.m_TimeModified = Entry.m_TimeModified;
+			return pfnCallback(&Info, Entry.m_IsDir, EntryType, pUser) != 0;
+		});
 	}
 
 	void ListDirectory(int Type, const char *pPath, FS_LISTDIR_CALLBACK pfnCallback, void *pUser) override
 	{
-		char aBuffer[IO_MAX_PATH_LENGTH];
-		if(Type == TYPE_ALL)
-		{
-			SListDirectoryUniqueCallbackData Data;
-			Data.m_pfnDelegate = pfnCallback;
-			Data.m_pDelegateUser = pUser;
-			// list all available directories
-			for(int i = TYPE_SAVE; i < m_NumPaths; ++i)
-				fs_listdir(GetPath(i, pPath, aBuffer, sizeof(aBuffer)), ListDirectoryUniqueCallback, i, &Data);
-		}
-		else if(Type >= TYPE_SAVE && Type < m_NumPaths)
-		{
-			// list wanted directory
-			fs_listdir(GetPath(Type, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, Type, pUser);
-		}
-		else
-		{
-			dbg_assert_failed("Type invalid");
-		}
+		ForEachEntry(Type, pPath, false, [&](const CDirectoryIndex::CEntry &Entry, int EntryType) {
+			return pfnCallback(Entry.m_Name.c_str(), Entry.m_IsDir, EntryType, pUser) != 0;
+		});
 	}
 
 	const char *GetPath(int Type, const char *pDir, char *pBuffer, unsigned BufferSize) const
@@ -501,6 +739,14 @@ public:
 			Type = fs_is_relative_path(pPath) ? TYPE_ALL : TYPE_ABSOLUTE;
 	}
 
+	IOHANDLE OpenPath(const char *pPath, int Flags)
+	{
+		IOHANDLE Handle = io_open(pPath, Flags);
+		if(Handle && (Flags & (IOFLAG_WRITE | IOFLAG_APPEND)))
+			m_Index.InvalidateParent(pPath);
+		return Handle;
+	}
+
 	IOHANDLE OpenFile(const char *pFilename, int Flags, int Type, char *pBuffer = nullptr, int BufferSize = 0) override
 	{
 		TranslateType(Type, pFilename);
@@ -517,7 +763,7 @@ public:
 
 		if(Type == TYPE_ABSOLUTE)
 		{
-			return io_open(GetPath(TYPE_ABSOLUTE, pFilename, pBuffer, BufferSize), Flags);
+			return OpenPath(GetPath(TYPE_ABSOLUTE, pFilename, pBuffer, BufferSize), Flags);
 		}
 
 		if(str_startswith(pFilename, "mapres/../skins/"))
@@ -538,7 +784,7 @@ public:
 			// check all available directories
 			for(int i = TYPE_SAVE; i < m_NumPaths; ++i)
 			{
-				IOHANDLE Handle = io_open(GetPath(i, pFilename, pBuffer, BufferSize), Flags);
+				IOHANDLE Handle = OpenPath(GetPath(i, pFilename, pBuffer, BufferSize), Flags);
 				if(Handle)
 				{
 					return Handle;
@@ -549,7 +795,7 @@ public:
 		else if(Type >= TYPE_SAVE && Type < m_NumPaths)
 		{
 			// check wanted directory
-			return io_open(GetPath(Type, pFilename, pBuffer, BufferSize), Flags);
+			return OpenPath(GetPath(Type, pFilename, pBuffer, BufferSize), Flags);
 		}
 		else
 		{
@@ -663,40 +909,31 @@ public:
 		return true;
 	}
 
-	struct CFindCBData
-	{
-		CStorage *m_pStorage;
-		const char *m_pFilename;
-		const char *m_pPath;
-		char *m_pBuffer;
-		int m_BufferSize;
-	};
-
-	static int FindFileCallback(const char *pName, int IsDir, int Type, void *pUser)
+	bool FindFileIn(int Type, const char *pPath, const char *pFilename, char *pBuffer, int BufferSize)
 	{
-		CFindCBData Data = *static_cast<CFindCBData *>(pUser);
-		if(IsDir)
+		char aBuf[IO_MAX_PATH_LENGTH];
+		const std::shared_ptr<const CDirectoryIndex::CListing> pListing = m_Index.List(GetPath(Type, pPath, aBuf, sizeof(aBuf)), false);
+		for(const CDirectoryIndex::CEntry &Entry : pListing->m_vEntries)
 		{
-			if(pName[0] == '.')
-				return 0;
+			if(Entry.m_IsDir)
+			{
+				if(Entry.m_Name[0] == '.')
+					continue;
 
-			// search within the folder
-			char aBuf[IO_MAX_PATH_LENGTH];
-			char aPath[IO_MAX_PATH_LENGTH];
-			str_format(aPath, sizeof(aPath), "%s/%s", Data.m_pPath, pName);
-			Data.m_pPath = aPath;
-			fs_listdir(Data.m_pStorage->GetPath(Type, aPath, aBuf, sizeof(aBuf)), FindFileCallback, Type, &Data);
-			if(Data.m_pBuffer[0])
-				return 1;
-		}
-		else if(!str_comp(pName, Data.m_pFilename))
-		{
-			// found the file = end
-			str_format(Data.m_pBuffer, Data.m_BufferSize, "%s/%s", Data.m_pPath, Data.m_pFilename);
-			return 1;
+				// search within the folder
+				char aPath[IO_MAX_PATH_LENGTH];
+				str_format(aPath, sizeof(aPath), "%s/%s", pPath, Entry.m_Name.c_str());
+				if(FindFileIn(Type, aPath, pFilename, pBuffer, BufferSize))
+					return true;
+			}
+			else if(Entry.m_Name == pFilename)
+			{
+				// found the file = end
+				str_format(pBuffer, BufferSize, "%s/%s", pPath, pFilename);
+				return true;
+			}
 		}
-
-		return 0;
+		return false;
 	}
 
 	bool FindFile(const char *pFilename, const char *pPath, int Type, char *pBuffer, int BufferSize) override
@@ -705,28 +942,19 @@ public:
 
 		pBuffer[0] = 0;
 
-		CFindCBData Data;
-		Data.m_pStorage = this;
-		Data.m_pFilename = pFilename;
-		Data.m_pPath = pPath;
-		Data.m_pBuffer = pBuffer;
-		Data.m_BufferSize = BufferSize;
-
-		char aBuf[IO_MAX_PATH_LENGTH];
 		if(Type == TYPE_ALL)
 		{
 			// search within all available directories
 			for(int i = TYPE_SAVE; i < m_NumPaths; ++i)
 			{
-				fs_listdir(GetPath(i, pPath, aBuf, sizeof(aBuf)), FindFileCallback, i, &Data);
-				if(pBuffer[0])
+				if(FindFileIn(i, pPath, pFilename, pBuffer, BufferSize))
 					return true;
 			}
 		}
 		else if(Type >= TYPE_SAVE && Type < m_NumPaths)
 		{
 			// search within wanted directory
-			fs_listdir(GetPath(Type, pPath, aBuf, sizeof(aBuf)), FindFileCallback, Type, &Data);
+			FindFileIn(Type, pPath, pFilename, pBuffer, BufferSize);
 		}
 		else
 		{
@@ -736,60 +964,45 @@ public:
 		return pBuffer[0] != 0;
 	}
 
-	struct SFindFilesCallbackData
+	void FindFilesIn(int Type, const char *pPath, const char *pFilename, std::set<std::string> *pEntries)
 	{
-		CStorage *m_pStorage;
-		const char *m_pFilename;
-		const char *m_pPath;
-		std::set<std::string> *m_pEntries;
-	};
-
-	static int FindFilesCallback(const char *pName, int IsDir, int Type, void *pUser)
-	{
-		SFindFilesCallbackData Data = *static_cast<SFindFilesCallbackData *>(pUser);
-		if(IsDir)
+		char aBuf[IO_MAX_PATH_LENGTH];
+		const std::shared_ptr<const CDirectoryIndex::CListing> pListing = m_Index.List(GetPath(Type, pPath, aBuf, sizeof(aBuf)), false);
+		for(const CDirectoryIndex::CEntry &Entry : pListing->m_vEntries)
 		{
-			if(pName[0] == '.')
-				return 0;
+			if(Entry.m_IsDir)
+			{
+				if(Entry.m_Name[0] == '.')
+					continue;
 
-			// search within the folder
-			char aBuf[IO_MAX_PATH_LENGTH];
-			char aPath[IO_MAX_PATH_LENGTH];
-			str_format(aPath, sizeof(aPath), "%s/%s", Data.m_pPath, pName);
-			Data.m_pPath = aPath;
-			fs_listdir(Data.m_pStorage->GetPath(Type, aPath, aBuf, sizeof(aBuf)), FindFilesCallback, Type, &Data);
-		}
-		else if(!str_comp(pName, Data.m_pFilename))
-		{
-			char aBuffer[IO_MAX_PATH_LENGTH];
-			str_format(aBuffer, sizeof(aBuffer), "%s/%s", Data.m_pPath, Data.m_pFilename);
-			Data.m_pEntries->emplace(aBuffer);
+				// search within the folder
+				char aPath[IO_MAX_PATH_LENGTH];
+				str_format(aPath, sizeof(aPath), "%s/%s", pPath, Entry.m_Name.c_str());
+				FindFilesIn(Type, aPath, pFilename, pEntries);
+			}
+			else if(Entry.m_Name == pFilename)
+			{
+				char aBuffer[IO_MAX_PATH_LENGTH];
+				str_format(aBuffer, sizeof(aBuffer), "%s/%s", pPath, pFilename);
+				pEntries->emplace(aBuffer);
+			}
 		}
-
-		return 0;
 	}
 
 	size_t FindFiles(const char *pFilename, const char *pPath, int Type, std::set<std::string> *pEntries) override
 	{
-		SFindFilesCallbackData Data;
-		Data.m_pStorage = this;
-		Data.m_pFilename = pFilename;
-		Data.m_pPath = pPath;
-		Data.m_pEntries = pEntries;
-
-		char aBuf[IO_MAX_PATH_LENGTH];
 		if(Type == TYPE_ALL)
 		{
 			// search within all available directories
 			for(int i = TYPE_SAVE; i < m_NumPaths; ++i)
 			{
-				fs_listdir(GetPath(i, pPath, aBuf, sizeof(aBuf)), FindFilesCallback, i, &Data);
+				FindFilesIn(i, pPath, pFilename, pEntries);
 			}
 		}
 		else if(Type >= TYPE_SAVE && Type < m_NumPaths)
 		{
 			// search within wanted directory
-			fs_listdir(GetPath(Type, pPath, aBuf, sizeof(aBuf)), FindFilesCallback, Type, &Data);
+			FindFilesIn(Type, pPath, pFilename, pEntries);
 		}
 		else
 		{
@@ -806,7 +1019,9 @@ public:
 		char aBuffer[IO_MAX_PATH_LENGTH];
 		GetPath(Type, pFilename, aBuffer, sizeof(aBuffer));
 
-		return fs_remove(aBuffer) == 0;
+		const bool Success = fs_remove(aBuffer) == 0;
+		m_Index.InvalidateParent(aBuffer);
+		return Success;
 	}
 
 	bool RemoveFolder(const char *pFilename, int Type) override
@@ -816,7 +1031,10 @@ public:
 		char aBuffer[IO_MAX_PATH_LENGTH];
 		GetPath(Type, pFilename, aBuffer, sizeof(aBuffer));
 
-		return fs_removedir(aBuffer) == 0;
+		const bool Success = fs_removedir(aBuffer) == 0;
+		m_Index.Invalidate(aBuffer);
+		m_Index.InvalidateParent(aBuffer);
+		return Success;
 	}
 
 	bool RemoveBinaryFile(const char *pFilename) override
@@ -836,7 +1054,11 @@ public:
 		GetPath(Type, pOldFilename, aOldBuffer, sizeof(aOldBuffer));
 		GetPath(Type, pNewFilename, aNewBuffer, sizeof(aNewBuffer));
 
-		return fs_rename(aOldBuffer, aNewBuffer) == 0;
+		const bool Success = fs_rename(aOldBuffer, aNewBuffer) == 0;
+		m_Index.Invalidate(aOldBuffer);
+		m_Index.InvalidateParent(aOldBuffer);
+		m_Index.InvalidateParent(aNewBuffer);
+		return Success;
 	}
 
 	bool RenameBinaryFile(const char *pOldFilename, const char *pNewFilename) override
@@ -862,7 +1084,9 @@ public:
 		char aBuffer[IO_MAX_PATH_LENGTH];
 		GetPath(Type, pFoldername, aBuffer, sizeof(aBuffer));
 
-		return fs_makedir(aBuffer) == 0;
+		const bool Success = fs_makedir(aBuffer) == 0;
+		m_Index.InvalidateParent(aBuffer);
+		return Success;
 	}
 
 	void GetCompletePath(int Type, const char *pDir, char *pBuffer, unsigned BufferSize) override
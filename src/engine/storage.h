@@ -50,6 +50,11 @@ public:
 	};
 
 	virtual int NumPaths() const = 0;
+	/**
+	 * Enables or disables the in-memory index of directory listings used by
+	 * ListDirectory, ListDirectoryInfo, FindFile and FindFiles.
+	 */
+	virtual void SetIndexEnabled(bool Enabled) = 0;
 
 	virtual void ListDirectory(int Type, const char *pPath, FS_LISTDIR_CALLBACK pfnCallback, void *pUser) = 0;
 	virtual void ListDirectoryInfo(int Type, const char *pPath, FS_LISTDIR_CALLBACK_FILEINFO pfnCallback, void *pUser) = 0;
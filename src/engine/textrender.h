@@ -182,6 +182,13 @@ struct STextContainerIndex
 	void Reset() { m_Index = -1; }
 };
 
+struct STextLayoutCacheStats
+{
+	int m_Entries = 0;
+	int m_Hits = 0;
+	int m_Misses = 0;
+};
+
 struct STextSizeProperties
 {
 	float *m_pHeight = nullptr;
@@ -253,6 +260,12 @@ class IEngineTextRender : public ITextRender
 public:
 	virtual void Init() = 0;
 	void Shutdown() override = 0;
+
+	virtual void SetLayoutCacheEnabled(bool Enabled) = 0;
+	// ages out cached TextEx layouts, called once per rendered frame
+	virtual void UpdateLayoutCache() = 0;
+	// counters of the last completed frame
+	virtual STextLayoutCacheStats LayoutCacheStats() const = 0;
 };
 
 extern IEngineTextRender *CreateEngineTextRender();
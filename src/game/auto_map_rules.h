@@ -0,0 +1,148 @@
+#ifndef GAME_AUTO_MAP_RULES_H
+#define GAME_AUTO_MAP_RULES_H
+
+#include <base/types.h>
+
+#include <functional>
+#include <vector>
+
+class CTile;
+class IEngine;
+
+/**
+ * Parsed automapper rules (`editor/automap/<image name>.rules`) and the rule engine applying them to tile data.
+ *
+ * This does not depend on the editor, so maps can also be automapped headless.
+ */
+class CAutoMapRules
+{
+	class CIndexInfo
+	{
+	public:
+		int m_Id;
+		int m_Flag;
+		bool m_TestFlag;
+	};
+
+	class CPosRule
+	{
+	public:
+		int m_X;
+		int m_Y;
+		int m_Value;
+		std::vector<CIndexInfo> m_vIndexList;
+		bool m_IsGuide;
+
+		enum
+		{
+			NORULE = 0,
+			INDEX,
+			NOTINDEX
+		};
+	};
+
+	class CModuloRule
+	{
+	public:
+		int m_ModX;
+		int m_ModY;
+		int m_OffsetX;
+		int m_OffsetY;
+	};
+
+	class CIndexRule
+	{
+	public:
+		int m_Id;
+		std::vector<CPosRule> m_vRules;
+		int m_Flag;
+		float m_RandomProbability;
+		std::vector<CModuloRule> m_vModuloRules;
+		bool m_DefaultRule;
+		bool m_SkipEmpty;
+		bool m_SkipFull;
+	};
+	class CRun
+	{
+	public:
+		std::vector<CIndexRule> m_vIndexRules;
+		bool m_AutomapCopy;
+	};
+
+public:
+	class CConfiguration
+	{
+	public:
+		std::vector<CRun> m_vRuns;
+		char m_aName[128];
+		int m_StartX;
+		int m_StartY;
+		int m_EndX;
+		int m_EndY;
+	};
+
+	/**
+	 * Number of game tiles which can be used as automapping reference, reference ids are 1-based.
+	 */
+	static constexpr int NUM_REFERENCE_TILES = 9;
+
+	/**
+	 * Layers with less tiles are always automapped on the calling thread.
+	 */
+	static constexpr int PARALLEL_MIN_TILES = 128 * 128;
+
+	/**
+	 * Called for every tile which was changed by a rule, in row-major order.
+	 *
+	 * @param X The x coordinate of the tile.
+	 * @param Y The y coordinate of the tile.
+	 * @param Previous The tile before automapping.
+	 * @param Current The tile after automapping.
+	 */
+	typedef std::function<void(int X, int Y, const CTile &Previous, const CTile &Current)> FTileChanged;
+
+	/**
+	 * Parses rules from a file, replacing the current configurations.
+	 *
+	 * @param File The file to read from, will be closed.
+	 * @param pPath The path of the file, used for logging.
+	 *
+	 * @return `true` on success, `false` if the file could not be read.
+	 */
+	bool Load(IOHANDLE File, const char *pPath);
+	void Unload();
+	int CheckIndexFlag(int Flag, const char *pFlag, bool CheckNone) const;
+
+	int ConfigNamesNum() const { return m_vConfigs.size(); }
+	const char *GetConfigName(int Index) const;
+	const CConfiguration *Config(int Index) const;
+
+	/**
+	 * Automaps a tile layer.
+	 *
+	 * The random rules are decided by hashing the seed with the position of every tile,
+	 * so the result does not depend on the order in which the tiles are processed.
+	 * If an engine is given, large layers are split into rows which are processed by
+	 * the job pool, the result is identical to the serial one.
+	 *
+	 * @param pTiles The tiles to automap in place.
+	 * @param Width The width of the layer.
+	 * @param Height The height of the layer.
+	 * @param pGameTiles The tiles of the game layer, only read if `ReferenceId` is not negative.
+	 * @param GameWidth The width of the game layer.
+	 * @param GameHeight The height of the game layer.
+	 * @param ReferenceId The game tile to use as reference, `0` for all and `-1` for the layer itself.
+	 * @param ConfigId The configuration to apply.
+	 * @param Seed The seed of the random rules, `0` picks a random seed.
+	 * @param SeedOffsetX Added to the x coordinate for random and modulo rules.
+	 * @param SeedOffsetY Added to the y coordinate for random and modulo rules.
+	 * @param TileChanged Called once for every changed tile, may be empty.
+	 * @param pEngine The engine whose job pool is used, may be `nullptr`.
+	 */
+	void Proceed(CTile *pTiles, int Width, int Height, const CTile *pGameTiles, int GameWidth, int GameHeight, int ReferenceId, int ConfigId, int Seed, int SeedOffsetX, int SeedOffsetY, const FTileChanged &TileChanged, IEngine *pEngine) const;
+
+private:
+	std::vector<CConfiguration> m_vConfigs;
+};
+
+#endif
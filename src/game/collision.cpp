@@ -146,6 +146,10 @@ void CCollision::Init(class CLayers *pLayers)
 			}
 		}
 	}
+
+	m_vTileFlags.resize((size_t)m_Width * m_Height);
+	for(int i = 0; i < m_Width * m_Height; i++)
+		UpdateTileFlags(i);
 }
 
 void CCollision::Unload()
@@ -169,6 +173,7 @@ void CCollision::Unload()
 	m_pTune = nullptr;
 	delete[] m_pDoor;
 	m_pDoor = nullptr;
+	m_vTileFlags.clear();
 }
 
 void CCollision::FillAntibot(CAntibotMapData *pMapData) const
@@ -318,11 +323,7 @@ int CCollision::GetTile(int x, int y) const
 
 	int Nx = std::clamp(x / 32, 0, m_Width - 1);
 	int Ny = std::clamp(y / 32, 0, m_Height - 1);
-	const int Index = Ny * m_Width + Nx;
-
-	if(m_pTiles[Index].m_Index >= TILE_SOLID && m_pTiles[Index].m_Index <= TILE_NOLASER)
-		return m_pTiles[Index].m_Index;
-	return 0;
+	return m_vTileFlags[Ny * m_Width + Nx] & TILEFLAG_COLLISION_MASK;
 }
 
 // TODO: rewrite this smarter!
@@ -597,8 +598,12 @@ void CCollision::MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, vec2 Elast
 
 int CCollision::IsSolid(int x, int y) const
 {
-	const int Index = GetTile(x, y);
-	return Index == TILE_SOLID || Index == TILE_NOHOOK;
+	if(!m_pTiles)
+		return 0;
+
+	int Nx = std::clamp(x / 32, 0, m_Width - 1);
+	int Ny = std::clamp(y / 32, 0, m_Height - 1);
+	return (m_vTileFlags[Ny * m_Width + Nx] & TILEFLAG_SOLID) != 0;
 }
 
 bool CCollision::IsThrough(int x, int y, int OffsetX, int OffsetY, vec2 Pos0, vec2 Pos1) const
@@ -839,7 +844,18 @@ bool CCollision::TileExists(int Index) const
 {
 	if(Index < 0)
 		return false;
+	return m_vTileFlags[Index] & (TILEFLAG_SPECIAL | TILEFLAG_NEXT_TO_STOPPER);
+}
 
+bool CCollision::TileExistsNext(int Index) const
+{
+	if(Index < 0)
+		return false;
+	return m_vTileFlags[Index] & TILEFLAG_NEXT_TO_STOPPER;
+}
+
+bool CCollision::ComputeTileExists(int Index) const
+{
 	if((m_pTiles[Index].m_Index >= TILE_FREEZE && m_pTiles[Index].m_Index <= TILE_TELE_LASER_DISABLE) || (m_pTiles[Index].m_Index >= TILE_LFREEZE && m_pTiles[Index].m_Index <= TILE_LUNFREEZE))
 		return true;
 	if(m_pFront && ((m_pFront[Index].m_Index >= TILE_FREEZE && m_pFront[Index].m_Index <= TILE_TELE_LASER_DISABLE) || (m_pFront[Index].m_Index >= TILE_LFREEZE && m_pFront[Index].m_Index <= TILE_LUNFREEZE)))
@@ -854,13 +870,11 @@ bool CCollision::TileExists(int Index) const
 		return true;
 	if(m_pTune && m_pTune[Index].m_Type)
 		return true;
-	return TileExistsNext(Index);
+	return false;
 }
 
-bool CCollision::TileExistsNext(int Index) const
+bool CCollision::ComputeTileExistsNext(int Index) const
 {
-	if(Index < 0)
-		return false;
 	int TileOnTheLeft = (Index - 1 > 0) ? Index - 1 : Index;
 	int TileOnTheRight = (Index + 1 < m_Width * m_Height) ? Index + 1 : Index;
 	int TileBelow = (Index + m_Width < m_Width * m_Height) ? Index + m_Width : Index;
@@ -899,6 +913,31 @@ bool CCollision::TileExistsNext(int Index) const
 	return false;
 }
 
+void CCollision::UpdateTileFlags(int Index)
+{
+	uint8_t Flags = 0;
+	const int Tile = m_pTiles[Index].m_Index;
+	if(Tile >= TILE_SOLID && Tile <= TILE_NOLASER)
+		Flags |= Tile;
+	if(Tile == TILE_SOLID || Tile == TILE_NOHOOK)
+		Flags |= TILEFLAG_SOLID;
+	if(ComputeTileExists(Index))
+		Flags |= TILEFLAG_SPECIAL;
+	if(ComputeTileExistsNext(Index))
+		Flags |= TILEFLAG_NEXT_TO_STOPPER;
+	m_vTileFlags[Index] = Flags;
+}
+
+void CCollision::UpdateTileFlagsAround(int Index)
+{
+	const int Size = m_Width * m_Height;
+	for(int Neighbour : {Index, Index - 1, Index + 1, Index - m_Width, Index + m_Width})
+	{
+		if(Neighbour >= 0 && Neighbour < Size)
+			UpdateTileFlags(Neighbour);
+	}
+}
+
 int CCollision::GetMapIndex(vec2 Pos) const
 {
 	int Nx = std::clamp((int)Pos.x / 32, 0, m_Width - 1);
@@ -914,43 +953,13 @@ int CCollision::GetMapIndex(vec2 Pos) const
 std::vector<int> CCollision::GetMapIndices(vec2 PrevPos, vec2 Pos, unsigned MaxIndices) const
 {
 	std::vector<int> vIndices;
-	float d = distance(PrevPos, Pos);
-	int End(d + 1);
-	if(!d)
-	{
-		int Nx = std::clamp((int)Pos.x / 32, 0, m_Width - 1);
-		int Ny = std::clamp((int)Pos.y / 32, 0, m_Height - 1);
-		int Index = Ny * m_Width + Nx;
-
-		if(TileExists(Index))
-		{
+	ForEachMapIndex(
+		PrevPos, Pos, [&](int Index) {
 			vIndices.push_back(Index);
-			return vIndices;
-		}
-		else
-			return vIndices;
-	}
-	else
-	{
-		int LastIndex = 0;
-		for(int i = 0; i < End; i++)
-		{
-			float a = i / d;
-			vec2 Tmp = mix(PrevPos, Pos, a);
-			int Nx = std::clamp((int)Tmp.x / 32, 0, m_Width - 1);
-			int Ny = std::clamp((int)Tmp.y / 32, 0, m_Height - 1);
-			int Index = Ny * m_Width + Nx;
-			if(TileExists(Index) && LastIndex != Index)
-			{
-				if(MaxIndices && vIndices.size() > MaxIndices)
-					return vIndices;
-				vIndices.push_back(Index);
-				LastIndex = Index;
-			}
-		}
-
-		return vIndices;
-	}
+			return true;
+		},
+		MaxIndices);
+	return vIndices;
 }
 
 vec2 CCollision::GetPos(int Index) const
@@ -1079,6 +1088,7 @@ void CCollision::SetCollisionAt(float x, float y, int Index)
 	int Ny = std::clamp(round_to_int(y) / 32, 0, m_Height - 1);
 
 	m_pTiles[Ny * m_Width + Nx].m_Index = Index;
+	UpdateTileFlagsAround(Ny * m_Width + Nx);
 }
 
 void CCollision::SetDoorCollisionAt(float x, float y, int Type, int Flags, int Number)
@@ -1091,6 +1101,7 @@ void CCollision::SetDoorCollisionAt(float x, float y, int Type, int Flags, int N
 	m_pDoor[Ny * m_Width + Nx].m_Index = Type;
 	m_pDoor[Ny * m_Width + Nx].m_Flags = Flags;
 	m_pDoor[Ny * m_Width + Nx].m_Number = Number;
+	UpdateTileFlagsAround(Ny * m_Width + Nx);
 }
 
 void CCollision::GetDoorTile(int Index, CDoorTile *pDoorTile) const
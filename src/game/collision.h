@@ -7,6 +7,8 @@
 
 #include <engine/shared/protocol.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -77,6 +79,18 @@ public:
 	int GetPureMapIndex(float x, float y) const;
 	int GetPureMapIndex(vec2 Pos) const { return GetPureMapIndex(Pos.x, Pos.y); }
 	std::vector<int> GetMapIndices(vec2 PrevPos, vec2 Pos, unsigned MaxIndices = 0) const;
+	/**
+	 * Walks the way from PrevPos to Pos and calls Visit(Index) for every tile
+	 * that exists, in the same order as GetMapIndices and without allocating.
+	 * A tile is not visited twice in a row.
+	 *
+	 * @param Visit returns false to stop the walk early
+	 * @param MaxIndices stops after more than this many tiles, 0 for no limit
+	 *
+	 * @return The number of visited tiles
+	 */
+	template<typename FVisit>
+	unsigned ForEachMapIndex(vec2 PrevPos, vec2 Pos, FVisit &&Visit, unsigned MaxIndices = 0) const;
 	int GetMapIndex(vec2 Pos) const;
 	bool TileExists(int Index) const;
 	bool TileExistsNext(int Index) const;
@@ -145,6 +159,23 @@ public:
 	const std::vector<vec2> &TeleOthers(int Number) { return m_TeleOthers[Number]; }
 
 private:
+	enum
+	{
+		// TILE_SOLID to TILE_NOLASER of the game layer, 0 otherwise
+		TILEFLAG_COLLISION_MASK = 0x7,
+		TILEFLAG_SOLID = 1 << 3,
+		// the tile itself is special in one of the game, front, tele, speedup, door, switch or tune layers
+		TILEFLAG_SPECIAL = 1 << 4,
+		// a stopper in a neighbouring tile affects this tile
+		TILEFLAG_NEXT_TO_STOPPER = 1 << 5,
+	};
+
+	bool ComputeTileExists(int Index) const;
+	bool ComputeTileExistsNext(int Index) const;
+	void UpdateTileFlags(int Index);
+	// updates the tile and the neighbours whose stopper flag depends on it
+	void UpdateTileFlagsAround(int Index);
+
 	CLayers *m_pLayers;
 
 	int m_Width;
@@ -158,6 +189,10 @@ private:
 	CTuneTile *m_pTune;
 	CDoorTile *m_pDoor;
 
+	// one byte per tile so that the hot predicates only need a single load,
+	// must be updated whenever the game or door layer changes
+	std::vector<uint8_t> m_vTileFlags;
+
 	// TILE_TELEIN
 	std::map<int, std::vector<vec2>> m_TeleIns;
 	// TILE_TELEOUT
@@ -168,5 +203,48 @@ private:
 	std::map<int, std::vector<vec2>> m_TeleOthers;
 };
 
+template<typename FVisit>
+unsigned CCollision::ForEachMapIndex(vec2 PrevPos, vec2 Pos, FVisit &&Visit, unsigned MaxIndices) const
+{
+	float d = distance(PrevPos, Pos);
+	if(!d)
+	{
+		int Nx = std::clamp((int)Pos.x / 32, 0, m_Width - 1);
+		int Ny = std::clamp((int)Pos.y / 32, 0, m_Height - 1);
+		int Index = Ny * m_Width + Nx;
+		if(!TileExists(Index))
+			return 0;
+		Visit(Index);
+		return 1;
+	}
+
+	unsigned Count = 0;
+	int LastIndex = 0;
+	int LastSampled = -1;
+	int End(d + 1);
+	for(int i = 0; i < End; i++)
+	{
+		float a = i / d;
+		vec2 Tmp = mix(PrevPos, Pos, a);
+		int Nx = std::clamp((int)Tmp.x / 32, 0, m_Width - 1);
+		int Ny = std::clamp((int)Tmp.y / 32, 0, m_Height - 1);
+		int Index = Ny * m_Width + Nx;
+		// the path is sampled every pixel, most samples hit the same tile again
+		if(Index == LastSampled)
+			continue;
+		LastSampled = Index;
+		if(TileExists(Index) && LastIndex != Index)
+		{
+			if(MaxIndices && Count > MaxIndices)
+				return Count;
+			Count++;
+			LastIndex = Index;
+			if(!Visit(Index))
+				return Count;
+		}
+	}
+	return Count;
+}
+
 void ThroughOffset(vec2 Pos0, vec2 Pos1, int *pOffsetX, int *pOffsetY);
 #endif
@@ -56,9 +56,10 @@ CEditorBrushDrawAction::CEditorBrushDrawAction(CEditorMap *pMap, int Group) :
 				}
 			}
 
-			if(!pLayerTiles->m_TilesHistory.empty())
+			if(!pLayerTiles->m_TilesHistory.Empty())
 			{
-				m_vTileChanges.emplace_back(k, std::map(pLayerTiles->m_TilesHistory));
+				pLayerTiles->m_TilesHistory.Compress();
+				m_vTileChanges.emplace_back(k, std::move(pLayerTiles->m_TilesHistory));
 				pLayerTiles->ClearHistory();
 			}
 		}
@@ -82,12 +83,7 @@ void CEditorBrushDrawAction::SetInfos()
 
 		if(pLayer->m_Type == LAYERTYPE_TILES)
 		{
-			std::shared_ptr<CLayerTiles> pLayerTiles = std::static_pointer_cast<CLayerTiles>(pLayer);
-			auto Changes = Pair.second;
-			for(auto &Change : Changes)
-			{
-				m_TotalTilesDrawn += Change.second.size();
-			}
+			m_TotalTilesDrawn += Pair.second.NumChanges();
 		}
 	}
 
@@ -147,18 +143,7 @@ void CEditorBrushDrawAction::Apply(bool Undo)
 		if(pLayer->m_Type == LAYERTYPE_TILES)
 		{
 			std::shared_ptr<CLayerTiles> pLayerTiles = std::static_pointer_cast<CLayerTiles>(pLayer);
-			auto Changes = Pair.second;
-			for(auto &Change : Changes)
-			{
-				int y = Change.first;
-				auto Line = Change.second;
-				for(auto &Tile : Line)
-				{
-					int x = Tile.first;
-					STileStateChange State = Tile.second;
-					pLayerTiles->SetTileIgnoreHistory(x, y, Undo ? State.m_Previous : State.m_Current);
-				}
-			}
+			Pair.second.Apply(pLayerTiles->m_pTiles, pLayerTiles->m_Width, pLayerTiles->m_Height, Undo);
 		}
 	}
 
@@ -515,11 +500,11 @@ void CEditorActionBulk::Redo()
 
 // ---------
 
-CEditorActionTileChanges::CEditorActionTileChanges(CEditorMap *pMap, int GroupIndex, int LayerIndex, const char *pAction, const EditorTileStateChangeHistory<STileStateChange> &Changes) :
-	CEditorActionLayerBase(pMap, GroupIndex, LayerIndex), m_Changes(Changes)
+CEditorActionTileChanges::CEditorActionTileChanges(CEditorMap *pMap, int GroupIndex, int LayerIndex, const char *pAction, CTileChanges &&Changes) :
+	CEditorActionLayerBase(pMap, GroupIndex, LayerIndex), m_Changes(std::move(Changes))
 {
-	ComputeInfos();
-	str_format(m_aDisplayText, sizeof(m_aDisplayText), "%s (x%d)", pAction, m_TotalChanges);
+	m_Changes.Compress();
+	str_format(m_aDisplayText, sizeof(m_aDisplayText), "%s (x%d)", pAction, m_Changes.NumChanges());
 }
 
 void CEditorActionTileChanges::Undo()
@@ -535,28 +520,11 @@ void CEditorActionTileChanges::Redo()
 void CEditorActionTileChanges::Apply(bool Undo)
 {
 	std::shared_ptr<CLayerTiles> pLayerTiles = std::static_pointer_cast<CLayerTiles>(m_pLayer);
-	for(auto &Change : m_Changes)
-	{
-		int y = Change.first;
-		auto Line = Change.second;
-		for(auto &Tile : Line)
-		{
-			int x = Tile.first;
-			STileStateChange State = Tile.second;
-			pLayerTiles->SetTileIgnoreHistory(x, y, Undo ? State.m_Previous : State.m_Current);
-		}
-	}
+	m_Changes.Apply(pLayerTiles->m_pTiles, pLayerTiles->m_Width, pLayerTiles->m_Height, Undo);
 
 	Map()->OnModify();
 }
 
-void CEditorActionTileChanges::ComputeInfos()
-{
-	m_TotalChanges = 0;
-	for(auto &Line : m_Changes)
-		m_TotalChanges += Line.second.size();
-}
-
 // ---------
 
 CEditorActionLayerBase::CEditorActionLayerBase(CEditorMap *pMap, int GroupIndex, int LayerIndex) :
@@ -42,9 +42,9 @@ public:
 private:
 	int m_Group;
 	// m_vTileChanges is a list of changes for each layer that was modified.
-	// The std::pair is used to pair one layer (index) with its history (2D map).
+	// The std::pair is used to pair one layer (index) with its compressed history.
 	// EditorTileStateChangeHistory<T> is a 2D map, storing a change item at a specific y,x position.
-	std::vector<std::pair<int, EditorTileStateChangeHistory<STileStateChange>>> m_vTileChanges;
+	std::vector<std::pair<int, CTileChanges>> m_vTileChanges;
 	EditorTileStateChangeHistory<STeleTileStateChange> m_TeleTileChanges;
 	EditorTileStateChangeHistory<SSpeedupTileStateChange> m_SpeedupTileChanges;
 	EditorTileStateChangeHistory<SSwitchTileStateChange> m_SwitchTileChanges;
@@ -188,16 +188,14 @@ private:
 class CEditorActionTileChanges : public CEditorActionLayerBase
 {
 public:
-	CEditorActionTileChanges(CEditorMap *pMap, int GroupIndex, int LayerIndex, const char *pAction, const EditorTileStateChangeHistory<STileStateChange> &Changes);
+	CEditorActionTileChanges(CEditorMap *pMap, int GroupIndex, int LayerIndex, const char *pAction, CTileChanges &&Changes);
 
 	void Undo() override;
 	void Redo() override;
 
 private:
-	EditorTileStateChangeHistory<STileStateChange> m_Changes;
-	int m_TotalChanges;
+	CTileChanges m_Changes;
 
-	void ComputeInfos();
 	void Apply(bool Undo);
 };
 
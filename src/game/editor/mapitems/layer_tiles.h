@@ -5,16 +5,10 @@
 
 #include <game/editor/editor_trackers.h>
 #include <game/editor/enums.h>
+#include <game/tile_changes.h>
 
 #include <map>
 
-struct STileStateChange
-{
-	bool m_Changed;
-	CTile m_Previous;
-	CTile m_Current;
-};
-
 template<typename T>
 using EditorTileStateChangeHistory = std::map<int, std::map<int, T>>;
 
@@ -197,8 +191,8 @@ public:
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	bool m_KnownTextModeLayer = false;
 
-	EditorTileStateChangeHistory<STileStateChange> m_TilesHistory;
-	virtual void ClearHistory() { m_TilesHistory.clear(); }
+	CTileChanges m_TilesHistory;
+	virtual void ClearHistory() { m_TilesHistory.Clear(); }
 
 	static bool HasAutomapEffect(ETilesProp Prop);
 
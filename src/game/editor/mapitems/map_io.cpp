@@ -98,8 +98,7 @@ bool CEditorMap::Save(const char *pFilename, const FErrorHandler &ErrorHandler)
 				mem_copy(pNext, Setting.m_aCommand, Length);
 				pNext += Length;
 			}
-			Item.m_Settings = Writer.AddData(Size, pSettings);
-			free(pSettings);
+			Item.m_Settings = Writer.AddDataOwned(Size, pSettings);
 		}
 
 		Writer.AddItem(MAPITEMTYPE_INFO, 0, sizeof(Item), &Item);
@@ -223,9 +222,7 @@ bool CEditorMap::Save(const char *pFilename, const FErrorHandler &ErrorHandler)
 				if(Item.m_Flags && !(pLayerTiles->m_HasGame))
 				{
 					CTile *pEmptyTiles = (CTile *)calloc((size_t)pLayerTiles->m_Width * pLayerTiles->m_Height, sizeof(CTile));
-					mem_zero(pEmptyTiles, (size_t)pLayerTiles->m_Width * pLayerTiles->m_Height * sizeof(CTile));
-					Item.m_Data = Writer.AddData((size_t)pLayerTiles->m_Width * pLayerTiles->m_Height * sizeof(CTile), pEmptyTiles);
-					free(pEmptyTiles);
+					Item.m_Data = Writer.AddDataOwned((size_t)pLayerTiles->m_Width * pLayerTiles->m_Height * sizeof(CTile), pEmptyTiles);
 
 					if(pLayerTiles->m_HasTele)
 						Item.m_Tele = Writer.AddData((size_t)pLayerTiles->m_Width * pLayerTiles->m_Height * sizeof(CTeleTile), std::static_pointer_cast<CLayerTele>(pLayerTiles)->m_pTeleTile);
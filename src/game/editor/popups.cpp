@@ -546,7 +546,7 @@ CUi::EPopupMenuFunctionResult CEditor::PopupGroup(void *pContext, CUIRect View,
 				}
 			}
 
-			if(!pGameLayer->m_TilesHistory.empty())
+			if(!pGameLayer->m_TilesHistory.Empty())
 			{
 				if(GameLayerIndex == -1)
 				{
@@ -555,7 +555,7 @@ CUi::EPopupMenuFunctionResult CEditor::PopupGroup(void *pContext, CUIRect View,
 				else
 				{
 					// record undo
-					pEditor->Map()->m_EditorHistory.RecordAction(std::make_shared<CEditorActionTileChanges>(pEditor->Map(), pEditor->Map()->m_SelectedGroup, GameLayerIndex, "Clean up game tiles", pGameLayer->m_TilesHistory));
+					pEditor->Map()->m_EditorHistory.RecordAction(std::make_shared<CEditorActionTileChanges>(pEditor->Map(), pEditor->Map()->m_SelectedGroup, GameLayerIndex, "Clean up game tiles", std::move(pGameLayer->m_TilesHistory)));
 				}
 				pGameLayer->ClearHistory();
 			}
@@ -17,6 +17,11 @@ public:
 	// to be the same for the same seed.
 	void Seed(uint64_t aSeed[2]);
 
+	// Seeds the random number generator from a string previously returned
+	// by `Description()`. Returns false if the description is not of a
+	// seeded generator of this kind.
+	bool SeedFromDescription(const char *pDescription);
+
 	// Generates 32 random bits. `Seed()` must be called before calling
 	// this function.
 	unsigned int RandomBits();
@@ -24,6 +24,7 @@
 #include <engine/shared/json.h>
 #include <engine/shared/linereader.h>
 #include <engine/shared/memheap.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/protocolglue.h>
 #include <engine/storage.h>
@@ -129,6 +130,7 @@ CGameContext::CGameContext(bool Resetting) :
 
 	m_aDeleteTempfile[0] = 0;
 	m_TeeHistorianActive = false;
+	m_ProfileTeehistorian = -1;
 }
 
 CGameContext::~CGameContext()
@@ -856,6 +858,35 @@ void CGameContext::SendSkinChange7(int ClientId)
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, -1);
 }
 
+bool CGameContext::ParseMapChangeCommand(const char *pCommand, char *pMap, int MapSize)
+{
+	const char *pArgument = str_startswith(pCommand, "change_map ");
+	if(!pArgument)
+		pArgument = str_startswith(pCommand, "sv_map ");
+	if(!pArgument)
+		return false;
+
+	pArgument = str_skip_whitespaces_const(pArgument);
+	const char *pEnd;
+	if(*pArgument == '"')
+	{
+		pArgument++;
+		pEnd = str_find(pArgument, "\"");
+		if(!pEnd)
+			return false;
+	}
+	else
+	{
+		pEnd = pArgument;
+		while(*pEnd && *pEnd != ';' && *pEnd != ' ')
+			pEnd++;
+	}
+	if(pEnd == pArgument)
+		return false;
+	str_truncate(pMap, MapSize, pArgument, pEnd - pArgument);
+	return true;
+}
+
 void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char *pReason, const char *pSixupDesc)
 {
 	// reset votes
@@ -877,6 +908,11 @@ void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char
 	str_copy(m_aVoteReason, pReason, sizeof(m_aVoteReason));
 	SendVoteSet(-1);
 	m_VoteUpdate = true;
+
+	// load the map in the background already in case the vote passes
+	char aMap[IO_MAX_PATH_LENGTH];
+	if(ParseMapChangeCommand(pCommand, aMap, sizeof(aMap)))
+		Server()->PreloadMap(aMap);
 }
 
 void CGameContext::EndVote()
@@ -1095,12 +1131,14 @@ void CGameContext::OnTick()
 
 	if(m_TeeHistorianActive)
 	{
+		CProfiler::CScope Scope(Server()->Profiler(), m_ProfileTeehistorian);
 		int Error = aio_error(m_pTeeHistorianFile);
 		if(Error)
 		{
 			dbg_msg("teehistorian", "error writing to file, err=%d", Error);
 			Server()->SetErrorShutdown("teehistorian io error");
 		}
+		m_pMetricTeehistorianQueued->Set(aio_queued(m_pTeeHistorianFile));
 
 		if(!m_TeeHistorian.Starting())
 		{
@@ -1390,6 +1428,7 @@ void CGameContext::OnTick()
 	// Record player position at the end of the tick
 	if(m_TeeHistorianActive)
 	{
+		CProfiler::CScope Scope(Server()->Profiler(), m_ProfileTeehistorian);
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
 			if(m_apPlayers[i] && m_apPlayers[i]->GetCharacter())
@@ -4120,6 +4159,8 @@ void CGameContext::OnInit(const void *pPersistentData)
 	m_pAntibot = Kernel()->RequestInterface<IAntibot>();
 	m_World.SetGameServer(this);
 	m_Events.SetGameServer(this);
+	m_ProfileTeehistorian = Server()->Profiler()->AddSection("teehistorian");
+	m_pMetricTeehistorianQueued = Server()->Metrics()->Gauge("ddnet_teehistorian_queued_bytes", "Teehistorian data waiting to be written to the file");
 
 	m_GameUuid = RandomUuid();
 	Console()->SetTeeHistorianCommandCallback(CommandCallback, this);
@@ -4518,13 +4559,12 @@ bool CGameContext::OnMapChange(char *pNewMapName, int MapNameSize)
 	{
 		if(i == SettingsIndex)
 		{
-			Writer.AddData(TotalLength, pSettings);
+			Writer.AddDataOwned(TotalLength, pSettings);
+			pSettings = nullptr;
 			continue;
 		}
-		const void *pData = Reader.GetData(i);
 		int Size = Reader.GetDataSize(i);
-		Writer.AddData(Size, pData);
-		Reader.UnloadData(i);
+		Writer.AddDataOwned(Size, Reader.ReleaseData(i));
 	}
 
 	free(pSettings);
@@ -4567,6 +4607,7 @@ void CGameContext::OnShutdown(void *pPersistentData)
 			Server()->SetErrorShutdown("teehistorian close error");
 		}
 		aio_free(m_pTeeHistorianFile);
+		m_pMetricTeehistorianQueued->Set(0);
 	}
 
 	// Stop any demos being recorded.
@@ -9,6 +9,7 @@
 
 #include <engine/console.h>
 #include <engine/server.h>
+#include <engine/shared/metrics.h>
 
 #include <generated/protocol.h>
 
@@ -124,6 +125,8 @@ class CGameContext : public IGameServer
 	bool m_TeeHistorianActive;
 	CTeeHistorian m_TeeHistorian;
 	ASYNCIO *m_pTeeHistorianFile;
+	int m_ProfileTeehistorian;
+	CMetrics::CGauge *m_pMetricTeehistorianQueued;
 	CUuid m_GameUuid;
 	CMapBugs m_MapBugs;
 	CPrng m_Prng;
@@ -200,6 +203,7 @@ public:
 	IAntibot *Antibot() { return m_pAntibot; }
 	CTeeHistorian *TeeHistorian() { return &m_TeeHistorian; }
 	bool TeeHistorianActive() const { return m_TeeHistorianActive; }
+	CPrng *Prng() { return &m_Prng; }
 	CNetObjHandler *GetNetObjHandler() override { return &m_NetObjHandler; }
 	protocol7::CNetObjHandler *GetNetObjHandler7() override { return &m_NetObjHandler7; }
 
@@ -232,6 +236,8 @@ public:
 
 	// voting
 	void StartVote(const char *pDesc, const char *pCommand, const char *pReason, const char *pSixupDesc);
+	// extracts the map from `change_map` and `sv_map` commands
+	static bool ParseMapChangeCommand(const char *pCommand, char *pMap, int MapSize);
 	void EndVote();
 	void SendVoteSet(int ClientId);
 	void SendVoteStatus(int ClientId, int Total, int Yes, int No);
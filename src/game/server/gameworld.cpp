@@ -7,8 +7,10 @@
 #include "entity.h"
 #include "gamecontext.h"
 #include "gamecontroller.h"
+#include "player.h"
 
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 
 #include <game/collision.h>
 
@@ -23,6 +25,7 @@ CGameWorld::CGameWorld()
 	m_pGameServer = nullptr;
 	m_pConfig = nullptr;
 	m_pServer = nullptr;
+	m_pProfiler = nullptr;
 
 	m_Paused = false;
 	m_ResetRequested = false;
@@ -43,6 +46,18 @@ void CGameWorld::SetGameServer(CGameContext *pGameServer)
 	m_pGameServer = pGameServer;
 	m_pConfig = m_pGameServer->Config();
 	m_pServer = m_pGameServer->Server();
+
+	static const char *const s_apEntTypeNames[NUM_ENTTYPES] = {"projectile", "laser", "pickup", "flag", "character"};
+	m_pProfiler = m_pServer->Profiler();
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+	{
+		char aName[64];
+		str_format(aName, sizeof(aName), "world_tick_%s", s_apEntTypeNames[i]);
+		m_aProfileTick[i] = m_pProfiler->AddSection(aName);
+		str_format(aName, sizeof(aName), "world_snap_%s", s_apEntTypeNames[i]);
+		m_aProfileSnap[i] = m_pProfiler->AddSection(aName);
+	}
+	m_ProfileTickDeferred = m_pProfiler->AddSection("world_tick_deferred");
 }
 
 void CGameWorld::Init(CCollision *pCollision, CTuningParams *pTuningList)
@@ -115,13 +130,48 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 }
 
 //
+int CGameWorld::SnapPriority(CEntity *pEnt, int SnappingClient)
+{
+	// the own character is never left out of the snapshot
+	if(pEnt->m_ObjType == ENTTYPE_CHARACTER && static_cast<CCharacter *>(pEnt)->GetPlayer()->GetCid() == SnappingClient)
+		return IServer::SNAP_PRIORITY_REQUIRED;
+
+	// characters and flags come before the other entities, then closer
+	// entities before ones further away, one priority per tile
+	const int Base = pEnt->m_ObjType == ENTTYPE_CHARACTER || pEnt->m_ObjType == ENTTYPE_FLAG ? 2 * SNAP_PRIORITY_RANGE : SNAP_PRIORITY_RANGE;
+	if(SnappingClient == SERVER_DEMO_CLIENT || !GameServer()->m_apPlayers[SnappingClient])
+		return Base;
+	const float Tiles = distance(GameServer()->m_apPlayers[SnappingClient]->m_ViewPos, pEnt->GetPos()) / 32.0f;
+	return Base - (int)std::clamp(Tiles, 0.0f, (float)(SNAP_PRIORITY_RANGE - 1));
+}
+
+int CGameWorld::SnapUpdatePeriod(CEntity *pEnt, int SnappingClient)
+{
+	if(Config()->m_SvSnapEdgePeriod <= 1 || SnappingClient == SERVER_DEMO_CLIENT || !GameServer()->m_apPlayers[SnappingClient])
+		return 1;
+
+	// entities at the edge of the view are updated less often, entities that
+	// don't change aren't sent anyway
+	const CPlayer *pPlayer = GameServer()->m_apPlayers[SnappingClient];
+	const vec2 Edge = pPlayer->m_ShowDistance * (Config()->m_SvSnapEdgeDistance / 100.0f);
+	const vec2 Distance = pPlayer->m_ViewPos - pEnt->GetPos();
+	if(absolute(Distance.x) > Edge.x || absolute(Distance.y) > Edge.y)
+		return Config()->m_SvSnapEdgePeriod;
+	return 1;
+}
+
 void CGameWorld::Snap(int SnappingClient)
 {
-	for(CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER]; pEnt;)
 	{
-		m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-		pEnt->Snap(SnappingClient);
-		pEnt = m_pNextTraverseEntity;
+		CProfiler::CScope Scope(m_pProfiler, m_aProfileSnap[ENTTYPE_CHARACTER]);
+		for(CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER]; pEnt;)
+		{
+			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+			Server()->SnapSetPriority(SnapPriority(pEnt, SnappingClient));
+			Server()->SnapSetUpdatePeriod(SnapUpdatePeriod(pEnt, SnappingClient));
+			pEnt->Snap(SnappingClient);
+			pEnt = m_pNextTraverseEntity;
+		}
 	}
 
 	for(int i = 0; i < NUM_ENTTYPES; i++)
@@ -129,13 +179,19 @@ void CGameWorld::Snap(int SnappingClient)
 		if(i == ENTTYPE_CHARACTER)
 			continue;
 
+		CProfiler::CScope Scope(m_pProfiler, m_aProfileSnap[i]);
 		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+			Server()->SnapSetPriority(SnapPriority(pEnt, SnappingClient));
+			Server()->SnapSetUpdatePeriod(SnapUpdatePeriod(pEnt, SnappingClient));
 			pEnt->Snap(SnappingClient);
 			pEnt = m_pNextTraverseEntity;
 		}
 	}
+
+	Server()->SnapSetPriority(IServer::SNAP_PRIORITY_REQUIRED);
+	Server()->SnapSetUpdatePeriod(1);
 }
 
 void CGameWorld::Reset()
@@ -210,6 +266,8 @@ void CGameWorld::Tick()
 		// update all objects
 		for(int i = 0; i < NUM_ENTTYPES; i++)
 		{
+			CProfiler::CScope Scope(m_pProfiler, m_aProfileTick[i]);
+
 			// It's important to call PreTick() and Tick() after each other.
 			// If we call PreTick() before, and Tick() after other entities have been processed, it causes physics changes such as a stronger shotgun or grenade.
 			if(g_Config.m_SvNoWeakHook && i == ENTTYPE_CHARACTER)
@@ -232,6 +290,7 @@ void CGameWorld::Tick()
 			}
 		}
 
+		CProfiler::CScope Scope(m_pProfiler, m_ProfileTickDeferred);
 		for(auto *pEnt : m_apFirstEntityTypes)
 			for(; pEnt;)
 			{
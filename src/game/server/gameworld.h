@@ -43,6 +43,20 @@ private:
 	class IServer *m_pServer;
 	CTuningParams *m_pTuningList;
 
+	class CProfiler *m_pProfiler;
+	int m_aProfileTick[NUM_ENTTYPES];
+	int m_ProfileTickDeferred;
+	int m_aProfileSnap[NUM_ENTTYPES];
+
+	enum
+	{
+		// range of the snapshot priorities of one kind of entity, lowered by
+		// the distance in tiles
+		SNAP_PRIORITY_RANGE = 1024,
+	};
+	int SnapPriority(CEntity *pEnt, int SnappingClient);
+	int SnapUpdatePeriod(CEntity *pEnt, int SnappingClient);
+
 public:
 	class CGameContext *GameServer() { return m_pGameServer; }
 	class CConfig *Config() { return m_pConfig; }
@@ -150,7 +164,10 @@ public:
 	/*
 		Function: Snap
 			Calls Snap on all the entities in the world to create
-			the snapshot.
+			the snapshot. Entities far away from the view of the
+			snapping client are left out first if the snapshot is
+			too large, and entities at the edge of the view are
+			updated less often, see sv_snap_edge_period.
 
 		Arguments:
 			SnappingClient - ID of the client which snapshot
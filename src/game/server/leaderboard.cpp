@@ -0,0 +1,74 @@
+#include "leaderboard.h"
+
+#include <base/system.h>
+
+#include <algorithm>
+
+void CLeaderboard::Clear()
+{
+	m_vEntries.clear();
+	m_BestTimes.clear();
+}
+
+bool CLeaderboard::Less(const CEntry &Left, const CEntry &Right)
+{
+	if(Left.m_Time != Right.m_Time)
+		return Left.m_Time < Right.m_Time;
+	return str_comp(Left.m_aName, Right.m_aName) < 0;
+}
+
+void CLeaderboard::Insert(const char *pName, float Time)
+{
+	CEntry Entry;
+	Entry.m_Time = RoundTime(Time);
+	str_copy(Entry.m_aName, pName);
+
+	auto [It, Inserted] = m_BestTimes.emplace(Entry.m_aName, Entry.m_Time);
+	if(!Inserted)
+	{
+		if(It->second <= Entry.m_Time)
+			return;
+		CEntry Old;
+		Old.m_Time = It->second;
+		str_copy(Old.m_aName, Entry.m_aName);
+		auto OldIt = std::lower_bound(m_vEntries.begin(), m_vEntries.end(), Old, Less);
+		dbg_assert(OldIt != m_vEntries.end() && str_comp(OldIt->m_aName, Old.m_aName) == 0, "leaderboard out of sync");
+		m_vEntries.erase(OldIt);
+		It->second = Entry.m_Time;
+	}
+	m_vEntries.insert(std::upper_bound(m_vEntries.begin(), m_vEntries.end(), Entry, Less), Entry);
+}
+
+int CLeaderboard::Rank(int Index) const
+{
+	const float Time = m_vEntries[Index].m_Time;
+	auto It = std::lower_bound(m_vEntries.begin(), m_vEntries.end(), Time, [](const CEntry &Entry, float Value) {
+		return Entry.m_Time < Value;
+	});
+	return (It - m_vEntries.begin()) + 1;
+}
+
+int CLeaderboard::Find(const char *pName) const
+{
+	auto It = m_BestTimes.find(pName);
+	if(It == m_BestTimes.end())
+		return -1;
+	CEntry Entry;
+	Entry.m_Time = It->second;
+	str_copy(Entry.m_aName, pName);
+	return std::lower_bound(m_vEntries.begin(), m_vEntries.end(), Entry, Less) - m_vEntries.begin();
+}
+
+float CLeaderboard::PercentRank(int Index) const
+{
+	if(Size() <= 1)
+		return 0.0f;
+	return (Rank(Index) - 1) / (float)(Size() - 1);
+}
+
+float CLeaderboard::RoundTime(float Time)
+{
+	char aBuf[32];
+	str_format(aBuf, sizeof(aBuf), "%.2f", Time);
+	return str_tofloat(aBuf);
+}
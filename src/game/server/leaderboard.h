@@ -0,0 +1,48 @@
+#ifndef GAME_SERVER_LEADERBOARD_H
+#define GAME_SERVER_LEADERBOARD_H
+
+#include <engine/shared/protocol.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// In-memory copy of the best time per player on a single map, ordered by time.
+//
+// Mirrors `SELECT RANK() OVER (ORDER BY MIN(Time)), MIN(Time), Name ... GROUP BY Name`
+// on the race table, so rank and top queries for the current map don't need a
+// database round trip.
+class CLeaderboard
+{
+public:
+	struct CEntry
+	{
+		float m_Time;
+		char m_aName[MAX_NAME_LENGTH];
+	};
+
+	void Clear();
+	// inserts a finish, only keeps the best time of each player
+	void Insert(const char *pName, float Time);
+
+	int Size() const { return m_vEntries.size(); }
+	// entries are sorted by ascending time
+	const CEntry &Get(int Index) const { return m_vEntries[Index]; }
+	// same as SQL RANK(): one plus the number of players with a strictly better time
+	int Rank(int Index) const;
+	// index of the player's entry, or -1 if the player has no finish
+	int Find(const char *pName) const;
+	// same as SQL PERCENT_RANK(): (Rank - 1) / (Size - 1)
+	float PercentRank(int Index) const;
+
+	// finish times are stored with centisecond precision in the database
+	static float RoundTime(float Time);
+
+private:
+	static bool Less(const CEntry &Left, const CEntry &Right);
+
+	std::vector<CEntry> m_vEntries;
+	std::unordered_map<std::string, float> m_BestTimes;
+};
+
+#endif // GAME_SERVER_LEADERBOARD_H
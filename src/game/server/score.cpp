@@ -78,9 +78,11 @@ void CScore::GeneratePassphrase(char *pBuf, int BufSize)
 CScore::CScore(CGameContext *pGameServer, CDbConnectionPool *pPool) :
 	m_pPool(pPool),
 	m_pGameServer(pGameServer),
-	m_pServer(pGameServer->Server())
+	m_pServer(pGameServer->Server()),
+	m_LeaderboardLoaded(false)
 {
 	LoadBestTime();
+	LoadLeaderboard();
 
 	uint64_t aSeed[2];
 	secure_random_fill(aSeed, sizeof(aSeed));
@@ -124,6 +126,62 @@ void CScore::LoadBestTime()
 	m_pPool->Execute(CScoreWorker::LoadBestTime, std::move(Tmp), "load best time");
 }
 
+void CScore::LoadLeaderboard()
+{
+	auto pResult = std::make_shared<CScoreLeaderboardResult>();
+	m_pLeaderboardResult = pResult;
+
+	auto Tmp = std::make_unique<CSqlLeaderboardRequest>(pResult);
+	str_copy(Tmp->m_aMap, Server()->GetMapName(), sizeof(Tmp->m_aMap));
+	str_copy(Tmp->m_aServer, g_Config.m_SvSqlServerName, sizeof(Tmp->m_aServer));
+	str_copy(m_aLeaderboardServer, Tmp->m_aServer);
+	m_pPool->Execute(CScoreWorker::LoadLeaderboard, std::move(Tmp), "load leaderboard");
+}
+
+bool CScore::UpdateLeaderboard()
+{
+	if(m_pLeaderboardResult != nullptr && m_pLeaderboardResult->m_Completed)
+	{
+		if(m_pLeaderboardResult->m_Success)
+		{
+			m_GlobalLeaderboard = std::move(m_pLeaderboardResult->m_Global);
+			m_RegionalLeaderboard = std::move(m_pLeaderboardResult->m_Regional);
+			m_LeaderboardLoaded = true;
+			for(const auto &[Name, Time] : m_vPendingFinishes)
+				InsertLeaderboard(Name.c_str(), Time);
+		}
+		m_vPendingFinishes.clear();
+		m_pLeaderboardResult = nullptr;
+	}
+	return m_LeaderboardLoaded && str_comp(m_aLeaderboardServer, g_Config.m_SvSqlServerName) == 0;
+}
+
+void CScore::InsertLeaderboard(const char *pName, float Time)
+{
+	UpdateLeaderboard();
+	if(!m_LeaderboardLoaded)
+	{
+		if(m_pLeaderboardResult != nullptr)
+			m_vPendingFinishes.emplace_back(pName, Time);
+		return;
+	}
+	m_GlobalLeaderboard.Insert(pName, Time);
+	if(str_find(g_Config.m_SvSqlServerName, m_aLeaderboardServer))
+		m_RegionalLeaderboard.Insert(pName, Time);
+}
+
+std::shared_ptr<CScorePlayerResult> CScore::NewCachedPlayerResult(int ClientId, CSqlPlayerRequest *pRequest, const char *pName, int Offset)
+{
+	if(GameServer()->m_apPlayers[ClientId]->m_ScoreQueryResult != nullptr)
+		return nullptr;
+	str_copy(pRequest->m_aName, pName, sizeof(pRequest->m_aName));
+	str_copy(pRequest->m_aMap, Server()->GetMapName(), sizeof(pRequest->m_aMap));
+	str_copy(pRequest->m_aServer, g_Config.m_SvSqlServerName, sizeof(pRequest->m_aServer));
+	str_copy(pRequest->m_aRequestingPlayer, Server()->ClientName(ClientId), sizeof(pRequest->m_aRequestingPlayer));
+	pRequest->m_Offset = Offset;
+	return std::make_shared<CScorePlayerResult>();
+}
+
 void CScore::LoadMapInfo()
 {
 	if(m_pGameServer->m_pLoadMapInfoResult)
@@ -184,6 +242,8 @@ void CScore::SaveScore(int ClientId, int TimeTicks, const char *pTimestamp, cons
 	for(int i = 0; i < NUM_CHECKPOINTS; i++)
 		Tmp->m_aCurrentTimeCp[i] = aTimeCp[i];
 
+	InsertLeaderboard(Tmp->m_aName, Tmp->m_Time);
+
 	m_pPool->ExecuteWrite(CScoreWorker::SaveScore, std::move(Tmp), "save score");
 }
 
@@ -217,6 +277,20 @@ void CScore::ShowRank(int ClientId, const char *pName)
 {
 	if(RateLimitPlayer(ClientId))
 		return;
+	if(UpdateLeaderboard())
+	{
+		CSqlPlayerRequest Request(nullptr);
+		auto pResult = NewCachedPlayerResult(ClientId, &Request, pName, 0);
+		if(pResult == nullptr)
+			return;
+		if(CScoreWorker::ShowRankCached(m_GlobalLeaderboard, m_RegionalLeaderboard, &Request, pResult.get()))
+		{
+			pResult->m_Success = true;
+			pResult->m_Completed = true;
+			GameServer()->m_apPlayers[ClientId]->m_ScoreQueryResult = pResult;
+			return;
+		}
+	}
 	ExecPlayerThread(CScoreWorker::ShowRank, "show rank", ClientId, pName, 0);
 }
 
@@ -231,6 +305,18 @@ void CScore::ShowTop(int ClientId, int Offset)
 {
 	if(RateLimitPlayer(ClientId))
 		return;
+	if(UpdateLeaderboard())
+	{
+		CSqlPlayerRequest Request(nullptr);
+		auto pResult = NewCachedPlayerResult(ClientId, &Request, "", Offset);
+		if(pResult == nullptr)
+			return;
+		CScoreWorker::ShowTopCached(m_GlobalLeaderboard, m_RegionalLeaderboard, &Request, pResult.get());
+		pResult->m_Success = true;
+		pResult->m_Completed = true;
+		GameServer()->m_apPlayers[ClientId]->m_ScoreQueryResult = pResult;
+		return;
+	}
 	ExecPlayerThread(CScoreWorker::ShowTop, "show top5", ClientId, "", Offset);
 }
 
@@ -21,6 +21,21 @@ class CScore
 	CGameContext *m_pGameServer;
 	IServer *m_pServer;
 
+	// best times of the current map, loaded once per map
+	std::shared_ptr<CScoreLeaderboardResult> m_pLeaderboardResult;
+	CLeaderboard m_GlobalLeaderboard;
+	CLeaderboard m_RegionalLeaderboard;
+	char m_aLeaderboardServer[5];
+	bool m_LeaderboardLoaded;
+	// finishes saved while the leaderboard is still loading
+	std::vector<std::pair<std::string, float>> m_vPendingFinishes;
+	void LoadLeaderboard();
+	// returns true if rank and top requests can be answered from memory
+	bool UpdateLeaderboard();
+	void InsertLeaderboard(const char *pName, float Time);
+	// same as NewSqlPlayerResult, but for requests answered without the database
+	std::shared_ptr<CScorePlayerResult> NewCachedPlayerResult(int ClientId, CSqlPlayerRequest *pRequest, const char *pName, int Offset);
+
 	std::vector<std::string> m_vWordlist;
 	CPrng m_Prng;
 	void GeneratePassphrase(char *pBuf, int BufSize);
@@ -171,6 +171,52 @@ bool CScoreWorker::LoadBestTime(IDbConnection *pSqlServer, const ISqlData *pGame
 	return true;
 }
 
+bool CScoreWorker::LoadLeaderboard(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CSqlLeaderboardRequest *>(pGameData);
+	auto *pResult = dynamic_cast<CScoreLeaderboardResult *>(pGameData->m_pResult.get());
+
+	char aBuf[512];
+	// sorted by time, so that entries are appended to the leaderboard
+	str_format(aBuf, sizeof(aBuf),
+		"SELECT Name, MIN(Time) AS Time "
+		"FROM %s_race "
+		"WHERE Map = ? "
+		"AND Server LIKE ? "
+		"GROUP BY Name "
+		"ORDER BY MIN(Time) ASC",
+		pSqlServer->GetPrefix());
+
+	char aServerLike[16];
+	str_format(aServerLike, sizeof(aServerLike), "%%%s%%", pData->m_aServer);
+	const char *pAny = "%";
+
+	CLeaderboard *apLeaderboards[] = {&pResult->m_Global, &pResult->m_Regional};
+	const char *apServers[] = {pAny, aServerLike};
+	for(int i = 0; i < 2; i++)
+	{
+		if(!pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+		{
+			return false;
+		}
+		pSqlServer->BindString(1, pData->m_aMap);
+		pSqlServer->BindString(2, apServers[i]);
+
+		bool End = false;
+		while(pSqlServer->Step(&End, pError, ErrorSize) && !End)
+		{
+			char aName[MAX_NAME_LENGTH];
+			pSqlServer->GetString(1, aName, sizeof(aName));
+			apLeaderboards[i]->Insert(aName, pSqlServer->GetFloat(2));
+		}
+		if(!End)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 // update stuff
 bool CScoreWorker::LoadPlayerData(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
@@ -819,6 +865,55 @@ bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGam
 	return true;
 }
 
+static void FormatRank(const CSqlPlayerRequest *pData, CScorePlayerResult *pResult, int Rank, float Time, float PercentRank, const char *pRegionalRank)
+{
+	char aTime[32];
+	str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
+
+	if(g_Config.m_SvHideScore)
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"Your time: %s", aTime);
+		return;
+	}
+
+	pResult->m_MessageKind = CScorePlayerResult::ALL;
+	// CEIL and FLOOR are not supported in SQLite
+	int BetterThanPercent = std::floor(100.0f - 100.0f * PercentRank);
+
+	if(str_comp_nocase(pData->m_aRequestingPlayer, pData->m_aName) == 0)
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"%s - %s - better than %d%%",
+			pData->m_aName, aTime, BetterThanPercent);
+	}
+	else
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"%s - %s - better than %d%% - requested by %s",
+			pData->m_aName, aTime, BetterThanPercent, pData->m_aRequestingPlayer);
+	}
+
+	if(g_Config.m_SvRegionalRankings)
+	{
+		str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
+			"Global rank %d - %s %s",
+			Rank, pData->m_aServer, pRegionalRank);
+	}
+	else
+	{
+		str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
+			"Global rank %d", Rank);
+	}
+}
+
+static void FormatTopLine(char *pBuf, int BufSize, int Rank, const char *pName, float Time)
+{
+	char aTime[32];
+	str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
+	str_format(pBuf, BufSize, "%d. %s Time: %s", Rank, pName, aTime);
+}
+
 bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
@@ -883,46 +978,7 @@ bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData
 
 	if(!End)
 	{
-		int Rank = pSqlServer->GetInt(1);
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, TIME_HOURS_CENTISECS, aBuf, sizeof(aBuf));
-
-		if(g_Config.m_SvHideScore)
-		{
-			str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-				"Your time: %s", aBuf);
-		}
-		else
-		{
-			pResult->m_MessageKind = CScorePlayerResult::ALL;
-			// CEIL and FLOOR are not supported in SQLite
-			int BetterThanPercent = std::floor(100.0f - 100.0f * pSqlServer->GetFloat(3));
-
-			if(str_comp_nocase(pData->m_aRequestingPlayer, pData->m_aName) == 0)
-			{
-				str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-					"%s - %s - better than %d%%",
-					pData->m_aName, aBuf, BetterThanPercent);
-			}
-			else
-			{
-				str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-					"%s - %s - better than %d%% - requested by %s",
-					pData->m_aName, aBuf, BetterThanPercent, pData->m_aRequestingPlayer);
-			}
-
-			if(g_Config.m_SvRegionalRankings)
-			{
-				str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
-					"Global rank %d - %s %s",
-					Rank, pData->m_aServer, aRegionalRank);
-			}
-			else
-			{
-				str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
-					"Global rank %d", Rank);
-			}
-		}
+		FormatRank(pData, pResult, pSqlServer->GetInt(1), pSqlServer->GetFloat(2), pSqlServer->GetFloat(3), aRegionalRank);
 	}
 	else
 	{
@@ -1055,19 +1111,14 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	str_copy(pResult->m_Data.m_aaMessages[Line], "------------ Global Top ------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
 	Line++;
 
-	char aTime[32];
 	bool End = false;
 
 	while(pSqlServer->Step(&End, pError, ErrorSize) && !End)
 	{
 		char aName[MAX_NAME_LENGTH];
 		pSqlServer->GetString(1, aName, sizeof(aName));
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
-		int Rank = pSqlServer->GetInt(3);
-		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
-			"%d. %s Time: %s", Rank, aName, aTime);
-
+		FormatTopLine(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			pSqlServer->GetInt(3), aName, pSqlServer->GetFloat(2));
 		Line++;
 	}
 
@@ -1097,17 +1148,70 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	{
 		char aName[MAX_NAME_LENGTH];
 		pSqlServer->GetString(1, aName, sizeof(aName));
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
-		int Rank = pSqlServer->GetInt(3);
-		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
-			"%d. %s Time: %s", Rank, aName, aTime);
+		FormatTopLine(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			pSqlServer->GetInt(3), aName, pSqlServer->GetFloat(2));
 		Line++;
 	}
 
 	return End;
 }
 
+bool CScoreWorker::ShowRankCached(const CLeaderboard &Global, const CLeaderboard &Regional, const CSqlPlayerRequest *pData, CScorePlayerResult *pResult)
+{
+	int Index = Global.Find(pData->m_aName);
+	if(Index < 0)
+	{
+		// name lookups might be case insensitive in the database
+		return false;
+	}
+
+	char aRegionalRank[16];
+	int RegionalIndex = Regional.Find(pData->m_aName);
+	if(RegionalIndex < 0)
+	{
+		str_copy(aRegionalRank, "unranked", sizeof(aRegionalRank));
+	}
+	else
+	{
+		str_format(aRegionalRank, sizeof(aRegionalRank), "rank %d", Regional.Rank(RegionalIndex));
+	}
+
+	FormatRank(pData, pResult, Global.Rank(Index), Global.Get(Index).m_Time, Global.PercentRank(Index), aRegionalRank);
+	return true;
+}
+
+void CScoreWorker::ShowTopCached(const CLeaderboard &Global, const CLeaderboard &Regional, const CSqlPlayerRequest *pData, CScorePlayerResult *pResult)
+{
+	int LimitStart = maximum(absolute(pData->m_Offset) - 1, 0);
+	bool Descending = pData->m_Offset < 0;
+
+	auto &&AddLines = [&](const CLeaderboard &Leaderboard, int &Line, int Count) {
+		for(int i = LimitStart; i < LimitStart + Count && i < Leaderboard.Size(); i++)
+		{
+			int Index = Descending ? Leaderboard.Size() - 1 - i : i;
+			FormatTopLine(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+				Leaderboard.Rank(Index), Leaderboard.Get(Index).m_aName, Leaderboard.Get(Index).m_Time);
+			Line++;
+		}
+	};
+
+	int Line = 0;
+	str_copy(pResult->m_Data.m_aaMessages[Line], "------------ Global Top ------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
+	Line++;
+	AddLines(Global, Line, 5);
+
+	if(!g_Config.m_SvRegionalRankings)
+	{
+		str_copy(pResult->m_Data.m_aaMessages[Line], "-----------------------------------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
+		return;
+	}
+
+	str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+		"------------ %s Top ------------", pData->m_aServer);
+	Line++;
+	AddLines(Regional, Line, 3);
+}
+
 bool CScoreWorker::ShowTeamTop5(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
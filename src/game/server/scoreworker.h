@@ -6,6 +6,7 @@
 #include <engine/shared/protocol.h>
 #include <engine/shared/uuid_manager.h>
 
+#include <game/server/leaderboard.h>
 #include <game/server/save.h>
 #include <game/voting.h>
 
@@ -80,6 +81,25 @@ struct CSqlLoadBestTimeRequest : ISqlData
 	char m_aMap[MAX_MAP_LENGTH];
 };
 
+struct CScoreLeaderboardResult : ISqlResult
+{
+	CLeaderboard m_Global;
+	CLeaderboard m_Regional;
+};
+
+struct CSqlLeaderboardRequest : ISqlData
+{
+	CSqlLeaderboardRequest(std::shared_ptr<CScoreLeaderboardResult> pResult) :
+		ISqlData(std::move(pResult))
+	{
+	}
+
+	// current map
+	char m_aMap[MAX_MAP_LENGTH];
+	// regional rankings are restricted to this server
+	char m_aServer[5];
+};
+
 struct CSqlPlayerRequest : ISqlData
 {
 	CSqlPlayerRequest(std::shared_ptr<CScorePlayerResult> pResult) :
@@ -290,6 +310,7 @@ struct CTeamrank
 struct CScoreWorker
 {
 	static bool LoadBestTime(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
+	static bool LoadLeaderboard(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 
 	static bool RandomMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 	static bool RandomUnfinishedMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
@@ -308,6 +329,12 @@ struct CScoreWorker
 	static bool ShowTopPoints(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 	static bool GetSaves(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 
+	// answer the same requests as ShowRank and ShowTop from the in-memory leaderboards of the current map
+	//
+	// returns false if the database has to be queried instead
+	static bool ShowRankCached(const CLeaderboard &Global, const CLeaderboard &Regional, const CSqlPlayerRequest *pData, CScorePlayerResult *pResult);
+	static void ShowTopCached(const CLeaderboard &Global, const CLeaderboard &Regional, const CSqlPlayerRequest *pData, CScorePlayerResult *pResult);
+
 	static bool SaveTeam(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize);
 	static bool LoadTeam(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize);
 
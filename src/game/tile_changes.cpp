@@ -0,0 +1,148 @@
+#include "tile_changes.h"
+
+#include <base/system.h>
+
+#include <utility>
+
+CTileChanges::CTileChanges(CTileChanges &&Other) noexcept
+{
+	*this = std::move(Other);
+}
+
+CTileChanges &CTileChanges::operator=(CTileChanges &&Other) noexcept
+{
+	m_vChunks = std::move(Other.m_vChunks);
+	m_ChunkIndices = std::move(Other.m_ChunkIndices);
+	m_LastChunk = std::exchange(Other.m_LastChunk, -1);
+	m_NumChanges = std::exchange(Other.m_NumChanges, 0);
+	m_Compressed = std::exchange(Other.m_Compressed, false);
+	Other.Clear();
+	return *this;
+}
+
+CTileChanges::CChunk &CTileChanges::FindChunk(int ChunkX, int ChunkY)
+{
+	// edits are local, most changes are in the same chunk as the last one
+	if(m_LastChunk != -1 && m_vChunks[m_LastChunk].m_X == ChunkX && m_vChunks[m_LastChunk].m_Y == ChunkY)
+		return m_vChunks[m_LastChunk];
+
+	const uint64_t Key = ((uint64_t)(uint32_t)ChunkY << 32) | (uint32_t)ChunkX;
+	auto [It, Inserted] = m_ChunkIndices.try_emplace(Key, (int)m_vChunks.size());
+	if(Inserted)
+	{
+		CChunk &Chunk = m_vChunks.emplace_back();
+		Chunk.m_X = ChunkX;
+		Chunk.m_Y = ChunkY;
+		Chunk.m_pRecording = std::make_unique<CRecording>();
+	}
+	m_LastChunk = It->second;
+	return m_vChunks[m_LastChunk];
+}
+
+void CTileChanges::Record(int x, int y, CTile Previous, CTile Current)
+{
+	dbg_assert(!m_Compressed, "tile changes recorded after compressing");
+	dbg_assert(x >= 0 && y >= 0, "tile change position out of range");
+
+	CRecording &Recording = *FindChunk(x / CHUNK_SIZE, y / CHUNK_SIZE).m_pRecording;
+	const int ChunkX = x % CHUNK_SIZE;
+	const int ChunkY = y % CHUNK_SIZE;
+	const int Offset = ChunkY * CHUNK_SIZE + ChunkX;
+	const uint32_t Bit = 1u << ChunkX;
+	if(!(Recording.m_aChanged[ChunkY] & Bit))
+	{
+		Recording.m_aChanged[ChunkY] |= Bit;
+		Recording.m_aPrevious[Offset] = Previous;
+		m_NumChanges++;
+	}
+	Recording.m_aCurrent[Offset] = Current;
+}
+
+static bool SameTile(const CTile &Tile, const CTile &Other)
+{
+	return Tile.m_Index == Other.m_Index && Tile.m_Flags == Other.m_Flags && Tile.m_Skip == Other.m_Skip && Tile.m_Reserved == Other.m_Reserved;
+}
+
+void CTileChanges::Compress()
+{
+	if(m_Compressed)
+		return;
+
+	for(CChunk &Chunk : m_vChunks)
+	{
+		const CRecording &Recording = *Chunk.m_pRecording;
+		for(int ChunkY = 0; ChunkY < CHUNK_SIZE; ChunkY++)
+		{
+			if(!Recording.m_aChanged[ChunkY])
+				continue;
+			for(int ChunkX = 0; ChunkX < CHUNK_SIZE; ChunkX++)
+			{
+				if(!(Recording.m_aChanged[ChunkY] & (1u << ChunkX)))
+					continue;
+				const int Offset = ChunkY * CHUNK_SIZE + ChunkX;
+				const CTile &Previous = Recording.m_aPrevious[Offset];
+				const CTile &Current = Recording.m_aCurrent[Offset];
+				// runs continue over rows, a filled chunk is a single run
+				if(!Chunk.m_vRuns.empty())
+				{
+					CRun &Last = Chunk.m_vRuns.back();
+					if(Last.m_Offset + Last.m_Length == Offset && SameTile(Last.m_Previous, Previous) && SameTile(Last.m_Current, Current))
+					{
+						Last.m_Length++;
+						continue;
+					}
+				}
+				Chunk.m_vRuns.push_back({(uint16_t)Offset, 1, Previous, Current});
+			}
+		}
+		Chunk.m_vRuns.shrink_to_fit();
+		Chunk.m_pRecording.reset();
+	}
+	m_vChunks.shrink_to_fit();
+	m_ChunkIndices.clear();
+	m_LastChunk = -1;
+	m_Compressed = true;
+}
+
+void CTileChanges::Apply(CTile *pTiles, int Width, int Height, bool Undo) const
+{
+	dbg_assert(m_Compressed, "tile changes applied before compressing");
+
+	for(const CChunk &Chunk : m_vChunks)
+	{
+		const int StartX = Chunk.m_X * CHUNK_SIZE;
+		const int StartY = Chunk.m_Y * CHUNK_SIZE;
+		for(const CRun &Run : Chunk.m_vRuns)
+		{
+			const CTile Tile = Undo ? Run.m_Previous : Run.m_Current;
+			for(int Offset = Run.m_Offset; Offset < Run.m_Offset + Run.m_Length; Offset++)
+			{
+				const int x = StartX + Offset % CHUNK_SIZE;
+				const int y = StartY + Offset / CHUNK_SIZE;
+				if(x < Width && y < Height)
+					pTiles[y * Width + x] = Tile;
+			}
+		}
+	}
+}
+
+void CTileChanges::Clear()
+{
+	m_vChunks.clear();
+	m_ChunkIndices.clear();
+	m_LastChunk = -1;
+	m_NumChanges = 0;
+	m_Compressed = false;
+}
+
+size_t CTileChanges::MemoryUsage() const
+{
+	size_t Usage = m_vChunks.capacity() * sizeof(CChunk) + m_ChunkIndices.size() * (sizeof(uint64_t) + sizeof(int) + 2 * sizeof(void *));
+	for(const CChunk &Chunk : m_vChunks)
+	{
+		Usage += Chunk.m_vRuns.capacity() * sizeof(CRun);
+		if(Chunk.m_pRecording)
+			Usage += sizeof(CRecording);
+	}
+	return Usage;
+}
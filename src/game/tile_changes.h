@@ -0,0 +1,87 @@
+#ifndef GAME_TILE_CHANGES_H
+#define GAME_TILE_CHANGES_H
+
+#include <game/mapitems.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The tiles of a layer changed by an edit, with their previous and current
+ * value, used to undo and redo the edit.
+ *
+ * Changes are stored in chunks of `CHUNK_SIZE` x `CHUNK_SIZE` tiles. While
+ * recording, a chunk stores its tiles uncompressed. @link Compress @endlink
+ * turns every chunk into runs of changed tiles with the same previous and
+ * current value, so filling a large area takes a few bytes per chunk.
+ */
+class CTileChanges
+{
+public:
+	static constexpr int CHUNK_SIZE = 32;
+
+	CTileChanges() = default;
+	CTileChanges(CTileChanges &&Other) noexcept;
+	CTileChanges &operator=(CTileChanges &&Other) noexcept;
+
+	/**
+	 * Records that the tile at the position was changed. The previous value is
+	 * only stored for the first change of a tile.
+	 */
+	void Record(int x, int y, CTile Previous, CTile Current);
+	/**
+	 * Run-length encodes the recorded changes. Changes cannot be recorded
+	 * afterwards.
+	 */
+	void Compress();
+	/**
+	 * Writes the previous (undo) or current (redo) value of the changed tiles.
+	 */
+	void Apply(CTile *pTiles, int Width, int Height, bool Undo) const;
+
+	void Clear();
+	bool Empty() const { return m_NumChanges == 0; }
+	int NumChanges() const { return m_NumChanges; }
+	size_t MemoryUsage() const;
+
+private:
+	class CRun
+	{
+	public:
+		uint16_t m_Offset;
+		uint16_t m_Length;
+		CTile m_Previous;
+		CTile m_Current;
+	};
+
+	class CRecording
+	{
+	public:
+		// indexed by y * CHUNK_SIZE + x
+		CTile m_aPrevious[CHUNK_SIZE * CHUNK_SIZE];
+		CTile m_aCurrent[CHUNK_SIZE * CHUNK_SIZE];
+		uint32_t m_aChanged[CHUNK_SIZE];
+	};
+
+	class CChunk
+	{
+	public:
+		int m_X;
+		int m_Y;
+		// only until compressed
+		std::unique_ptr<CRecording> m_pRecording;
+		std::vector<CRun> m_vRuns;
+	};
+
+	std::vector<CChunk> m_vChunks;
+	std::unordered_map<uint64_t, int> m_ChunkIndices;
+	int m_LastChunk = -1;
+	int m_NumChanges = 0;
+	bool m_Compressed = false;
+
+	CChunk &FindChunk(int ChunkX, int ChunkY);
+};
+
+#endif
@@ -0,0 +1,133 @@
+// This test runs in its own executable because it replaces the global
+// allocation functions to count heap allocations.
+
+#include <test/test.h>
+
+#include <base/system.h>
+
+#include <engine/map.h>
+#include <engine/shared/datafile.h>
+#include <engine/storage.h>
+
+#include <game/collision.h>
+#include <game/layers.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// only allocations of the thread that enabled counting are counted
+static thread_local bool gs_CountAllocations = false;
+static thread_local int gs_NumAllocations = 0;
+
+static void *CountedAlloc(size_t Size)
+{
+	if(gs_CountAllocations)
+		gs_NumAllocations++;
+	void *pData = malloc(Size ? Size : 1);
+	dbg_assert(pData != nullptr, "out of memory");
+	return pData;
+}
+
+void *operator new(size_t Size)
+{
+	return CountedAlloc(Size);
+}
+
+void *operator new[](size_t Size)
+{
+	return CountedAlloc(Size);
+}
+
+void operator delete(void *pData) noexcept
+{
+	free(pData);
+}
+
+void operator delete[](void *pData) noexcept
+{
+	free(pData);
+}
+
+void operator delete(void *pData, size_t Size) noexcept
+{
+	free(pData);
+}
+
+void operator delete[](void *pData, size_t Size) noexcept
+{
+	free(pData);
+}
+
+class CAllocationCounter
+{
+public:
+	CAllocationCounter()
+	{
+		gs_NumAllocations = 0;
+		gs_CountAllocations = true;
+	}
+	~CAllocationCounter() { gs_CountAllocations = false; }
+	int NumAllocations() const { return gs_NumAllocations; }
+};
+
+TEST(MapIndicesAlloc, NoHeapAllocations)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+
+	CDataFileReader DataFile;
+	ASSERT_TRUE(DataFile.Open(pStorage.get(), "maps/coverage.map", IStorage::TYPE_ALL));
+	std::unique_ptr<IEngineMap> pMap(CreateEngineMap());
+	pMap->Load(std::move(DataFile));
+	CLayers Layers;
+	Layers.Init(pMap.get(), false);
+	CCollision Collision;
+	Collision.Init(&Layers);
+
+	const float Width = Collision.GetWidth() * 32.0f;
+	const float Height = Collision.GetHeight() * 32.0f;
+	const vec2 Start(16.0f, 16.0f);
+	const vec2 End(Width - 16.0f, Height - 16.0f);
+
+	// the counter sees the allocations of the vector version
+	{
+		CAllocationCounter Counter;
+		const std::vector<int> vIndices = Collision.GetMapIndices(Start, End);
+		EXPECT_FALSE(vIndices.empty());
+		EXPECT_GT(Counter.NumAllocations(), 0);
+	}
+
+	CAllocationCounter Counter;
+	unsigned NumVisited = 0;
+	int Sum = 0;
+	for(float y = 16.0f; y < Height; y += 32.0f * 3.5f)
+	{
+		for(float Length : {0.0f, 5.0f, 40.0f, 400.0f, 1500.0f})
+		{
+			const vec2 PrevPos(16.0f, y);
+			const vec2 Pos(16.0f + Length, y + Length / 3.0f);
+			NumVisited += Collision.ForEachMapIndex(PrevPos, Pos, [&](int Index) {
+				Sum += Index;
+				return true;
+			});
+			NumVisited += Collision.ForEachMapIndex(
+				PrevPos, Pos, [&](int Index) {
+					Sum -= Index;
+					return true;
+				},
+				2);
+		}
+	}
+	NumVisited += Collision.ForEachMapIndex(Start, End, [&](int Index) {
+		Sum += Index;
+		return false;
+	});
+	EXPECT_EQ(Counter.NumAllocations(), 0);
+	EXPECT_GT(NumVisited, 0u);
+	EXPECT_NE(Sum, 0);
+}
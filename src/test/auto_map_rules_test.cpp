@@ -0,0 +1,140 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/engine.h>
+
+#include <game/auto_map_rules.h>
+#include <game/mapitems.h>
+#include <game/prng.h>
+#include <game/version.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+static const char RULES[] = R"RULES(
+#comment
+[Walls]
+Index 1
+Pos 0 -1 EMPTY
+Index 2 XFLIP
+Pos -1 0 FULL
+Pos 1 0 INDEX 1 OR 3 ROTATE
+Random 30%
+Index 3
+Pos 0 1 NOTINDEX 0 OR 2
+Modulo 3 2 1 0
+NewRun
+Index 4 YFLIP
+Pos 0 0 INDEX 1
+Random 4
+NewRun
+NoLayerCopy
+Index 5
+Pos 1 1 INDEX 4
+Pos -1 -1 EMPTY
+[Empty]
+)RULES";
+
+struct STileChange
+{
+	int m_X;
+	int m_Y;
+	CTile m_Previous;
+	CTile m_Current;
+};
+
+class AutoMapRules : public ::testing::Test
+{
+protected:
+	CAutoMapRules m_Rules;
+
+	void SetUp() override
+	{
+		CTestInfo Info;
+		IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+		ASSERT_TRUE(File);
+		io_write(File, RULES, str_length(RULES));
+		io_close(File);
+		ASSERT_TRUE(m_Rules.Load(io_open(Info.m_aFilename, IOFLAG_READ), Info.m_aFilename));
+		fs_remove(Info.m_aFilename);
+	}
+
+	static std::vector<CTile> RandomLayer(int Width, int Height)
+	{
+		CPrng Prng;
+		uint64_t aSeed[2] = {(uint64_t)Width, (uint64_t)Height};
+		Prng.Seed(aSeed);
+		std::vector<CTile> vTiles((size_t)Width * Height, CTile{});
+		for(auto &Tile : vTiles)
+		{
+			// mostly empty or solid, like a hand-drawn layer
+			const unsigned Random = Prng.RandomBits() % 16;
+			Tile.m_Index = Random < 8 ? 0 : (Random < 14 ? 1 : Random - 12);
+			Tile.m_Flags = Prng.RandomBits() % 8;
+		}
+		return vTiles;
+	}
+
+	void Automap(std::vector<CTile> &vTiles, int Width, int Height, int Seed, IEngine *pEngine, std::vector<STileChange> *pvChanges)
+	{
+		const auto &&RecordChange = [&](int X, int Y, const CTile &Previous, const CTile &Current) {
+			pvChanges->push_back({X, Y, Previous, Current});
+		};
+		m_Rules.Proceed(vTiles.data(), Width, Height, nullptr, 0, 0, -1, 0, Seed, 0, 0, RecordChange, pEngine);
+	}
+};
+
+TEST_F(AutoMapRules, Load)
+{
+	ASSERT_EQ(m_Rules.ConfigNamesNum(), 2);
+	EXPECT_STREQ(m_Rules.GetConfigName(0), "Walls");
+	EXPECT_STREQ(m_Rules.GetConfigName(1), "Empty");
+	EXPECT_STREQ(m_Rules.GetConfigName(2), "(unknown)");
+	const CAutoMapRules::CConfiguration *pConfig = m_Rules.Config(0);
+	ASSERT_TRUE(pConfig);
+	EXPECT_EQ(pConfig->m_vRuns.size(), 3u);
+	EXPECT_EQ(pConfig->m_StartX, -1);
+	EXPECT_EQ(pConfig->m_StartY, -1);
+	EXPECT_EQ(pConfig->m_EndX, 1);
+	EXPECT_EQ(pConfig->m_EndY, 1);
+	EXPECT_FALSE(m_Rules.Config(-1));
+}
+
+TEST_F(AutoMapRules, ParallelMatchesSerial)
+{
+	std::unique_ptr<IEngine> pEngine(CreateTestEngine(GAME_NAME));
+
+	const int Width = 300;
+	const int Height = 200;
+	ASSERT_GE(Width * Height, CAutoMapRules::PARALLEL_MIN_TILES);
+	const std::vector<CTile> vOriginal = RandomLayer(Width, Height);
+
+	for(int Seed = 1; Seed <= 4; Seed++)
+	{
+		std::vector<CTile> vSerial = vOriginal;
+		std::vector<STileChange> vSerialChanges;
+		Automap(vSerial, Width, Height, Seed, nullptr, &vSerialChanges);
+
+		std::vector<CTile> vParallel = vOriginal;
+		std::vector<STileChange> vParallelChanges;
+		Automap(vParallel, Width, Height, Seed, pEngine.get(), &vParallelChanges);
+
+		EXPECT_NE(mem_comp(vSerial.data(), vOriginal.data(), vOriginal.size() * sizeof(CTile)), 0);
+		EXPECT_EQ(mem_comp(vSerial.data(), vParallel.data(), vSerial.size() * sizeof(CTile)), 0);
+
+		// changes are reported in the same order with the tile before the first run
+		ASSERT_EQ(vSerialChanges.size(), vParallelChanges.size());
+		for(size_t i = 0; i < vSerialChanges.size(); i++)
+		{
+			const STileChange &Change = vParallelChanges[i];
+			const int Index = Change.m_Y * Width + Change.m_X;
+			EXPECT_EQ(Change.m_X, vSerialChanges[i].m_X);
+			EXPECT_EQ(Change.m_Y, vSerialChanges[i].m_Y);
+			EXPECT_EQ(mem_comp(&Change.m_Previous, &vOriginal[Index], sizeof(CTile)), 0);
+			EXPECT_EQ(mem_comp(&Change.m_Current, &vParallel[Index], sizeof(CTile)), 0);
+		}
+	}
+}
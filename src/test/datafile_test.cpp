@@ -1,9 +1,14 @@
 #include "test.h"
 
+#include <base/log.h>
+#include <base/system.h>
+#include <base/time.h>
+
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 
 #include <game/mapitems_ex.h>
+#include <game/prng.h>
 
 #include <gtest/gtest.h>
 
@@ -112,3 +117,93 @@ TEST(Datafile, StringData)
 		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
 	}
 }
+
+static void WriteDatafile(IStorage *pStorage, const char *pFilename, int CompressionThreads)
+{
+	CDataFileWriter Writer;
+	Writer.SetCompressionThreads(CompressionThreads);
+	ASSERT_TRUE(Writer.Open(pStorage, pFilename));
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {1, 2};
+	Prng.Seed(aSeed);
+	for(int i = 0; i < 16; i++)
+	{
+		// compressible data of different sizes, like the layers of a map
+		const size_t Size = (size_t)(i + 1) * 4 * 1024;
+		unsigned char *pData = (unsigned char *)malloc(Size);
+		for(size_t j = 0; j < Size; j++)
+			pData[j] = Prng.RandomBits() % 4 == 0 ? Prng.RandomBits() : 0;
+		int Item[2] = {i, (int)Size};
+		Writer.AddItem(MAPITEMTYPE_TEST, i, sizeof(Item), Item);
+		if(i % 2 == 0)
+		{
+			EXPECT_EQ(Writer.AddData(Size, pData, i % 4 == 0 ? CDataFileWriter::COMPRESSION_BEST : CDataFileWriter::COMPRESSION_DEFAULT), i);
+			free(pData);
+		}
+		else
+		{
+			EXPECT_EQ(Writer.AddDataOwned(Size, pData), i);
+		}
+	}
+	Writer.Finish();
+}
+
+TEST(Datafile, ParallelCompression)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+	char aSerial[IO_MAX_PATH_LENGTH];
+	char aParallel[IO_MAX_PATH_LENGTH];
+	str_format(aSerial, sizeof(aSerial), "%s.serial", Info.m_aFilename);
+	str_format(aParallel, sizeof(aParallel), "%s.parallel", Info.m_aFilename);
+
+	int64_t Start = time_get();
+	WriteDatafile(pStorage.get(), aSerial, 1);
+	const int64_t SerialTime = time_get() - Start;
+	Start = time_get();
+	WriteDatafile(pStorage.get(), aParallel, 4);
+	const int64_t ParallelTime = time_get() - Start;
+	log_info("datafile", "serial %.2fms, parallel %.2fms", SerialTime * 1000.0 / time_freq(), ParallelTime * 1000.0 / time_freq());
+
+	void *pSerial, *pParallel;
+	unsigned SerialSize, ParallelSize;
+	ASSERT_TRUE(pStorage->ReadFile(aSerial, IStorage::TYPE_SAVE, &pSerial, &SerialSize));
+	ASSERT_TRUE(pStorage->ReadFile(aParallel, IStorage::TYPE_SAVE, &pParallel, &ParallelSize));
+	EXPECT_EQ(SerialSize, ParallelSize);
+	EXPECT_TRUE(SerialSize == ParallelSize && mem_comp(pSerial, pParallel, SerialSize) == 0);
+	free(pSerial);
+	free(pParallel);
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), aParallel, IStorage::TYPE_ALL));
+		ASSERT_EQ(Reader.NumData(), 16);
+		for(int i = 0; i < Reader.NumData(); i++)
+		{
+			const int *pItem = (const int *)Reader.FindItem(MAPITEMTYPE_TEST, i);
+			ASSERT_TRUE(pItem);
+			EXPECT_EQ(Reader.GetDataSize(i), pItem[1]);
+		}
+
+		// released data is owned by the caller and loaded again when needed
+		const int Size = Reader.GetDataSize(5);
+		void *pData = Reader.ReleaseData(5);
+		ASSERT_TRUE(pData);
+		EXPECT_EQ(Reader.GetDataSize(5), Size);
+		const void *pLoaded = Reader.GetData(5);
+		ASSERT_TRUE(pLoaded);
+		EXPECT_NE(pLoaded, pData);
+		EXPECT_EQ(mem_comp(pLoaded, pData, Size), 0);
+		free(pData);
+		Reader.Close();
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(aSerial, IStorage::TYPE_SAVE);
+		pStorage->RemoveFile(aParallel, IStorage::TYPE_SAVE);
+	}
+}
@@ -0,0 +1,244 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/engine.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <game/prng.h>
+#include <game/version.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+static std::vector<unsigned char> RecordDemo(IStorage *pStorage, const char *pFilename, IEngine *pEngine, CDemoRecorder::CAsyncStats *pStats)
+{
+	CSnapshotDelta SnapshotDelta;
+	CDemoRecorder Recorder(&SnapshotDelta, true);
+	Recorder.RecordAsync(pEngine);
+	unsigned char aMapData[1] = {0};
+	SHA256_DIGEST Sha256 = {};
+	EXPECT_EQ(Recorder.Start(pStorage, nullptr, pFilename, "0.6 626fce9a778df4d4", "test", Sha256, 0, "server", 0, aMapData, nullptr, nullptr, nullptr), 0);
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {42, 42};
+	Prng.Seed(aSeed);
+	CSnapshotBuilder Builder;
+	char aSnapshot[CSnapshot::MAX_SIZE];
+	for(int Tick = 1; Tick <= 1000; Tick++)
+	{
+		// items appear, change and disappear again
+		Builder.Init();
+		for(int Id = 0; Id < 64; Id++)
+		{
+			if((Id + Tick / 50) % 5 == 0)
+				continue;
+			int *pItem = (int *)Builder.NewItem(1 + Id % 4, Id, 16 * sizeof(int));
+			for(int i = 0; i < 16; i++)
+				pItem[i] = i < 4 ? Prng.RandomBits() % 8 : Id * i + Tick / 10;
+		}
+		const int Size = Builder.Finish(aSnapshot);
+		Recorder.RecordSnapshot(Tick, aSnapshot, Size);
+
+		if(Tick % 7 == 0)
+		{
+			unsigned char aMessage[256];
+			const int MessageSize = 1 + Prng.RandomBits() % sizeof(aMessage);
+			for(int i = 0; i < MessageSize; i++)
+				aMessage[i] = Prng.RandomBits();
+			Recorder.RecordMessage(aMessage, MessageSize);
+		}
+		if(Tick % 200 == 0)
+			Recorder.AddDemoMarker();
+	}
+	EXPECT_EQ(Recorder.Length(), 999 / SERVER_TICK_SPEED);
+	EXPECT_EQ(Recorder.Stop(IDemoRecorder::EStopMode::KEEP_FILE), 0);
+	*pStats = Recorder.AsyncStats();
+
+	void *pData;
+	unsigned Size;
+	EXPECT_TRUE(pStorage->ReadFile(pFilename, IStorage::TYPE_SAVE, &pData, &Size));
+	std::vector<unsigned char> vData((unsigned char *)pData, (unsigned char *)pData + Size);
+	free(pData);
+
+	// the timestamp may differ
+	EXPECT_GE(vData.size(), sizeof(CDemoHeader));
+	if(vData.size() >= sizeof(CDemoHeader))
+		mem_zero(vData.data() + offsetof(CDemoHeader, m_aTimestamp), sizeof(CDemoHeader::m_aTimestamp));
+	return vData;
+}
+
+TEST(Demo, AsyncRecordingIsIdentical)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+	std::unique_ptr<IEngine> pEngine(CreateTestEngine(GAME_NAME));
+	CNetBase::Init();
+
+	CDemoRecorder::CAsyncStats Stats;
+	const std::vector<unsigned char> vSync = RecordDemo(pStorage.get(), "sync.demo", nullptr, &Stats);
+	const std::vector<unsigned char> vAsync = RecordDemo(pStorage.get(), "async.demo", pEngine.get(), &Stats);
+	ASSERT_EQ(vSync.size(), vAsync.size());
+	EXPECT_EQ(mem_comp(vSync.data(), vAsync.data(), vSync.size()), 0);
+	EXPECT_GT(Stats.m_MaxQueuedBytes, 0);
+}
+
+class CPlayedChunk
+{
+public:
+	int m_Tick;
+	bool m_Message;
+	std::vector<unsigned char> m_vData;
+
+	bool operator==(const CPlayedChunk &Other) const
+	{
+		return m_Tick == Other.m_Tick && m_Message == Other.m_Message && m_vData == Other.m_vData;
+	}
+};
+
+class CChunkListener : public CDemoPlayer::IListener
+{
+public:
+	CDemoPlayer *m_pPlayer;
+	std::vector<CPlayedChunk> m_vChunks;
+
+	void Add(bool Message, const void *pData, int Size)
+	{
+		m_vChunks.push_back({m_pPlayer->Info()->m_Info.m_CurrentTick, Message, std::vector<unsigned char>((const unsigned char *)pData, (const unsigned char *)pData + Size)});
+	}
+	void OnDemoPlayerSnapshot(void *pData, int Size) override { Add(false, pData, Size); }
+	void OnDemoPlayerMessage(void *pData, int Size) override { Add(true, pData, Size); }
+};
+
+static std::vector<CPlayedChunk> PlayDemo(IStorage *pStorage, const char *pFilename)
+{
+	CSnapshotDelta SnapshotDelta;
+	CDemoPlayer Player(&SnapshotDelta, false);
+	CChunkListener Listener;
+	Listener.m_pPlayer = &Player;
+	Player.SetListener(&Listener);
+	EXPECT_EQ(Player.Load(pStorage, nullptr, pFilename, IStorage::TYPE_SAVE), 0);
+	if(!Player.IsPlaying())
+		return {};
+	Player.Play();
+	while(Player.IsPlaying() && !Player.Info()->m_Info.m_Paused)
+		Player.Update(false);
+	Player.Stop();
+	return Listener.m_vChunks;
+}
+
+static std::vector<CPlayedChunk> ChunksInRange(const std::vector<CPlayedChunk> &vChunks, int StartTick, int EndTick)
+{
+	std::vector<CPlayedChunk> vResult;
+	for(const CPlayedChunk &Chunk : vChunks)
+		if(Chunk.m_Tick >= StartTick && Chunk.m_Tick <= EndTick)
+			vResult.push_back(Chunk);
+	return vResult;
+}
+
+static bool FilterOddMessages(const void *pData, int Size, void *pUser)
+{
+	return ((const unsigned char *)pData)[0] % 2 == 1;
+}
+
+TEST(Demo, Slice)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+	CNetBase::Init();
+
+	CDemoRecorder::CAsyncStats Stats;
+	RecordDemo(pStorage.get(), "source.demo", nullptr, &Stats);
+	const std::vector<CPlayedChunk> vSource = PlayDemo(pStorage.get(), "source.demo");
+	ASSERT_FALSE(vSource.empty());
+
+	CSnapshotDelta SnapshotDelta;
+	CDemoEditor Editor;
+	Editor.Init(&SnapshotDelta, nullptr, pStorage.get());
+
+	ASSERT_TRUE(Editor.Slice("source.demo", "full.demo", -1, -1, nullptr, nullptr));
+	EXPECT_EQ(PlayDemo(pStorage.get(), "full.demo"), vSource);
+
+	// starts between keyframes, copies the keyframe at tick 503
+	ASSERT_TRUE(Editor.Slice("source.demo", "slice.demo", 300, 700, nullptr, nullptr));
+	const std::vector<CPlayedChunk> vSlice = PlayDemo(pStorage.get(), "slice.demo");
+	EXPECT_EQ(vSlice, ChunksInRange(vSource, 300, 700));
+
+	CDemoPlayer Player(&SnapshotDelta, false);
+	ASSERT_EQ(Player.Load(pStorage.get(), nullptr, "slice.demo", IStorage::TYPE_SAVE), 0);
+	EXPECT_EQ(Player.Info()->m_Info.m_FirstTick, 300);
+	EXPECT_EQ(Player.Info()->m_Info.m_LastTick, 700);
+	EXPECT_EQ(Player.SeekKeyFrame(400), 300);
+	EXPECT_EQ(Player.SeekKeyFrame(600), 503);
+	Player.Stop();
+
+	// filtered messages are left out of the decoded and the copied part
+	ASSERT_TRUE(Editor.Slice("source.demo", "filtered.demo", 300, 700, FilterOddMessages, nullptr));
+	std::vector<CPlayedChunk> vExpected;
+	for(const CPlayedChunk &Chunk : vSlice)
+		if(!Chunk.m_Message || !FilterOddMessages(Chunk.m_vData.data(), Chunk.m_vData.size(), nullptr))
+			vExpected.push_back(Chunk);
+	EXPECT_LT(vExpected.size(), vSlice.size());
+	EXPECT_EQ(PlayDemo(pStorage.get(), "filtered.demo"), vExpected);
+}
+
+TEST(Demo, FastForward)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+	CNetBase::Init();
+
+	CDemoRecorder::CAsyncStats Stats;
+	RecordDemo(pStorage.get(), "source.demo", nullptr, &Stats);
+	const std::vector<CPlayedChunk> vSource = PlayDemo(pStorage.get(), "source.demo");
+
+	CSnapshotDelta SnapshotDelta;
+	CDemoPlayer Player(&SnapshotDelta, false);
+	CChunkListener Listener;
+	Listener.m_pPlayer = &Player;
+	Player.SetListener(&Listener);
+	ASSERT_EQ(Player.Load(pStorage.get(), nullptr, "source.demo", IStorage::TYPE_SAVE), 0);
+	Player.Play();
+
+	// seeks from the keyframe at tick 503
+	Listener.m_vChunks.clear();
+	ASSERT_TRUE(Player.SetPos(700));
+	const int CurrentTick = Player.Info()->m_Info.m_CurrentTick;
+	Player.Stop();
+
+	std::vector<CPlayedChunk> vSnapshots;
+	std::vector<std::vector<unsigned char>> vMessages;
+	for(const CPlayedChunk &Chunk : Listener.m_vChunks)
+	{
+		if(Chunk.m_Message)
+			vMessages.push_back(Chunk.m_vData);
+		else
+			vSnapshots.push_back(Chunk);
+	}
+
+	// only the last snapshots are passed to the listener, the current one matches normal playback
+	ASSERT_FALSE(vSnapshots.empty());
+	EXPECT_LE(vSnapshots.size(), 5u);
+	const std::vector<CPlayedChunk> vExpectedSnapshot = ChunksInRange(vSource, CurrentTick, CurrentTick);
+	ASSERT_FALSE(vExpectedSnapshot.empty());
+	EXPECT_EQ(vSnapshots.back(), vExpectedSnapshot.front());
+
+	// all messages are passed in order
+	std::vector<std::vector<unsigned char>> vExpectedMessages;
+	for(const CPlayedChunk &Chunk : ChunksInRange(vSource, 503, CurrentTick))
+		if(Chunk.m_Message)
+			vExpectedMessages.push_back(Chunk.m_vData);
+	EXPECT_GT(vExpectedMessages.size(), 20u);
+	EXPECT_EQ(vMessages, vExpectedMessages);
+}
@@ -25,6 +25,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <memory>
 #include <thread>
 
@@ -310,3 +311,110 @@ TEST_F(CTestGameWorld, CharacterEmote)
 	pChr->Freeze(10);
 	ASSERT_EQ(pChr->DetermineEyeEmote(), EMOTE_ANGRY);
 }
+
+// The per-pixel walk of CCollision::GetMapIndices before ForEachMapIndex
+// replaced it, kept verbatim as reference. Only the map accessors differ.
+static std::vector<int> ReferenceMapIndices(const CCollision *pCollision, vec2 PrevPos, vec2 Pos, unsigned MaxIndices)
+{
+	const int Width = pCollision->GetWidth();
+	const int Height = pCollision->GetHeight();
+	std::vector<int> vIndices;
+	float d = distance(PrevPos, Pos);
+	int End(d + 1);
+	if(!d)
+	{
+		int Nx = std::clamp((int)Pos.x / 32, 0, Width - 1);
+		int Ny = std::clamp((int)Pos.y / 32, 0, Height - 1);
+		int Index = Ny * Width + Nx;
+
+		if(pCollision->TileExists(Index))
+		{
+			vIndices.push_back(Index);
+			return vIndices;
+		}
+		else
+			return vIndices;
+	}
+	else
+	{
+		int LastIndex = 0;
+		for(int i = 0; i < End; i++)
+		{
+			float a = i / d;
+			vec2 Tmp = mix(PrevPos, Pos, a);
+			int Nx = std::clamp((int)Tmp.x / 32, 0, Width - 1);
+			int Ny = std::clamp((int)Tmp.y / 32, 0, Height - 1);
+			int Index = Ny * Width + Nx;
+			if(pCollision->TileExists(Index) && LastIndex != Index)
+			{
+				if(MaxIndices && vIndices.size() > MaxIndices)
+					return vIndices;
+				vIndices.push_back(Index);
+				LastIndex = Index;
+			}
+		}
+
+		return vIndices;
+	}
+}
+
+TEST_F(CTestGameWorld, MapIndices)
+{
+	const CCollision *pCollision = GameServer()->Collision();
+	const float Width = pCollision->GetWidth() * 32.0f;
+	const float Height = pCollision->GetHeight() * 32.0f;
+
+	int NumPaths = 0;
+	int NumVisited = 0;
+	int NumStopped = 0;
+	std::vector<int> vVisited;
+	for(float y = 16.0f; y < Height; y += 32.0f * 3.5f)
+	{
+		for(float x : {16.0f, Width / 2.0f + 7.0f, Width - 3.0f})
+		{
+			for(vec2 Direction : {vec2(1.0f, 1.0f / 3.0f), vec2(-1.0f, 0.5f), vec2(0.1f, -1.0f), vec2(-0.7f, -0.7f)})
+			{
+				for(float Length : {0.0f, 5.0f, 40.0f, 400.0f, 1500.0f})
+				{
+					// also leaves the map, where the walk is clamped to the border
+					const vec2 PrevPos(x, y);
+					const vec2 Pos = PrevPos + Direction * Length;
+					for(unsigned MaxIndices : {0u, 1u, 3u})
+					{
+						const std::vector<int> vExpected = ReferenceMapIndices(pCollision, PrevPos, Pos, MaxIndices);
+						vVisited.clear();
+						const unsigned Count = pCollision->ForEachMapIndex(
+							PrevPos, Pos, [&](int Index) {
+								vVisited.push_back(Index);
+								return true;
+							},
+							MaxIndices);
+						EXPECT_EQ(Count, vExpected.size());
+						EXPECT_EQ(vVisited, vExpected);
+						EXPECT_EQ(pCollision->GetMapIndices(PrevPos, Pos, MaxIndices), vExpected);
+						NumVisited += Count;
+					}
+
+					// stopped by the visitor after a few tiles
+					const std::vector<int> vAll = ReferenceMapIndices(pCollision, PrevPos, Pos, 0);
+					for(size_t StopAfter = 1; StopAfter <= 3 && StopAfter < vAll.size(); StopAfter++)
+					{
+						vVisited.clear();
+						const unsigned Count = pCollision->ForEachMapIndex(PrevPos, Pos, [&](int Index) {
+							vVisited.push_back(Index);
+							return vVisited.size() < StopAfter;
+						});
+						EXPECT_EQ(Count, StopAfter);
+						EXPECT_EQ(vVisited, std::vector<int>(vAll.begin(), vAll.begin() + StopAfter));
+						NumStopped++;
+					}
+					NumPaths++;
+				}
+			}
+		}
+	}
+	EXPECT_GT(NumPaths, 0);
+	// the coverage map is full of special tiles
+	EXPECT_GT(NumVisited, 0);
+	EXPECT_GT(NumStopped, 0);
+}
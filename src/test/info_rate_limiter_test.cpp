@@ -0,0 +1,79 @@
+#include <base/system.h>
+#include <base/time.h>
+
+#include <engine/server/info_rate_limiter.h>
+
+#include <gtest/gtest.h>
+
+static NETADDR Addr(const char *pAddr)
+{
+	NETADDR Result;
+	EXPECT_EQ(net_addr_from_str(&Result, pAddr), 0) << pAddr;
+	return Result;
+}
+
+TEST(InfoRateLimiter, PerRange)
+{
+	CInfoRateLimiter Limiter;
+	const int64_t Now = time_get();
+	const NETADDR Spoofer = Addr("192.0.2.1:8303");
+	const NETADDR Neighbour = Addr("192.0.2.200:8303");
+	const NETADDR Browser = Addr("198.51.100.7:8303");
+
+	for(int i = 0; i < 3; i++)
+		EXPECT_TRUE(Limiter.Consume(&Spoofer, 3, Now));
+	EXPECT_FALSE(Limiter.Consume(&Spoofer, 3, Now));
+	// the whole /24 shares the bucket
+	EXPECT_FALSE(Limiter.Consume(&Neighbour, 3, Now));
+	EXPECT_TRUE(Limiter.Consume(&Browser, 3, Now));
+}
+
+TEST(InfoRateLimiter, Ipv6)
+{
+	CInfoRateLimiter Limiter;
+	const int64_t Now = time_get();
+	const NETADDR A = Addr("[2001:db8:1:2::1]:8303");
+	const NETADDR B = Addr("[2001:db8:1:2:ffff::1]:8303");
+	const NETADDR C = Addr("[2001:db8:1:3::1]:8303");
+
+	EXPECT_TRUE(Limiter.Consume(&A, 1, Now));
+	EXPECT_FALSE(Limiter.Consume(&B, 1, Now));
+	EXPECT_TRUE(Limiter.Consume(&C, 1, Now));
+}
+
+TEST(InfoRateLimiter, Refill)
+{
+	CInfoRateLimiter Limiter;
+	const int64_t Now = time_get();
+	const NETADDR Source = Addr("192.0.2.1:8303");
+
+	for(int i = 0; i < 10; i++)
+		EXPECT_TRUE(Limiter.Consume(&Source, 10, Now));
+	EXPECT_FALSE(Limiter.Consume(&Source, 10, Now));
+	EXPECT_FALSE(Limiter.Consume(&Source, 10, Now + time_freq() / 20));
+	EXPECT_TRUE(Limiter.Consume(&Source, 10, Now + time_freq() / 10));
+	EXPECT_FALSE(Limiter.Consume(&Source, 10, Now + time_freq() / 10));
+	for(int i = 0; i < 10; i++)
+		EXPECT_TRUE(Limiter.Consume(&Source, 10, Now + 2 * time_freq()));
+	EXPECT_FALSE(Limiter.Consume(&Source, 10, Now + 2 * time_freq()));
+}
+
+TEST(InfoRateLimiter, ManyRanges)
+{
+	CInfoRateLimiter Limiter;
+	const int64_t Now = time_get();
+	const NETADDR Source = Addr("192.0.2.1:8303");
+	EXPECT_TRUE(Limiter.Consume(&Source, 1, Now));
+
+	// more ranges than slots, all of them get their first reply
+	for(int i = 0; i < 2 * CInfoRateLimiter::NUM_SLOTS; i++)
+	{
+		char aAddr[NETADDR_MAXSTRSIZE];
+		str_format(aAddr, sizeof(aAddr), "10.%d.%d.1:8303", (i >> 8) & 0xff, i & 0xff);
+		const NETADDR Other = Addr(aAddr);
+		EXPECT_TRUE(Limiter.Consume(&Other, 1, Now + time_freq()));
+	}
+
+	Limiter.Clear();
+	EXPECT_TRUE(Limiter.Consume(&Source, 1, Now));
+}
@@ -0,0 +1,81 @@
+#include <engine/server/input_buffer.h>
+
+#include <gtest/gtest.h>
+
+static const int *AddInput(CInputBuffer *pBuffer, int Value, int IntendedTick, int CurrentTick, int Margin = 20, int *pAppliedTick = nullptr)
+{
+	int aData[2] = {Value, Value};
+	const int AppliedTick = pBuffer->Add(aData, std::size(aData), IntendedTick, CurrentTick, Margin);
+	if(pAppliedTick)
+		*pAppliedTick = AppliedTick;
+	return pBuffer->Get(AppliedTick);
+}
+
+TEST(InputBuffer, Lookup)
+{
+	CInputBuffer Buffer;
+	EXPECT_EQ(Buffer.Get(0), nullptr);
+	EXPECT_EQ(Buffer.Get(-1), nullptr);
+
+	AddInput(&Buffer, 1, 101, 100);
+	AddInput(&Buffer, 2, 103, 100);
+	ASSERT_NE(Buffer.Get(101), nullptr);
+	EXPECT_EQ(Buffer.Get(101)[0], 1);
+	EXPECT_EQ(Buffer.Get(101)[2], 0);
+	EXPECT_EQ(Buffer.Get(102), nullptr);
+	EXPECT_EQ(Buffer.Get(103)[0], 2);
+	// same slot, different tick
+	EXPECT_EQ(Buffer.Get(101 + CInputBuffer::NUM_SLOTS), nullptr);
+
+	// old inputs are replaced when their slot comes around again
+	AddInput(&Buffer, 3, 101 + CInputBuffer::NUM_SLOTS, 101 + CInputBuffer::NUM_SLOTS - 5);
+	EXPECT_EQ(Buffer.Get(101), nullptr);
+	EXPECT_EQ(Buffer.Get(101 + CInputBuffer::NUM_SLOTS)[0], 3);
+
+	Buffer.Reset();
+	EXPECT_EQ(Buffer.Get(103), nullptr);
+	EXPECT_EQ(Buffer.Stats().m_NumInputs, 0);
+}
+
+TEST(InputBuffer, LateDuplicateAndEarly)
+{
+	CInputBuffer Buffer;
+	int AppliedTick;
+
+	// late inputs are applied in the next tick
+	AddInput(&Buffer, 1, 95, 100, -100, &AppliedTick);
+	EXPECT_EQ(AppliedTick, 101);
+	EXPECT_EQ(Buffer.Get(101)[0], 1);
+	EXPECT_EQ(Buffer.Stats().m_NumLate, 1);
+
+	// the first input for a tick wins
+	AddInput(&Buffer, 2, 101, 100);
+	EXPECT_EQ(Buffer.Get(101)[0], 1);
+	EXPECT_EQ(Buffer.Stats().m_NumDuplicate, 1);
+
+	// inputs too far ahead would overwrite upcoming ticks
+	EXPECT_EQ(AddInput(&Buffer, 3, 100 + CInputBuffer::NUM_SLOTS + 1, 100), nullptr);
+	EXPECT_EQ(Buffer.Get(101)[0], 1);
+	EXPECT_EQ(Buffer.Stats().m_NumTooEarly, 1);
+
+	EXPECT_EQ(Buffer.Stats().m_NumInputs, 3);
+	EXPECT_EQ(Buffer.Stats().LatePercent(), 33);
+}
+
+TEST(InputBuffer, Stats)
+{
+	CInputBuffer Buffer;
+	for(int Tick = 1; Tick <= 100; Tick++)
+	{
+		AddInput(&Buffer, Tick, Tick + 2, Tick, Tick % 2 ? 30 : 10);
+		if(Tick % 10 == 0)
+			EXPECT_EQ(Buffer.Consume(Tick + 3), nullptr);
+		else
+			Buffer.Consume(Tick + 2);
+	}
+	EXPECT_EQ(Buffer.Stats().m_NumInputs, 100);
+	EXPECT_EQ(Buffer.Stats().m_NumLate, 0);
+	EXPECT_EQ(Buffer.Stats().m_NumMissing, 10);
+	EXPECT_NEAR(Buffer.Stats().m_MarginAvg, 20.0f, 2.0f);
+	EXPECT_NEAR(Buffer.Stats().m_MarginJitter, 10.0f, 2.0f);
+}
@@ -76,6 +76,40 @@ TEST(Io, Length4)
 	TestFileLength("\xef\xbb\xbfxyz");
 }
 
+TEST(Io, Map)
+{
+	CTestInfo Info;
+	const char *pWritten = "mapped file contents";
+
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_FALSE(io_close(File));
+
+	// empty files cannot be mapped
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	void *pData;
+	unsigned Length;
+	EXPECT_FALSE(io_map(File, &pData, &Length));
+	EXPECT_EQ(pData, nullptr);
+	EXPECT_FALSE(io_close(File));
+
+	File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_write(File, pWritten, str_length(pWritten)), (unsigned)str_length(pWritten));
+	EXPECT_FALSE(io_close(File));
+
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	ASSERT_TRUE(io_map(File, &pData, &Length));
+	// the mapping outlives the handle
+	EXPECT_FALSE(io_close(File));
+	ASSERT_EQ(Length, (unsigned)str_length(pWritten));
+	EXPECT_EQ(mem_comp(pData, pWritten, Length), 0);
+	io_unmap(pData, Length);
+	EXPECT_FALSE(fs_remove(Info.m_aFilename));
+}
+
 TEST(Io, SeekTellSkip)
 {
 	const char *pWritten1 = "01234567890123456789";
@@ -0,0 +1,105 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+static void LogMessages()
+{
+	const char aBuffer[4] = {'a', 'b', 'c', 'd'}; // not null-terminated
+	std::string Long(5000, 'x');
+	std::string LongUtf8 = std::string(4070, 'x') + std::string(30, 'x') + "\xc3\xa4\xc3\xa4";
+	int Value = 1;
+
+	log_info("test", "plain message");
+	log_warn("system", "%d %i %5d %-5d| %05d %+d", -1, 2, 3, 4, 5, 6);
+	log_debug("test", "%u %x %X %o %#x", 4000000000u, 255u, 255u, 8u, 16u);
+	log_error("test", "%hhd %hd %ld %lld %zu %" PRId64 " %" PRIzu, (signed char)-3, (short)-4, -5L, -6LL, (size_t)7, (int64_t)-8, (size_t)9);
+	log_trace("test", "%.3f %10.2e %g %G %F", 3.14159, 12345.678, 0.0001, 1e20, 2.5);
+	log_info("test", "%Lf", (long double)1.5);
+	log_info("test", "%c%c%c", 'a', 'b', 'c');
+	log_info("test", "%s|%10s|%-10s|%.3s|%.*s|%*s|%-*.*s|", "str", "right", "left", "truncated", 2, aBuffer, 6, "w", -4, 1, "xy");
+	log_info("test", "%p", (void *)&Value);
+	log_info("test", "100%% done");
+	log_info("test", "%s", Long.c_str());
+	log_info("test", "%s", LongUtf8.c_str());
+	log_info_color(LOG_COLOR{255, 0, 0}, "color", "in color %d", 1);
+	log_info("test", "%1$s %1$s", "positional");
+	log_info("test", "%d after positional", 2);
+	// repeated flags are valid, but too many of them are not deferred
+	const char *pManyFlags = "%-------------------------------------------------------------------------5d|";
+	log_info("test", pManyFlags, 3);
+	log_info("test", "%d after many flags", 4);
+}
+
+static std::vector<CLogMessage> CollectMessages(bool Deferred)
+{
+	std::shared_ptr<CMemoryLogger> pMemory = std::make_shared<CMemoryLogger>();
+	pMemory->SetFilter(CLogFilter{LEVEL_TRACE});
+	std::unique_ptr<ILogger> pLogger = log_logger_collection({pMemory});
+	if(Deferred)
+		pLogger = log_logger_deferred(std::move(pLogger));
+	{
+		CLogScope LogScope(pLogger.get());
+		LogMessages();
+	}
+	// outputs the remaining messages
+	pLogger.reset();
+	return pMemory->Lines();
+}
+
+TEST(Log, DeferredFormatting)
+{
+	const std::vector<CLogMessage> vImmediate = CollectMessages(false);
+	const std::vector<CLogMessage> vDeferred = CollectMessages(true);
+	ASSERT_EQ(vImmediate.size(), 17u);
+	ASSERT_EQ(vImmediate.size(), vDeferred.size());
+	EXPECT_STREQ(vDeferred[15].Message(), "3    |");
+	for(size_t i = 0; i < vImmediate.size(); i++)
+	{
+		const CLogMessage &Immediate = vImmediate[i];
+		const CLogMessage &Deferred = vDeferred[i];
+		EXPECT_EQ(Immediate.m_Level, Deferred.m_Level);
+		EXPECT_EQ(Immediate.m_HaveColor, Deferred.m_HaveColor);
+		EXPECT_STREQ(Immediate.m_aSystem, Deferred.m_aSystem);
+		EXPECT_STREQ(Immediate.Message(), Deferred.Message());
+		EXPECT_EQ(Immediate.m_LineLength - Immediate.m_TimestampLength, Deferred.m_LineLength - Deferred.m_TimestampLength);
+	}
+}
+
+TEST(Log, DeferredThreads)
+{
+	std::shared_ptr<CMemoryLogger> pMemory = std::make_shared<CMemoryLogger>();
+	std::unique_ptr<ILogger> pLogger = log_logger_deferred(log_logger_collection({pMemory}));
+	const int NumThreads = 4;
+	const int NumMessages = 5000;
+	std::vector<std::thread> vThreads;
+	for(int t = 0; t < NumThreads; t++)
+	{
+		vThreads.emplace_back([&pLogger, t]() {
+			CLogScope LogScope(pLogger.get());
+			for(int i = 0; i < NumMessages; i++)
+				log_info("thread", "%d %d %s", t, i, "some text to fill the ring buffer faster");
+		});
+	}
+	for(std::thread &Thread : vThreads)
+		Thread.join();
+	pLogger.reset();
+
+	// all messages arrive, in order per thread
+	const std::vector<CLogMessage> vLines = pMemory->Lines();
+	ASSERT_EQ(vLines.size(), (size_t)NumThreads * NumMessages);
+	std::vector<int> vNext(NumThreads, 0);
+	for(const CLogMessage &Line : vLines)
+	{
+		int Thread, Index;
+		ASSERT_EQ(sscanf(Line.Message(), "%d %d", &Thread, &Index), 2);
+		ASSERT_GE(Thread, 0);
+		ASSERT_LT(Thread, NumThreads);
+		EXPECT_EQ(Index, vNext[Thread]);
+		vNext[Thread] = Index + 1;
+	}
+}
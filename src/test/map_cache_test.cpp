@@ -0,0 +1,151 @@
+#include "test.h"
+
+#include <base/hash.h>
+#include <base/system.h>
+
+#include <engine/server/map_cache.h>
+#include <engine/storage.h>
+
+#include <gtest/gtest.h>
+
+static void WriteFile(IStorage *pStorage, const char *pFilename, const char *pContents)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, pContents, str_length(pContents));
+	io_close(File);
+}
+
+TEST(MapCache, Memory)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+	WriteFile(pStorage.get(), "a.map", "first map");
+	WriteFile(pStorage.get(), "b.map", "first map");
+	WriteFile(pStorage.get(), "c.map", "third map, a bit longer");
+
+	CMapCache Cache;
+	EXPECT_EQ(Cache.Load(pStorage.get(), "missing.map", IStorage::TYPE_SAVE), nullptr);
+
+	std::shared_ptr<const CMapCache::CEntry> pA = Cache.Load(pStorage.get(), "a.map", IStorage::TYPE_SAVE);
+	ASSERT_NE(pA, nullptr);
+	ASSERT_EQ(pA->m_Size, 9u);
+	EXPECT_EQ(mem_comp(pA->m_pData, "first map", 9), 0);
+	EXPECT_EQ(pA->m_Sha256, sha256("first map", 9));
+	EXPECT_FALSE(pA->m_Mapped);
+	EXPECT_EQ(Cache.NumMisses(), 1);
+
+	// same file again
+	EXPECT_EQ(Cache.Load(pStorage.get(), "a.map", IStorage::TYPE_SAVE), pA);
+	EXPECT_EQ(Cache.NumHits(), 1);
+
+	// same contents under another name share the entry
+	EXPECT_EQ(Cache.Load(pStorage.get(), "b.map", IStorage::TYPE_SAVE), pA);
+	EXPECT_EQ(Cache.NumEntries(), 1);
+	EXPECT_EQ(Cache.NumBytes(), 9);
+
+	// over budget, the least recently used entry is dropped but stays valid for its users
+	Cache.SetBudget(20);
+	std::shared_ptr<const CMapCache::CEntry> pC = Cache.Load(pStorage.get(), "c.map", IStorage::TYPE_SAVE);
+	ASSERT_NE(pC, nullptr);
+	EXPECT_EQ(Cache.NumEntries(), 1);
+	EXPECT_EQ(Cache.NumBytes(), (int64_t)pC->m_Size);
+	EXPECT_EQ(mem_comp(pA->m_pData, "first map", 9), 0);
+	EXPECT_NE(Cache.Load(pStorage.get(), "a.map", IStorage::TYPE_SAVE), nullptr);
+	EXPECT_EQ(Cache.NumMisses(), 4);
+}
+
+TEST(MapCache, Directory)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+	WriteFile(pStorage.get(), "a.map", "shared map");
+	WriteFile(pStorage.get(), "b.map", "another shared map");
+	char aDirectory[IO_MAX_PATH_LENGTH];
+	str_format(aDirectory, sizeof(aDirectory), "%s/cache", Info.m_aFilename);
+
+	// two caches with the same directory act like two server processes
+	CMapCache First;
+	First.SetDirectory(aDirectory);
+	std::shared_ptr<const CMapCache::CEntry> pFirst = First.Load(pStorage.get(), "a.map", IStorage::TYPE_SAVE);
+	ASSERT_NE(pFirst, nullptr);
+	EXPECT_TRUE(pFirst->m_Mapped);
+	EXPECT_EQ(First.NumMisses(), 1);
+
+	CMapCache Second;
+	Second.SetDirectory(aDirectory);
+	std::shared_ptr<const CMapCache::CEntry> pSecond = Second.Load(pStorage.get(), "a.map", IStorage::TYPE_SAVE);
+	ASSERT_NE(pSecond, nullptr);
+	EXPECT_TRUE(pSecond->m_Mapped);
+	EXPECT_EQ(Second.NumMisses(), 0);
+	EXPECT_EQ(Second.NumHits(), 1);
+	EXPECT_EQ(pSecond->m_Sha256, pFirst->m_Sha256);
+	EXPECT_EQ(pSecond->m_Crc, pFirst->m_Crc);
+	ASSERT_EQ(pSecond->m_Size, 10u);
+	EXPECT_EQ(mem_comp(pSecond->m_pData, "shared map", 10), 0);
+
+	// the directory is pruned to the budget, the newest map stays
+	Second.SetBudget(12);
+	std::shared_ptr<const CMapCache::CEntry> pB = Second.Load(pStorage.get(), "b.map", IStorage::TYPE_SAVE);
+	ASSERT_NE(pB, nullptr);
+	char aPath[IO_MAX_PATH_LENGTH];
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(pB->m_Sha256, aSha256, sizeof(aSha256));
+	str_format(aPath, sizeof(aPath), "%s/%s.map", aDirectory, aSha256);
+	EXPECT_TRUE(fs_is_file(aPath));
+	sha256_str(pFirst->m_Sha256, aSha256, sizeof(aSha256));
+	str_format(aPath, sizeof(aPath), "%s/%s.map", aDirectory, aSha256);
+	EXPECT_FALSE(fs_is_file(aPath));
+	// still mapped by both caches
+	EXPECT_EQ(mem_comp(pFirst->m_pData, "shared map", 10), 0);
+
+	// a stale index entry falls back to reading the file
+	CMapCache Third;
+	Third.SetDirectory(aDirectory);
+	std::shared_ptr<const CMapCache::CEntry> pThird = Third.Load(pStorage.get(), "a.map", IStorage::TYPE_SAVE);
+	ASSERT_NE(pThird, nullptr);
+	EXPECT_EQ(Third.NumMisses(), 1);
+	EXPECT_EQ(pThird->m_Sha256, pFirst->m_Sha256);
+}
+
+TEST(MapCache, DirectoryDamaged)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+	WriteFile(pStorage.get(), "a.map", "shared map");
+	char aDirectory[IO_MAX_PATH_LENGTH];
+	str_format(aDirectory, sizeof(aDirectory), "%s/cache", Info.m_aFilename);
+
+	CMapCache First;
+	First.SetDirectory(aDirectory);
+	std::shared_ptr<const CMapCache::CEntry> pFirst = First.Load(pStorage.get(), "a.map", IStorage::TYPE_SAVE);
+	ASSERT_NE(pFirst, nullptr);
+	const SHA256_DIGEST Sha256 = pFirst->m_Sha256;
+	pFirst = nullptr;
+
+	// same size, other contents
+	char aPath[IO_MAX_PATH_LENGTH];
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(Sha256, aSha256, sizeof(aSha256));
+	str_format(aPath, sizeof(aPath), "%s/%s.map", aDirectory, aSha256);
+	IOHANDLE File = io_open(aPath, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_write(File, "damaged!!!", 10);
+	io_close(File);
+
+	// the damaged file is never served under the hash of the map
+	CMapCache Second;
+	Second.SetDirectory(aDirectory);
+	std::shared_ptr<const CMapCache::CEntry> pSecond = Second.Load(pStorage.get(), "a.map", IStorage::TYPE_SAVE);
+	ASSERT_NE(pSecond, nullptr);
+	EXPECT_EQ(Second.NumMisses(), 1);
+	EXPECT_EQ(pSecond->m_Sha256, Sha256);
+	ASSERT_EQ(pSecond->m_Size, 10u);
+	EXPECT_EQ(mem_comp(pSecond->m_pData, "shared map", 10), 0);
+}
@@ -0,0 +1,58 @@
+#include "test.h"
+
+#include <engine/server/map_preload.h>
+#include <engine/storage.h>
+
+#include <game/server/gamecontext.h>
+
+#include <gtest/gtest.h>
+
+TEST(MapPreload, Prepare)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+
+	CMapCache MapCache;
+	CMapPreload Preload(pStorage.get(), &MapCache, "coverage", "maps/coverage.map", true);
+	Preload.Prepare();
+	ASSERT_TRUE(Preload.m_Success);
+	ASSERT_TRUE(Preload.m_DataFile.IsOpen());
+	ASSERT_NE(Preload.m_pMapFile, nullptr);
+	EXPECT_EQ((int)Preload.m_pMapFile->m_Size, Preload.m_DataFile.Size());
+	EXPECT_EQ(Preload.m_pMapFile->m_Sha256, Preload.m_DataFile.Sha256());
+	EXPECT_EQ(Preload.m_pMapFile->m_Crc, Preload.m_DataFile.Crc());
+	// there is no sixup version of this map
+	EXPECT_EQ(Preload.m_pSixupMapFile, nullptr);
+	EXPECT_STREQ(Preload.m_aSixupPath, "maps7/coverage.map");
+}
+
+TEST(MapPreload, Missing)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+
+	CMapCache MapCache;
+	CMapPreload Preload(pStorage.get(), &MapCache, "does_not_exist", "maps/does_not_exist.map", false);
+	Preload.Prepare();
+	EXPECT_FALSE(Preload.m_Success);
+	EXPECT_FALSE(Preload.m_DataFile.IsOpen());
+	EXPECT_EQ(Preload.m_pMapFile, nullptr);
+}
+
+TEST(MapPreload, ParseMapChangeCommand)
+{
+	char aMap[128];
+	EXPECT_TRUE(CGameContext::ParseMapChangeCommand("change_map Tutorial", aMap, sizeof(aMap)));
+	EXPECT_STREQ(aMap, "Tutorial");
+	EXPECT_TRUE(CGameContext::ParseMapChangeCommand("change_map \"Gold Mine\"", aMap, sizeof(aMap)));
+	EXPECT_STREQ(aMap, "Gold Mine");
+	EXPECT_TRUE(CGameContext::ParseMapChangeCommand("sv_map dm1; say hi", aMap, sizeof(aMap)));
+	EXPECT_STREQ(aMap, "dm1");
+	EXPECT_FALSE(CGameContext::ParseMapChangeCommand("change_map ", aMap, sizeof(aMap)));
+	EXPECT_FALSE(CGameContext::ParseMapChangeCommand("kick 1", aMap, sizeof(aMap)));
+	EXPECT_FALSE(CGameContext::ParseMapChangeCommand("random_map", aMap, sizeof(aMap)));
+}
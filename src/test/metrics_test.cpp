@@ -0,0 +1,130 @@
+#include <base/secure.h>
+#include <base/system.h>
+
+#include <engine/server/metrics_server.h>
+#include <engine/shared/metrics.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+TEST(Metrics, Format)
+{
+	CMetrics Metrics;
+	CMetrics::CCounter *pCounter = Metrics.Counter("test_events_total", "Events");
+	CMetrics::CGauge *pGauge0 = Metrics.Gauge("test_level", "Level per slot", "slot=\"0\"");
+	CMetrics::CGauge *pGauge1 = Metrics.Gauge("test_level", "Level per slot", "slot=\"1\"");
+	CMetrics::CHistogram *pHistogram = Metrics.Histogram("test_size_bytes", "Sizes", {10, 100});
+
+	EXPECT_EQ(Metrics.Counter("test_events_total", "Events"), pCounter);
+	EXPECT_EQ(Metrics.Gauge("test_level", "Level per slot", "slot=\"1\""), pGauge1);
+
+	pCounter->Add();
+	pCounter->Add(2);
+	pGauge0->Set(-5);
+	pGauge1->Add(7);
+	pHistogram->Observe(10);
+	pHistogram->Observe(50);
+	pHistogram->Observe(1000);
+
+	std::string Output;
+	Metrics.Format(Output);
+	EXPECT_EQ(Output,
+		"# HELP test_events_total Events\n"
+		"# TYPE test_events_total counter\n"
+		"test_events_total 3\n"
+		"# HELP test_level Level per slot\n"
+		"# TYPE test_level gauge\n"
+		"test_level{slot=\"0\"} -5\n"
+		"test_level{slot=\"1\"} 7\n"
+		"# HELP test_size_bytes Sizes\n"
+		"# TYPE test_size_bytes histogram\n"
+		"test_size_bytes_bucket{le=\"10\"} 1\n"
+		"test_size_bytes_bucket{le=\"100\"} 2\n"
+		"test_size_bytes_bucket{le=\"+Inf\"} 3\n"
+		"test_size_bytes_sum 1060\n"
+		"test_size_bytes_count 3\n");
+}
+
+TEST(Metrics, ConcurrentFormat)
+{
+	CMetrics Metrics;
+	CMetrics::CCounter *pCounter = Metrics.Counter("test_events_total", "Events");
+	std::atomic_bool Done = false;
+	std::thread Reader([&]() {
+		std::string Output;
+		while(!Done)
+		{
+			Output.clear();
+			Metrics.Format(Output);
+		}
+	});
+	for(int i = 0; i < 100000; i++)
+	{
+		pCounter->Add();
+		// registering while the other thread reads the metrics
+		if(i % 10000 == 0)
+		{
+			char aLabels[32];
+			str_format(aLabels, sizeof(aLabels), "n=\"%d\"", i);
+			Metrics.Gauge("test_gauge", "Gauge", aLabels)->Set(i);
+		}
+	}
+	Done = true;
+	Reader.join();
+	EXPECT_EQ(pCounter->Value(), 100000u);
+}
+
+TEST(Metrics, Respond)
+{
+	CMetrics Metrics;
+	Metrics.Counter("test_events_total", "Events")->Add();
+
+	std::string Response;
+	CMetricsServer::Respond(&Metrics, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n", Response);
+	EXPECT_EQ(Response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+	EXPECT_NE(Response.find("\r\n\r\n# HELP test_events_total Events\n"), std::string::npos);
+
+	CMetricsServer::Respond(&Metrics, "GET /metrics?name=x HTTP/1.1\r\n\r\n", Response);
+	EXPECT_EQ(Response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+	CMetricsServer::Respond(&Metrics, "GET /metricsx HTTP/1.1\r\n\r\n", Response);
+	EXPECT_EQ(Response.rfind("HTTP/1.1 404 Not Found\r\n", 0), 0u);
+	CMetricsServer::Respond(&Metrics, "POST /metrics HTTP/1.1\r\n\r\n", Response);
+	EXPECT_EQ(Response.rfind("HTTP/1.1 405 Method Not Allowed\r\n", 0), 0u);
+	CMetricsServer::Respond(&Metrics, "garbage", Response);
+	EXPECT_EQ(Response.rfind("HTTP/1.1 400 Bad Request\r\n", 0), 0u);
+}
+
+TEST(Metrics, Server)
+{
+	CMetrics Metrics;
+	Metrics.Gauge("test_players", "Players")->Set(12);
+
+	CMetricsServer Server;
+	NETADDR Addr;
+	ASSERT_EQ(net_addr_from_str(&Addr, "127.0.0.1:0"), 0);
+	for(Addr.port = 18300 + secure_rand_below(1000); !Server.Open(Addr, &Metrics); Addr.port++)
+		ASSERT_LT(Addr.port, 19400) << "no free port";
+
+	NETADDR BindAddr = {};
+	BindAddr.type = NETTYPE_IPV4;
+	NETSOCKET Socket = net_tcp_create(BindAddr);
+	ASSERT_TRUE(Socket);
+	ASSERT_EQ(net_tcp_connect(Socket, &Addr), 0);
+	const char aRequest[] = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	ASSERT_EQ(net_tcp_send(Socket, aRequest, str_length(aRequest)), str_length(aRequest));
+
+	// the server closes the connection after the response
+	std::string Response;
+	char aBuf[1024];
+	int Received;
+	while((Received = net_tcp_recv(Socket, aBuf, sizeof(aBuf))) > 0)
+		Response.append(aBuf, Received);
+	net_tcp_close(Socket);
+	Server.Close();
+
+	EXPECT_EQ(Response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+	EXPECT_NE(Response.find("\ntest_players 12\n"), std::string::npos);
+}
@@ -1,7 +1,13 @@
+#include <base/system.h>
+
 #include <engine/server/name_ban.h>
 
 #include <gtest/gtest.h>
 
+#include <set>
+#include <string>
+#include <vector>
+
 TEST(NameBan, Empty)
 {
 	CNameBans Bans;
@@ -78,3 +84,124 @@ TEST(NameBan, UnbanNotFound)
 	CNameBans Bans;
 	Bans.Unban("abc");
 }
+
+TEST(NameBan, LastBanWins)
+{
+	CNameBans Bans;
+	Bans.Ban("abc", "first", 1, false);
+	Bans.Ban("abd", "second", 1, false);
+	Bans.Ban("bc", "third", 0, true);
+	EXPECT_STREQ(Bans.IsBanned("abc")->m_aReason, "third");
+	EXPECT_STREQ(Bans.IsBanned("abd")->m_aReason, "second");
+	Bans.Unban("bc");
+	EXPECT_STREQ(Bans.IsBanned("abc")->m_aReason, "second");
+	Bans.Unban("abd");
+	EXPECT_STREQ(Bans.IsBanned("abc")->m_aReason, "first");
+}
+
+TEST(NameBan, SubstringCase)
+{
+	CNameBans Bans;
+	Bans.Ban("Ünban", "", 0, true);
+	Bans.Ban("ana", "", 0, true);
+	EXPECT_TRUE(Bans.IsBanned("xxüNBANxx"));
+	EXPECT_TRUE(Bans.IsBanned("bananas"));
+	EXPECT_FALSE(Bans.IsBanned("unban"));
+	EXPECT_FALSE(Bans.IsBanned("an an"));
+}
+
+// Looks up the name the way the bans used to be checked, one by one.
+static const CNameBan *IsBannedLinear(const std::vector<CNameBan> &vBans, const char *pName)
+{
+	char aTrimmed[MAX_NAME_LENGTH];
+	str_copy(aTrimmed, str_utf8_skip_whitespaces(pName));
+	str_utf8_trim_right(aTrimmed);
+
+	int aSkeleton[MAX_NAME_SKELETON_LENGTH];
+	int SkeletonLength = str_utf8_to_skeleton(aTrimmed, aSkeleton, std::size(aSkeleton));
+	int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
+
+	const CNameBan *pResult = nullptr;
+	for(const CNameBan &Ban : vBans)
+	{
+		int Distance = str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer));
+		if(Distance <= Ban.m_Distance || (Ban.m_IsSubstring && str_utf8_find_nocase(pName, Ban.m_aName)))
+			pResult = &Ban;
+	}
+	return pResult;
+}
+
+static void RandomName(char *pName, int Size, unsigned &Seed)
+{
+	static const char *const s_apParts[] = {"a", "b", "c", "o", "0", "l", "I", "1", "x", "Ä", "ä", "ö", " ", "nameless", "tee", "brainless"};
+	pName[0] = '\0';
+	Seed = Seed * 1103515245 + 12345;
+	const int NumParts = 1 + (Seed >> 16) % 8;
+	for(int i = 0; i < NumParts; i++)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		str_append(pName, s_apParts[(Seed >> 16) % std::size(s_apParts)], Size);
+	}
+}
+
+TEST(NameBan, Many)
+{
+	CNameBans Bans;
+	std::vector<CNameBan> vReference;
+	std::set<std::string> Names;
+	unsigned Seed = 1;
+	char aName[MAX_NAME_LENGTH];
+	while(vReference.size() < 10000)
+	{
+		RandomName(aName, sizeof(aName), Seed);
+		if(!Names.emplace(aName).second)
+			continue;
+		const int Distance = (Seed >> 8) % 3;
+		const bool IsSubstring = (Seed >> 12) % 16 == 0 && str_length(aName) > 4;
+		Bans.Ban(aName, "", Distance, IsSubstring);
+		vReference.emplace_back(aName, "", Distance, IsSubstring);
+	}
+
+	const int NumLookups = 500;
+	std::vector<std::string> vNames;
+	for(int i = 0; i < NumLookups; i++)
+	{
+		RandomName(aName, sizeof(aName), Seed);
+		vNames.emplace_back(aName);
+	}
+
+	std::vector<const CNameBan *> vIndexed;
+	for(const std::string &Name : vNames)
+		vIndexed.push_back(Bans.IsBanned(Name.c_str()));
+	std::vector<const CNameBan *> vLinear;
+	for(const std::string &Name : vNames)
+		vLinear.push_back(IsBannedLinear(vReference, Name.c_str()));
+
+	int NumBanned = 0;
+	for(int i = 0; i < NumLookups; i++)
+	{
+		ASSERT_EQ(vIndexed[i] == nullptr, vLinear[i] == nullptr) << vNames[i];
+		if(vIndexed[i])
+		{
+			EXPECT_STREQ(vIndexed[i]->m_aName, vLinear[i]->m_aName) << vNames[i];
+			NumBanned++;
+		}
+	}
+	EXPECT_GT(NumBanned, 0);
+
+	// removing bans rebuilds the indices
+	for(int i = 0; i < (int)vReference.size(); i += 3)
+		Bans.Unban(vReference[i].m_aName);
+	for(int i = ((int)vReference.size() - 1) / 3 * 3; i >= 0; i -= 3)
+		vReference.erase(vReference.begin() + i);
+	for(const std::string &Name : vNames)
+	{
+		const CNameBan *pIndexed = Bans.IsBanned(Name.c_str());
+		const CNameBan *pLinear = IsBannedLinear(vReference, Name.c_str());
+		ASSERT_EQ(pIndexed == nullptr, pLinear == nullptr) << Name;
+		if(pIndexed)
+		{
+			EXPECT_STREQ(pIndexed->m_aName, pLinear->m_aName) << Name;
+		}
+	}
+}
@@ -79,3 +79,23 @@ TEST(Prng, Description)
 	Prng.Seed(aSeed2);
 	EXPECT_STREQ(Prng.Description(), "pcg-xsh-rr:0000000000000000:0000000000000000");
 }
+
+TEST(Prng, SeedFromDescription)
+{
+	uint64_t aSeed[2] = {0xfedbca9876543210, 0x0123456789abcdef};
+	CPrng Expected;
+	Expected.Seed(aSeed);
+
+	CPrng Prng;
+	EXPECT_TRUE(Prng.SeedFromDescription(Expected.Description()));
+	EXPECT_STREQ(Prng.Description(), Expected.Description());
+	for(int i = 0; i < 8; i++)
+	{
+		EXPECT_EQ(Prng.RandomBits(), Expected.RandomBits());
+	}
+
+	EXPECT_FALSE(Prng.SeedFromDescription("pcg-xsh-rr:unseeded"));
+	EXPECT_FALSE(Prng.SeedFromDescription("pcg-xsh-rr:fedbca9876543210"));
+	EXPECT_FALSE(Prng.SeedFromDescription("pcg-xsh-rr:fedbca987654321g:0123456789abcdef"));
+	EXPECT_FALSE(Prng.SeedFromDescription("xorshift:fedbca9876543210:0123456789abcdef"));
+}
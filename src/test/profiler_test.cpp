@@ -0,0 +1,80 @@
+#include "test.h"
+
+#include <engine/shared/profiler.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+static std::vector<std::string> PrintProfile(const CProfiler &Profiler)
+{
+	std::vector<std::string> vLines;
+	Profiler.Print([&](const char *pLine) { vLines.emplace_back(pLine); });
+	return vLines;
+}
+
+TEST(Profiler, SectionsAreShared)
+{
+	CProfiler Profiler;
+	const int Tick = Profiler.AddSection("tick");
+	const int Snap = Profiler.AddSection("snap");
+	EXPECT_NE(Tick, Snap);
+	EXPECT_EQ(Profiler.AddSection("tick"), Tick);
+}
+
+TEST(Profiler, DisabledScopeRecordsNothing)
+{
+	CProfiler Profiler;
+	const int Section = Profiler.AddSection("tick");
+	{
+		CProfiler::CScope Scope(&Profiler, Section);
+	}
+	Profiler.EndFrame();
+	EXPECT_EQ(PrintProfile(Profiler).size(), 1u);
+}
+
+TEST(Profiler, Percentiles)
+{
+	CProfiler Profiler;
+	Profiler.SetEnabled(true);
+	const int Tick = Profiler.AddSection("tick");
+	Profiler.AddSection("unused");
+	for(int i = 1; i <= 100; i++)
+	{
+		// two parts in one frame are summed up
+		Profiler.Add(Tick, std::chrono::milliseconds(i));
+		Profiler.Add(Tick, std::chrono::milliseconds(i));
+		Profiler.EndFrame();
+	}
+	const std::vector<std::string> vLines = PrintProfile(Profiler);
+	ASSERT_EQ(vLines.size(), 2u);
+	EXPECT_NE(vLines[1].find("tick"), std::string::npos);
+	EXPECT_NE(vLines[1].find("p50  102.000"), std::string::npos) << vLines[1];
+	EXPECT_NE(vLines[1].find("p99  200.000"), std::string::npos) << vLines[1];
+	EXPECT_NE(vLines[1].find("max  200.000"), std::string::npos) << vLines[1];
+
+	Profiler.Reset();
+	EXPECT_EQ(PrintProfile(Profiler).size(), 1u);
+}
+
+TEST(Profiler, RollingWindow)
+{
+	CProfiler Profiler;
+	Profiler.SetEnabled(true);
+	const int Tick = Profiler.AddSection("tick");
+	Profiler.Add(Tick, 1s);
+	Profiler.EndFrame();
+	for(int i = 0; i < CProfiler::WINDOW_SIZE; i++)
+	{
+		Profiler.Add(Tick, 1ms);
+		Profiler.EndFrame();
+	}
+	const std::vector<std::string> vLines = PrintProfile(Profiler);
+	ASSERT_EQ(vLines.size(), 2u);
+	// the slow frame dropped out of the window but is still the all-time maximum
+	EXPECT_NE(vLines[1].find("max    1.000"), std::string::npos) << vLines[1];
+	EXPECT_NE(vLines[1].find("all-time max 1000.000"), std::string::npos) << vLines[1];
+}
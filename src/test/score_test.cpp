@@ -74,13 +74,13 @@ struct Score : public testing::TestWithParam<IDbConnection *>
 		ASSERT_EQ(NumInserted, 1);
 	}
 
-	void InsertRank(float Time = 100.0, bool WithTimeCheckPoints = false)
+	void InsertRank(float Time = 100.0, bool WithTimeCheckPoints = false, const char *pName = "nameless tee")
 	{
 		str_copy(g_Config.m_SvSqlServerName, "USA", sizeof(g_Config.m_SvSqlServerName));
 		CSqlScoreData ScoreData(std::make_shared<CScorePlayerResult>());
 		str_copy(ScoreData.m_aMap, "Kobra 3", sizeof(ScoreData.m_aMap));
 		str_copy(ScoreData.m_aGameUuid, "8d300ecf-5873-4297-bee5-95668fdff320", sizeof(ScoreData.m_aGameUuid));
-		str_copy(ScoreData.m_aName, "nameless tee", sizeof(ScoreData.m_aName));
+		str_copy(ScoreData.m_aName, pName, sizeof(ScoreData.m_aName));
 		ScoreData.m_ClientId = 0;
 		ScoreData.m_Time = Time;
 		str_copy(ScoreData.m_aTimestamp, "2021-11-24 19:24:08", sizeof(ScoreData.m_aTimestamp));
@@ -261,6 +261,85 @@ TEST_P(SingleScore, TimesDoesntExist)
 	ExpectLines(m_pPlayerResult, {"There are no times in the specified range"});
 }
 
+TEST_P(SingleScore, LeaderboardMatchesSql)
+{
+	InsertRank(90.0, false, "brainless tee");
+	InsertRank(110.0, false, "brainless tee");
+	InsertRank(95.5, false, "headless tee");
+	InsertRank(120.0, false, "finishless");
+
+	CSqlLeaderboardRequest LeaderboardRequest(std::make_shared<CScoreLeaderboardResult>());
+	str_copy(LeaderboardRequest.m_aMap, "Kobra 3", sizeof(LeaderboardRequest.m_aMap));
+
+	for(const char *pServer : {"GER", "USA"})
+	{
+		str_copy(LeaderboardRequest.m_aServer, pServer, sizeof(LeaderboardRequest.m_aServer));
+		auto pLeaderboards = std::make_shared<CScoreLeaderboardResult>();
+		LeaderboardRequest.m_pResult = pLeaderboards;
+		ASSERT_TRUE(CScoreWorker::LoadLeaderboard(m_pConn, &LeaderboardRequest, m_aError, sizeof(m_aError))) << m_aError;
+		str_copy(m_PlayerRequest.m_aServer, pServer, sizeof(m_PlayerRequest.m_aServer));
+
+		for(bool Regional : {false, true})
+		{
+			g_Config.m_SvRegionalRankings = Regional;
+			for(int Offset : {0, 2, -1, -3})
+			{
+				m_PlayerRequest.m_Offset = Offset;
+				m_pPlayerResult = std::make_shared<CScorePlayerResult>();
+				m_PlayerRequest.m_pResult = m_pPlayerResult;
+				ASSERT_TRUE(CScoreWorker::ShowTop(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+				CScorePlayerResult Cached;
+				CScoreWorker::ShowTopCached(pLeaderboards->m_Global, pLeaderboards->m_Regional, &m_PlayerRequest, &Cached);
+				EXPECT_EQ(Cached.m_MessageKind, m_pPlayerResult->m_MessageKind);
+				for(int i = 0; i < CScorePlayerResult::MAX_MESSAGES; i++)
+					EXPECT_STREQ(Cached.m_Data.m_aaMessages[i], m_pPlayerResult->m_Data.m_aaMessages[i]) << "offset " << Offset;
+			}
+			for(const char *pName : {"nameless tee", "brainless tee", "headless tee", "finishless"})
+			{
+				str_copy(m_PlayerRequest.m_aName, pName, sizeof(m_PlayerRequest.m_aName));
+				m_pPlayerResult = std::make_shared<CScorePlayerResult>();
+				m_PlayerRequest.m_pResult = m_pPlayerResult;
+				ASSERT_TRUE(CScoreWorker::ShowRank(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+				CScorePlayerResult Cached;
+				ASSERT_TRUE(CScoreWorker::ShowRankCached(pLeaderboards->m_Global, pLeaderboards->m_Regional, &m_PlayerRequest, &Cached));
+				EXPECT_EQ(Cached.m_MessageKind, m_pPlayerResult->m_MessageKind);
+				for(int i = 0; i < CScorePlayerResult::MAX_MESSAGES; i++)
+					EXPECT_STREQ(Cached.m_Data.m_aaMessages[i], m_pPlayerResult->m_Data.m_aaMessages[i]) << pName;
+			}
+		}
+	}
+
+	CScorePlayerResult Cached;
+	str_copy(m_PlayerRequest.m_aName, "foo", sizeof(m_PlayerRequest.m_aName));
+	auto *pLeaderboards = dynamic_cast<CScoreLeaderboardResult *>(LeaderboardRequest.m_pResult.get());
+	EXPECT_FALSE(CScoreWorker::ShowRankCached(pLeaderboards->m_Global, pLeaderboards->m_Regional, &m_PlayerRequest, &Cached));
+}
+
+TEST(Leaderboard, Ties)
+{
+	CLeaderboard Leaderboard;
+	Leaderboard.Insert("a", 10.0f);
+	Leaderboard.Insert("b", 12.0f);
+	Leaderboard.Insert("c", 12.0f);
+	Leaderboard.Insert("d", 15.0f);
+	Leaderboard.Insert("d", 20.0f);
+	ASSERT_EQ(Leaderboard.Size(), 4);
+	EXPECT_EQ(Leaderboard.Rank(Leaderboard.Find("a")), 1);
+	EXPECT_EQ(Leaderboard.Rank(Leaderboard.Find("b")), 2);
+	EXPECT_EQ(Leaderboard.Rank(Leaderboard.Find("c")), 2);
+	EXPECT_EQ(Leaderboard.Rank(Leaderboard.Find("d")), 4);
+	EXPECT_EQ(Leaderboard.Get(Leaderboard.Find("d")).m_Time, 15.0f);
+	EXPECT_EQ(Leaderboard.Find("e"), -1);
+
+	// rounded to centiseconds like in the database
+	Leaderboard.Insert("d", 9.999f);
+	EXPECT_EQ(Leaderboard.Get(Leaderboard.Find("d")).m_Time, 10.0f);
+	EXPECT_EQ(Leaderboard.Rank(Leaderboard.Find("d")), 1);
+	EXPECT_EQ(Leaderboard.Rank(Leaderboard.Find("a")), 1);
+	EXPECT_EQ(Leaderboard.Rank(Leaderboard.Find("b")), 3);
+	EXPECT_FLOAT_EQ(Leaderboard.PercentRank(Leaderboard.Find("b")), 2.0f / 3.0f);
+}
+
 struct TeamScore : public Score
 {
 	void SetUp() override
@@ -85,3 +85,175 @@ TEST(Snapshot, CrcOverflow)
 
 	ASSERT_EQ(pSnapshot->Crc(), 1);
 }
+
+static void AddFlag(CSnapshotBuilder &Builder, int Id, int Priority)
+{
+	Builder.SetPriority(Priority);
+	CNetObj_Flag *pFlag = static_cast<CNetObj_Flag *>(Builder.NewItem(CNetObj_Flag::ms_MsgId, Id, sizeof(CNetObj_Flag)));
+	ASSERT_TRUE(pFlag);
+	pFlag->m_X = Id;
+}
+
+TEST(Snapshot, BudgetKeepsImportantItems)
+{
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	AddFlag(Builder, 0, 10);
+	AddFlag(Builder, 1, CSnapshotBuilder::PRIORITY_REQUIRED);
+	AddFlag(Builder, 2, 30);
+	AddFlag(Builder, 3, 20);
+
+	// room for three items with an offset and a flag each
+	const int ItemSize = sizeof(int) + sizeof(CSnapshotItem) + sizeof(CNetObj_Flag);
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnapshot = (CSnapshot *)aData;
+	const int Size = Builder.Finish(pSnapshot, sizeof(CSnapshot) + 3 * ItemSize);
+	EXPECT_EQ(Size, (int)sizeof(CSnapshot) + 3 * ItemSize);
+	EXPECT_EQ(Builder.NumCutItems(), 1);
+	EXPECT_EQ(Builder.CutSize(), ItemSize);
+
+	// the kept items stay in their order
+	ASSERT_EQ(pSnapshot->NumItems(), 3);
+	EXPECT_EQ(pSnapshot->GetItem(0)->Id(), 1);
+	EXPECT_EQ(pSnapshot->GetItem(1)->Id(), 2);
+	EXPECT_EQ(pSnapshot->GetItem(2)->Id(), 3);
+	EXPECT_EQ(((const CNetObj_Flag *)pSnapshot->GetItem(2)->Data())->m_X, 3);
+}
+
+TEST(Snapshot, BudgetKeepsRequiredItems)
+{
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	AddFlag(Builder, 0, CSnapshotBuilder::PRIORITY_REQUIRED);
+	AddFlag(Builder, 1, 1000);
+	AddFlag(Builder, 2, CSnapshotBuilder::PRIORITY_REQUIRED);
+
+	// the budget is smaller than the required items alone
+	const int ItemSize = sizeof(int) + sizeof(CSnapshotItem) + sizeof(CNetObj_Flag);
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnapshot = (CSnapshot *)aData;
+	CSnapshotStarvation Starvation;
+	const int Size = Builder.Finish(pSnapshot, sizeof(CSnapshot) + ItemSize, &Starvation);
+	EXPECT_EQ(Size, (int)sizeof(CSnapshot) + 2 * ItemSize);
+	EXPECT_EQ(Builder.NumCutItems(), 1);
+	ASSERT_EQ(pSnapshot->NumItems(), 2);
+	EXPECT_EQ(pSnapshot->GetItem(0)->Id(), 0);
+	EXPECT_EQ(pSnapshot->GetItem(1)->Id(), 2);
+}
+
+TEST(Snapshot, BudgetCutsWholeGroups)
+{
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	// an entity with a large and a small item, only the small one would fit
+	Builder.SetPriority(20);
+	ASSERT_TRUE(Builder.NewItem(CNetObj_Character::ms_MsgId, 0, sizeof(CNetObj_Character)));
+	ASSERT_TRUE(Builder.NewItem(CNetObj_Flag::ms_MsgId, 0, sizeof(CNetObj_Flag)));
+	AddFlag(Builder, 1, 10);
+
+	const int FlagSize = sizeof(int) + sizeof(CSnapshotItem) + sizeof(CNetObj_Flag);
+	const int CharacterSize = sizeof(int) + sizeof(CSnapshotItem) + sizeof(CNetObj_Character);
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnapshot = (CSnapshot *)aData;
+	CSnapshotStarvation Starvation;
+	Builder.Finish(pSnapshot, sizeof(CSnapshot) + FlagSize, &Starvation);
+	EXPECT_EQ(Builder.NumCutItems(), 2);
+	EXPECT_EQ(Builder.CutSize(), CharacterSize + FlagSize);
+
+	// the less important entity takes the space instead
+	ASSERT_EQ(pSnapshot->NumItems(), 1);
+	EXPECT_EQ(pSnapshot->GetItem(0)->Type(), CNetObj_Flag::ms_MsgId);
+	EXPECT_EQ(pSnapshot->GetItem(0)->Id(), 1);
+
+	// the group is preferred by the key of its first item
+	EXPECT_EQ(Starvation.CutSnapshots((CNetObj_Character::ms_MsgId << 16) | 0), 1);
+	EXPECT_EQ(Starvation.CutSnapshots((CNetObj_Flag::ms_MsgId << 16) | 0), 0);
+}
+
+TEST(Snapshot, BudgetRotatesCutItems)
+{
+	const int ItemSize = sizeof(int) + sizeof(CSnapshotItem) + sizeof(CNetObj_Flag);
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnapshot = (CSnapshot *)aData;
+	CSnapshotStarvation Starvation;
+	CSnapshotBuilder Builder;
+	int aSeen[8] = {0};
+	for(int Snapshot = 0; Snapshot < 50; Snapshot++)
+	{
+		Builder.Init();
+		// the first item is much more important than the other ones
+		for(int i = 0; i < 8; i++)
+			AddFlag(Builder, i, i == 0 ? 100 * CSnapshotBuilder::STARVATION_BOOST : 8 - i);
+		Builder.Finish(pSnapshot, sizeof(CSnapshot) + 4 * ItemSize, &Starvation);
+		ASSERT_EQ(pSnapshot->NumItems(), 4);
+		EXPECT_EQ(pSnapshot->GetItem(0)->Id(), 0);
+		for(int i = 0; i < pSnapshot->NumItems(); i++)
+			aSeen[pSnapshot->GetItem(i)->Id()]++;
+	}
+	for(int i = 0; i < 8; i++)
+		EXPECT_GE(aSeen[i], 10) << "item " << i;
+	EXPECT_EQ(Starvation.CutSnapshots(0), 0);
+
+	// everything fits again
+	Builder.Init();
+	AddFlag(Builder, 0, 1);
+	Builder.Finish(pSnapshot, CSnapshot::MAX_SIZE, &Starvation);
+	EXPECT_EQ(Builder.NumCutItems(), 0);
+	for(int i = 0; i < 8; i++)
+		EXPECT_EQ(Starvation.CutSnapshots(i), 0);
+}
+
+TEST(Snapshot, BudgetItemLimit)
+{
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	for(int i = 0; i < CSnapshot::MAX_ITEMS; i++)
+		AddFlag(Builder, i, CSnapshotBuilder::PRIORITY_REQUIRED);
+	// required items have to fit into the snapshot, the other ones are cut
+	EXPECT_FALSE(Builder.NewItem(CNetObj_Flag::ms_MsgId, CSnapshot::MAX_ITEMS, sizeof(CNetObj_Flag)));
+	AddFlag(Builder, CSnapshot::MAX_ITEMS, 1);
+
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnapshot = (CSnapshot *)aData;
+	Builder.Finish(pSnapshot);
+	EXPECT_EQ(pSnapshot->NumItems(), CSnapshot::MAX_ITEMS);
+	EXPECT_EQ(Builder.NumCutItems(), 1);
+	EXPECT_EQ(pSnapshot->GetItem(CSnapshot::MAX_ITEMS - 1)->Id(), CSnapshot::MAX_ITEMS - 1);
+}
+
+TEST(Snapshot, ReuseItemsUntilUpdate)
+{
+	char aPrevious[CSnapshot::MAX_SIZE];
+	CSnapshot *pPrevious = (CSnapshot *)aPrevious;
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnapshot = (CSnapshot *)aData;
+	CSnapshotBuilder Builder;
+
+	Builder.Init();
+	AddFlag(Builder, 0, 1);
+	AddFlag(Builder, 4, 1);
+	Builder.Finish(pPrevious);
+
+	// the item with the update period keeps its previous data until the
+	// next period starts, the other item is always updated
+	int aUpdates[2] = {0};
+	for(int Tick = 1; Tick <= 8; Tick++)
+	{
+		Builder.Init();
+		AddFlag(Builder, 0, 1);
+		Builder.SetUpdatePeriod(4);
+		AddFlag(Builder, 4, 1);
+		((CNetObj_Flag *)Builder.GetItemData((CNetObj_Flag::ms_MsgId << 16) | 0))->m_Y = Tick;
+		((CNetObj_Flag *)Builder.GetItemData((CNetObj_Flag::ms_MsgId << 16) | 4))->m_Y = Tick;
+		const int StaleSize = Builder.ReuseItems(pPrevious, Tick - 1, Tick);
+		Builder.Finish(pSnapshot);
+
+		const bool Updated = Tick % 4 == 0;
+		EXPECT_EQ(StaleSize, Updated ? 0 : (int)sizeof(CNetObj_Flag)) << "tick " << Tick;
+		aUpdates[0] += ((const CNetObj_Flag *)pSnapshot->FindItem(CNetObj_Flag::ms_MsgId, 0))->m_Y == Tick;
+		aUpdates[1] += ((const CNetObj_Flag *)pSnapshot->FindItem(CNetObj_Flag::ms_MsgId, 4))->m_Y == Tick;
+		mem_copy(aPrevious, aData, CSnapshot::MAX_SIZE);
+	}
+	EXPECT_EQ(aUpdates[0], 8);
+	EXPECT_EQ(aUpdates[1], 2);
+}
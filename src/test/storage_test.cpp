@@ -0,0 +1,118 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/storage.h>
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+
+static void WriteFile(IStorage *pStorage, const char *pFilename)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_close(File);
+}
+
+// Writes a file without going through the storage, like another process would.
+static void WriteFileExternally(IStorage *pStorage, const char *pFilename)
+{
+	char aPath[IO_MAX_PATH_LENGTH];
+	pStorage->GetCompletePath(IStorage::TYPE_SAVE, pFilename, aPath, sizeof(aPath));
+	IOHANDLE File = io_open(aPath, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_close(File);
+}
+
+static void RemoveFileExternally(IStorage *pStorage, const char *pFilename)
+{
+	char aPath[IO_MAX_PATH_LENGTH];
+	pStorage->GetCompletePath(IStorage::TYPE_SAVE, pFilename, aPath, sizeof(aPath));
+	ASSERT_EQ(fs_remove(aPath), 0);
+}
+
+static int CollectNames(const char *pName, int IsDir, int Type, void *pUser)
+{
+	if(pName[0] != '.')
+		static_cast<std::set<std::string> *>(pUser)->emplace(pName);
+	return 0;
+}
+
+static void TestLookups(IStorage *pStorage)
+{
+	ASSERT_TRUE(pStorage->CreateFolder("index", IStorage::TYPE_SAVE));
+	ASSERT_TRUE(pStorage->CreateFolder("index/a", IStorage::TYPE_SAVE));
+	ASSERT_TRUE(pStorage->CreateFolder("index/a/b", IStorage::TYPE_SAVE));
+	WriteFile(pStorage, "index/a/b/x.txt");
+
+	char aFound[IO_MAX_PATH_LENGTH];
+	ASSERT_TRUE(pStorage->FindFile("x.txt", "index", IStorage::TYPE_SAVE, aFound, sizeof(aFound)));
+	EXPECT_STREQ(aFound, "index/a/b/x.txt");
+	EXPECT_FALSE(pStorage->FindFile("y.txt", "index", IStorage::TYPE_SAVE, aFound, sizeof(aFound)));
+	EXPECT_STREQ(aFound, "");
+
+	// changes made behind the storage's back are noticed too
+	WriteFileExternally(pStorage, "index/a/y.txt");
+	ASSERT_TRUE(pStorage->FindFile("y.txt", "index", IStorage::TYPE_SAVE, aFound, sizeof(aFound)));
+	EXPECT_STREQ(aFound, "index/a/y.txt");
+
+	std::set<std::string> Names;
+	pStorage->ListDirectory(IStorage::TYPE_SAVE, "index/a", CollectNames, &Names);
+	EXPECT_EQ(Names, (std::set<std::string>{"b", "y.txt"}));
+
+	RemoveFileExternally(pStorage, "index/a/y.txt");
+	EXPECT_FALSE(pStorage->FindFile("y.txt", "index", IStorage::TYPE_SAVE, aFound, sizeof(aFound)));
+
+	ASSERT_TRUE(pStorage->RenameFile("index/a/b/x.txt", "index/a/y.txt", IStorage::TYPE_SAVE));
+	std::set<std::string> Entries;
+	EXPECT_EQ(pStorage->FindFiles("y.txt", "index", IStorage::TYPE_SAVE, &Entries), 1u);
+	EXPECT_EQ(Entries, (std::set<std::string>{"index/a/y.txt"}));
+	EXPECT_FALSE(pStorage->FindFile("x.txt", "index", IStorage::TYPE_SAVE, aFound, sizeof(aFound)));
+
+	Names.clear();
+	pStorage->ListDirectory(IStorage::TYPE_SAVE, "index/a/", CollectNames, &Names);
+	EXPECT_EQ(Names, (std::set<std::string>{"b", "y.txt"}));
+
+	EXPECT_TRUE(pStorage->RemoveFile("index/a/y.txt", IStorage::TYPE_SAVE));
+	Names.clear();
+	pStorage->ListDirectory(IStorage::TYPE_SAVE, "index/a", CollectNames, &Names);
+	EXPECT_EQ(Names, (std::set<std::string>{"b"}));
+}
+
+TEST(Storage, IndexedLookups)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+	TestLookups(pStorage.get());
+}
+
+TEST(Storage, UnindexedLookups)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+	pStorage->SetIndexEnabled(false);
+	TestLookups(pStorage.get());
+}
+
+TEST(Storage, ListDirectoryAll)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+
+	// the data directory is also a storage path, its maps show up once
+	std::set<std::string> Names;
+	pStorage->ListDirectory(IStorage::TYPE_ALL, "maps", CollectNames, &Names);
+	EXPECT_EQ(Names.count("coverage.map"), 1u);
+
+	char aFound[IO_MAX_PATH_LENGTH];
+	ASSERT_TRUE(pStorage->FindFile("coverage.map", "maps", IStorage::TYPE_ALL, aFound, sizeof(aFound)));
+	EXPECT_STREQ(aFound, "maps/coverage.map");
+}
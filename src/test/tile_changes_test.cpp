@@ -0,0 +1,80 @@
+#include <base/system.h>
+
+#include <game/mapitems.h>
+#include <game/prng.h>
+#include <game/tile_changes.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+static bool SameTiles(const std::vector<CTile> &vTiles, const std::vector<CTile> &vOther)
+{
+	return vTiles.size() == vOther.size() && mem_comp(vTiles.data(), vOther.data(), vTiles.size() * sizeof(CTile)) == 0;
+}
+
+TEST(TileChanges, UndoRedo)
+{
+	const int Width = 100;
+	const int Height = 70;
+	std::vector<CTile> vTiles(Width * Height);
+	CPrng Prng;
+	uint64_t aSeed[2] = {1, 2};
+	Prng.Seed(aSeed);
+	for(CTile &Tile : vTiles)
+		Tile.m_Index = Prng.RandomBits() % 4;
+	const std::vector<CTile> vBefore = vTiles;
+
+	CTileChanges Changes;
+	EXPECT_TRUE(Changes.Empty());
+	for(int i = 0; i < 2000; i++)
+	{
+		const int x = Prng.RandomBits() % Width;
+		const int y = Prng.RandomBits() % Height;
+		CTile Tile = {(unsigned char)(Prng.RandomBits() % 8), (unsigned char)(Prng.RandomBits() % 2)};
+		Changes.Record(x, y, vTiles[y * Width + x], Tile);
+		vTiles[y * Width + x] = Tile;
+	}
+	const std::vector<CTile> vAfter = vTiles;
+	int NumChanged = 0;
+	for(int i = 0; i < Width * Height; i++)
+		NumChanged += vTiles[i].m_Index != vBefore[i].m_Index || vTiles[i].m_Flags != vBefore[i].m_Flags;
+	EXPECT_GE(Changes.NumChanges(), NumChanged);
+	EXPECT_LE(Changes.NumChanges(), 2000);
+
+	CTileChanges Moved = std::move(Changes);
+	EXPECT_TRUE(Changes.Empty());
+	Moved.Compress();
+	Moved.Apply(vTiles.data(), Width, Height, true);
+	EXPECT_TRUE(SameTiles(vTiles, vBefore));
+	Moved.Apply(vTiles.data(), Width, Height, false);
+	EXPECT_TRUE(SameTiles(vTiles, vAfter));
+}
+
+TEST(TileChanges, Fill)
+{
+	const int Size = 1000;
+	std::vector<CTile> vTiles(Size * Size);
+	CTile Fill = {TILE_SOLID};
+
+	CTileChanges Changes;
+	for(int y = 0; y < Size; y++)
+	{
+		for(int x = 0; x < Size; x++)
+		{
+			Changes.Record(x, y, vTiles[y * Size + x], Fill);
+			vTiles[y * Size + x] = Fill;
+		}
+	}
+	const size_t RecordingUsage = Changes.MemoryUsage();
+	Changes.Compress();
+	EXPECT_EQ(Changes.NumChanges(), Size * Size);
+
+	// a run per chunk, no matter the size of the fill
+	const int NumChunks = (Size + CTileChanges::CHUNK_SIZE - 1) / CTileChanges::CHUNK_SIZE;
+	EXPECT_LT(Changes.MemoryUsage(), (size_t)NumChunks * NumChunks * 128);
+	EXPECT_LT(Changes.MemoryUsage(), RecordingUsage);
+
+	Changes.Apply(vTiles.data(), Size, Size, true);
+	EXPECT_TRUE(SameTiles(vTiles, std::vector<CTile>(Size * Size)));
+}
@@ -0,0 +1,644 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/message.h>
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/protocol_ex.h>
+#include <engine/shared/snapshot.h>
+#include <engine/shared/uuid_manager.h>
+
+#include <generated/protocol.h>
+#include <game/version.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static const char *TOOL_NAME = "bot_swarm";
+
+// one line of an input script: hold the given input for a number of ticks
+struct CScriptStep
+{
+	int m_Ticks;
+	int m_Direction;
+	int m_Jump;
+	int m_Fire;
+	int m_Hook;
+	int m_TargetX;
+	int m_TargetY;
+};
+
+static bool LoadScript(const char *pFilename, std::vector<CScriptStep> &vSteps)
+{
+	IOHANDLE File = io_open(pFilename, IOFLAG_READ);
+	if(!File)
+	{
+		log_error(TOOL_NAME, "failed to open input script '%s'", pFilename);
+		return false;
+	}
+	char *pScript = io_read_all_str(File);
+	io_close(File);
+	if(!pScript)
+	{
+		log_error(TOOL_NAME, "failed to read input script '%s'", pFilename);
+		return false;
+	}
+
+	int LineNumber = 0;
+	const char *pLine = pScript;
+	while(pLine && *pLine)
+	{
+		char aLine[256];
+		const char *pNext = str_next_token(pLine, "\n", aLine, sizeof(aLine));
+		LineNumber++;
+		pLine = pNext;
+		if(aLine[0] == '\0' || aLine[0] == '#')
+			continue;
+
+		CScriptStep Step;
+		if(sscanf(aLine, "%d %d %d %d %d %d %d", &Step.m_Ticks, &Step.m_Direction, &Step.m_Jump, &Step.m_Fire, &Step.m_Hook, &Step.m_TargetX, &Step.m_TargetY) != 7 || Step.m_Ticks <= 0)
+		{
+			log_error(TOOL_NAME, "%s:%d: expected '<ticks> <direction> <jump> <fire> <hook> <target x> <target y>'", pFilename, LineNumber);
+			free(pScript);
+			return false;
+		}
+		vSteps.push_back(Step);
+	}
+	free(pScript);
+
+	if(vSteps.empty())
+	{
+		log_error(TOOL_NAME, "input script '%s' is empty", pFilename);
+		return false;
+	}
+	return true;
+}
+
+class CBot
+{
+public:
+	enum
+	{
+		STATE_CONNECTING,
+		STATE_LOADING,
+		STATE_READY,
+		STATE_INGAME,
+		STATE_OFFLINE,
+	};
+
+	int m_Id;
+	int m_State = STATE_CONNECTING;
+	CNetClient m_NetClient;
+
+	bool m_DownloadMap = true;
+	int m_MapChunk = 0;
+	int64_t m_MapBytes = 0;
+
+	// snapshot assembly, we only track which parts arrived and never decode them
+	int m_CurrentRecvTick = -1;
+	uint64_t m_SnapshotParts = 0;
+	int m_AckGameTick = -1;
+	int m_FirstGameTick = -1;
+	int64_t m_FirstGameTickTime = 0;
+	int64_t m_LastSnapshotTime = 0;
+	int64_t m_SnapshotBytes = 0;
+	int m_NumSnapshots = 0;
+
+	// input timing
+	int m_PredMargin = 2;
+	int64_t m_LastMarginChange = 0;
+	int m_LastInputTick = -1;
+	std::vector<int> m_vTimeLeft;
+	// send time of the input for each predicted tick, to measure the latency until a snapshot covers it
+	std::vector<std::pair<int, int64_t>> m_vPendingInputs;
+	std::vector<int64_t> m_vLatencies;
+
+	// input generation
+	const std::vector<CScriptStep> *m_pScript = nullptr;
+	int m_ScriptStep = 0;
+	int m_ScriptTicksLeft = 0;
+	CNetObj_PlayerInput m_Input = {};
+	bool m_FireHeld = false;
+
+	explicit CBot(int Id) :
+		m_Id(Id)
+	{
+	}
+
+	void SendMsg(CMsgPacker *pMsg, int Flags)
+	{
+		CPacker Packer;
+		Packer.Reset();
+		Packer.AddInt((pMsg->m_MsgId << 1) | (pMsg->m_System ? 1 : 0));
+		Packer.AddRaw(pMsg->Data(), pMsg->Size());
+
+		CNetChunk Packet;
+		mem_zero(&Packet, sizeof(Packet));
+		Packet.m_ClientId = 0;
+		Packet.m_pData = Packer.Data();
+		Packet.m_DataSize = Packer.Size();
+		if(Flags & MSGFLAG_VITAL)
+			Packet.m_Flags |= NETSENDFLAG_VITAL;
+		if(Flags & MSGFLAG_FLUSH)
+			Packet.m_Flags |= NETSENDFLAG_FLUSH;
+		m_NetClient.Send(&Packet);
+	}
+
+	void SendInfo(const char *pPassword)
+	{
+		CUuid ConnectionId = RandomUuid();
+		CMsgPacker MsgVer(NETMSG_CLIENTVER, true);
+		MsgVer.AddRaw(&ConnectionId, sizeof(ConnectionId));
+		MsgVer.AddInt(DDNET_VERSION_NUMBER);
+		MsgVer.AddString(GAME_NAME " " GAME_RELEASE_VERSION " (bot_swarm)");
+		SendMsg(&MsgVer, MSGFLAG_VITAL);
+
+		CMsgPacker Msg(NETMSG_INFO, true);
+		Msg.AddString(GAME_NETVERSION);
+		Msg.AddString(pPassword);
+		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+
+	void SendReady()
+	{
+		m_State = STATE_READY;
+		CMsgPacker Msg(NETMSG_READY, true);
+		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+
+	void SendMapRequest()
+	{
+		CMsgPacker Msg(NETMSG_REQUEST_MAP_DATA, true);
+		Msg.AddInt(m_MapChunk);
+		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+
+	void SendStartInfo()
+	{
+		char aName[MAX_NAME_LENGTH];
+		str_format(aName, sizeof(aName), "bot %d", m_Id);
+
+		CNetMsg_Cl_StartInfo Msg;
+		Msg.m_pName = aName;
+		Msg.m_pClan = TOOL_NAME;
+		Msg.m_Country = -1;
+		Msg.m_pSkin = "default";
+		Msg.m_UseCustomColor = 0;
+		Msg.m_ColorBody = 0;
+		Msg.m_ColorFeet = 0;
+		CMsgPacker Packer(&Msg);
+		Msg.Pack(&Packer);
+		SendMsg(&Packer, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+
+	// advances the input by the number of ticks since the last sent input
+	void NextInput(int Ticks)
+	{
+		if(m_pScript)
+		{
+			m_ScriptTicksLeft -= Ticks;
+			if(m_ScriptTicksLeft <= 0)
+			{
+				const CScriptStep &Step = (*m_pScript)[m_ScriptStep];
+				m_ScriptStep = (m_ScriptStep + 1) % m_pScript->size();
+				m_ScriptTicksLeft = Step.m_Ticks;
+				m_Input.m_Direction = std::clamp(Step.m_Direction, -1, 1);
+				m_Input.m_Jump = Step.m_Jump != 0;
+				m_Input.m_Hook = Step.m_Hook != 0;
+				m_Input.m_TargetX = Step.m_TargetX;
+				m_Input.m_TargetY = Step.m_TargetY;
+				// the fire field counts presses and releases
+				if((Step.m_Fire != 0) != m_FireHeld)
+				{
+					m_FireHeld = !m_FireHeld;
+					m_Input.m_Fire++;
+				}
+			}
+		}
+		else
+		{
+			if(rand() % 25 == 0)
+				m_Input.m_Direction = rand() % 3 - 1;
+			m_Input.m_Jump = rand() % 20 == 0;
+			if(rand() % 30 == 0)
+				m_Input.m_Hook = !m_Input.m_Hook;
+			if(rand() % 15 == 0)
+				m_Input.m_Fire++;
+			if(rand() % 10 == 0)
+			{
+				m_Input.m_TargetX = rand() % 401 - 200;
+				m_Input.m_TargetY = rand() % 401 - 200;
+			}
+		}
+		if(m_Input.m_TargetX == 0 && m_Input.m_TargetY == 0)
+			m_Input.m_TargetY = -1;
+		m_Input.m_PlayerFlags = PLAYERFLAG_PLAYING;
+	}
+
+	void SendInput(int64_t Now)
+	{
+		if(m_State != STATE_INGAME || m_AckGameTick < 0)
+			return;
+
+		const int PredTick = m_AckGameTick + m_PredMargin;
+		if(PredTick <= m_LastInputTick)
+			return;
+		NextInput(m_LastInputTick < 0 ? 1 : PredTick - m_LastInputTick);
+		m_LastInputTick = PredTick;
+
+		CMsgPacker Msg(NETMSG_INPUT, true);
+		Msg.AddInt(m_AckGameTick);
+		Msg.AddInt(PredTick);
+		Msg.AddInt(sizeof(m_Input));
+		const int *pData = (const int *)&m_Input;
+		for(unsigned i = 0; i < sizeof(m_Input) / sizeof(int); i++)
+			Msg.AddInt(pData[i]);
+		SendMsg(&Msg, MSGFLAG_FLUSH);
+
+		m_vPendingInputs.emplace_back(PredTick, Now);
+	}
+
+	void OnSnapshot(int GameTick, int64_t Now)
+	{
+		m_AckGameTick = GameTick;
+		m_LastSnapshotTime = Now;
+		m_NumSnapshots++;
+		if(m_FirstGameTick < 0)
+		{
+			m_FirstGameTick = GameTick;
+			m_FirstGameTickTime = Now;
+		}
+
+		auto It = m_vPendingInputs.begin();
+		for(; It != m_vPendingInputs.end() && It->first <= GameTick; ++It)
+			m_vLatencies.push_back(Now - It->second);
+		m_vPendingInputs.erase(m_vPendingInputs.begin(), It);
+	}
+
+	void ProcessPacket(CNetChunk *pPacket, int64_t Now)
+	{
+		CUnpacker Unpacker;
+		Unpacker.Reset(pPacket->m_pData, pPacket->m_DataSize);
+		CMsgPacker Packer(NETMSG_EX, true);
+
+		int Msg;
+		bool Sys;
+		CUuid Uuid;
+		int Result = UnpackMessageId(&Msg, &Sys, &Uuid, &Unpacker, &Packer);
+		if(Result == UNPACKMESSAGE_ERROR)
+			return;
+		else if(Result == UNPACKMESSAGE_ANSWER)
+			SendMsg(&Packer, MSGFLAG_VITAL);
+
+		if(!Sys)
+		{
+			if(Msg == NETMSGTYPE_SV_READYTOENTER && m_State == STATE_READY)
+			{
+				CMsgPacker MsgEnter(NETMSG_ENTERGAME, true);
+				SendMsg(&MsgEnter, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+				m_State = STATE_INGAME;
+			}
+			return;
+		}
+
+		if(Msg == NETMSG_MAP_CHANGE)
+		{
+			const char *pMap = Unpacker.GetString(CUnpacker::SANITIZE_CC | CUnpacker::SKIP_START_WHITESPACES);
+			Unpacker.GetInt();
+			const int MapSize = Unpacker.GetInt();
+			if(Unpacker.Error())
+				return;
+			log_debug(TOOL_NAME, "bot %d: map change to '%s' (%d bytes)", m_Id, pMap, MapSize);
+			m_State = STATE_LOADING;
+			m_MapChunk = 0;
+			m_CurrentRecvTick = -1;
+			m_AckGameTick = -1;
+			m_LastInputTick = -1;
+			m_vPendingInputs.clear();
+			if(m_DownloadMap)
+				SendMapRequest();
+			else
+				SendReady();
+		}
+		else if(Msg == NETMSG_MAP_DATA)
+		{
+			if(m_State != STATE_LOADING)
+				return;
+			const int Last = Unpacker.GetInt();
+			Unpacker.GetInt();
+			const int Chunk = Unpacker.GetInt();
+			const int Size = Unpacker.GetInt();
+			Unpacker.GetRaw(Size);
+			if(Unpacker.Error() || Chunk != m_MapChunk)
+				return;
+			m_MapBytes += Size;
+			m_MapChunk++;
+			if(Last)
+				SendReady();
+			else
+				SendMapRequest();
+		}
+		else if(Msg == NETMSG_CON_READY)
+		{
+			SendStartInfo();
+		}
+		else if(Msg == NETMSG_PING)
+		{
+			CMsgPacker MsgReply(NETMSG_PING_REPLY, true);
+			SendMsg(&MsgReply, MSGFLAG_FLUSH);
+		}
+		else if(Msg == NETMSG_INPUTTIMING)
+		{
+			Unpacker.GetInt();
+			const int TimeLeft = Unpacker.GetInt();
+			if(Unpacker.Error())
+				return;
+			m_vTimeLeft.push_back(TimeLeft);
+			// keep the input slightly ahead of the server, like the client's prediction does,
+			// waiting a bit after each change for the timing reports to catch up
+			if(Now - m_LastMarginChange < time_freq() / 2)
+				return;
+			const int TargetTimeLeft = 40;
+			if(TimeLeft < 0 || TimeLeft > 2 * TargetTimeLeft)
+			{
+				m_PredMargin = maximum(1, m_PredMargin + (TargetTimeLeft - TimeLeft) * SERVER_TICK_SPEED / 1000);
+				m_LastMarginChange = Now;
+			}
+		}
+		else if(Msg == NETMSG_SNAP || Msg == NETMSG_SNAPSINGLE || Msg == NETMSG_SNAPEMPTY)
+		{
+			if(m_State < STATE_READY)
+				return;
+
+			const int GameTick = Unpacker.GetInt();
+			Unpacker.GetInt();
+			int NumParts = 1;
+			int Part = 0;
+			if(Msg == NETMSG_SNAP)
+			{
+				NumParts = Unpacker.GetInt();
+				Part = Unpacker.GetInt();
+			}
+			int PartSize = 0;
+			if(Msg != NETMSG_SNAPEMPTY)
+			{
+				Unpacker.GetInt();
+				PartSize = Unpacker.GetInt();
+			}
+			Unpacker.GetRaw(PartSize);
+			if(Unpacker.Error() || NumParts < 1 || NumParts > CSnapshot::MAX_PARTS || Part < 0 || Part >= NumParts || PartSize < 0 || PartSize > MAX_SNAPSHOT_PACKSIZE)
+				return;
+
+			m_SnapshotBytes += PartSize;
+			if(GameTick < m_CurrentRecvTick || GameTick <= m_AckGameTick)
+				return;
+			if(GameTick != m_CurrentRecvTick)
+			{
+				m_SnapshotParts = 0;
+				m_CurrentRecvTick = GameTick;
+			}
+			m_SnapshotParts |= (uint64_t)1 << Part;
+			const uint64_t AllParts = NumParts == CSnapshot::MAX_PARTS ? ~(uint64_t)0 : ((uint64_t)1 << NumParts) - 1;
+			if(m_SnapshotParts == AllParts)
+				OnSnapshot(GameTick, Now);
+		}
+	}
+
+	void Update(int64_t Now)
+	{
+		if(m_State == STATE_OFFLINE)
+			return;
+
+		m_NetClient.Update();
+		if(m_NetClient.State() == NETSTATE_OFFLINE)
+		{
+			log_error(TOOL_NAME, "bot %d: disconnected (%s)", m_Id, m_NetClient.ErrorString());
+			m_State = STATE_OFFLINE;
+			return;
+		}
+
+		CNetChunk Packet;
+		SECURITY_TOKEN ResponseToken;
+		while(m_NetClient.Recv(&Packet, &ResponseToken, false))
+		{
+			if(Packet.m_ClientId == -1)
+				continue;
+			ProcessPacket(&Packet, Now);
+		}
+	}
+};
+
+template<typename T>
+static T Percentile(const std::vector<T> &vSorted, double Fraction)
+{
+	if(vSorted.empty())
+		return T();
+	return vSorted[std::min<size_t>(vSorted.size() - 1, (size_t)(Fraction * vSorted.size()))];
+}
+
+static void Usage(const char *pProgram)
+{
+	log_error(TOOL_NAME, "usage: %s [-n bots] [-t seconds] [-s input_script] [-p password] [--no-download] server[:port] (default port: 8303)", pProgram);
+	log_error(TOOL_NAME, "all bots connect from the same address, so the server needs a high enough sv_connlimit and sv_max_clients_per_ip");
+	log_error(TOOL_NAME, "input script lines: <ticks> <direction> <jump> <fire> <hook> <target x> <target y>, the script is looped");
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+
+	log_set_global_logger_default();
+
+	int NumBots = 16;
+	int Duration = 30;
+	const char *pScriptFile = nullptr;
+	const char *pPassword = "";
+	const char *pServer = nullptr;
+	bool DownloadMap = true;
+	for(int i = 1; i < argc; i++)
+	{
+		if(str_comp(argv[i], "-n") == 0 && i + 1 < argc)
+			NumBots = str_toint(argv[++i]);
+		else if(str_comp(argv[i], "-t") == 0 && i + 1 < argc)
+			Duration = str_toint(argv[++i]);
+		else if(str_comp(argv[i], "-s") == 0 && i + 1 < argc)
+			pScriptFile = argv[++i];
+		else if(str_comp(argv[i], "-p") == 0 && i + 1 < argc)
+			pPassword = argv[++i];
+		else if(str_comp(argv[i], "--no-download") == 0)
+			DownloadMap = false;
+		else if(!pServer && argv[i][0] != '-')
+			pServer = argv[i];
+		else
+		{
+			Usage(argv[0]);
+			return -1;
+		}
+	}
+	if(!pServer || NumBots <= 0 || Duration <= 0)
+	{
+		Usage(argv[0]);
+		return -1;
+	}
+
+	std::vector<CScriptStep> vScript;
+	if(pScriptFile && !LoadScript(pScriptFile, vScript))
+		return -1;
+
+	// the network code reads its timeouts from the config, which isn't loaded here
+	g_Config.m_ConnTimeout = 100;
+	g_Config.m_ConnTimeoutProtection = 1000;
+
+	net_init();
+	CNetBase::Init();
+
+	NETADDR Addr;
+	if(net_host_lookup(pServer, &Addr, NETTYPE_ALL))
+	{
+		log_error(TOOL_NAME, "host lookup failed");
+		return -1;
+	}
+	if(Addr.port == 0)
+		Addr.port = 8303;
+
+	NETADDR BindAddr;
+	mem_zero(&BindAddr, sizeof(BindAddr));
+	BindAddr.type = NETTYPE_ALL;
+
+	std::vector<std::unique_ptr<CBot>> vpBots;
+	for(int i = 0; i < NumBots; i++)
+	{
+		auto pBot = std::make_unique<CBot>(i);
+		if(!pBot->m_NetClient.Open(BindAddr))
+		{
+			log_error(TOOL_NAME, "failed to open socket for bot %d", i);
+			return -1;
+		}
+		pBot->m_DownloadMap = DownloadMap;
+		if(!vScript.empty())
+		{
+			pBot->m_pScript = &vScript;
+			// spread the bots over the script so they don't all move in lockstep
+			pBot->m_ScriptStep = i % vScript.size();
+		}
+		vpBots.push_back(std::move(pBot));
+	}
+
+	log_info(TOOL_NAME, "connecting %d bots to %s for %d seconds", NumBots, pServer, Duration);
+
+	NETSTATS StartStats;
+	net_stats(&StartStats);
+
+	const int64_t Freq = time_freq();
+	const int64_t StartTime = time_get();
+	const int64_t EndTime = StartTime + Duration * Freq;
+	// don't flood the server with connection attempts
+	const int64_t ConnectInterval = Freq / 20;
+	const int64_t InputInterval = Freq / SERVER_TICK_SPEED;
+	int NumConnected = 0;
+	int64_t NextInputTime = StartTime;
+	int64_t LastReportTime = StartTime;
+
+	int64_t Now = StartTime;
+	while(Now < EndTime)
+	{
+		while(NumConnected < NumBots && StartTime + NumConnected * ConnectInterval <= Now)
+		{
+			CBot *pBot = vpBots[NumConnected].get();
+			pBot->m_NetClient.Connect(&Addr, 1);
+			NumConnected++;
+		}
+
+		for(int i = 0; i < NumConnected; i++)
+		{
+			CBot *pBot = vpBots[i].get();
+			const bool WasConnecting = pBot->m_State == CBot::STATE_CONNECTING;
+			pBot->Update(Now);
+			if(WasConnecting && pBot->m_NetClient.State() == NETSTATE_ONLINE)
+			{
+				pBot->m_State = CBot::STATE_LOADING;
+				pBot->SendInfo(pPassword);
+			}
+		}
+
+		if(Now >= NextInputTime)
+		{
+			for(int i = 0; i < NumConnected; i++)
+				vpBots[i]->SendInput(Now);
+			NextInputTime += InputInterval;
+			if(NextInputTime < Now)
+				NextInputTime = Now + InputInterval;
+		}
+
+		if(Now - LastReportTime >= 5 * Freq)
+		{
+			int NumIngame = 0;
+			for(const auto &pBot : vpBots)
+				NumIngame += pBot->m_State == CBot::STATE_INGAME;
+			log_info(TOOL_NAME, "%d/%d bots in game", NumIngame, NumBots);
+			LastReportTime = Now;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		Now = time_get();
+	}
+
+	NETSTATS EndStats;
+	net_stats(&EndStats);
+
+	int NumIngame = 0;
+	int64_t MapBytes = 0;
+	int64_t SnapshotBytes = 0;
+	int NumSnapshots = 0;
+	std::vector<double> vTickRates;
+	std::vector<int> vTimeLeft;
+	std::vector<int64_t> vLatencies;
+	for(const auto &pBot : vpBots)
+	{
+		NumIngame += pBot->m_State == CBot::STATE_INGAME;
+		MapBytes += pBot->m_MapBytes;
+		SnapshotBytes += pBot->m_SnapshotBytes;
+		NumSnapshots += pBot->m_NumSnapshots;
+		if(pBot->m_FirstGameTick >= 0 && pBot->m_AckGameTick > pBot->m_FirstGameTick)
+			vTickRates.push_back((pBot->m_AckGameTick - pBot->m_FirstGameTick) / ((pBot->m_LastSnapshotTime - pBot->m_FirstGameTickTime) / (double)Freq));
+		vTimeLeft.insert(vTimeLeft.end(), pBot->m_vTimeLeft.begin(), pBot->m_vTimeLeft.end());
+		vLatencies.insert(vLatencies.end(), pBot->m_vLatencies.begin(), pBot->m_vLatencies.end());
+		pBot->m_NetClient.Disconnect("bot swarm finished");
+	}
+	std::sort(vTickRates.begin(), vTickRates.end());
+	std::sort(vTimeLeft.begin(), vTimeLeft.end());
+	std::sort(vLatencies.begin(), vLatencies.end());
+
+	const double Seconds = (Now - StartTime) / (double)Freq;
+	log_info(TOOL_NAME, "%d/%d bots in game after %.1fs", NumIngame, NumBots, Seconds);
+	log_info(TOOL_NAME, "network: sent %" PRIu64 " bytes, received %" PRIu64 " bytes, %.1f KiB/s received per bot",
+		EndStats.sent_bytes - StartStats.sent_bytes, EndStats.recv_bytes - StartStats.recv_bytes,
+		(EndStats.recv_bytes - StartStats.recv_bytes) / 1024.0 / Seconds / NumBots);
+	log_info(TOOL_NAME, "payload: %" PRId64 " map bytes, %" PRId64 " snapshot bytes in %d snapshots, %.1f bytes per snapshot",
+		MapBytes, SnapshotBytes, NumSnapshots, NumSnapshots ? SnapshotBytes / (double)NumSnapshots : 0.0);
+	if(!vTickRates.empty())
+	{
+		// the server doesn't expose its tick duration, a server falling behind shows up as a lower tick rate
+		log_info(TOOL_NAME, "server tick rate: min %.2f median %.2f max %.2f (nominal %d)",
+			vTickRates.front(), Percentile(vTickRates, 0.5), vTickRates.back(), SERVER_TICK_SPEED);
+	}
+	if(!vTimeLeft.empty())
+	{
+		log_info(TOOL_NAME, "input time left: p1 %dms p50 %dms p99 %dms",
+			Percentile(vTimeLeft, 0.01), Percentile(vTimeLeft, 0.5), Percentile(vTimeLeft, 0.99));
+	}
+	if(!vLatencies.empty())
+	{
+		const double ToMs = 1000.0 / Freq;
+		log_info(TOOL_NAME, "input to snapshot latency: p50 %.1fms p90 %.1fms p99 %.1fms max %.1fms (%d samples)",
+			Percentile(vLatencies, 0.5) * ToMs, Percentile(vLatencies, 0.9) * ToMs, Percentile(vLatencies, 0.99) * ToMs,
+			vLatencies.back() * ToMs, (int)vLatencies.size());
+	}
+
+	return NumIngame == NumBots ? 0 : 1;
+}
@@ -110,13 +110,12 @@ static void Process(IStorage *pStorage, const char *pMapName, const char *pConfi
 	{
 		if(i == SettingsIndex)
 		{
-			Writer.AddData(TotalLength, pSettings);
+			Writer.AddDataOwned(TotalLength, pSettings);
+			pSettings = nullptr;
 			continue;
 		}
-		unsigned char *pData = (unsigned char *)Reader.GetData(i);
 		int Size = Reader.GetDataSize(i);
-		Writer.AddData(Size, pData);
-		Reader.UnloadData(i);
+		Writer.AddDataOwned(Size, Reader.ReleaseData(i));
 	}
 
 	free(pSettings);
@@ -0,0 +1,95 @@
+#include <base/logger.h>
+#include <base/math.h>
+#include <base/system.h>
+#include <base/time.h>
+
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <memory>
+
+static const char *TOOL_NAME = "demo_slice";
+
+static void Usage()
+{
+	log_error(TOOL_NAME, "Usage: %s <demo> <start> <end> <out demo> [<start> <end> <out demo> ...]", TOOL_NAME);
+	log_error(TOOL_NAME, "Cuts clips out of a demo, start and end are in seconds since the beginning of the demo.");
+}
+
+static int SliceDemo(const char *pDemo, int NumClips, const char **ppClipArgs, IStorage *pStorage)
+{
+	CSnapshotDelta SnapshotDelta;
+	int FirstTick, LastTick;
+	{
+		CDemoPlayer DemoPlayer(&SnapshotDelta, false);
+		if(DemoPlayer.Load(pStorage, nullptr, pDemo, IStorage::TYPE_ALL_OR_ABSOLUTE) == -1)
+		{
+			log_error(TOOL_NAME, "Demo file '%s' failed to load: %s", pDemo, DemoPlayer.ErrorMessage());
+			return -1;
+		}
+		FirstTick = DemoPlayer.Info()->m_Info.m_FirstTick;
+		LastTick = DemoPlayer.Info()->m_Info.m_LastTick;
+		DemoPlayer.Stop();
+	}
+
+	CDemoEditor DemoEditor;
+	DemoEditor.Init(&SnapshotDelta, nullptr, pStorage);
+	int Result = 0;
+	for(int i = 0; i < NumClips; i++)
+	{
+		const char *pStart = ppClipArgs[i * 3];
+		const char *pEnd = ppClipArgs[i * 3 + 1];
+		const char *pOut = ppClipArgs[i * 3 + 2];
+		float Start, End;
+		if(!str_tofloat(pStart, &Start) || !str_tofloat(pEnd, &End) || Start < 0.0f || End <= Start)
+		{
+			log_error(TOOL_NAME, "Invalid clip '%s' to '%s' for '%s'", pStart, pEnd, pOut);
+			Result = -1;
+			continue;
+		}
+		const int StartTick = FirstTick + round_to_int(Start * (float)SERVER_TICK_SPEED);
+		const int EndTick = FirstTick + round_to_int(End * (float)SERVER_TICK_SPEED);
+		if(StartTick > LastTick)
+		{
+			log_error(TOOL_NAME, "Clip '%s' starts after the end of the demo (%.2fs)", pOut, (LastTick - FirstTick) / (float)SERVER_TICK_SPEED);
+			Result = -1;
+			continue;
+		}
+
+		const int64_t SliceStart = time_get();
+		if(!DemoEditor.Slice(pDemo, pOut, StartTick, EndTick, nullptr, nullptr))
+		{
+			log_error(TOOL_NAME, "Failed to write clip '%s'", pOut);
+			Result = -1;
+			continue;
+		}
+		log_info(TOOL_NAME, "Wrote ticks %d to %d to '%s' in %.2fms", StartTick, minimum(EndTick, LastTick), pOut, (time_get() - SliceStart) * 1000.0 / time_freq());
+	}
+	return Result;
+}
+
+int main(int argc, const char *argv[])
+{
+	// Create storage before setting logger to avoid log messages from storage creation
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating local storage");
+		return -1;
+	}
+
+	if(argc < 5 || (argc - 2) % 3 != 0)
+	{
+		Usage();
+		return -1;
+	}
+
+	CNetBase::Init();
+	return SliceDemo(argv[1], (argc - 2) / 3, &argv[2], pStorage.get());
+}
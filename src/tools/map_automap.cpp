@@ -0,0 +1,237 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/engine.h>
+#include <engine/shared/datafile.h>
+#include <engine/storage.h>
+
+#include <game/auto_map_rules.h>
+#include <game/mapitems.h>
+#include <game/mapitems_ex.h>
+#include <game/version.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+static const char *TOOL_NAME = "map_automap";
+
+static const int PHYSICS_LAYER_FLAGS = TILESLAYERFLAG_GAME | TILESLAYERFLAG_TELE | TILESLAYERFLAG_SPEEDUP | TILESLAYERFLAG_FRONT | TILESLAYERFLAG_SWITCH | TILESLAYERFLAG_TUNE;
+
+static void Usage()
+{
+	log_error(TOOL_NAME, "Usage: %s [--all] <map> <out map>", TOOL_NAME);
+	log_error(TOOL_NAME, "       %s --check [--all] <map>", TOOL_NAME);
+	log_error(TOOL_NAME, "Applies the automapper configurations saved in the map to their tile layers.");
+	log_error(TOOL_NAME, "  --check  Do not write a map, exit with 1 if any layer is not automapped");
+	log_error(TOOL_NAME, "  --all    Also process layers which are not set to automatic automapping");
+}
+
+static const CMapItemLayerTilemap *FindTilemap(CDataFileReader &Reader, int GroupId, int LayerId)
+{
+	int GroupsStart, GroupsNum, LayersStart, LayersNum;
+	Reader.GetType(MAPITEMTYPE_GROUP, &GroupsStart, &GroupsNum);
+	Reader.GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
+	if(GroupId < 0 || GroupId >= GroupsNum || LayerId < 0)
+		return nullptr;
+
+	const CMapItemGroup_v1 *pGroup = (CMapItemGroup_v1 *)Reader.GetItem(GroupsStart + GroupId);
+	if(LayerId >= pGroup->m_NumLayers || pGroup->m_StartLayer < 0 || pGroup->m_StartLayer + LayerId >= LayersNum)
+		return nullptr;
+
+	const int LayerIndex = LayersStart + pGroup->m_StartLayer + LayerId;
+	const CMapItemLayer *pLayer = (CMapItemLayer *)Reader.GetItem(LayerIndex);
+	if(pLayer->m_Type != LAYERTYPE_TILES || Reader.GetItemSize(LayerIndex) < (int)(offsetof(CMapItemLayerTilemap, m_Data) + sizeof(int)))
+		return nullptr;
+	return (CMapItemLayerTilemap *)pLayer;
+}
+
+static int AutomapMap(const char *pSourceMap, const char *pDestinationMap, bool Check, bool All, IStorage *pStorage, IEngine *pEngine)
+{
+	CDataFileReader Reader;
+	if(!Reader.Open(pStorage, pSourceMap, IStorage::TYPE_ABSOLUTE))
+	{
+		log_error(TOOL_NAME, "Failed to open source map '%s' for reading", pSourceMap);
+		return -1;
+	}
+
+	int ImagesStart, ImagesNum;
+	Reader.GetType(MAPITEMTYPE_IMAGE, &ImagesStart, &ImagesNum);
+
+	// rules are loaded once per image
+	std::map<int, std::unique_ptr<CAutoMapRules>> RulesByImage;
+	// automapped tile data by data index
+	std::map<int, std::vector<CTile>> ReplacedData;
+	int NumLayers = 0;
+	int NumChangedLayers = 0;
+
+	int ConfigsStart, ConfigsNum;
+	Reader.GetType(MAPITEMTYPE_AUTOMAPPER_CONFIG, &ConfigsStart, &ConfigsNum);
+	for(int i = 0; i < ConfigsNum; i++)
+	{
+		const CMapItemAutoMapperConfig *pConfig = (CMapItemAutoMapperConfig *)Reader.GetItem(ConfigsStart + i);
+		if(pConfig->m_Version != 1 || pConfig->m_AutomapperConfig < 0)
+			continue;
+		if(!All && !(pConfig->m_Flags & CMapItemAutoMapperConfig::FLAG_AUTOMATIC))
+			continue;
+
+		const CMapItemLayerTilemap *pTilemap = FindTilemap(Reader, pConfig->m_GroupId, pConfig->m_LayerId);
+		if(!pTilemap || (pTilemap->m_Flags & PHYSICS_LAYER_FLAGS) || pTilemap->m_Image < 0 || pTilemap->m_Image >= ImagesNum)
+			continue;
+
+		if(pTilemap->m_Version >= CMapItemLayerTilemap::VERSION_TEEWORLDS_TILESKIP)
+		{
+			log_warn(TOOL_NAME, "Skipping layer %d of group %d, tile skipping is not supported", pConfig->m_LayerId, pConfig->m_GroupId);
+			continue;
+		}
+		if(Check && pConfig->m_AutomapperSeed == 0)
+		{
+			log_warn(TOOL_NAME, "Skipping layer %d of group %d, it uses a random seed", pConfig->m_LayerId, pConfig->m_GroupId);
+			continue;
+		}
+
+		auto RulesIt = RulesByImage.find(pTilemap->m_Image);
+		if(RulesIt == RulesByImage.end())
+		{
+			const CMapItemImage *pImage = (CMapItemImage *)Reader.GetItem(ImagesStart + pTilemap->m_Image);
+			const char *pImageName = Reader.GetDataString(pImage->m_ImageName);
+			std::unique_ptr<CAutoMapRules> pRules;
+			if(pImageName != nullptr && pImageName[0] != '\0')
+			{
+				char aPath[IO_MAX_PATH_LENGTH];
+				str_format(aPath, sizeof(aPath), "editor/automap/%s.rules", pImageName);
+				if(pStorage->FileExists(aPath, IStorage::TYPE_ALL))
+				{
+					pRules = std::make_unique<CAutoMapRules>();
+					if(!pRules->Load(pStorage->OpenFile(aPath, IOFLAG_READ, IStorage::TYPE_ALL), aPath))
+						pRules = nullptr;
+				}
+				else
+				{
+					log_warn(TOOL_NAME, "No rules found for image '%s'", pImageName);
+				}
+			}
+			RulesIt = RulesByImage.emplace(pTilemap->m_Image, std::move(pRules)).first;
+		}
+		const CAutoMapRules *pRules = RulesIt->second.get();
+		if(!pRules)
+			continue;
+		if(pConfig->m_AutomapperConfig >= pRules->ConfigNamesNum())
+		{
+			log_warn(TOOL_NAME, "Skipping layer %d of group %d, configuration %d does not exist", pConfig->m_LayerId, pConfig->m_GroupId, pConfig->m_AutomapperConfig);
+			continue;
+		}
+
+		const size_t NumTiles = (size_t)pTilemap->m_Width * pTilemap->m_Height;
+		if(pTilemap->m_Width <= 0 || pTilemap->m_Height <= 0 || ReplacedData.count(pTilemap->m_Data) ||
+			Reader.GetDataSize(pTilemap->m_Data) != (int)(NumTiles * sizeof(CTile)))
+		{
+			log_warn(TOOL_NAME, "Skipping layer %d of group %d, invalid tile data", pConfig->m_LayerId, pConfig->m_GroupId);
+			continue;
+		}
+		const CTile *pTiles = (CTile *)Reader.GetData(pTilemap->m_Data);
+
+		std::vector<CTile> vTiles(pTiles, pTiles + NumTiles);
+		int NumChangedTiles = 0;
+		const auto &&CountChange = [&](int X, int Y, const CTile &Previous, const CTile &Current) {
+			if(Previous.m_Index != Current.m_Index || Previous.m_Flags != Current.m_Flags)
+				NumChangedTiles++;
+		};
+		pRules->Proceed(vTiles.data(), pTilemap->m_Width, pTilemap->m_Height, nullptr, 0, 0, -1, pConfig->m_AutomapperConfig, pConfig->m_AutomapperSeed, 0, 0, CountChange, pEngine);
+
+		NumLayers++;
+		if(NumChangedTiles > 0)
+		{
+			NumChangedLayers++;
+			log_info(TOOL_NAME, "Layer %d of group %d: '%s' changed %d tiles", pConfig->m_LayerId, pConfig->m_GroupId, pRules->GetConfigName(pConfig->m_AutomapperConfig), NumChangedTiles);
+		}
+		ReplacedData.emplace(pTilemap->m_Data, std::move(vTiles));
+	}
+
+	if(Check)
+	{
+		Reader.Close();
+		log_info(TOOL_NAME, "%d of %d automapped layers in '%s' are outdated", NumChangedLayers, NumLayers, pSourceMap);
+		return NumChangedLayers > 0 ? 1 : 0;
+	}
+
+	CDataFileWriter Writer;
+	if(!Writer.Open(pStorage, pDestinationMap, IStorage::TYPE_ABSOLUTE))
+	{
+		log_error(TOOL_NAME, "Failed to open destination map '%s' for writing", pDestinationMap);
+		Reader.Close();
+		return -1;
+	}
+
+	// add all items
+	for(int Index = 0; Index < Reader.NumItems(); Index++)
+	{
+		int Type, Id;
+		CUuid Uuid;
+		const void *pPtr = Reader.GetItem(Index, &Type, &Id, &Uuid);
+
+		// Filter ITEMTYPE_EX items, they will be automatically added again.
+		if(Type == ITEMTYPE_EX)
+		{
+			continue;
+		}
+
+		int Size = Reader.GetItemSize(Index);
+		Writer.AddItem(Type, Id, Size, pPtr, &Uuid);
+	}
+
+	// add all data, replacing the automapped tiles
+	for(int Index = 0; Index < Reader.NumData(); Index++)
+	{
+		auto ReplacedIt = ReplacedData.find(Index);
+		if(ReplacedIt != ReplacedData.end())
+		{
+			Writer.AddData(ReplacedIt->second.size() * sizeof(CTile), ReplacedIt->second.data());
+			continue;
+		}
+		int Size = Reader.GetDataSize(Index);
+		Writer.AddDataOwned(Size, Reader.ReleaseData(Index));
+	}
+
+	Reader.Close();
+	Writer.Finish();
+	log_info(TOOL_NAME, "Automapped %d layers (%d changed) of '%s' to '%s'", NumLayers, NumChangedLayers, pSourceMap, pDestinationMap);
+	return 0;
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	bool Check = false;
+	bool All = false;
+	std::vector<const char *> vpArgs;
+	for(int i = 1; i < argc; i++)
+	{
+		if(str_comp(argv[i], "--check") == 0)
+			Check = true;
+		else if(str_comp(argv[i], "--all") == 0)
+			All = true;
+		else
+			vpArgs.push_back(argv[i]);
+	}
+
+	if(vpArgs.size() != (Check ? 1 : 2))
+	{
+		Usage();
+		return -1;
+	}
+
+	std::unique_ptr<IStorage> pStorage = std::unique_ptr<IStorage>(CreateStorage(IStorage::EInitializationType::BASIC, argc, argv));
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating basic storage");
+		return -1;
+	}
+
+	// only used for its job pool
+	std::unique_ptr<IEngine> pEngine = std::unique_ptr<IEngine>(CreateEngine(GAME_NAME, nullptr));
+
+	return AutomapMap(vpArgs[0], Check ? nullptr : vpArgs[1], Check, All, pStorage.get(), pEngine.get());
+}
@@ -210,14 +210,13 @@ int main(int argc, const char **argv)
 	// add all data
 	for(int Index = 0; Index < g_DataReader.NumData(); Index++)
 	{
-		void *pData = g_DataReader.GetData(Index);
 		int Size = g_DataReader.GetDataSize(Index);
-		g_DataWriter.AddData(Size, pData);
+		g_DataWriter.AddDataOwned(Size, g_DataReader.ReleaseData(Index));
 	}
 
 	for(int Index = 0; Index < g_Index; Index++)
 	{
-		g_DataWriter.AddData(g_aNewDataSize[Index], g_apNewData[Index]);
+		g_DataWriter.AddDataOwned(g_aNewDataSize[Index], g_apNewData[Index]);
 	}
 
 	g_DataReader.Close();
@@ -46,9 +46,8 @@ static int ResaveMap(const char *pSourceMap, const char *pDestinationMap, IStora
 	// add all data
 	for(int Index = 0; Index < Reader.NumData(); Index++)
 	{
-		const void *pPtr = Reader.GetData(Index);
 		int Size = Reader.GetDataSize(Index);
-		Writer.AddData(Size, pPtr);
+		Writer.AddDataOwned(Size, Reader.ReleaseData(Index));
 	}
 
 	Reader.Close();
@@ -0,0 +1,777 @@
+#include <base/hash.h>
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/engine.h>
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/server/antibot.h>
+#include <engine/server/databases/connection_pool.h>
+#include <engine/server/server.h>
+#include <engine/shared/config.h>
+#include <engine/shared/json.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/profiler.h>
+#include <engine/shared/uuid_manager.h>
+#include <engine/storage.h>
+
+#include <generated/protocol.h>
+
+#include <game/gamecore.h>
+#include <game/server/entities/character.h>
+#include <game/server/gamecontext.h>
+#include <game/server/player.h>
+#include <game/version.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const char *TOOL_NAME = "teehistorian_replay";
+
+static volatile sig_atomic_t InterruptSignaled = 0;
+
+bool IsInterrupted()
+{
+	return InterruptSignaled;
+}
+
+std::vector<std::string> FetchAndroidServerCommandQueue()
+{
+	return {};
+}
+
+static void HandleSigInt(int Param)
+{
+	InterruptSignaled = 1;
+	signal(SIGINT, SIG_DFL);
+}
+
+// chunk types, see `game/server/teehistorian.cpp`
+enum
+{
+	TEEHISTORIAN_NONE,
+	TEEHISTORIAN_FINISH,
+	TEEHISTORIAN_TICK_SKIP,
+	TEEHISTORIAN_PLAYER_NEW,
+	TEEHISTORIAN_PLAYER_OLD,
+	TEEHISTORIAN_INPUT_DIFF,
+	TEEHISTORIAN_INPUT_NEW,
+	TEEHISTORIAN_MESSAGE,
+	TEEHISTORIAN_JOIN,
+	TEEHISTORIAN_DROP,
+	TEEHISTORIAN_CONSOLE_COMMAND,
+	TEEHISTORIAN_EX,
+};
+
+static const CUuid TEEHISTORIAN_UUID = CalculateUuid("teehistorian@ddnet.tw");
+
+#define UUID(id, name) static const CUuid UUID_##id = CalculateUuid(name);
+#include <engine/shared/teehistorian_ex_chunks.h>
+#undef UUID
+
+template<typename T>
+static T Percentile(const std::vector<T> &vSorted, double Fraction)
+{
+	if(vSorted.empty())
+		return T();
+	return vSorted[std::min<size_t>(vSorted.size() - 1, (size_t)(Fraction * vSorted.size()))];
+}
+
+// Feeds the recorded joins, inputs, messages and console commands of a
+// teehistorian file into a server that is never connected to the network and
+// advances its ticks as fast as possible.
+//
+// The file records the player positions at the end of each tick, followed by
+// everything that happened before the next tick. Positions are only written
+// when they changed and ticks without any records are skipped.
+class CReplay
+{
+public:
+	CServer *m_pServer;
+	CGameContext *m_pGameServer;
+	bool m_Verify = false;
+	bool m_Snap = false;
+
+	// statistics
+	std::vector<int64_t> m_vTickDurations;
+	int m_VerifiedTicks = 0;
+	int m_MismatchedTicks = 0;
+	int m_FirstMismatchTick = -1;
+	int m_SkippedLoads = 0;
+
+	CReplay(CServer *pServer, CGameContext *pGameServer) :
+		m_pServer(pServer), m_pGameServer(pGameServer)
+	{
+		for(auto &Player : m_aExpected)
+			Player.m_Alive = false;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			m_aHasInput[i] = false;
+			m_aNewInput[i] = false;
+			m_aSixup[i] = false;
+		}
+		m_ProfileFrame = m_pServer->Profiler()->AddSection("frame");
+	}
+
+	// returns false on a malformed file
+	bool Run(const unsigned char *pData, int Size)
+	{
+		m_Unpacker.Reset(pData, Size);
+		while(!IsInterrupted())
+		{
+			const int Type = m_Unpacker.GetInt();
+			if(m_Unpacker.Error())
+			{
+				log_error(TOOL_NAME, "unexpected end of file after tick %d", m_Tick);
+				return false;
+			}
+			if(Type == -TEEHISTORIAN_FINISH)
+			{
+				FlushEnter();
+				if(m_VerifyPending)
+					Verify();
+				return true;
+			}
+			if(!HandleRecord(Type))
+				return false;
+		}
+		return true;
+	}
+
+private:
+	struct CPlayerState
+	{
+		bool m_Alive;
+		int m_X;
+		int m_Y;
+	};
+
+	CUnpacker m_Unpacker;
+
+	// tick of the records that are currently read
+	int m_Tick = 0;
+	// player records are sorted by client id, the tick starts anew once the
+	// order is broken. `MAX_CLIENTS` makes the first record start tick 1
+	int m_LastPlayerId = MAX_CLIENTS;
+	bool m_InInputs = false;
+	bool m_VerifyPending = false;
+
+	CPlayerState m_aExpected[MAX_CLIENTS];
+	CNetObj_PlayerInput m_aInputs[MAX_CLIENTS];
+	bool m_aHasInput[MAX_CLIENTS];
+	bool m_aNewInput[MAX_CLIENTS];
+	bool m_aSixup[MAX_CLIENTS];
+	// the client version is recorded after the client entered the game, but
+	// the game needs to know it while entering
+	int m_PendingEnter = -1;
+
+	int m_ProfileFrame;
+
+	CServer::CClient &Client(int ClientId) { return m_pServer->m_aClients[ClientId]; }
+
+	bool ValidClientId(int ClientId)
+	{
+		if(ClientId >= 0 && ClientId < MAX_CLIENTS)
+			return true;
+		log_error(TOOL_NAME, "invalid client id %d in tick %d", ClientId, m_Tick);
+		return false;
+	}
+
+	void BeginTick(int Tick)
+	{
+		FlushEnter();
+		if(m_VerifyPending)
+			Verify();
+
+		m_Tick = Tick;
+		m_LastPlayerId = -1;
+		m_InInputs = false;
+		while(m_pServer->Tick() < Tick && !IsInterrupted())
+		{
+			SimulateTick();
+			// nothing was recorded for skipped ticks, so nobody moved
+			if(m_Verify && m_pServer->Tick() < Tick)
+				Verify();
+		}
+		m_VerifyPending = m_Verify;
+	}
+
+	void OnPlayerRecord(int ClientId)
+	{
+		if(m_InInputs || ClientId <= m_LastPlayerId)
+			BeginTick(m_Tick + 1);
+		m_LastPlayerId = ClientId;
+	}
+
+	void OnInputRecord()
+	{
+		FlushEnter();
+		if(!m_InInputs && m_VerifyPending)
+			Verify();
+		m_InInputs = true;
+	}
+
+	void SimulateTick()
+	{
+		const std::chrono::nanoseconds Start = time_get_nanoseconds();
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(Client(i).m_State != CServer::CClient::STATE_INGAME || !m_aHasInput[i])
+				continue;
+			if(m_aNewInput[i])
+			{
+				Client(i).m_Inputs.Add((const int *)&m_aInputs[i], sizeof(m_aInputs[i]) / sizeof(int), m_pServer->Tick() + 1, m_pServer->Tick(), 0);
+				m_aNewInput[i] = false;
+			}
+			// clients send their input once per tick
+			m_pGameServer->OnClientDirectInput(i, &m_aInputs[i]);
+		}
+		m_pServer->RunGameTick();
+		if(m_Snap)
+			m_pServer->DoSnapshot();
+		const std::chrono::nanoseconds Duration = time_get_nanoseconds() - Start;
+		m_vTickDurations.push_back(Duration.count());
+		m_pServer->Profiler()->Add(m_ProfileFrame, Duration);
+		m_pServer->Profiler()->EndFrame();
+	}
+
+	void Verify()
+	{
+		m_VerifyPending = false;
+		m_VerifiedTicks++;
+		bool Mismatch = false;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			CPlayer *pPlayer = m_pGameServer->m_apPlayers[i];
+			CCharacter *pChr = pPlayer ? pPlayer->GetCharacter() : nullptr;
+			CNetObj_CharacterCore Core = {};
+			if(pChr)
+				pChr->GetCore().Write(&Core);
+
+			const CPlayerState &Expected = m_aExpected[i];
+			if(Expected.m_Alive == (pChr != nullptr) && (!pChr || (Core.m_X == Expected.m_X && Core.m_Y == Expected.m_Y)))
+				continue;
+
+			if(m_MismatchedTicks < 10)
+			{
+				log_warn(TOOL_NAME, "tick %d: cid=%d recorded %s (%d, %d), replayed %s (%d, %d)", m_pServer->Tick(), i,
+					Expected.m_Alive ? "alive" : "dead", Expected.m_X, Expected.m_Y,
+					pChr ? "alive" : "dead", Core.m_X, Core.m_Y);
+			}
+			Mismatch = true;
+		}
+		if(Mismatch)
+		{
+			if(m_FirstMismatchTick < 0)
+				m_FirstMismatchTick = m_pServer->Tick();
+			m_MismatchedTicks++;
+		}
+	}
+
+	void EnsureConnected(int ClientId)
+	{
+		if(Client(ClientId).m_State == CServer::CClient::STATE_EMPTY)
+			CServer::NewClientCallback(ClientId, m_pServer, m_aSixup[ClientId]);
+		if(Client(ClientId).m_State >= CServer::CClient::STATE_READY)
+			return;
+		Client(ClientId).m_State = CServer::CClient::STATE_READY;
+		m_pGameServer->OnClientConnected(ClientId, nullptr);
+	}
+
+	void FlushEnter()
+	{
+		if(m_PendingEnter < 0)
+			return;
+		const int ClientId = m_PendingEnter;
+		m_PendingEnter = -1;
+		EnsureConnected(ClientId);
+		if(Client(ClientId).m_State == CServer::CClient::STATE_INGAME)
+			return;
+		Client(ClientId).m_State = CServer::CClient::STATE_INGAME;
+		m_pGameServer->OnClientEnter(ClientId);
+	}
+
+	void Drop(int ClientId, const char *pReason)
+	{
+		if(m_PendingEnter == ClientId)
+			m_PendingEnter = -1;
+		if(Client(ClientId).m_State != CServer::CClient::STATE_EMPTY)
+			CServer::DelClientCallback(ClientId, pReason, m_pServer);
+		m_aHasInput[ClientId] = false;
+		m_aNewInput[ClientId] = false;
+		m_aSixup[ClientId] = false;
+	}
+
+	void ConsoleCommand(int ClientId, int FlagMask, const char *pCmd, int NumArgs)
+	{
+		char aLine[1024];
+		str_copy(aLine, pCmd);
+		for(int i = 0; i < NumArgs; i++)
+		{
+			const char *pArg = m_Unpacker.GetString(CUnpacker::SANITIZE_CC);
+			str_append(aLine, " \"");
+			char *pDst = aLine + str_length(aLine);
+			str_escape(&pDst, pArg, aLine + sizeof(aLine) - 2);
+			*pDst = '\0';
+			str_append(aLine, "\"");
+		}
+		if(m_Unpacker.Error())
+			return;
+		// chat commands are run again by replaying the chat message
+		if(FlagMask & CFGFLAG_CHAT)
+			return;
+		m_pGameServer->Console()->ExecuteLineFlag(aLine, FlagMask, ClientId, false);
+	}
+
+	bool HandleEx()
+	{
+		const CUuid *pUuid = (const CUuid *)m_Unpacker.GetRaw(sizeof(CUuid));
+		const int Size = m_Unpacker.GetInt();
+		const unsigned char *pData = Size >= 0 ? m_Unpacker.GetRaw(Size) : nullptr;
+		if(m_Unpacker.Error() || !pData)
+		{
+			log_error(TOOL_NAME, "malformed extra chunk in tick %d", m_Tick);
+			return false;
+		}
+		const CUuid Uuid = *pUuid;
+
+		CUnpacker Ex;
+		Ex.Reset(pData, Size);
+		const int ClientId = Ex.GetInt();
+
+		if(Uuid == UUID_TEEHISTORIAN_DDNETVER || Uuid == UUID_TEEHISTORIAN_DDNETVER_OLD)
+		{
+			if(Ex.Error() || !ValidClientId(ClientId))
+				return false;
+			CServer::CClient &Info = Client(ClientId);
+			if(Uuid == UUID_TEEHISTORIAN_DDNETVER)
+			{
+				const CUuid *pConnectionId = (const CUuid *)Ex.GetRaw(sizeof(CUuid));
+				const int DDNetVersion = Ex.GetInt();
+				const char *pVersionStr = Ex.GetString(CUnpacker::SANITIZE_CC);
+				if(Ex.Error())
+					return false;
+				Info.m_ConnectionId = *pConnectionId;
+				Info.m_DDNetVersion = DDNetVersion;
+				str_copy(Info.m_aDDNetVersionStr, pVersionStr);
+				Info.m_GotDDNetVersionPacket = true;
+			}
+			else
+			{
+				Info.m_DDNetVersion = Ex.GetInt();
+			}
+			Info.m_DDNetVersionSettled = true;
+			if(m_PendingEnter == ClientId)
+				FlushEnter();
+			return true;
+		}
+
+		OnInputRecord();
+		if(Uuid == UUID_TEEHISTORIAN_JOINVER6 || Uuid == UUID_TEEHISTORIAN_JOINVER7)
+		{
+			if(Ex.Error() || !ValidClientId(ClientId))
+				return false;
+			m_aSixup[ClientId] = Uuid == UUID_TEEHISTORIAN_JOINVER7;
+		}
+		else if(Uuid == UUID_TEEHISTORIAN_PLAYER_READY)
+		{
+			if(Ex.Error() || !ValidClientId(ClientId))
+				return false;
+			m_PendingEnter = ClientId;
+		}
+		else if(Uuid == UUID_TEEHISTORIAN_PLAYER_REJOIN)
+		{
+			if(Ex.Error() || !ValidClientId(ClientId))
+				return false;
+			if(Client(ClientId).m_State != CServer::CClient::STATE_EMPTY)
+				CServer::ClientRejoinCallback(ClientId, m_pServer);
+		}
+		else if(Uuid == UUID_TEEHISTORIAN_LOAD_SUCCESS)
+		{
+			// the save comes from the database and can't be restored here
+			m_SkippedLoads++;
+		}
+		// everything else is a consequence of the replayed inputs
+		return true;
+	}
+
+	bool HandleRecord(int Type)
+	{
+		if(Type >= 0)
+		{
+			const int ClientId = Type;
+			const int Dx = m_Unpacker.GetInt();
+			const int Dy = m_Unpacker.GetInt();
+			if(m_Unpacker.Error() || !ValidClientId(ClientId))
+				return false;
+			OnPlayerRecord(ClientId);
+			m_aExpected[ClientId].m_X += Dx;
+			m_aExpected[ClientId].m_Y += Dy;
+			return true;
+		}
+
+		switch(-Type)
+		{
+		case TEEHISTORIAN_TICK_SKIP:
+		{
+			const int Skip = m_Unpacker.GetInt();
+			if(m_Unpacker.Error() || Skip < 0)
+				return false;
+			BeginTick(m_Tick + Skip + 1);
+			return true;
+		}
+		case TEEHISTORIAN_PLAYER_NEW:
+		{
+			const int ClientId = m_Unpacker.GetInt();
+			const int X = m_Unpacker.GetInt();
+			const int Y = m_Unpacker.GetInt();
+			if(m_Unpacker.Error() || !ValidClientId(ClientId))
+				return false;
+			OnPlayerRecord(ClientId);
+			m_aExpected[ClientId] = {true, X, Y};
+			return true;
+		}
+		case TEEHISTORIAN_PLAYER_OLD:
+		{
+			const int ClientId = m_Unpacker.GetInt();
+			if(m_Unpacker.Error() || !ValidClientId(ClientId))
+				return false;
+			OnPlayerRecord(ClientId);
+			m_aExpected[ClientId].m_Alive = false;
+			return true;
+		}
+		case TEEHISTORIAN_INPUT_DIFF:
+		case TEEHISTORIAN_INPUT_NEW:
+		{
+			const int ClientId = m_Unpacker.GetInt();
+			int aInput[sizeof(CNetObj_PlayerInput) / sizeof(int)];
+			for(int &Value : aInput)
+				Value = m_Unpacker.GetInt();
+			if(m_Unpacker.Error() || !ValidClientId(ClientId))
+				return false;
+			OnInputRecord();
+			int *pInput = (int *)&m_aInputs[ClientId];
+			for(size_t i = 0; i < std::size(aInput); i++)
+				pInput[i] = (-Type == TEEHISTORIAN_INPUT_DIFF ? pInput[i] : 0) + aInput[i];
+			m_aHasInput[ClientId] = true;
+			m_aNewInput[ClientId] = true;
+			return true;
+		}
+		case TEEHISTORIAN_MESSAGE:
+		{
+			const int ClientId = m_Unpacker.GetInt();
+			const int Size = m_Unpacker.GetInt();
+			const unsigned char *pMsg = Size >= 0 ? m_Unpacker.GetRaw(Size) : nullptr;
+			if(m_Unpacker.Error() || !pMsg || !ValidClientId(ClientId))
+				return false;
+			OnInputRecord();
+			CUnpacker Msg;
+			Msg.Reset(pMsg, Size);
+			const int MsgId = Msg.GetInt();
+			if(Msg.Error() || (MsgId & 1))
+				return true;
+			EnsureConnected(ClientId);
+			m_pGameServer->OnMessage(MsgId >> 1, &Msg, ClientId);
+			return true;
+		}
+		case TEEHISTORIAN_JOIN:
+		{
+			const int ClientId = m_Unpacker.GetInt();
+			if(m_Unpacker.Error() || !ValidClientId(ClientId))
+				return false;
+			OnInputRecord();
+			m_aHasInput[ClientId] = false;
+			m_aNewInput[ClientId] = false;
+			CServer::NewClientCallback(ClientId, m_pServer, m_aSixup[ClientId]);
+			return true;
+		}
+		case TEEHISTORIAN_DROP:
+		{
+			const int ClientId = m_Unpacker.GetInt();
+			const char *pReason = m_Unpacker.GetString();
+			if(m_Unpacker.Error() || !ValidClientId(ClientId))
+				return false;
+			OnInputRecord();
+			Drop(ClientId, pReason);
+			return true;
+		}
+		case TEEHISTORIAN_CONSOLE_COMMAND:
+		{
+			const int ClientId = m_Unpacker.GetInt();
+			const int FlagMask = m_Unpacker.GetInt();
+			const char *pCmd = m_Unpacker.GetString(CUnpacker::SANITIZE_CC);
+			const int NumArgs = m_Unpacker.GetInt();
+			if(m_Unpacker.Error() || NumArgs < 0)
+				return false;
+			OnInputRecord();
+			char aCmd[128];
+			str_copy(aCmd, pCmd);
+			ConsoleCommand(ClientId, FlagMask, aCmd, NumArgs);
+			return !m_Unpacker.Error();
+		}
+		case TEEHISTORIAN_EX:
+			return HandleEx();
+		default:
+			log_error(TOOL_NAME, "unknown chunk type %d in tick %d", -Type, m_Tick);
+			return false;
+		}
+	}
+};
+
+static void ApplyConfig(IConsole *pConsole, const json_value *pConfig)
+{
+	if(pConfig->type != json_object)
+		return;
+	for(unsigned i = 0; i < pConfig->u.object.length; i++)
+	{
+		const char *pName = pConfig->u.object.values[i].name;
+		const char *pValue = json_string_get(pConfig->u.object.values[i].value);
+		// the replay itself must not be recorded again
+		if(!pValue || str_comp(pName, "sv_tee_historian") == 0)
+			continue;
+		char aLine[1024];
+		str_format(aLine, sizeof(aLine), "%s \"", pName);
+		char *pDst = aLine + str_length(aLine);
+		str_escape(&pDst, pValue, aLine + sizeof(aLine) - 2);
+		*pDst = '\0';
+		str_append(aLine, "\"");
+		pConsole->ExecuteLine(aLine, IConsole::CLIENT_ID_UNSPECIFIED);
+	}
+}
+
+static void ApplyTuning(CTuningParams *pTuning, const json_value *pTuningJson)
+{
+	if(pTuningJson->type != json_object)
+		return;
+	for(unsigned i = 0; i < pTuningJson->u.object.length; i++)
+	{
+		const char *pValue = json_string_get(pTuningJson->u.object.values[i].value);
+		if(!pValue)
+			continue;
+		// recorded as fixed point, set it without going through a float
+		for(int Index = 0; Index < CTuningParams::Num(); Index++)
+		{
+			if(str_comp(CTuningParams::Name(Index), pTuningJson->u.object.values[i].name) == 0)
+				((CTuneParam *)pTuning)[Index].Set(str_toint(pValue));
+		}
+	}
+}
+
+static void Usage(const char *pProgram)
+{
+	log_error(TOOL_NAME, "usage: %s [--verify] [--snap] [-m map] [--log] file.teehistorian", pProgram);
+	log_error(TOOL_NAME, "  --verify  compare the replayed player positions with the recorded ones after every tick");
+	log_error(TOOL_NAME, "  --snap    also create a snapshot every tick like the server does");
+	log_error(TOOL_NAME, "  -m map    load maps/<map>.map instead of the map named in the file");
+	log_error(TOOL_NAME, "  --log     show the log output of the server");
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+
+	ILogger *pLogger = log_logger_stdout().release();
+	log_set_global_logger(pLogger);
+
+	bool Verify = false;
+	bool Snap = false;
+	bool ShowLog = false;
+	const char *pMapOverride = nullptr;
+	const char *pFilename = nullptr;
+	for(int i = 1; i < argc; i++)
+	{
+		if(str_comp(argv[i], "--verify") == 0)
+			Verify = true;
+		else if(str_comp(argv[i], "--snap") == 0)
+			Snap = true;
+		else if(str_comp(argv[i], "--log") == 0)
+			ShowLog = true;
+		else if(str_comp(argv[i], "-m") == 0 && i + 1 < argc)
+			pMapOverride = argv[++i];
+		else if(!pFilename && argv[i][0] != '-')
+			pFilename = argv[i];
+		else
+		{
+			Usage(argv[0]);
+			return -1;
+		}
+	}
+	if(!pFilename)
+	{
+		Usage(argv[0]);
+		return -1;
+	}
+
+	IOHANDLE File = io_open(pFilename, IOFLAG_READ);
+	void *pFileData = nullptr;
+	unsigned FileSize = 0;
+	if(!File || !io_read_all(File, &pFileData, &FileSize))
+	{
+		if(File)
+			io_close(File);
+		log_error(TOOL_NAME, "failed to read '%s'", pFilename);
+		return -1;
+	}
+	io_close(File);
+	std::unique_ptr<unsigned char, decltype(&free)> pData((unsigned char *)pFileData, &free);
+
+	// the header is a null terminated json object after the uuid
+	const unsigned char *pHeaderEnd = FileSize > sizeof(CUuid) ? (const unsigned char *)memchr(pData.get() + sizeof(CUuid), 0, FileSize - sizeof(CUuid)) : nullptr;
+	if(!pHeaderEnd || mem_comp(pData.get(), &TEEHISTORIAN_UUID, sizeof(CUuid)) != 0)
+	{
+		log_error(TOOL_NAME, "'%s' is not a teehistorian file", pFilename);
+		return -1;
+	}
+	const char *pHeader = (const char *)pData.get() + sizeof(CUuid);
+	json_value *pJson = json_parse(pHeader, pHeaderEnd - (const unsigned char *)pHeader);
+	if(!pJson || pJson->type != json_object)
+	{
+		log_error(TOOL_NAME, "failed to parse the header of '%s'", pFilename);
+		if(pJson)
+			json_value_free(pJson);
+		return -1;
+	}
+	const char *pMapName = json_string_get(json_object_get(pJson, "map_name"));
+	const char *pMapSha256 = json_string_get(json_object_get(pJson, "map_sha256"));
+	const char *pPrngDescription = json_string_get(json_object_get(pJson, "prng_description"));
+	if(pMapOverride)
+		pMapName = pMapOverride;
+	if(!pMapName)
+	{
+		log_error(TOOL_NAME, "no map name in the header, use -m");
+		json_value_free(pJson);
+		return -1;
+	}
+
+	signal(SIGINT, HandleSigInt);
+	if(!ShowLog)
+		pLogger->SetFilter(CLogFilter{LEVEL_WARN});
+
+	CServer *pServer = CreateServer();
+	std::unique_ptr<IKernel> pKernel(IKernel::Create());
+	pKernel->RegisterInterface(pServer);
+
+	IEngine *pEngine = CreateEngine(GAME_NAME, nullptr);
+	pKernel->RegisterInterface(pEngine);
+
+	IStorage *pStorage = CreateStorage(IStorage::EInitializationType::SERVER, argc, argv);
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "failed to initialize storage");
+		json_value_free(pJson);
+		return -1;
+	}
+	pKernel->RegisterInterface(pStorage);
+
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER | CFGFLAG_ECON).release();
+	pKernel->RegisterInterface(pConsole);
+
+	IConfigManager *pConfigManager = CreateConfigManager();
+	pKernel->RegisterInterface(pConfigManager);
+
+	IEngineMap *pEngineMap = CreateEngineMap();
+	pKernel->RegisterInterface(pEngineMap);
+	pKernel->RegisterInterface(static_cast<IMap *>(pEngineMap), false);
+
+	IEngineAntibot *pEngineAntibot = CreateEngineAntibot();
+	pKernel->RegisterInterface(pEngineAntibot);
+	pKernel->RegisterInterface(static_cast<IAntibot *>(pEngineAntibot), false);
+
+	CGameContext *pGameServer = (CGameContext *)CreateGameServer();
+	pKernel->RegisterInterface(static_cast<IGameServer *>(pGameServer));
+
+	pEngine->Init();
+	pConsole->Init();
+	pConfigManager->Init();
+	pServer->RegisterCommands();
+
+	ApplyConfig(pConsole, json_object_get(pJson, "config"));
+	g_Config.m_SvTeeHistorian = 0;
+
+	pServer->m_RunServer = CServer::RUNNING;
+	pServer->m_AuthManager.Init();
+	{
+		int Size = pGameServer->PersistentClientDataSize();
+		for(auto &Client : pServer->m_aClients)
+		{
+			Client.m_HasPersistentData = false;
+			Client.m_pPersistentData = malloc(Size);
+		}
+	}
+	pServer->m_pPersistentData = malloc(pGameServer->PersistentDataSize());
+
+	if(!pServer->LoadMap(pMapName))
+	{
+		log_error(TOOL_NAME, "failed to load map '%s', use -m to choose another one", pMapName);
+		json_value_free(pJson);
+		return -1;
+	}
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(pServer->m_aCurrentMapSha256[CServer::MAP_TYPE_SIX], aSha256, sizeof(aSha256));
+	if(pMapSha256 && str_comp(aSha256, pMapSha256) != 0)
+		log_warn(TOOL_NAME, "map '%s' differs from the recorded one (sha256 %s), the replay will diverge", pMapName, pMapSha256);
+
+	pServer->m_NetServer.SetCallbacks(CServer::NewClientCallback, CServer::NewClientNoAuthCallback, CServer::ClientRejoinCallback, CServer::DelClientCallback, pServer);
+	pServer->Antibot()->Init();
+	pGameServer->OnInit(nullptr);
+
+	ApplyTuning(pGameServer->GlobalTuning(), json_object_get(pJson, "tuning"));
+	if(!pPrngDescription || !pGameServer->Prng()->SeedFromDescription(pPrngDescription))
+		log_warn(TOOL_NAME, "unknown random number generator '%s', the replay may diverge", pPrngDescription ? pPrngDescription : "");
+	json_value_free(pJson);
+
+	CReplay Replay(pServer, pGameServer);
+	Replay.m_Verify = Verify;
+	Replay.m_Snap = Snap;
+	pServer->Profiler()->SetEnabled(true);
+
+	const int64_t StartTime = time_get();
+	const int StartTick = pServer->Tick();
+	const bool Success = Replay.Run(pHeaderEnd + 1, pData.get() + FileSize - (pHeaderEnd + 1));
+	const double Seconds = (time_get() - StartTime) / (double)time_freq();
+	const int Ticks = pServer->Tick() - StartTick;
+
+	pLogger->SetFilter(CLogFilter{LEVEL_INFO});
+	if(IsInterrupted())
+		log_info(TOOL_NAME, "interrupted");
+	log_info(TOOL_NAME, "replayed %d ticks (%.1fs of game time) in %.3fs: %.0f ticks/s, %.1fx real time",
+		Ticks, Ticks / (double)SERVER_TICK_SPEED, Seconds, Ticks / Seconds, Ticks / (double)SERVER_TICK_SPEED / Seconds);
+
+	std::vector<int64_t> vDurations = Replay.m_vTickDurations;
+	std::sort(vDurations.begin(), vDurations.end());
+	if(!vDurations.empty())
+	{
+		int64_t Total = 0;
+		for(int64_t Duration : vDurations)
+			Total += Duration;
+		log_info(TOOL_NAME, "tick cost (us): p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f avg %.1f",
+			Percentile(vDurations, 0.5) / 1000.0, Percentile(vDurations, 0.9) / 1000.0, Percentile(vDurations, 0.99) / 1000.0,
+			Percentile(vDurations, 0.999) / 1000.0, vDurations.back() / 1000.0, Total / (double)vDurations.size() / 1000.0);
+	}
+	pServer->Profiler()->Print([](const char *pLine) { log_info(TOOL_NAME, "%s", pLine); });
+
+	if(Replay.m_SkippedLoads)
+		log_info(TOOL_NAME, "%d team loads from the database could not be replayed", Replay.m_SkippedLoads);
+	bool Matched = true;
+	if(Verify)
+	{
+		Matched = Replay.m_MismatchedTicks == 0;
+		if(Matched)
+			log_info(TOOL_NAME, "verify: all %d ticks match the recorded positions", Replay.m_VerifiedTicks);
+		else
+			log_info(TOOL_NAME, "verify: %d of %d ticks differ from the recorded positions, first at tick %d",
+				Replay.m_MismatchedTicks, Replay.m_VerifiedTicks, Replay.m_FirstMismatchTick);
+	}
+
+	pLogger->SetFilter(CLogFilter{LEVEL_WARN});
+	pGameServer->OnShutdown(nullptr);
+	pServer->m_pMap->Unload();
+	pServer->DbPool()->OnShutdown();
+
+	return Success && Matched ? 0 : 1;
+}